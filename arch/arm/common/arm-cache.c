@@ -346,6 +346,44 @@ BT_ERROR BT_DCacheInvalidateLine(void *addr) {
 }
 BT_EXPORT_SYMBOL(BT_DCacheInvalidateLine);
 
+/**
+ *	Cleans and invalidates a range through L1 and then L2, so that the memory is
+ *	up to date before a DMA master reads it.
+ **/
+BT_ERROR BT_DCacheFlushRange(void *addr, BT_u32 len) {
+	volatile PL310_REGS *pRegs = (PL310_REGS *) g_pregs;
+	const BT_u32 cacheline = 32;
+	BT_u32 end, adr;
+
+	if(len) {
+		end = (BT_u32) addr + len;
+
+		wrcp(ARM_CP15_CACHE_SIZE_SEL, 0);
+
+		adr = (BT_u32) addr & ~(cacheline - 1);
+		while(adr < end) {
+			__asm__ __volatile__("mcr "						\
+			ARM_CP15_CLEAN_INVAL_DC_LINE_MVA_POC :: "r" (adr));
+			adr += cacheline;
+		}
+
+		dsb();
+
+		adr = (BT_u32) addr & ~(cacheline - 1);
+		while(adr < end) {
+			pRegs->reg7_clean_inv_pa = bt_virt_to_phys(adr);
+			adr += cacheline;
+		}
+	}
+
+	dsb();
+
+	while(pRegs->reg7_cache_sync);
+
+	return BT_ERR_NONE;
+}
+BT_EXPORT_SYMBOL(BT_DCacheFlushRange);
+
 BT_ERROR BT_DCacheInvalidateRange(void *addr, BT_u32 len) {
 	volatile PL310_REGS *pRegs = (PL310_REGS *) g_pregs;
 	const BT_u32 cacheline = 32;
@@ -42,6 +42,8 @@
 
 #define ARM_CP15_INVAL_DC_LINE_MVA_POC	"p15, 0, %0,  c7,  c6, 1"
 #define ARM_CP15_INVAL_DC_LINE_SW		"p15, 0, %0,  c7,  c6, 2"
+#define ARM_CP15_CLEAN_DC_LINE_MVA_POC	"p15, 0, %0,  c7, c10, 1"
+#define ARM_CP15_CLEAN_INVAL_DC_LINE_MVA_POC "p15, 0, %0,  c7, c14, 1"
 #define ARM_CP15_CLEAN_INVAL_DC_LINE_SW "p15, 0, %0,  c7, c14, 2"
 
 
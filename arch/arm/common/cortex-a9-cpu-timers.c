@@ -64,6 +64,13 @@ static BT_ERROR timer_stop(BT_HANDLE hTimer) {
 	return BT_ERR_NONE;
 }
 
+static BT_ERROR timer_restart(BT_HANDLE hTimer, BT_u32 ulOffset) {
+	BT_u32 ulLoad = hTimer->pRegs->timers[hTimer->ulTimerID].LOAD;
+	hTimer->pRegs->timers[hTimer->ulTimerID].COUNT = (ulOffset < ulLoad) ? ulLoad - ulOffset : 0;
+	hTimer->pRegs->timers[hTimer->ulTimerID].CONTROL |= 0x1;
+	return BT_ERR_NONE;
+}
+
 static BT_ERROR timer_enable_interrupt(BT_HANDLE hTimer) {
 	hTimer->pRegs->timers[hTimer->ulTimerID].CONTROL |= 0x4;
 	return BT_ERR_NONE;
@@ -112,6 +119,7 @@ static const BT_DEV_IF_SYSTIMER oDeviceOps = {
 	.pfnGetOffset			= timer_get_offset,
 	.pfnStart				= timer_start,
 	.pfnStop				= timer_stop,
+	.pfnRestart				= timer_restart,
 };
 
 static const BT_IF_DEVICE oDeviceInterface = {
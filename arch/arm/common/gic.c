@@ -24,7 +24,7 @@ static BT_HANDLE				g_hActiveHandle = NULL;
 static BT_INTERRUPT_VECTOR 		g_oVectorTable[BT_CONFIG_ARCH_ARM_GIC_TOTAL_IRQS];
 static BT_u32 					g_oVectorStats[BT_CONFIG_ARCH_ARM_GIC_TOTAL_IRQS];
 
-static BT_s32					g_ulIRQ = -1;
+static BT_s32					g_ulIRQ[BT_CONFIG_CPU_CORES] = { [0 ... BT_CONFIG_CPU_CORES-1] = -1 };
 
 struct _BT_OPAQUE_HANDLE {
 	BT_HANDLE_HEADER 			h;
@@ -38,17 +38,18 @@ void BT_ARCH_ARM_GIC_IRQHandler() {
 	BT_HANDLE hGic = g_hActiveHandle;
 
 	BT_u32 ulStatus, ulIRQ;
+	BT_u32 ulCPU = BT_GetCoreID();
 
 	ulStatus = hGic->pGICC->IAR;
 	ulIRQ = ulStatus & 0x03FF;
 
 	while(ulIRQ < 1020) {
-		g_oVectorStats[ulIRQ] += 1;
+		__atomic_fetch_add(&g_oVectorStats[ulIRQ], 1, __ATOMIC_RELAXED);	// Both CPUs take interrupts.
 		ulIRQ 	   += hGic->ulBaseIRQ;		// Remap the IRQn into logical IRQ# space.
-		g_ulIRQ		= ulIRQ;
+		g_ulIRQ[ulCPU] = ulIRQ;
 		g_oVectorTable[ulIRQ].pfnHandler(ulIRQ, g_oVectorTable[ulIRQ].pParam);
-		g_ulIRQ 	= -1;
-		hGic->pGICC->EOIR = ulIRQ;
+		g_ulIRQ[ulCPU] = -1;
+		hGic->pGICC->EOIR = ulStatus;		// SGIs are only completed with their source CPU ID.
 		ulStatus 	= hGic->pGICC->IAR;		// receive the first interrupt from the IAR.
 		ulIRQ 		= ulStatus & 0x03FF;	// Get the IRQ number.
 	}
@@ -164,7 +165,7 @@ static BT_s32 gic_getactiveinterrupt(BT_HANDLE hGic, BT_ERROR *pError) {
 		*pError = BT_ERR_NONE;
 	}
 
-	return g_ulIRQ;
+	return g_ulIRQ[BT_GetCoreID()];
 }
 
 
@@ -282,7 +283,27 @@ static BT_ERROR gic_unmask_interrupts(BT_HANDLE hGic, BT_u32 ulNewMaskValue) {
 }
 
 static BT_u32 gic_get_count(BT_HANDLE hGic, BT_u32 ulIRQ) {
-	return g_oVectorStats[ulIRQ];
+	return __atomic_load_n(&g_oVectorStats[ulIRQ], __ATOMIC_RELAXED);
+}
+
+/*
+ *	The SGI and PPI enables, their priorities and the CPU interface are banked, so
+ *	each secondary CPU sets up its own copy.
+ */
+static BT_ERROR gic_init_cpu(BT_HANDLE hGic) {
+	gic_cpu_init(hGic);
+	return BT_ERR_NONE;
+}
+
+static BT_ERROR gic_send_sgi(BT_HANDLE hGic, BT_u32 ulSGI, BT_u32 ulCPUMask) {
+	if(ulSGI > 15) {
+		return BT_ERR_INVALID_VALUE;
+	}
+
+	__asm volatile("dsb" ::: "memory");		// Make our stores visible before the target handles it.
+	hGic->pGICD->SGIR = ((ulCPUMask & 0xFF) << 16) | ulSGI;
+
+	return BT_ERR_NONE;
 }
 
 static const BT_DEV_IF_IRQ oDeviceOps = {
@@ -302,6 +323,8 @@ static const BT_DEV_IF_IRQ oDeviceOps = {
 	.pfnUnmaskInterrupts 	= gic_unmask_interrupts,
 	.pfnGetCount			= gic_get_count,
 	.pfnGetActiveInterrupt  = gic_getactiveinterrupt,
+	.pfnInitCPU				= gic_init_cpu,
+	.pfnSendSGI				= gic_send_sgi,
 };
 
 static const BT_IF_DEVICE oDeviceInterface = {
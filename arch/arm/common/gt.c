@@ -14,8 +14,24 @@ BT_DEF_MODULE_EMAIL					("james@fullfat-fs.co.uk")
 struct _BT_OPAQUE_HANDLE {
 	BT_HANDLE_HEADER h;
 	volatile GT_REGS *pRegs;
+	BT_BOOL	bIRQ;
+	BT_FN_INTERRUPT_HANDLER pfnHandler;
+	void *pParam;
 };
 
+static BT_ERROR gt_irq_handler(BT_u32 ulIRQ, void *pParam) {
+	BT_HANDLE hTimer = (BT_HANDLE) pParam;
+
+	// ACK first, the handler may set the next compare value.
+	hTimer->pRegs->isr = GT_ISR_EVENT;
+
+	if(hTimer->pfnHandler) {
+		hTimer->pfnHandler(ulIRQ, hTimer->pParam);
+	}
+
+	return BT_ERR_NONE;
+}
+
 BT_ERROR gt_cleanup(BT_HANDLE hTimer) {
 	return BT_ERR_NONE;
 }
@@ -30,12 +46,50 @@ BT_u32 gt_rate(BT_HANDLE hTimer, BT_ERROR *pError) {
 }
 
 BT_u64 gt_value(BT_HANDLE hTimer, BT_ERROR *pError) {
-	return ((BT_u64) (hTimer->pRegs->count_0 | (BT_u64) hTimer->pRegs->count_1 << 32)) >> 5;
+	BT_u32 hi, lo;
+
+	// Read the upper word again, in case the lower one wrapped in between.
+	do {
+		hi = hTimer->pRegs->count_1;
+		lo = hTimer->pRegs->count_0;
+	} while(hi != hTimer->pRegs->count_1);
+
+	return ((BT_u64) lo | (BT_u64) hi << 32) >> 5;
+}
+
+static BT_ERROR gt_register_interrupt(BT_HANDLE hTimer, BT_FN_INTERRUPT_HANDLER pfnHandler, void *pParam) {
+	if(!hTimer->bIRQ) {
+		return BT_ERR_GENERIC;
+	}
+
+	hTimer->pfnHandler 	= pfnHandler;
+	hTimer->pParam 		= pParam;
+	return BT_ERR_NONE;
+}
+
+static BT_ERROR gt_set_compare(BT_HANDLE hTimer, BT_u64 ullValue) {
+	ullValue <<= 5;		// In the units of gt_value().
+
+	hTimer->pRegs->control &= ~GT_CONTROL_COMP_ENABLE;
+	hTimer->pRegs->comp_0 = (BT_u32) ullValue;
+	hTimer->pRegs->comp_1 = (BT_u32) (ullValue >> 32);
+	hTimer->pRegs->control |= GT_CONTROL_COMP_ENABLE | GT_CONTROL_IRQ_ENABLE;
+
+	return BT_ERR_NONE;
+}
+
+static BT_ERROR gt_clear_compare(BT_HANDLE hTimer) {
+	hTimer->pRegs->control &= ~(GT_CONTROL_COMP_ENABLE | GT_CONTROL_IRQ_ENABLE);
+	hTimer->pRegs->isr = GT_ISR_EVENT;
+	return BT_ERR_NONE;
 }
 
 static const BT_DEV_IF_GTIMER gt_ops = {
 	.pfnGetClockRate = gt_rate,
 	.pfnGetValue = gt_value,
+	.pfnRegisterInterrupt = gt_register_interrupt,
+	.pfnSetCompare = gt_set_compare,
+	.pfnClearCompare = gt_clear_compare,
 };
 
 static const BT_IF_DEVICE oDeviceInterface = {
@@ -67,6 +121,14 @@ static BT_HANDLE gt_probe(const BT_INTEGRATED_DEVICE *pDevice, BT_ERROR *pError)
 	}
 
 	hTimer->pRegs = (GT_REGS *) bt_ioremap((void *) pResource->ulStart, sizeof(GT_REGS));
+	hTimer->pRegs->control |= GT_CONTROL_TIMER_ENABLE;
+
+	// The comparator interrupt is optional, the timer still counts without it.
+	pResource = BT_GetIntegratedResource(pDevice, BT_RESOURCE_IRQ, 0);
+	if(pResource && !BT_RegisterInterrupt(pResource->ulStart, gt_irq_handler, hTimer)) {
+		BT_EnableInterrupt(pResource->ulStart);
+		hTimer->bIRQ = BT_TRUE;
+	}
 
 	BT_SetGlobalTimerHandle(hTimer);
 
@@ -91,6 +153,11 @@ static const BT_RESOURCE gt_resources[] = {
 		.ulEnd				= BT_CONFIG_ARCH_ARM_CORTEX_A9_MPCORE_BASE + 0x0200 + BT_SIZE_4K - 1,
 		.ulFlags			= BT_RESOURCE_MEM,
 	},
+	{
+		.ulStart			= 27,
+		.ulEnd				= 27,
+		.ulFlags			= BT_RESOURCE_IRQ,
+	},
 };
 
 BT_INTEGRATED_DEVICE_DEF oZynq_cpu_timer_device = {
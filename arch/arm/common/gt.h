@@ -11,6 +11,12 @@ typedef struct _GT_REGS {
 	BT_u32 	autoinc;
 } GT_REGS;
 
+#define GT_CONTROL_TIMER_ENABLE		0x00000001
+#define GT_CONTROL_COMP_ENABLE		0x00000002
+#define GT_CONTROL_IRQ_ENABLE		0x00000004
+
+#define GT_ISR_EVENT				0x00000001
+
 
 
 
@@ -0,0 +1,545 @@
+/**
+ *	Zynq PL330 DMA Controller driver.
+ *
+ *	Builds a small PL330 microcode program per submission, one set of loops per
+ *	segment, so that a whole scatter list completes with a single event/interrupt.
+ *
+ **/
+#include <bitthunder.h>
+#include <asm/barrier.h>
+#include <devman/bt_dma.h>
+#include <process/bt_spinlock.h>
+#include <string.h>
+#include "dmac.h"
+#include "slcr.h"
+
+BT_DEF_MODULE_NAME				("Zynq-DMAC")
+BT_DEF_MODULE_DESCRIPTION		("PL330 DMA engine driver for Zynq")
+
+#ifndef BT_CONFIG_MEM_PAGE_COHERENT_POOL
+#error "Zynq DMAC requires a coherent memory pool for channel programs. Ensure CONFIG_MEM_PAGE_COHERENT_POOL is configured."
+#endif
+
+#define DMAC_PROGRAM_SIZE				BT_PAGE_SIZE
+
+/*
+ *	PL330 instruction encodings.
+ */
+#define DMA_END							0x00
+#define DMA_LD							0x04
+#define DMA_ST							0x08
+#define DMA_RMB							0x12
+#define DMA_WMB							0x13
+#define DMA_LP(lc)						(0x20 | ((lc) << 1))
+#define DMA_SEV							0x34
+#define DMA_LPEND(lc)					(0x38 | ((lc) << 2))
+#define DMA_GO							0xA0
+#define DMA_MOV							0xBC
+#define DMA_MOV_SAR						0
+#define DMA_MOV_CCR						1
+#define DMA_MOV_DAR						2
+
+#define DMA_BURST_BYTES					16			///< 4 beats of 4 bytes.
+
+struct dmac_channel {
+	BT_BOOL					bInUse;
+	BT_BOOL					bBusy;
+	bt_paddr_t				program_phys;
+	BT_u8				   *program;
+	BT_DMA_COMPLETE			pfnComplete;
+	void 				   *pContext;
+	BT_u32					ulFaultType;	///< FTR of the last fault, for debugging.
+};
+
+struct _BT_OPAQUE_HANDLE {
+	BT_HANDLE_HEADER		h;
+	volatile ZYNQ_DMAC_REGS *pRegs;
+	bt_spinlock_t			lock;			///< Debug interface and channel busy state.
+	BT_u32					irq[ZYNQ_DMAC_TOTAL_CHANNELS];
+	BT_u32					ulRegisteredIrqs;
+	BT_u32					abort_irq;
+	BT_BOOL					bAbortRegistered;
+	struct dmac_channel		channels[ZYNQ_DMAC_TOTAL_CHANNELS];
+};
+
+static BT_u32 emit_mov(BT_u8 *p, BT_u8 reg, BT_u32 val) {
+	p[0] = DMA_MOV;
+	p[1] = reg;
+	p[2] = (val) & 0xFF;
+	p[3] = (val >> 8) & 0xFF;
+	p[4] = (val >> 16) & 0xFF;
+	p[5] = (val >> 24) & 0xFF;
+	return 6;
+}
+
+/**
+ *	Emits (LP lc1 {) LP lc0 { LD ST } (}) for the requested number of iterations.
+ **/
+static BT_u32 emit_loops(BT_u8 *p, BT_u32 outer, BT_u32 inner) {
+	BT_u32 i = 0;
+
+	if(outer > 1) {
+		p[i++] = DMA_LP(1);
+		p[i++] = outer - 1;
+	}
+
+	p[i++] = DMA_LP(0);
+	p[i++] = inner - 1;
+	p[i++] = DMA_LD;
+	p[i++] = DMA_ST;
+	p[i++] = DMA_LPEND(0);
+	p[i++] = 2;
+
+	if(outer > 1) {
+		p[i++] = DMA_LPEND(1);
+		p[i++] = 6;
+	}
+
+	return i;
+}
+
+static BT_u32 segment_ccr(const BT_DMA_SEGMENT *pSeg, BT_u32 size, BT_u32 len) {
+	BT_u32 ccr = CCR_SRC_BURST_SIZE(size) | CCR_SRC_BURST_LEN(len) | CCR_SRC_PROT_CTRL(1)
+			   | CCR_DST_BURST_SIZE(size) | CCR_DST_BURST_LEN(len) | CCR_DST_PROT_CTRL(1);
+
+	if(!(pSeg->flags & BT_DMA_SEG_SRC_FIXED)) {
+		ccr |= CCR_SRC_INC;
+	}
+
+	if(!(pSeg->flags & BT_DMA_SEG_DST_FIXED)) {
+		ccr |= CCR_DST_INC;
+	}
+
+	return ccr;
+}
+
+/**
+ *	Number of program bytes that emit_segment() will use for a segment.
+ **/
+static BT_u32 segment_program_size(const BT_DMA_SEGMENT *pSeg) {
+	BT_u32 bursts = pSeg->len / DMA_BURST_BYTES;
+	BT_u32 size = 12;
+
+	if(bursts) {
+		size += 6;
+		size += (bursts / (256 * 256)) * 10;
+		bursts %= (256 * 256);
+		if(bursts >= 256) {
+			size += (bursts / 256 > 1) ? 10 : 6;
+		}
+		if(bursts % 256) {
+			size += 6;
+		}
+	}
+
+	if(pSeg->len % DMA_BURST_BYTES) {
+		size += 12;
+	}
+
+	return size;
+}
+
+static BT_u32 emit_segment(BT_u8 *p, const BT_DMA_SEGMENT *pSeg) {
+	BT_u32 i = 0;
+	BT_u32 bursts = pSeg->len / DMA_BURST_BYTES;
+	BT_u32 residue = pSeg->len % DMA_BURST_BYTES;
+
+	i += emit_mov(&p[i], DMA_MOV_SAR, pSeg->src);
+	i += emit_mov(&p[i], DMA_MOV_DAR, pSeg->dst);
+
+	if(bursts) {
+		i += emit_mov(&p[i], DMA_MOV_CCR, segment_ccr(pSeg, 2, DMA_BURST_BYTES / 4));
+		while(bursts) {
+			if(bursts >= 256) {
+				BT_u32 outer = bursts / 256;
+				if(outer > 256) {
+					outer = 256;
+				}
+				i += emit_loops(&p[i], outer, 256);
+				bursts -= outer * 256;
+			} else {
+				i += emit_loops(&p[i], 1, bursts);
+				bursts = 0;
+			}
+		}
+	}
+
+	if(residue) {
+		i += emit_mov(&p[i], DMA_MOV_CCR, segment_ccr(pSeg, 0, 1));
+		i += emit_loops(&p[i], 1, residue);
+	}
+
+	return i;
+}
+
+/*
+ *	The debug registers take one instruction at a time, so this is called with
+ *	hDmac->lock held. It returns once the controller has taken the instruction.
+ */
+static void dmac_execute_debug_locked(BT_HANDLE hDmac, BT_u32 inst0, BT_u32 inst1) {
+	while(hDmac->pRegs->DBGSTATUS & DBGSTATUS_BUSY) {
+		;
+	}
+
+	hDmac->pRegs->DBGINST0 = inst0;
+	hDmac->pRegs->DBGINST1 = inst1;
+	dsb();
+	hDmac->pRegs->DBGCMD = 0;
+
+	while(hDmac->pRegs->DBGSTATUS & DBGSTATUS_BUSY) {
+		;
+	}
+}
+
+/*
+ *	DMAKILL on the channel thread.
+ */
+static void dmac_kill_locked(BT_HANDLE hDmac, BT_u32 ulChannel) {
+	dmac_execute_debug_locked(hDmac, (0x01 << 16) | (ulChannel << 8) | 1, 0);
+}
+
+/*
+ *	Completes a submission once, whichever of the event or the abort interrupt sees it first.
+ */
+static void dmac_complete(BT_HANDLE hDmac, BT_u32 ulChannel, BT_ERROR Status) {
+	struct dmac_channel *chan = &hDmac->channels[ulChannel];
+	bt_irqflags_t flags;
+
+	bt_spin_lock_irqsave(&hDmac->lock, flags);
+	BT_BOOL bBusy = chan->bBusy;
+	chan->bBusy = BT_FALSE;
+	bt_spin_unlock_irqrestore(&hDmac->lock, flags);
+
+	if(bBusy && chan->pfnComplete) {
+		chan->pfnComplete(chan->pContext, Status);
+	}
+}
+
+static BT_ERROR dmac_irq(BT_u32 ulIRQ, void *pParam) {
+	BT_HANDLE hDmac = (BT_HANDLE) pParam;
+	BT_u32 status = hDmac->pRegs->INTMIS;
+	BT_u32 faults = hDmac->pRegs->FSRC;
+	BT_u32 i;
+
+	for(i = 0; i < ZYNQ_DMAC_TOTAL_CHANNELS; i++) {
+		if(!(status & (1 << i))) {
+			continue;
+		}
+
+		hDmac->pRegs->INTCLR = (1 << i);
+		dmac_complete(hDmac, i, (faults & (1 << i)) ? BT_ERR_GENERIC : BT_ERR_NONE);
+	}
+
+	return BT_ERR_NONE;
+}
+
+/*
+ *	A faulting thread stops without signalling its event, so its waiter is completed
+ *	from here. The fault status is level, killing the threads clears it.
+ */
+static BT_ERROR dmac_abort_irq(BT_u32 ulIRQ, void *pParam) {
+	BT_HANDLE hDmac = (BT_HANDLE) pParam;
+	bt_irqflags_t flags;
+	BT_u32 i;
+
+	bt_spin_lock_irqsave(&hDmac->lock, flags);
+
+	BT_u32 manager = hDmac->pRegs->FSRD;
+	BT_u32 faults = hDmac->pRegs->FSRC;
+
+	if(manager & 1) {
+		dmac_execute_debug_locked(hDmac, (0x01 << 16), 0);		// DMAKILL on the manager thread.
+	}
+
+	for(i = 0; i < ZYNQ_DMAC_TOTAL_CHANNELS; i++) {
+		if(faults & (1 << i)) {
+			hDmac->channels[i].ulFaultType = hDmac->pRegs->FTR[i];
+			dmac_kill_locked(hDmac, i);
+		}
+	}
+
+	bt_spin_unlock_irqrestore(&hDmac->lock, flags);
+
+	BT_u32 events = hDmac->pRegs->INT_EVENT_RIS;
+
+	for(i = 0; i < ZYNQ_DMAC_TOTAL_CHANNELS; i++) {
+		/*
+		 *	A manager fault on DMAGO leaves the channel that was to be started stopped,
+		 *	so a busy channel that is stopped without having signalled its event failed too.
+		 */
+		BT_BOOL bStopped = (hDmac->pRegs->CHANNEL_STATUS[i].CSR & CSR_CHANNEL_STATUS) == CSR_STOPPED;
+		if((faults & (1 << i)) || ((manager & 1) && bStopped && !(events & (1 << i)))) {
+			dmac_complete(hDmac, i, BT_ERR_GENERIC);
+		}
+	}
+
+	return BT_ERR_NONE;
+}
+
+static BT_s32 dmac_request_channel(BT_HANDLE hDmac, BT_ERROR *pError) {
+	BT_s32 i;
+	BT_ERROR Error = BT_ERR_BUSY;
+
+	BT_kEnterCritical();
+	{
+		for(i = 0; i < ZYNQ_DMAC_TOTAL_CHANNELS; i++) {
+			if(!hDmac->channels[i].bInUse) {
+				hDmac->channels[i].bInUse = BT_TRUE;
+				Error = BT_ERR_NONE;
+				break;
+			}
+		}
+	}
+	BT_kExitCritical();
+
+	if(pError) {
+		*pError = Error;
+	}
+
+	return (Error == BT_ERR_NONE) ? i : -1;
+}
+
+static BT_ERROR dmac_release_channel(BT_HANDLE hDmac, BT_u32 ulChannel) {
+	if(ulChannel >= ZYNQ_DMAC_TOTAL_CHANNELS) {
+		return BT_ERR_INVALID_VALUE;
+	}
+
+	hDmac->channels[ulChannel].bInUse = BT_FALSE;
+	return BT_ERR_NONE;
+}
+
+static BT_ERROR dmac_submit(BT_HANDLE hDmac, BT_u32 ulChannel, const BT_DMA_SEGMENT *pSegments, BT_u32 ulSegments, BT_DMA_COMPLETE pfnComplete, void *pContext) {
+	BT_u32 i, pc = 0;
+
+	if(ulChannel >= ZYNQ_DMAC_TOTAL_CHANNELS || !hDmac->channels[ulChannel].bInUse) {
+		return BT_ERR_INVALID_VALUE;
+	}
+
+	struct dmac_channel *chan = &hDmac->channels[ulChannel];
+	if(chan->bBusy) {
+		return BT_ERR_BUSY;
+	}
+
+	for(i = 0; i < ulSegments; i++) {
+		pc += segment_program_size(&pSegments[i]);
+	}
+
+	if(pc + 4 > DMAC_PROGRAM_SIZE) {
+		return BT_ERR_INVALID_VALUE;
+	}
+
+	pc = 0;
+
+	for(i = 0; i < ulSegments; i++) {
+		pc += emit_segment(&chan->program[pc], &pSegments[i]);
+	}
+
+	chan->program[pc++] = DMA_WMB;
+	chan->program[pc++] = DMA_SEV;
+	chan->program[pc++] = ulChannel << 3;
+	chan->program[pc++] = DMA_END;
+
+	chan->pfnComplete = pfnComplete;
+	chan->pContext = pContext;
+
+	dsb();
+
+	bt_irqflags_t flags;
+	bt_spin_lock_irqsave(&hDmac->lock, flags);
+	chan->bBusy = BT_TRUE;
+	// DMAGO (secure) for the channel, issued on the manager thread.
+	dmac_execute_debug_locked(hDmac, (ulChannel << 24) | (DMA_GO << 16), chan->program_phys);
+	bt_spin_unlock_irqrestore(&hDmac->lock, flags);
+
+	return BT_ERR_NONE;
+}
+
+static BT_ERROR dmac_abort(BT_HANDLE hDmac, BT_u32 ulChannel) {
+	if(ulChannel >= ZYNQ_DMAC_TOTAL_CHANNELS) {
+		return BT_ERR_INVALID_VALUE;
+	}
+
+	bt_irqflags_t flags;
+	bt_spin_lock_irqsave(&hDmac->lock, flags);
+	dmac_kill_locked(hDmac, ulChannel);
+	hDmac->channels[ulChannel].bBusy = BT_FALSE;
+	bt_spin_unlock_irqrestore(&hDmac->lock, flags);
+
+	return BT_ERR_NONE;
+}
+
+/*
+ *	Also unwinds a probe that failed partway, so it only releases what was set up.
+ */
+static BT_ERROR dmac_cleanup(BT_HANDLE hDmac) {
+	BT_u32 i;
+
+	if(hDmac->pRegs) {
+		hDmac->pRegs->INTEN = 0;
+	}
+
+	for(i = 0; i < hDmac->ulRegisteredIrqs; i++) {
+		BT_DisableInterrupt(hDmac->irq[i]);
+		BT_UnregisterInterrupt(hDmac->irq[i], dmac_irq, hDmac);
+	}
+
+	if(hDmac->bAbortRegistered) {
+		BT_DisableInterrupt(hDmac->abort_irq);
+		BT_UnregisterInterrupt(hDmac->abort_irq, dmac_abort_irq, hDmac);
+	}
+
+	for(i = 0; i < ZYNQ_DMAC_TOTAL_CHANNELS; i++) {
+		if(hDmac->channels[i].program_phys) {
+			bt_page_free_coherent(hDmac->channels[i].program_phys, DMAC_PROGRAM_SIZE);
+		}
+	}
+
+	if(hDmac->pRegs) {
+		bt_iounmap(hDmac->pRegs);
+	}
+
+	return BT_ERR_NONE;
+}
+
+static const BT_DEV_IF_DMA oDmaInterface = {
+	.pfnRequestChannel	= dmac_request_channel,
+	.pfnReleaseChannel	= dmac_release_channel,
+	.pfnSubmit			= dmac_submit,
+	.pfnAbort			= dmac_abort,
+};
+
+static const BT_IF_DEVICE oDeviceInterface = {
+	.eConfigType = BT_DEV_IF_T_DMA,
+	.unConfigIfs = {
+		.pDmaIF = &oDmaInterface,
+	},
+};
+
+static const BT_IF_HANDLE oHandleInterface = {
+	BT_MODULE_DEF_INFO_NO_AUTHOR,
+	.oIfs = {
+		.pDevIF = &oDeviceInterface,
+	},
+	.eType = BT_HANDLE_T_DEVICE,
+	.pfnCleanup = dmac_cleanup,
+};
+
+static BT_HANDLE dmac_probe(const BT_INTEGRATED_DEVICE *pDevice, BT_ERROR *pError) {
+	BT_ERROR Error = BT_ERR_NONE;
+	BT_HANDLE hDmac = NULL;
+	BT_u32 i, ulID = 0;
+
+	const BT_RESOURCE *pResource = BT_GetIntegratedResource(pDevice, BT_RESOURCE_MEM, 0);
+	if(!pResource) {
+		Error = BT_ERR_INVALID_RESOURCE;
+		goto err_out;
+	}
+
+	hDmac = BT_CreateHandle(&oHandleInterface, sizeof(struct _BT_OPAQUE_HANDLE), pError);
+	if(!hDmac) {
+		Error = BT_ERR_NO_MEMORY;
+		goto err_out;
+	}
+
+	bt_spin_lock_init(&hDmac->lock);
+	hDmac->pRegs = (ZYNQ_DMAC_REGS *) bt_ioremap((void *) pResource->ulStart, BT_SIZE_4K);
+
+	volatile ZYNQ_SLCR_REGS *pSLCR = bt_ioremap((void *) ZYNQ_SLCR, BT_SIZE_4K);
+	zynq_slcr_unlock(pSLCR);
+	pSLCR->APER_CLK_CTRL |= 0x00000001;		// DMA_CPU_2XCLKACT
+	pSLCR->DMAC_RST_CTRL = 1;
+	pSLCR->DMAC_RST_CTRL = 0;
+	zynq_slcr_lock(pSLCR);
+	bt_iounmap(pSLCR);
+
+	pResource = BT_GetIntegratedResource(pDevice, BT_RESOURCE_ENUM, 0);
+	if(pResource) {
+		ulID = pResource->ulStart;
+	}
+
+	/*
+	 *	Channel events 0-3 and 4-7 are routed to two separate IRQ ranges on the GIC.
+	 */
+	BT_u32 chan = 0;
+	for(i = 0; chan < ZYNQ_DMAC_TOTAL_CHANNELS; i++) {
+		pResource = BT_GetIntegratedResource(pDevice, BT_RESOURCE_IRQ, i);
+		if(!pResource) {
+			Error = BT_ERR_INVALID_RESOURCE;
+			goto err_free_out;
+		}
+
+		BT_u32 irq;
+		for(irq = pResource->ulStart; irq <= pResource->ulEnd && chan < ZYNQ_DMAC_TOTAL_CHANNELS; irq++, chan++) {
+			hDmac->irq[chan] = irq;
+			Error = BT_RegisterInterrupt(irq, dmac_irq, hDmac);
+			if(Error) {
+				goto err_free_out;
+			}
+			hDmac->ulRegisteredIrqs = chan + 1;
+			BT_SetInterruptLabel(irq, dmac_irq, hDmac, "zynq,dmac");
+		}
+	}
+
+	/*
+	 *	The abort interrupt follows the channel event ranges.
+	 */
+	pResource = BT_GetIntegratedResource(pDevice, BT_RESOURCE_IRQ, i);
+	if(!pResource) {
+		Error = BT_ERR_INVALID_RESOURCE;
+		goto err_free_out;
+	}
+
+	hDmac->abort_irq = pResource->ulStart;
+	Error = BT_RegisterInterrupt(hDmac->abort_irq, dmac_abort_irq, hDmac);
+	if(Error) {
+		goto err_free_out;
+	}
+	hDmac->bAbortRegistered = BT_TRUE;
+	BT_SetInterruptLabel(hDmac->abort_irq, dmac_abort_irq, hDmac, "zynq,dmac-abort");
+
+	for(i = 0; i < ZYNQ_DMAC_TOTAL_CHANNELS; i++) {
+		hDmac->channels[i].program_phys = bt_page_alloc_coherent(DMAC_PROGRAM_SIZE);
+		if(!hDmac->channels[i].program_phys) {
+			Error = BT_ERR_NO_MEMORY;
+			goto err_free_out;
+		}
+		hDmac->channels[i].program = (BT_u8 *) bt_phys_to_virt(hDmac->channels[i].program_phys);
+	}
+
+	// Route all channel events to interrupts.
+	hDmac->pRegs->INTCLR = 0xFF;
+	hDmac->pRegs->INTEN = 0xFF;
+
+	for(i = 0; i < ZYNQ_DMAC_TOTAL_CHANNELS; i++) {
+		BT_EnableInterrupt(hDmac->irq[i]);
+	}
+	BT_EnableInterrupt(hDmac->abort_irq);
+
+	Error = BT_DmaRegisterController(hDmac, ulID);
+	if(Error) {
+		goto err_free_out;
+	}
+
+	if(pError) {
+		*pError = Error;
+	}
+
+	BT_kPrint("ZYNQ-DMAC: at 0x%08X, %d channels", hDmac->pRegs, ZYNQ_DMAC_TOTAL_CHANNELS);
+
+	return hDmac;
+
+err_free_out:
+	BT_CloseHandle(hDmac);		// dmac_cleanup() releases what was set up.
+
+err_out:
+	if(pError) {
+		*pError = Error;
+	}
+
+	return NULL;
+}
+
+BT_INTEGRATED_DRIVER_DEF oDmacDriver = {
+	.name 		= "arm,pl330",
+	.pfnProbe 	= dmac_probe,
+};
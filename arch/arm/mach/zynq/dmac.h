@@ -0,0 +1,86 @@
+#ifndef _DMAC_H_
+#define _DMAC_H_
+
+#include <bitthunder.h>
+#include <bt_struct.h>
+
+#define ZYNQ_DMAC_S_BASE				0xF8003000
+#define ZYNQ_DMAC_NS_BASE				0xF8004000
+
+#define ZYNQ_DMAC_TOTAL_CHANNELS		8
+
+/*
+ *	ARM PL330 DMA Controller, as integrated on the Zynq PS.
+ */
+typedef struct _ZYNQ_DMAC_REGS {
+	BT_u32	DSR;						// 0x000 Manager thread status.
+	#define DSR_DMA_STATUS				0x0000000F
+	BT_u32	DPC;						// 0x004 Manager thread program counter.
+
+	BT_STRUCT_RESERVED_u32(0, 0x004, 0x020);
+
+	BT_u32	INTEN;						// 0x020 Event / interrupt select.
+	BT_u32	INT_EVENT_RIS;				// 0x024 Event status.
+	BT_u32	INTMIS;						// 0x028 Interrupt status.
+	BT_u32	INTCLR;						// 0x02C Interrupt clear.
+	BT_u32	FSRD;						// 0x030 Manager fault status.
+	BT_u32	FSRC;						// 0x034 Channel fault status.
+	BT_u32	FTRD;						// 0x038 Manager fault type.
+
+	BT_STRUCT_RESERVED_u32(1, 0x038, 0x040);
+
+	BT_u32	FTR[ZYNQ_DMAC_TOTAL_CHANNELS];	// 0x040 Channel fault type.
+
+	BT_STRUCT_RESERVED_u32(2, 0x05C, 0x100);
+
+	struct {
+		BT_u32	CSR;					// Channel status.
+		#define CSR_CHANNEL_STATUS		0x0000000F
+		#define CSR_STOPPED				0x00000000
+		BT_u32	CPC;					// Channel program counter.
+	} CHANNEL_STATUS[ZYNQ_DMAC_TOTAL_CHANNELS];
+
+	BT_STRUCT_RESERVED_u32(3, 0x13C, 0x400);
+
+	struct {
+		BT_u32	SAR;
+		BT_u32	DAR;
+		BT_u32	CCR;
+		BT_u32	LC0;
+		BT_u32	LC1;
+		BT_u32	reserved[3];
+	} CHANNEL_CTRL[ZYNQ_DMAC_TOTAL_CHANNELS];
+
+	BT_STRUCT_RESERVED_u32(4, 0x4FC, 0xD00);
+
+	BT_u32	DBGSTATUS;					// 0xD00 Debug status.
+	#define DBGSTATUS_BUSY				0x00000001
+	BT_u32	DBGCMD;						// 0xD04 Debug command.
+	BT_u32	DBGINST0;					// 0xD08 Debug instruction-0.
+	BT_u32	DBGINST1;					// 0xD0C Debug instruction-1.
+
+	BT_STRUCT_RESERVED_u32(5, 0xD0C, 0xE00);
+
+	BT_u32	CR0;						// 0xE00 Configuration registers.
+	BT_u32	CR1;
+	BT_u32	CR2;
+	BT_u32	CR3;
+	BT_u32	CR4;
+	BT_u32	CRDN;
+} ZYNQ_DMAC_REGS;
+
+/*
+ *	Channel control register fields.
+ */
+#define CCR_SRC_INC						0x00000001
+#define CCR_SRC_BURST_SIZE(x)			(((x) & 0x7) << 1)		///< log2 of bytes per beat.
+#define CCR_SRC_BURST_LEN(x)			((((x) - 1) & 0xF) << 4)
+#define CCR_SRC_PROT_CTRL(x)			(((x) & 0x7) << 8)
+#define CCR_SRC_CACHE_CTRL(x)			(((x) & 0x7) << 11)
+#define CCR_DST_INC						0x00004000
+#define CCR_DST_BURST_SIZE(x)			(((x) & 0x7) << 15)
+#define CCR_DST_BURST_LEN(x)			((((x) - 1) & 0xF) << 18)
+#define CCR_DST_PROT_CTRL(x)			(((x) & 0x7) << 22)
+#define CCR_DST_CACHE_CTRL(x)			(((x) & 0x7) << 25)
+
+#endif
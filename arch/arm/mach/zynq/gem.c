@@ -33,6 +33,31 @@ enum TX_STATE {
 	TX_STATE_DONE,
 };
 
+#ifdef BT_CONFIG_MACH_ZYNQ_GEM_ZEROCOPY
+#define GEM_CAPABILITIES_ZEROCOPY	(BT_NET_IF_CAPABILITIES_ZEROCOPY | BT_NET_IF_CAPABILITIES_SCATTER_GATHER)
+
+struct gem_rx_slot {
+	void						   *pBuffer;		// Network stack buffer on the descriptor, NULL when empty.
+	void						   *pData;
+};
+
+struct gem_tx_slot {
+	void						   *pBuffer;		// Kept on the first descriptor of each frame.
+	BT_u32							ulSegments;		// Descriptors used by the frame.
+};
+#else
+#define GEM_CAPABILITIES_ZEROCOPY	0
+#endif
+
+/*
+ *	Checksums are generated (DMA_CFG_TCPCKSUM) and verified (NET_CFG_RXCHKSUMEN) in
+ *	hardware, frames with bad checksums are dropped. IP fragments can't be verified,
+ *	so UDP, which is commonly fragmented, is still checked by the stack.
+ */
+#define GEM_CAPABILITIES_CHECKSUM	(BT_NET_IF_CAPABILITIES_TX_CSUM_IP | BT_NET_IF_CAPABILITIES_TX_CSUM_TCP | \
+									 BT_NET_IF_CAPABILITIES_TX_CSUM_UDP | BT_NET_IF_CAPABILITIES_RX_CSUM_IP | \
+									 BT_NET_IF_CAPABILITIES_RX_CSUM_TCP)
+
 struct _BT_OPAQUE_HANDLE {
 	BT_HANDLE_HEADER 				h;
 	volatile GEM_REGS			   *pRegs;
@@ -54,8 +79,16 @@ struct _BT_OPAQUE_HANDLE {
 	volatile GEM_BD				   *txbd;
 	BT_u32							tx_ci;
 	BT_u32							tx_bytes;
+	BT_BOOL							tx_stalled;		// The stack found the TX ring full, see gem_tx_stalled().
 	bt_paddr_t 						txbufs_phys;
 	void						   *txbufs;
+#ifdef BT_CONFIG_MACH_ZYNQ_GEM_ZEROCOPY
+	BT_u32							rx_pi;			// Next RX descriptor to post a buffer to.
+	struct gem_rx_slot				rx_slots[RECV_BD_CNT];
+	BT_u32							tx_pi;			// Next TX descriptor to fill, tx_ci is the next to reclaim.
+	BT_u32							tx_free;
+	struct gem_tx_slot				tx_slots[SEND_BD_CNT];
+#endif
 	BT_u32 							speed;			// Current operating speed of the MAC.
 	BT_u32							duplex;			// Current operating duplex of the MAC.
 	BT_u32							link;			// Current operating link mode of the MAC. (Up or Down?)
@@ -69,24 +102,81 @@ struct _MII_HANDLE {
 static const BT_IF_HANDLE oMIIHandleInterface;
 
 
+/*
+ *	Receive interrupts stay masked while the stack polls the ring, see mac_rx_interrupt().
+ *	Only unmasked sources are acknowledged, so that a frame arriving while polling raises
+ *	the interrupt again as soon as it is unmasked.
+ */
+#define GEM_INT_RX_POLL		(GEM_INT_RX_COMPLETE | GEM_INT_RX_USED)
+
+/*
+ *	Transmit doorbell, the GEM is only started when it is idle. While it is working through
+ *	the ring it picks up newly queued frames by itself, so a burst costs one STARTTX.
+ *	A frame queued just as the GEM read its used bit is started from the TX_USED interrupt.
+ */
+static void gem_tx_kick(BT_HANDLE hMac) {
+	dsb();
+
+	if(!(hMac->pRegs->tx_status & TX_STAT_TXGO)) {
+		hMac->pRegs->net_ctrl |= NET_CTRL_STARTTX;
+		dsb();
+	}
+}
+
+static void gem_tx_restart(BT_HANDLE hMac) {
+	BT_u32 idx = (hMac->pRegs->tx_qbar - hMac->txbd_phys) / sizeof(GEM_BD);
+
+	if(idx < SEND_BD_CNT && !(hMac->txbd[idx].flags & TX_BD_USED)) {
+		gem_tx_kick(hMac);
+	}
+}
+
+/*
+ *	TX_COMPLETE is masked, frames are reclaimed in batches by the stack. Only when the ring
+ *	has filled up is it unmasked, so that the stack can be told to move its queued frames on.
+ */
+static void gem_tx_stalled(BT_HANDLE hMac) {
+	hMac->tx_stalled = BT_TRUE;
+	hMac->pRegs->intr_enable = GEM_INT_TX_COMPLETE;
+}
+
 static BT_ERROR gem_interrupt_handler(BT_u32 ulIRQ, void *pParam) {
 	BT_HANDLE hMac = (BT_HANDLE) pParam;
 
-	BT_u32 regisr = hMac->pRegs->intr_status;
+	BT_u32 regisr = hMac->pRegs->intr_status & ~hMac->pRegs->intr_mask;
 	hMac->pRegs->intr_status = regisr;
 	while(regisr) {
-		if(regisr & GEM_INT_RX_COMPLETE) {
+		if(regisr & GEM_INT_RX_POLL) {
+			hMac->pRegs->intr_disable = GEM_INT_RX_POLL;
+			if(regisr & GEM_INT_RX_USED) {
+				// The ring is full (or, in zero-copy mode, out of buffers), a frame was lost.
+				hMac->pfnEvent(hMac->pIf, BT_NET_IF_RX_DROPPED, BT_TRUE);
+			}
 			hMac->pfnEvent(hMac->pIf, BT_NET_IF_RX_READY, BT_TRUE);
-			hMac->pRegs->rx_status = RX_STAT_FRAME_RECD;
-		} else if(regisr & GEM_INT_TX_COMPLETE) {
-			hMac->pRegs->tx_status = 0x20;
-		}else if(regisr & GEM_INT_RX_OVERRUN) {
-			//BT_kPrint("rx overrun");
-		} else {
-			//BT_kPrint("other int:%08x", regisr);
+			hMac->pRegs->rx_status = RX_STAT_FRAME_RECD | RX_STAT_BUFFNA;
+		}
+
+		// Several sources can be pending at once, each one has been acknowledged above.
+		if(regisr & GEM_INT_TX_USED) {
+			// End of a burst, or the GEM read a used bit that was just being cleared.
+			hMac->pRegs->tx_status = TX_STAT_USED_READ;
+			gem_tx_restart(hMac);
+		}
+
+		if(regisr & GEM_INT_TX_COMPLETE) {
+			hMac->pRegs->tx_status = TX_STAT_COMPLETE;
+			hMac->pRegs->intr_disable = GEM_INT_TX_COMPLETE;
+			if(hMac->tx_stalled) {
+				hMac->tx_stalled = BT_FALSE;
+				hMac->pfnEvent(hMac->pIf, BT_NET_IF_TX_COMPLETE, BT_TRUE);
+			}
+		}
+
+		if(regisr & GEM_INT_RX_OVERRUN) {
+			hMac->pfnEvent(hMac->pIf, BT_NET_IF_RX_DROPPED, BT_TRUE);
 		}
 
-		regisr = hMac->pRegs->intr_status;
+		regisr = hMac->pRegs->intr_status & ~hMac->pRegs->intr_mask;
 		hMac->pRegs->intr_status = regisr;
 	}
 
@@ -136,6 +226,7 @@ static BT_u32 mac_getmtusize(BT_HANDLE hMac, BT_ERROR *pError) {
 }
 
 
+#ifndef BT_CONFIG_MACH_ZYNQ_GEM_ZEROCOPY
 static BT_u32 mac_dataready(BT_HANDLE hMac, BT_ERROR *pError) {
 	volatile GEM_BD *cur = &hMac->rxbd[hMac->rx_ci];
 	if(cur->address & RX_BD_OWNERSHIP) {
@@ -187,6 +278,8 @@ static BT_BOOL mac_tx_ready(BT_HANDLE hMac, BT_ERROR *pError) {
 		return BT_TRUE;
 	}
 
+	gem_tx_stalled(hMac);
+
 	return BT_FALSE;
 }
 
@@ -206,19 +299,188 @@ static BT_ERROR mac_sendframe(BT_HANDLE hMac) {
 		hMac->tx_ci = 0;
 	}
 
+	gem_tx_kick(hMac);
+
+	return BT_ERR_NONE;
+}
+#else
+
+/*
+ *	Zero-copy mode, the descriptors point straight at the network stack's buffers.
+ *
+ *	RX descriptors without a buffer keep their ownership bit set, so the GEM stops at
+ *	them (raising RX_USED) until the stack posts a new buffer.
+ */
+static BT_ERROR mac_rx_post(BT_HANDLE hMac, const BT_NET_BUFFER *pBuffer) {
+	volatile GEM_BD *cur = &hMac->rxbd[hMac->rx_pi];
+	struct gem_rx_slot *slot = &hMac->rx_slots[hMac->rx_pi];
+
+	if(slot->pBuffer || pBuffer->ulLength < RX_BUF_SIZE) {
+		return BT_ERR_GENERIC;
+	}
+
+	slot->pBuffer = pBuffer->pBuffer;
+	slot->pData = pBuffer->pData;
+
+	// No dirty lines may be written back over the buffer once the GEM owns it.
+	BT_DCacheInvalidateRange(pBuffer->pData, RX_BUF_SIZE);
+
+	cur->flags = 0;
 	dsb();
+	cur->address = (bt_virt_to_phys(pBuffer->pData) & RX_BD_ADDRESS) | (cur->address & RX_BD_WRAP);
+
+	hMac->rx_pi += 1;
+	if(hMac->rx_pi == RECV_BD_CNT) {
+		hMac->rx_pi = 0;
+	}
+
+	return BT_ERR_NONE;
+}
+
+static void *mac_rx_frame(BT_HANDLE hMac, BT_u32 *pulLength, BT_ERROR *pError) {
+
+	while(1) {
+		volatile GEM_BD *cur = &hMac->rxbd[hMac->rx_ci];
+		struct gem_rx_slot *slot = &hMac->rx_slots[hMac->rx_ci];
+
+		if(!slot->pBuffer || !(cur->address & RX_BD_OWNERSHIP)) {
+			return NULL;
+		}
+
+		BT_u32 flags = cur->flags;
+		BT_NET_BUFFER oBuffer = {
+			.pBuffer 	= slot->pBuffer,
+			.pData		= slot->pData,
+			.ulLength	= RX_BUF_SIZE,
+		};
+
+		slot->pBuffer = NULL;
+
+		hMac->rx_ci += 1;
+		if(hMac->rx_ci == RECV_BD_CNT) {
+			hMac->rx_ci = 0;
+		}
+
+		if((flags & (RX_BD_SOF | RX_BD_EOF)) == (RX_BD_SOF | RX_BD_EOF)) {
+			*pulLength = flags & RX_BD_LENGTH;
+			BT_DCacheInvalidateRange(oBuffer.pData, *pulLength);
+			return oBuffer.pBuffer;
+		}
+
+		// Frames never span buffers of RX_BUF_SIZE, recycle anything that does.
+		mac_rx_post(hMac, &oBuffer);
+	}
+}
+
+static BT_BOOL mac_tx_ready(BT_HANDLE hMac, BT_ERROR *pError) {
+	if(!hMac->tx_free) {
+		gem_tx_stalled(hMac);
+		return BT_FALSE;
+	}
+
+	return BT_TRUE;
+}
 
-	hMac->pRegs->net_ctrl |= NET_CTRL_STARTTX;
+/*
+ *	One descriptor per segment. The GEM only starts on a frame once the used bit
+ *	of its first descriptor is cleared, so that is done last.
+ */
+static BT_ERROR mac_tx_frame(BT_HANDLE hMac, const BT_NET_BUFFER *pSegments, BT_u32 ulSegments, void *pBuffer) {
+	BT_u32 first = hMac->tx_pi;
+	BT_u32 i, idx = first;
+
+	if(!ulSegments) {
+		return BT_ERR_GENERIC;
+	}
+
+	if(ulSegments > hMac->tx_free) {
+		gem_tx_stalled(hMac);
+		return BT_ERR_GENERIC;
+	}
+
+	for(i = 0; i < ulSegments; i++) {
+		volatile GEM_BD *cur = &hMac->txbd[idx];
+		BT_u32 flags = (cur->flags & TX_BD_WRAP) | (pSegments[i].ulLength & TX_BD_LENGTH);
+
+		if(i == ulSegments - 1) {
+			flags |= TX_BD_LAST;
+		}
+
+		if(idx == first) {
+			flags |= TX_BD_USED;
+		}
+
+		BT_DCacheFlushRange(pSegments[i].pData, pSegments[i].ulLength);
+
+		cur->address = bt_virt_to_phys(pSegments[i].pData);
+		cur->flags = flags;
+
+		idx += 1;
+		if(idx == SEND_BD_CNT) {
+			idx = 0;
+		}
+	}
+
+	hMac->tx_slots[first].pBuffer = pBuffer;
+	hMac->tx_slots[first].ulSegments = ulSegments;
+
+	hMac->tx_pi = idx;
+	hMac->tx_free -= ulSegments;
 
 	dsb();
 
+	hMac->txbd[first].flags &= ~TX_BD_USED;
+
+	gem_tx_kick(hMac);
+
 	return BT_ERR_NONE;
 }
 
+/*
+ *	The GEM only sets the used bit of the first descriptor of a sent frame, the others
+ *	are marked here so that the ring is always terminated after the last queued frame.
+ */
+static BT_u32 mac_tx_reclaim(BT_HANDLE hMac, void **ppBuffers, BT_u32 ulMax) {
+	BT_u32 i, n = 0;
+
+	while(n < ulMax && hMac->tx_free < SEND_BD_CNT) {
+		struct gem_tx_slot *slot = &hMac->tx_slots[hMac->tx_ci];
+
+		if(!(hMac->txbd[hMac->tx_ci].flags & TX_BD_USED)) {
+			break;
+		}
+
+		for(i = 0; i < slot->ulSegments; i++) {
+			hMac->txbd[hMac->tx_ci].flags |= TX_BD_USED;
+			hMac->tx_ci += 1;
+			if(hMac->tx_ci == SEND_BD_CNT) {
+				hMac->tx_ci = 0;
+			}
+		}
+
+		hMac->tx_free += slot->ulSegments;
+		ppBuffers[n++] = slot->pBuffer;
+		slot->pBuffer = NULL;
+	}
+
+	return n;
+}
+#endif
+
 static BT_ERROR mac_send_event(BT_HANDLE hMac, BT_u32 ulEvent) {
 	return BT_ERR_NONE;
 }
 
+static BT_ERROR mac_rx_interrupt(BT_HANDLE hMac, BT_BOOL bEnable) {
+	if(bEnable) {
+		hMac->pRegs->intr_enable = GEM_INT_RX_POLL;
+	} else {
+		hMac->pRegs->intr_disable = GEM_INT_RX_POLL;
+	}
+
+	return BT_ERR_NONE;
+}
+
 static void mac_set_freq(BT_HANDLE hMac, BT_u32 freq) {
 
 	volatile ZYNQ_SLCR_REGS *pSLCR = bt_ioremap((void *) ZYNQ_SLCR, BT_SIZE_4K);
@@ -326,7 +588,7 @@ static BT_ERROR mac_init(BT_HANDLE hMac) {
 	hMac->pRegs->net_ctrl |= NET_CTRL_TXEN;
 	hMac->pRegs->net_ctrl |= NET_CTRL_RXEN;
 
-	hMac->pRegs->intr_enable = GEM_INT_ALL_MASK;
+	hMac->pRegs->intr_enable = GEM_INT_ALL_MASK & ~GEM_INT_TX_COMPLETE;
 
 	return Error;
 }
@@ -405,19 +667,27 @@ static const BT_IF_HANDLE oMIIHandleInterface = {
 };
 
 static const BT_DEV_IF_EMAC mac_ops = {
-	.ulCapabilities 	= BT_NET_IF_CAPABILITIES_ETHERNET | BT_NET_IF_CAPABILITIES_100MBPS | BT_NET_IF_CAPABILITIES_1000MBPS,
+	.ulCapabilities 	= BT_NET_IF_CAPABILITIES_ETHERNET | BT_NET_IF_CAPABILITIES_100MBPS | BT_NET_IF_CAPABILITIES_1000MBPS | GEM_CAPABILITIES_ZEROCOPY | GEM_CAPABILITIES_CHECKSUM,
 	.pfnEventSubscribe 	= mac_eventsubscribe,
 	.pfnInitialise		= mac_init,
 	.pfnGetMACAddr		= mac_getaddr,
 	.pfnSetMACAddr		= mac_setaddr,
 	.pfnGetMTU			= mac_getmtusize,
+	.pfnTxFifoReady		= mac_tx_ready,
+#ifdef BT_CONFIG_MACH_ZYNQ_GEM_ZEROCOPY
+	.pfnRxPostBuffer	= mac_rx_post,
+	.pfnRxFrame			= mac_rx_frame,
+	.pfnTxFrame			= mac_tx_frame,
+	.pfnTxReclaim		= mac_tx_reclaim,
+#else
 	.pfnDataReady		= mac_dataready,
 	.pfnRead			= mac_read,
 	.pfnWrite			= mac_write,
 	.pfnDropFrame		= mac_drop,
-	.pfnTxFifoReady		= mac_tx_ready,
 	.pfnSendFrame		= mac_sendframe,
+#endif
 	.pfnSendEvent		= mac_send_event,
+	.pfnRxInterrupt		= mac_rx_interrupt,
 	.adjust_link		= mac_adjust_link,
 	.adjust_state		= mac_adjust_state,
 };
@@ -455,6 +725,37 @@ BT_u8 dividers[8] = {
 	224
 };
 
+#ifdef BT_CONFIG_MACH_ZYNQ_GEM_ZEROCOPY
+static BT_ERROR descriptor_init(BT_HANDLE hMac) {
+
+	BT_u32 i;
+
+	// Buffers are posted by the network stack, until then every descriptor belongs to software.
+	hMac->rxbd_phys = bt_page_alloc_coherent(sizeof(GEM_BD) * RECV_BD_CNT);
+	hMac->rxbd = (void *) bt_phys_to_virt(hMac->rxbd_phys);
+
+	for(i = 0; i < RECV_BD_CNT; i++) {
+		hMac->rxbd[i].address 	= RX_BD_OWNERSHIP;
+		hMac->rxbd[i].flags 	= 0;
+	}
+
+	hMac->rxbd[RECV_BD_CNT-1].address |= RX_BD_WRAP;
+
+	hMac->txbd_phys = bt_page_alloc_coherent(sizeof(GEM_BD) * SEND_BD_CNT);
+	hMac->txbd = (void *) bt_phys_to_virt(hMac->txbd_phys);
+
+	for(i = 0; i < SEND_BD_CNT; i++) {
+		hMac->txbd[i].address 	= 0;
+		hMac->txbd[i].flags 	= TX_BD_USED;
+	}
+
+	hMac->txbd[SEND_BD_CNT-1].flags |= TX_BD_WRAP;
+
+	hMac->tx_free = SEND_BD_CNT;
+
+	return BT_ERR_NONE;
+}
+#else
 static BT_ERROR descriptor_init(BT_HANDLE hMac) {
 
 	hMac->rxbufs_phys = bt_page_alloc_coherent(RX_BUF_SIZE * RECV_BD_CNT);
@@ -495,6 +796,7 @@ static BT_ERROR descriptor_init(BT_HANDLE hMac) {
 
 	return BT_ERR_NONE;
 }
+#endif
 
 static void mac_set_hwaddr(BT_HANDLE hMac) {
 	// Set mac address
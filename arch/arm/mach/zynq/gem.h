@@ -111,8 +111,12 @@ typedef struct _GEM_REGS {
 	#define DMA_CFG_DISC_NO_AHB 		0x01000000
 
 	BT_u32 tx_status;
+	#define TX_STAT_USED_READ			0x00000001
+	#define TX_STAT_TXGO				0x00000008
+	#define TX_STAT_COMPLETE			0x00000020
+
 	BT_u32 rx_qbar;
-	BT_u32 tx_qbar;
+	BT_u32 tx_qbar;								///< Reads back the descriptor being processed.
 	BT_u32 rx_status;
 	#define RX_STAT_BUFFNA				0x00000001
 	#define RX_STAT_FRAME_RECD 			0x00000002
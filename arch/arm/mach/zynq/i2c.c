@@ -380,7 +380,7 @@ static BT_HANDLE i2c_probe(const BT_INTEGRATED_DEVICE *pDevice, BT_ERROR *pError
 	hI2C->i2c_master.pDevice = pDevice;
 	i2c_set_clock_rate(hI2C, BT_I2C_CLOCKRATE_400kHz);
 
-	hI2C->pMutex = BT_kMutexCreate();
+	hI2C->pMutex = BT_kSemaphoreCreate();
 	if(!hI2C->pMutex) {
 		Error = BT_ERR_NO_MEMORY;
 		goto err_free_int_out;
@@ -14,6 +14,7 @@ MACH_ZYNQ_OBJECTS-$(BT_CONFIG_MACH_ZYNQ_GPIO) += $(BUILD_DIR)/arch/arm/mach/zynq
 MACH_ZYNQ_OBJECTS-$(BT_CONFIG_MACH_ZYNQ_SDIO) += $(BUILD_DIR)/arch/arm/mach/zynq/sdio.o
 MACH_ZYNQ_OBJECTS-$(BT_CONFIG_MACH_ZYNQ_DEVCFG) += $(BUILD_DIR)/arch/arm/mach/zynq/devcfg.o
 MACH_ZYNQ_OBJECTS-$(BT_CONFIG_MACH_ZYNQ_QSPI) += $(BUILD_DIR)/arch/arm/mach/zynq/qspi.o
+MACH_ZYNQ_OBJECTS-$(BT_CONFIG_MACH_ZYNQ_DMAC) += $(BUILD_DIR)/arch/arm/mach/zynq/dmac.o
 MACH_ZYNQ_OBJECTS-$(BT_CONFIG_MACH_ZYNQ_I2C) += $(BUILD_DIR)/arch/arm/mach/zynq/i2c.o
 
 MACH_ZYNQ_OBJECTS-$(BT_CONFIG_MACH_ZYNQ_GEM) += $(BUILD_DIR)/arch/arm/mach/zynq/gem.o
@@ -2,6 +2,7 @@
 #include <collections/bt_list.h>
 #include <of/bt_of.h>
 #include <string.h>
+#include <devman/bt_dma.h>
 #include "qspi.h"
 #include "slcr.h"
 
@@ -51,6 +52,11 @@ BT_DEF_MODULE_EMAIL				("mdaniel@riegl.com")
 #define QSPI_FLASH_OPCODE_SE         0xD8    /* Sector erase (usually 64KB)*/
 #define QSPI_FLASH_OPCODE_QPP		 0x32	 /* Quad page program */
 
+/*
+ * Maximum number of rx transfers that can be chained into one DMA program.
+ */
+#define QSPI_DMA_MAX_SEGMENTS		8
+
 
 struct _BT_OPAQUE_HANDLE {
 	BT_HANDLE_HEADER 				 	 h;
@@ -79,6 +85,15 @@ struct _BT_OPAQUE_HANDLE {
 	BT_BOOL 							is_inst;
 
 	volatile BT_u32								irq;
+
+#ifdef BT_CONFIG_MACH_ZYNQ_QSPI_DMA
+	BT_HANDLE							hDma;
+	BT_s32								dma_channel;
+	BT_SPI_MESSAGE					   *dma_message;
+	BT_u32								dma_cmd_len;
+	BT_u32								dma_segment_count;
+	BT_DMA_SEGMENT						dma_segments[QSPI_DMA_MAX_SEGMENTS];
+#endif
 };
 
 /**
@@ -718,6 +733,151 @@ BT_s32 qspi_transfer(BT_HANDLE hQspi, BT_SPI_MESSAGE * message) {
 	return BT_ERR_NONE;
 }
 
+#ifdef BT_CONFIG_MACH_ZYNQ_QSPI_DMA
+/*
+ * The PS QSPI controller has no DMA request lines, so large reads are made by the
+ * PL330 copying from the linear aperture, with the controller issuing the read
+ * command itself. Everything else stays on the FIFO path.
+ */
+static void qspi_enter_linear(BT_HANDLE qspi, BT_u8 opcode, BT_u32 dummy)
+{
+	BT_u32 lcfg = QSPI_LCFG_ENABLE_MASK | ((dummy << QSPI_LCFG_DUMMY_SHIFT) & 0x700) | opcode;
+
+	if(qspi->is_dual)
+		lcfg |= QSPI_LCFG_TWO_MEM_MASK | QSPI_LCFG_SEP_BUS_MASK;
+
+	qspi->pRegs->ENABLE = ~QSPI_ENABLE_ENABLE_MASK;
+	qspi->pRegs->CONFIG &= ~(QSPI_CONFIG_MANSRTEN_MASK | QSPI_CONFIG_PCS_MASK);
+	qspi->pRegs->LINEAR_CFG = lcfg;
+	qspi->pRegs->ENABLE = QSPI_ENABLE_ENABLE_MASK;
+}
+
+static void qspi_leave_linear(BT_HANDLE qspi)
+{
+	qspi->pRegs->ENABLE = ~QSPI_ENABLE_ENABLE_MASK;
+	qspi->pRegs->LINEAR_CFG &= ~QSPI_LCFG_ENABLE_MASK;
+	qspi->pRegs->CONFIG |= (QSPI_CONFIG_MANSRTEN_MASK | QSPI_CONFIG_PCS_MASK | QSPI_CONFIG_SSCTRL_MASK);
+	qspi->pRegs->ENABLE = QSPI_ENABLE_ENABLE_MASK;
+}
+
+static void qspi_dma_complete(void *pContext, BT_ERROR Status)
+{
+	BT_HANDLE hQspi = (BT_HANDLE) pContext;
+	BT_SPI_MESSAGE *message = hQspi->dma_message;
+	BT_SPI_TRANSFER *transfer;
+	BT_u32 i;
+
+	qspi_leave_linear(hQspi);
+
+	message->actual_length = hQspi->dma_cmd_len;
+	for(i = 0; i < hQspi->dma_segment_count; i++) {
+		message->actual_length += hQspi->dma_segments[i].len;
+	}
+
+	bt_list_for_each_entry(transfer, &message->transfers, transfer_list) {
+		if(transfer->rx_buf) {
+			BT_DCacheInvalidateRange(transfer->rx_buf, transfer->len);
+		}
+	}
+
+	hQspi->dma_message = NULL;
+	hQspi->dev_busy = 0;
+
+	message->status = Status;
+	message->complete(message->context);
+}
+
+/*
+ * Accepts messages of the form: [read opcode + 3 address bytes (+ dummy)] [rx] ([rx] ...)
+ * and chains all rx transfers into a single DMA program.
+ */
+static BT_s32 qspi_transfer_dma(BT_HANDLE hQspi, BT_SPI_MESSAGE *message) {
+	BT_SPI_TRANSFER *transfer;
+	BT_ERROR Error;
+	BT_u32 offset, dummy, n = 0;
+	const BT_u8 *cmd;
+
+	if(!hQspi->hDma) {
+		hQspi->hDma = BT_DmaGetController(0);
+		if(!hQspi->hDma) {
+			return BT_ERR_UNSUPPORTED_FLAG;
+		}
+
+		hQspi->dma_channel = BT_DmaRequestChannel(hQspi->hDma, &Error);
+		if(hQspi->dma_channel < 0) {
+			hQspi->hDma = NULL;
+			return BT_ERR_UNSUPPORTED_FLAG;
+		}
+	}
+
+	if(bt_list_empty(&message->transfers)) {
+		return BT_ERR_UNSUPPORTED_FLAG;
+	}
+
+	transfer = bt_list_first_entry(&message->transfers, BT_SPI_TRANSFER, transfer_list);
+	cmd = transfer->tx_buf;
+	if(!cmd || transfer->rx_buf || transfer->len < 4 || transfer->len > 5) {
+		return BT_ERR_UNSUPPORTED_FLAG;
+	}
+
+	switch(cmd[0]) {
+	case QSPI_FLASH_OPCODE_NORM_READ:
+	case QSPI_FLASH_OPCODE_FAST_READ:
+	case QSPI_FLASH_OPCODE_DUAL_READ:
+	case QSPI_FLASH_OPCODE_QUAD_READ:
+		break;
+
+	default:
+		return BT_ERR_UNSUPPORTED_FLAG;
+	}
+
+	dummy = transfer->len - 4;
+	offset = (cmd[1] << 16) | (cmd[2] << 8) | cmd[3];
+	if(hQspi->is_dual)
+		offset <<= 1;
+
+	hQspi->dma_cmd_len = transfer->len;
+
+	bt_list_for_each_entry_continue(transfer, &message->transfers, transfer_list) {
+		if(transfer->tx_buf || !transfer->rx_buf || n == QSPI_DMA_MAX_SEGMENTS) {
+			return BT_ERR_UNSUPPORTED_FLAG;
+		}
+
+		hQspi->dma_segments[n].src 		= ZYNQ_QSPI_LINEAR_BASE + offset;
+		hQspi->dma_segments[n].dst 		= bt_virt_to_phys(transfer->rx_buf);
+		hQspi->dma_segments[n].len 		= transfer->len;
+		hQspi->dma_segments[n].flags 	= 0;
+
+		BT_DCacheFlushRange(transfer->rx_buf, transfer->len);
+
+		offset += transfer->len;
+		n++;
+	}
+
+	if(!n) {
+		return BT_ERR_UNSUPPORTED_FLAG;
+	}
+
+	hQspi->dma_segment_count = n;
+	hQspi->dma_message = message;
+	hQspi->dev_busy = 1;
+
+	message->actual_length = 0;
+
+	qspi_enter_linear(hQspi, cmd[0], dummy);
+
+	Error = BT_DmaSubmit(hQspi->hDma, hQspi->dma_channel, hQspi->dma_segments, n, qspi_dma_complete, hQspi);
+	if(Error) {
+		qspi_leave_linear(hQspi);
+		hQspi->dma_message = NULL;
+		hQspi->dev_busy = 0;
+		return BT_ERR_UNSUPPORTED_FLAG;
+	}
+
+	return BT_ERR_NONE;
+}
+#endif
+
 #if	(QSPI_USE_WORKQUEUE)
 static inline int qspi_start_queue(BT_HANDLE hQspi)
 {
@@ -789,6 +949,9 @@ static inline int qspi_destroy_queue(BT_HANDLE hQspi)
 static const BT_DEV_IF_SPI oSPIInterface = {
 	.pfnTransfer		= qspi_transfer,
 	.pfnSetup			= qspi_setup,
+#ifdef BT_CONFIG_MACH_ZYNQ_QSPI_DMA
+	.pfnTransferDma		= qspi_transfer_dma,
+#endif
 };
 
 static const BT_IF_DEVICE oDeviceInterface = {
@@ -942,6 +1105,11 @@ static BT_HANDLE qspi_probe(const BT_INTEGRATED_DEVICE *pDevice, BT_ERROR *pErro
 	hQSPI->speed_hz = InputClk / 2;
 	hQSPI->dev_busy = 0;
 
+#ifdef BT_CONFIG_MACH_ZYNQ_QSPI_DMA
+	hQSPI->spi_master.dma_alignment = 32;	// Cache line, the receive buffers are invalidated after DMA.
+	hQSPI->spi_master.dma_threshold = BT_CONFIG_SPI_DMA_THRESHOLD;
+#endif
+
 #if	(QSPI_USE_WORKQUEUE)
 	BT_LIST_INIT_HEAD(&hQSPI->queue);
 
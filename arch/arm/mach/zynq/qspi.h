@@ -4,6 +4,7 @@
 #include <bitthunder.h>
 
 #define ZYNQ_QSPI_CONTROLLER_BASE		0xE000D000
+#define ZYNQ_QSPI_LINEAR_BASE			0xFC000000		/* Linear (memory mapped) flash aperture */
 
 typedef struct _ZYNQ_QSPI_REGS {
 	BT_u32 CONFIG;						/* Configuration  Register, RW */
@@ -14,6 +15,8 @@ typedef struct _ZYNQ_QSPI_REGS {
 	 * of the QSPI controller
 	 */
 	#define QSPI_CONFIG_MANSRT_MASK      0x00010000 /* Manual TX Start */
+	#define QSPI_CONFIG_MANSRTEN_MASK    0x00008000 /* Manual Start Enable */
+	#define QSPI_CONFIG_PCS_MASK         0x00004000 /* Manual Chip Select */
 	#define QSPI_CONFIG_CPHA_MASK        0x00000004 /* Clock Phase Control */
 	#define QSPI_CONFIG_CPOL_MASK        0x00000002 /* Clock Polarity Control */
 	#define QSPI_CONFIG_SSCTRL_MASK      0x00003C00 /* Slave Select Mask */
@@ -70,6 +73,7 @@ typedef struct _ZYNQ_QSPI_REGS {
 	 * It is named Linear Configuration but it controls other modes when not in
 	 * linear mode also.
 	 */
+	#define QSPI_LCFG_ENABLE_MASK        0x80000000 /* LQSPI Linear mode enable */
 	#define QSPI_LCFG_TWO_MEM_MASK       0x40000000 /* LQSPI Two memories Mask */
 	#define QSPI_LCFG_SEP_BUS_MASK       0x20000000 /* LQSPI Separate bus Mask */
 	#define QSPI_LCFG_U_PAGE_MASK        0x10000000 /* LQSPI Upper Page Mask */
@@ -439,6 +439,43 @@ static BT_ERROR uart_flush(BT_HANDLE hUart) {
 	return BT_ERR_NONE;
 }
 
+#ifdef BT_CONFIG_POLL
+/*
+ *	Only the buffered mode signals readiness changes (through its FIFOs), the other
+ *	modes just report the current state.
+ */
+static BT_u32 uart_poll(BT_HANDLE hUart, struct bt_poll_table *pTable) {
+
+	BT_u32 ulEvents = 0;
+	volatile ZYNQ_UART_REGS *pRegs = hUart->pRegs;
+
+	switch(hUart->eMode) {
+	case BT_UART_MODE_BUFFERED:
+		ulEvents |= BT_FifoPoll(hUart->hRxFifo, pTable) & BT_POLLIN;
+		ulEvents |= BT_FifoPoll(hUart->hTxFifo, pTable) & BT_POLLOUT;
+		break;
+
+	case BT_UART_MODE_SIMPLE_BUFFERED:
+		if(hUart->uRxBegin != hUart->uRxEnd) {
+			ulEvents |= BT_POLLIN;
+		}
+		ulEvents |= BT_POLLOUT;
+		break;
+
+	default:
+		if(!(pRegs->SR & ZYNQ_UART_SR_RXEMPTY)) {
+			ulEvents |= BT_POLLIN;
+		}
+		if(!(pRegs->SR & ZYNQ_UART_SR_TXFULL)) {
+			ulEvents |= BT_POLLOUT;
+		}
+		break;
+	}
+
+	return ulEvents;
+}
+#endif
+
 static BT_ERROR uart_enable(BT_HANDLE hUart) {
 
 	BT_DisableInterrupt(hUart->ulIRQ);
@@ -699,6 +736,9 @@ static const BT_IF_FILE oFileInterface = {
 	.pfnRead = uart_read,
 	.pfnWrite = uart_write,
 	.pfnFlush = uart_flush,
+#ifdef BT_CONFIG_POLL
+	.pfnPoll = uart_poll,
+#endif
 	.ulSupported = BT_FILE_NON_BLOCK,
 };
 
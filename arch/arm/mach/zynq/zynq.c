@@ -17,6 +17,7 @@
 #include "uart.h"
 #include "gpio.h"
 #include "qspi.h"
+#include "dmac.h"
 
 #ifdef BT_CONFIG_MACH_ZYNQ_GPIO
 static const BT_RESOURCE oZynq_gpio_resources[] = {
@@ -191,6 +192,42 @@ BT_DEVFS_INODE_DEF oZynq_i2c1_inode = {
 #endif
 
 #ifndef BT_CONFIG_OF
+#ifdef BT_CONFIG_MACH_ZYNQ_DMAC
+static const BT_RESOURCE oZynq_dmac_resources[] = {
+	{
+		.ulStart			= ZYNQ_DMAC_S_BASE,
+		.ulEnd				= ZYNQ_DMAC_S_BASE + BT_SIZE_4K - 1,
+		.ulFlags			= BT_RESOURCE_MEM,
+	},
+	{
+		.ulStart			= 0,			// DMA controller ID
+		.ulEnd				= 0,
+		.ulFlags			= BT_RESOURCE_ENUM,
+	},
+	{
+		.ulStart			= 46,			// Channel 0-3 events.
+		.ulEnd				= 49,
+		.ulFlags			= BT_RESOURCE_IRQ,
+	},
+	{
+		.ulStart			= 72,			// Channel 4-7 events.
+		.ulEnd				= 75,
+		.ulFlags			= BT_RESOURCE_IRQ,
+	},
+	{
+		.ulStart			= 45,			// Abort.
+		.ulEnd				= 45,
+		.ulFlags			= BT_RESOURCE_IRQ,
+	},
+};
+
+BT_INTEGRATED_DEVICE_DEF oZynq_dmac_device = {
+	.name					= "arm,pl330",
+	.ulTotalResources		= BT_ARRAY_SIZE(oZynq_dmac_resources),
+	.pResources				= oZynq_dmac_resources,
+};
+#endif
+
 #ifdef BT_CONFIG_MACH_ZYNQ_QSPI
 static const BT_RESOURCE oZynq_qspi_resources[] = {
 	{
@@ -300,15 +337,18 @@ static BT_ERROR zynq_boot_core(BT_u32 ulCoreID, void *address, bt_register_t a,
 	zero[3] = c;
 	zero[4] = d;
 
-	BT_DCacheFlush();
-	BT_DCacheDisable();
+	BT_DCacheFlush();		// The core starts with its caches off, and must see the trampoline and its image.
 
 	//bt_iounmap(zero);
 
 	zynq_slcr_cpu_stop(ulCoreID);
 	zynq_slcr_cpu_start(ulCoreID);
 
+	/*
+	 *	The core signals the jump with an uncached store, drop our stale copy each time.
+	 */
 	while(1) {
+		BT_DCacheInvalidateLine((void *) zero);
 		if(zero[0] != (BT_u32) address) {
 			break;
 		}
@@ -70,6 +70,8 @@ $(BUILD_DIR)/arch/arm/mm/v7-mmu.o: CFLAGS_REMOVE += -mthumb
 #	Boot-Up
 #
 BT_ARCH_ARM_OBJECTS-$(BT_CONFIG_ARCH_ARM_BOOT)		+= $(BUILD_DIR)/arch/arm/boot/head.o
+BT_ARCH_ARM_OBJECTS-$(BT_CONFIG_SMP)				+= $(BUILD_DIR)/arch/arm/boot/headsmp.o
+BT_ARCH_ARM_OBJECTS-$(BT_CONFIG_AMP)				+= $(BUILD_DIR)/arch/arm/boot/headsmp.o
 BT_ARCH_ARM_OBJECTS-$(BT_CONFIG_ARCH_ARM_BOOT)		+= $(BUILD_DIR)/arch/arm/common/crtinit.o
 BT_ARCH_ARM_OBJECTS-$(BT_CONFIG_ARCH_ARM_BOOT)		+= $(BUILD_DIR)/arch/arm/common/cpuinit.o
 
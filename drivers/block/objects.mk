@@ -1,4 +1,5 @@
 BLOCK_OBJECTS-$(BT_CONFIG_DRIVERS_BLOCK_RAMDISK) += $(BUILD_DIR)/drivers/block/ramdisk.o
+BLOCK_OBJECTS-$(BT_CONFIG_DRIVERS_BLOCK_RAMDISK_LINKED_IMAGE) += $(BUILD_DIR)/drivers/block/ramdisk_image.o
 
 
 BLOCK_OBJECTS += $(BLOCK_OBJECTS-y)
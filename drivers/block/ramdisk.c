@@ -6,30 +6,79 @@ BT_DEF_MODULE_DESCRIPTION	("Simple ram based block disk")
 BT_DEF_MODULE_AUTHOR		("James Walmsley")
 BT_DEF_MODULE_EMAIL			("james@fullfat-fs.co.uk")
 
+/*
+ *	The backing store of a ramdisk is taken from (in order of preference):
+ *
+ *	BT_RESOURCE_MEM 0		A boot-time memory region (physical), e.g. an image placed by the bootloader.
+ *	Linked image			The .bt.ramdisk section, when CONFIG_DRIVERS_BLOCK_RAMDISK_LINKED_IMAGE is set.
+ *	BT_RESOURCE_STRING 0	An image file, loaded into a newly allocated buffer.
+ *
+ *	The first two are used in place, without copying. Blocks can be mapped directly
+ *	through BT_BlockMap().
+ */
 
 struct _BT_OPAQUE_HANDLE {
-	BT_HANDLE_HEADER h;
-	BT_BLKDEV_DESCRIPTOR oDescriptor;
-	void *buffer;
+	BT_HANDLE_HEADER 		h;
+	BT_BLKDEV_DESCRIPTOR 	oDescriptor;
+	BT_u8 				   *buffer;
+	BT_BOOL					bAllocated;
 };
 
-static BT_u32 ramdisk_blockread(BT_HANDLE hBlock, BT_u32 ulBlock, BT_u32 ulCount, void *pBuffer, BT_ERROR *pError) {
-	BT_u8 *p = (BT_u8 *) hBlock->buffer;
-	p += (hBlock->oDescriptor.oGeometry.ulBlockSize * ulBlock);
-	memcpy(pBuffer, p, hBlock->oDescriptor.oGeometry.ulBlockSize * ulCount);
+#ifdef BT_CONFIG_DRIVERS_BLOCK_RAMDISK_LINKED_IMAGE
+extern BT_u8 __bt_ramdisk_start;
+extern BT_u8 __bt_ramdisk_end;
+#endif
+
+static BT_BOOL ramdisk_in_range(BT_HANDLE hBlock, BT_u32 ulBlock, BT_u32 ulCount) {
+	BT_u32 ulTotal = hBlock->oDescriptor.oGeometry.ulTotalBlocks;
+	return (ulBlock < ulTotal && ulCount <= ulTotal - ulBlock);
+}
+
+static BT_s32 ramdisk_blockread(BT_HANDLE hBlock, BT_u32 ulBlock, BT_u32 ulCount, void *pBuffer) {
+	BT_u32 ulBlockSize = hBlock->oDescriptor.oGeometry.ulBlockSize;
+
+	if(!ramdisk_in_range(hBlock, ulBlock, ulCount)) {
+		return BT_ERR_INVALID_VALUE;
+	}
+
+	memcpy(pBuffer, hBlock->buffer + (ulBlockSize * ulBlock), ulBlockSize * ulCount);
 	return ulCount;
 }
 
-static BT_u32 ramdisk_blockwrite(BT_HANDLE hBlock, BT_u32 ulBlock, BT_u32 ulCount, void *pBuffer, BT_ERROR *pError) {
-	BT_u8 *p = (BT_u8 *) hBlock->buffer;
-	p += (hBlock->oDescriptor.oGeometry.ulBlockSize * ulBlock);
-	memcpy(hBlock->buffer, pBuffer, hBlock->oDescriptor.oGeometry.ulBlockSize * ulCount);
+static BT_s32 ramdisk_blockwrite(BT_HANDLE hBlock, BT_u32 ulBlock, BT_u32 ulCount, void *pBuffer) {
+	BT_u32 ulBlockSize = hBlock->oDescriptor.oGeometry.ulBlockSize;
+
+	if(!ramdisk_in_range(hBlock, ulBlock, ulCount)) {
+		return BT_ERR_INVALID_VALUE;
+	}
+
+	memcpy(hBlock->buffer + (ulBlockSize * ulBlock), pBuffer, ulBlockSize * ulCount);
 	return ulCount;
 }
 
+static void *ramdisk_blockmap(BT_HANDLE hBlock, BT_u32 ulBlock, BT_u32 ulCount, BT_ERROR *pError) {
+	if(!ramdisk_in_range(hBlock, ulBlock, ulCount)) {
+		if(pError) {
+			*pError = BT_ERR_INVALID_VALUE;
+		}
+		return NULL;
+	}
+
+	return hBlock->buffer + (hBlock->oDescriptor.oGeometry.ulBlockSize * ulBlock);
+}
+
+static BT_ERROR ramdisk_cleanup(BT_HANDLE hBlock) {
+	if(hBlock->bAllocated) {
+		BT_kFree(hBlock->buffer);
+	}
+
+	return BT_ERR_NONE;
+}
+
 static const BT_IF_BLOCK ramdisk_blockdev_interface = {
-	ramdisk_blockread,
-	ramdisk_blockwrite,
+	.pfnReadBlocks 	= ramdisk_blockread,
+	.pfnWriteBlocks = ramdisk_blockwrite,
+	.pfnMapBlocks 	= ramdisk_blockmap,
 };
 
 static const BT_IF_DEVICE oDeviceInterface = {
@@ -42,33 +91,109 @@ static const BT_IF_HANDLE oHandleInterface = {
 	.oIfs = {
 		.pDevIF = &oDeviceInterface,
 	},
+	.pfnCleanup = ramdisk_cleanup,
 };
 
 static BT_HANDLE ramdisk_probe(const BT_DEVICE *pDevice, BT_ERROR *pError) {
+
+	BT_ERROR Error = BT_ERR_NONE;
+	BT_u32 ulSize = 0;
+	BT_i8 name[8];
+
 	BT_HANDLE hBlock = BT_CreateHandle(&oHandleInterface, sizeof(struct _BT_OPAQUE_HANDLE), pError);
+	if(!hBlock) {
+		return NULL;
+	}
 
 	const BT_RESOURCE *pResource = BT_GetIntegratedResource(pDevice, BT_RESOURCE_INTEGER, 0);
+	if(!pResource || !pResource->ulStart) {
+		Error = BT_ERR_INVALID_RESOURCE;
+		goto err_free_out;
+	}
+
 	hBlock->oDescriptor.oGeometry.ulBlockSize = pResource->ulStart;
 
 	pResource = BT_GetIntegratedResource(pDevice, BT_RESOURCE_INTEGER, 1);
-	hBlock->oDescriptor.oGeometry.ulTotalBlocks = pResource->ulStart;
+	if(pResource) {
+		ulSize = hBlock->oDescriptor.oGeometry.ulBlockSize * pResource->ulStart;
+	}
+
+	pResource = BT_GetIntegratedResource(pDevice, BT_RESOURCE_MEM, 0);
+	if(pResource) {
+		// Boot-time memory region, keep it out of the page allocator and use it in place.
+		BT_u32 ulRegion = pResource->ulEnd - pResource->ulStart + 1;
+		if(!ulSize || ulSize > ulRegion) {
+			ulSize = ulRegion;
+		}
+
+		bt_page_reserve(pResource->ulStart, ulSize);
+		hBlock->buffer = (BT_u8 *) bt_phys_to_virt(pResource->ulStart);
+		goto geometry;
+	}
 
-	hBlock->buffer = BT_kMalloc(hBlock->oDescriptor.oGeometry.ulBlockSize * hBlock->oDescriptor.oGeometry.ulTotalBlocks);
+#ifdef BT_CONFIG_DRIVERS_BLOCK_RAMDISK_LINKED_IMAGE
+	BT_u32 ulLinked = (BT_u32) (&__bt_ramdisk_end - &__bt_ramdisk_start);
+	if(ulLinked) {
+		if(!ulSize || ulSize > ulLinked) {
+			ulSize = ulLinked;
+		}
+
+		hBlock->buffer = &__bt_ramdisk_start;
+		goto geometry;
+	}
+#endif
+
+	if(!ulSize) {
+		Error = BT_ERR_INVALID_RESOURCE;
+		goto err_free_out;
+	}
+
+	hBlock->buffer = BT_kMalloc(ulSize);
+	if(!hBlock->buffer) {
+		Error = BT_ERR_NO_MEMORY;
+		goto err_free_out;
+	}
+
+	hBlock->bAllocated = BT_TRUE;
 
 	pResource = BT_GetIntegratedResource(pDevice, BT_RESOURCE_STRING, 0);
 	if(pResource) {
 		const BT_i8 *image = pResource->szpName;
-		BT_HANDLE h = BT_Open(image, BT_GetModeFlags("rb"), NULL);
-		BT_Read(h, 0, hBlock->oDescriptor.oGeometry.ulBlockSize * hBlock->oDescriptor.oGeometry.ulTotalBlocks, hBlock->buffer, NULL);
-		BT_CloseHandle(h);
+		BT_s32 slRead = 0;
+		BT_HANDLE h = BT_Open(image, BT_GetModeFlags("rb"), &Error);
+		if(h) {
+			slRead = BT_Read(h, 0, ulSize, hBlock->buffer);
+			BT_CloseHandle(h);
+		}
+
+		if(slRead < 0) {
+			slRead = 0;
+		}
+
+		memset(hBlock->buffer + slRead, 0, ulSize - slRead);
 
 	} else {
-		memset(hBlock->buffer, 0, hBlock->oDescriptor.oGeometry.ulBlockSize * hBlock->oDescriptor.oGeometry.ulTotalBlocks);
+		memset(hBlock->buffer, 0, ulSize);
 	}
 
-	BT_RegisterBlockDevice(hBlock, "rd0", &hBlock->oDescriptor);
+geometry:
+	hBlock->oDescriptor.oGeometry.ulTotalBlocks = ulSize / hBlock->oDescriptor.oGeometry.ulBlockSize;
+
+	pResource = BT_GetIntegratedResource(pDevice, BT_RESOURCE_ENUM, 0);
+	bt_sprintf(name, "rd%d", pResource ? pResource->ulStart : 0);
+
+	BT_RegisterBlockDevice(hBlock, name, &hBlock->oDescriptor);
 
 	return hBlock;
+
+err_free_out:
+	BT_DestroyHandle(hBlock);
+
+	if(pError) {
+		*pError = Error;
+	}
+
+	return NULL;
 }
 
 BT_INTEGRATED_DRIVER_DEF ramdisk_driver = {
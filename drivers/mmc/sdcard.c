@@ -59,7 +59,11 @@ static void card_event_handler(MMC_HOST *pHost, BT_MMC_CARD_EVENT eEvent, BT_BOO
 		break;
 	}
 
-	BT_TaskletSchedule(&sm_tasklet);
+	if(bInterruptContext) {
+		BT_TaskletScheduleFromISR(&sm_tasklet);
+	} else {
+		BT_TaskletSchedule(&sm_tasklet);
+	}
 }
 
 BT_ERROR BT_RegisterSDHostController(BT_HANDLE hHost, const BT_MMC_OPS *pOps) {
@@ -304,6 +308,7 @@ static void sd_manager_sm(void *pData) {
 				
 				BT_u32 ulBlocks = 0;
 				BT_u32 ulBlockSize = 512;
+				BT_u32 ulEraseBytes = 0;
 				BT_u32 csdversion = 0;
 				
 				csdversion = (oCommand.response[3] >> 22) & 0x3;
@@ -312,11 +317,13 @@ static void sd_manager_sm(void *pData) {
 					tCSD1_x *CSD = (tCSD1_x*)oCommand.response;
 					ulBlockSize  = ((BT_u32)0x01 << (CSD->Read_BL_Len));
 					ulBlocks     = CSD->C_Size * ((BT_u32)0x01 << (CSD->C_Size_Mult + 2));
+					ulEraseBytes = (CSD->Sector_Size + 1) << CSD->Write_BL_Len;
 				}
 				else if (csdversion == 1) {
 					tCSD2_x *CSD = (tCSD2_x*)oCommand.response;
 					ulBlockSize  = ((BT_u32)0x01 << (CSD->Read_BL_Len));
 					ulBlocks     = CSD->C_Size * 1024;
+					ulEraseBytes = (CSD->Sector_Size + 1) << CSD->Write_BL_Len;
 				}
 				else {
 					BT_kDebug("SDCARD: Unrecognised CSD register structure version.");
@@ -414,6 +421,7 @@ static void sd_manager_sm(void *pData) {
 
 				hSD->oDescriptor.oGeometry.ulBlockSize = ulBlockSize;
 				hSD->oDescriptor.oGeometry.ulTotalBlocks = ulBlocks;
+				hSD->oDescriptor.oGeometry.ulEraseBlocks = ulEraseBytes / ulBlockSize;
 
 
 				char buffer[10];
@@ -730,7 +738,7 @@ static const BT_IF_HANDLE oHandleInterface = {
 	},
 };
 
-static BT_TASKLET sm_tasklet = {NULL, BT_TASKLET_IDLE, sd_manager_sm, NULL};
+static BT_TASKLET sm_tasklet = BT_TASKLET_INIT(sd_manager_sm, NULL);
 
 static BT_ERROR bt_sdcard_manager_init() {
 
@@ -1 +1,8 @@
+NETDEV_OBJECTS-$(BT_CONFIG_DRIVERS_NET_REFLECTOR) += $(BUILD_DIR)/drivers/net/reflector.o
+NETDEV_OBJECTS += $(NETDEV_OBJECTS-y)
+
+$(NETDEV_OBJECTS): MODULE_NAME="drivers-net"
+
+OBJECTS += $(NETDEV_OBJECTS)
+
 include $(BASE)/drivers/net/phy/objects.mk
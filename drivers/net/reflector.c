@@ -0,0 +1,306 @@
+/**
+ *	Frame reflector, a virtual ethernet MAC for benchmarking the network stack.
+ *
+ *	Every frame sent on the interface comes straight back to it, with the ethernet
+ *	and IPv4 source and destination addresses exchanged, and ARP requests are answered
+ *	on behalf of the peer. A connection to any other address on the interface's subnet
+ *	therefore arrives back at the stack as a connection from that address, so both ends
+ *	of a TCP or UDP flow run through the netif glue and the zero-copy frame interface
+ *	with no hardware in the way.
+ *
+ *	Transmitted frames are copied once into a posted receive buffer (the wire) and are
+ *	reclaimable as soon as pfnTxFrame returns. Checksums are neither generated nor
+ *	verified, as with full offload on a real MAC.
+ *
+ *	This stands in for a pair of MACs connected back to back. Both ends of a flow share
+ *	one stack, one tcpip thread and one CPU here, so the figures measure the target's
+ *	stack as a whole rather than one end of a link. The host harness in os/src/net/test
+ *	runs a real pair, one stack per process.
+ **/
+#include <bitthunder.h>
+#include <string.h>
+
+BT_DEF_MODULE_NAME					("reflector")
+BT_DEF_MODULE_DESCRIPTION			("Frame reflecting loopback ethernet interface")
+
+#define REFLECTOR_RX_SLOTS			64
+#define REFLECTOR_TX_SLOTS			64
+#define REFLECTOR_FRAME_SIZE		1536
+
+#define ETH_HLEN					14
+#define ETH_ALEN					6
+#define ETH_P_IP					0x0800
+#define ETH_P_ARP					0x0806
+#define ARP_REQUEST					1
+#define ARP_REPLY					2
+
+#define REFLECTOR_CAPABILITIES_CHECKSUM	(BT_NET_IF_CAPABILITIES_TX_CSUM_IP | BT_NET_IF_CAPABILITIES_TX_CSUM_TCP | \
+										 BT_NET_IF_CAPABILITIES_TX_CSUM_UDP | BT_NET_IF_CAPABILITIES_RX_CSUM_IP | \
+										 BT_NET_IF_CAPABILITIES_RX_CSUM_TCP | BT_NET_IF_CAPABILITIES_RX_CSUM_UDP)
+
+static const BT_u8 g_local_addr[ETH_ALEN] = { 0x02, 0x00, 0x00, 0xbe, 0xef, 0x01 };
+static const BT_u8 g_peer_addr[ETH_ALEN] = { 0x02, 0x00, 0x00, 0xbe, 0xef, 0x02 };
+
+struct _BT_OPAQUE_HANDLE {
+	BT_HANDLE_HEADER 				h;
+	BT_NET_IF					   *pIf;
+	BT_NET_IF_EVENTRECEIVER			pfnEvent;
+	BT_u8							addr[ETH_ALEN];
+	BT_NET_BUFFER					rx[REFLECTOR_RX_SLOTS];
+	BT_u32							rx_post;		// Free-running indices, rx_take <= rx_fill <= rx_post.
+	BT_u32							rx_fill;
+	BT_u32							rx_take;
+	BT_BOOL							rx_masked;
+	void						   *tx[REFLECTOR_TX_SLOTS];
+	BT_u32							tx_head;
+	BT_u32							tx_tail;
+	BT_BOOL							tx_stalled;
+};
+
+static BT_u16 get_be16(const BT_u8 *p) {
+	return (p[0] << 8) | p[1];
+}
+
+static void swap_bytes(BT_u8 *a, BT_u8 *b, BT_u32 ulLength) {
+	while(ulLength--) {
+		BT_u8 t = *a;
+		*a++ = *b;
+		*b++ = t;
+	}
+}
+
+/*
+ *	Turns a transmitted frame into the one the peer would send back, returns BT_FALSE
+ *	for frames that get no answer (broadcasts other than ARP requests, other protocols).
+ */
+static BT_BOOL reflect_frame(BT_u8 *frame, BT_u32 ulLength) {
+	if(ulLength < ETH_HLEN) {
+		return BT_FALSE;
+	}
+
+	BT_u8 *payload = frame + ETH_HLEN;
+
+	switch(get_be16(frame + 12)) {
+	case ETH_P_ARP: {
+		// Ethernet/IPv4 ARP: op at 6, sender hw/ip at 8/14, target hw/ip at 18/24.
+		if(ulLength < ETH_HLEN + 28 || get_be16(payload + 6) != ARP_REQUEST) {
+			return BT_FALSE;
+		}
+
+		if(!memcmp(payload + 14, payload + 24, 4)) {
+			return BT_FALSE;	// Gratuitous ARP.
+		}
+
+		payload[7] = ARP_REPLY;
+		memcpy(payload + 18, payload + 8, ETH_ALEN);
+		memcpy(payload + 8, g_peer_addr, ETH_ALEN);
+		swap_bytes(payload + 14, payload + 24, 4);
+
+		memcpy(frame, frame + ETH_ALEN, ETH_ALEN);
+		memcpy(frame + ETH_ALEN, g_peer_addr, ETH_ALEN);
+		return BT_TRUE;
+	}
+
+	case ETH_P_IP:
+		if(ulLength < ETH_HLEN + 20 || (frame[0] & 0x01)) {
+			return BT_FALSE;
+		}
+
+		// The checksums cover both addresses symmetrically, so remain valid.
+		swap_bytes(frame, frame + ETH_ALEN, ETH_ALEN);
+		swap_bytes(payload + 12, payload + 16, 4);
+		return BT_TRUE;
+
+	default:
+		return BT_FALSE;
+	}
+}
+
+static BT_ERROR mac_cleanup(BT_HANDLE hMac) {
+	return BT_ERR_NONE;
+}
+
+static BT_ERROR mac_eventsubscribe(BT_HANDLE hMac, BT_NET_IF_EVENTRECEIVER pfnReceiver, BT_NET_IF *pIf) {
+	hMac->pIf = pIf;
+	hMac->pfnEvent = pfnReceiver;
+	return BT_ERR_NONE;
+}
+
+static BT_ERROR mac_init(BT_HANDLE hMac) {
+	return BT_ERR_NONE;
+}
+
+static BT_ERROR mac_getaddr(BT_HANDLE hMac, BT_u8 *addr, BT_u32 ulLength) {
+	memcpy(addr, hMac->addr, ETH_ALEN);
+	return BT_ERR_NONE;
+}
+
+static BT_ERROR mac_setaddr(BT_HANDLE hMac, const BT_u8 *addr, BT_u32 ulLength) {
+	memcpy(hMac->addr, addr, ETH_ALEN);
+	return BT_ERR_NONE;
+}
+
+static BT_u32 mac_getmtusize(BT_HANDLE hMac, BT_ERROR *pError) {
+	return REFLECTOR_FRAME_SIZE;
+}
+
+static BT_BOOL mac_tx_ready(BT_HANDLE hMac, BT_ERROR *pError) {
+	if(hMac->tx_head - hMac->tx_tail == REFLECTOR_TX_SLOTS) {
+		hMac->tx_stalled = BT_TRUE;
+		return BT_FALSE;
+	}
+
+	return BT_TRUE;
+}
+
+static BT_ERROR mac_rx_post(BT_HANDLE hMac, const BT_NET_BUFFER *pBuffer) {
+	if(hMac->rx_post - hMac->rx_take == REFLECTOR_RX_SLOTS) {
+		return BT_ERR_GENERIC;
+	}
+
+	hMac->rx[hMac->rx_post++ % REFLECTOR_RX_SLOTS] = *pBuffer;
+
+	return BT_ERR_NONE;
+}
+
+static void *mac_rx_frame(BT_HANDLE hMac, BT_u32 *pulLength, BT_ERROR *pError) {
+	if(hMac->rx_take == hMac->rx_fill) {
+		return NULL;
+	}
+
+	BT_NET_BUFFER *pSlot = &hMac->rx[hMac->rx_take++ % REFLECTOR_RX_SLOTS];
+	*pulLength = pSlot->ulLength;
+
+	return pSlot->pBuffer;
+}
+
+static BT_ERROR mac_tx_frame(BT_HANDLE hMac, const BT_NET_BUFFER *pSegments, BT_u32 ulSegments, void *pBuffer) {
+	BT_u32 i;
+
+	if(!mac_tx_ready(hMac, NULL)) {
+		return BT_ERR_GENERIC;
+	}
+
+	hMac->tx[hMac->tx_head++ % REFLECTOR_TX_SLOTS] = pBuffer;
+
+	if(hMac->rx_fill == hMac->rx_post) {
+		hMac->pfnEvent(hMac->pIf, BT_NET_IF_RX_DROPPED, BT_FALSE);
+		return BT_ERR_NONE;
+	}
+
+	BT_NET_BUFFER *pSlot = &hMac->rx[hMac->rx_fill % REFLECTOR_RX_SLOTS];
+	BT_u8 *frame = pSlot->pData;
+	BT_u32 ulLength = 0;
+
+	for(i = 0; i < ulSegments; i++) {
+		if(ulLength + pSegments[i].ulLength > pSlot->ulLength) {
+			return BT_ERR_NONE;		// Oversized, lost on the wire.
+		}
+		memcpy(frame + ulLength, pSegments[i].pData, pSegments[i].ulLength);
+		ulLength += pSegments[i].ulLength;
+	}
+
+	if(!reflect_frame(frame, ulLength)) {
+		return BT_ERR_NONE;
+	}
+
+	pSlot->ulLength = ulLength;
+	hMac->rx_fill++;
+
+	if(!hMac->rx_masked) {
+		hMac->rx_masked = BT_TRUE;
+		hMac->pfnEvent(hMac->pIf, BT_NET_IF_RX_READY, BT_FALSE);
+	}
+
+	return BT_ERR_NONE;
+}
+
+static BT_u32 mac_tx_reclaim(BT_HANDLE hMac, void **ppBuffers, BT_u32 ulMax) {
+	BT_u32 n = 0;
+
+	while(n < ulMax && hMac->tx_tail != hMac->tx_head) {
+		ppBuffers[n++] = hMac->tx[hMac->tx_tail++ % REFLECTOR_TX_SLOTS];
+	}
+
+	if(n && hMac->tx_stalled) {
+		hMac->tx_stalled = BT_FALSE;
+		hMac->pfnEvent(hMac->pIf, BT_NET_IF_TX_COMPLETE, BT_FALSE);
+	}
+
+	return n;
+}
+
+static BT_ERROR mac_rx_interrupt(BT_HANDLE hMac, BT_BOOL bEnable) {
+	hMac->rx_masked = !bEnable;
+	return BT_ERR_NONE;
+}
+
+static BT_ERROR mac_send_event(BT_HANDLE hMac, BT_u32 ulEvent) {
+	return BT_ERR_NONE;
+}
+
+static const BT_DEV_IF_EMAC mac_ops = {
+	.ulCapabilities 	= BT_NET_IF_CAPABILITIES_ETHERNET | BT_NET_IF_CAPABILITIES_1000MBPS | BT_NET_IF_CAPABILITIES_ZEROCOPY |
+						  BT_NET_IF_CAPABILITIES_SCATTER_GATHER | REFLECTOR_CAPABILITIES_CHECKSUM,
+	.pfnEventSubscribe 	= mac_eventsubscribe,
+	.pfnInitialise		= mac_init,
+	.pfnGetMACAddr		= mac_getaddr,
+	.pfnSetMACAddr		= mac_setaddr,
+	.pfnGetMTU			= mac_getmtusize,
+	.pfnTxFifoReady		= mac_tx_ready,
+	.pfnRxPostBuffer	= mac_rx_post,
+	.pfnRxFrame			= mac_rx_frame,
+	.pfnTxFrame			= mac_tx_frame,
+	.pfnTxReclaim		= mac_tx_reclaim,
+	.pfnSendEvent		= mac_send_event,
+	.pfnRxInterrupt		= mac_rx_interrupt,
+};
+
+static const BT_IF_DEVICE oDeviceIF = {
+	.eConfigType	= BT_DEV_IF_T_EMAC,
+	.unConfigIfs 	= {
+		.pEMacIF = &mac_ops,
+	},
+};
+
+static const BT_IF_HANDLE oHandleInterface = {
+	BT_MODULE_DEF_INFO_NO_AUTHOR,
+	.oIfs = {
+		.pDevIF = &oDeviceIF,
+	},
+	.eType = BT_HANDLE_T_DEVICE,
+	.pfnCleanup = mac_cleanup,
+};
+
+static BT_HANDLE reflector_probe(const BT_DEVICE *pDevice, BT_ERROR *pError) {
+
+	BT_ERROR Error;
+
+	BT_HANDLE hMac = BT_CreateHandle(&oHandleInterface, sizeof(struct _BT_OPAQUE_HANDLE), pError);
+	if(!hMac) {
+		return NULL;
+	}
+
+	memcpy(hMac->addr, g_local_addr, ETH_ALEN);
+
+	Error = BT_RegisterNetworkInterface(hMac);
+	if(Error) {
+		BT_DestroyHandle(hMac);
+		hMac = NULL;
+	}
+
+	if(pError) {
+		*pError = Error;
+	}
+
+	return hMac;
+}
+
+BT_INTEGRATED_DRIVER_DEF reflector_driver = {
+	.name = "net,reflector",
+	.pfnProbe = reflector_probe,
+};
+
+BT_INTEGRATED_DEVICE_DEF oReflector_device = {
+	.name				= "net,reflector",
+};
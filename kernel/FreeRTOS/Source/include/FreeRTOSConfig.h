@@ -105,6 +105,12 @@
 #define configGENERATE_RUN_TIME_STATS	0
 #define configUSE_TASK_NOTIFICATIONS	1
 
+#ifdef BT_CONFIG_KERNEL_TICKLESS_IDLE
+#define configUSE_TICKLESS_IDLE		1
+void bt_suppress_ticks_and_sleep(BT_u32 ulExpectedIdleTime);
+#define portSUPPRESS_TICKS_AND_SLEEP(xExpectedIdleTime)	bt_suppress_ticks_and_sleep(xExpectedIdleTime)
+#endif
+
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES 		0
 #define configMAX_CO_ROUTINE_PRIORITIES ( 2 )
@@ -4,6 +4,7 @@
 #include <queue.h>
 #include <semphr.h>
 #include <bt_kernel.h>
+#include <string.h>
 
 BT_ERROR BT_kStartScheduler() {
 	vTaskStartScheduler();
@@ -88,31 +89,201 @@ void BT_kSetThreadTag(void *pThreadID, void *pTagData) {
 	vTaskSetApplicationTaskTag((xTaskHandle) pThreadID, pTagData);
 }
 
-void *BT_kMutexCreate() {
-	xSemaphoreHandle m;
-	vSemaphoreCreateBinary(m);
+/*
+ *	Mutexes are FreeRTOS mutexes, so a thread blocking on one raises the priority of
+ *	the holder to its own until the mutex is released. They must be released by the
+ *	thread that holds them, and never from an ISR. Semaphores are binary semaphores,
+ *	for signalling between threads and from ISRs.
+ *
+ *	With BT_CONFIG_KERNEL_MUTEX_STATS every object is wrapped to count acquisitions
+ *	and record the longest time a thread blocked on each mutex. The counters are only
+ *	updated by the thread that has just taken the mutex, so need no locking of their
+ *	own.
+ */
+#ifdef BT_CONFIG_KERNEL_MUTEX_STATS
+
+#define BT_KMUTEX_RECURSIVE		0x00000001
+#define BT_KMUTEX_SEMAPHORE		0x00000002
+
+struct bt_kmutex {
+	xSemaphoreHandle		h;
+	BT_u32					ulFlags;
+	void				   *pCreator;
+	BT_u32					ulAcquired;
+	BT_u32					ulContended;
+	BT_u64					ullWorstBlocked;	///< In global timer counts.
+	struct bt_list_head		item;
+};
+
+static BT_LIST_HEAD(g_kmutexes);
+
+#define KMUTEX_HANDLE(p)	(((struct bt_kmutex *) (p))->h)
+
+static void *kmutex_wrap(xSemaphoreHandle h, BT_u32 ulFlags, void *pCreator) {
+	if(!h) {
+		return NULL;
+	}
+
+	struct bt_kmutex *m = BT_kMalloc(sizeof(*m));
+	if(!m) {
+		vSemaphoreDelete(h);
+		return NULL;
+	}
+
+	memset(m, 0, sizeof(*m));
+	m->h = h;
+	m->ulFlags = ulFlags;
+	m->pCreator = pCreator;
+
+	BT_kEnterCritical();
+	{
+		bt_list_add_tail(&m->item, &g_kmutexes);
+	}
+	BT_kExitCritical();
+
 	return m;
 }
 
+static BT_BOOL kmutex_take(struct bt_kmutex *m, BT_TICK oTimeoutTicks) {
+	if(m->ulFlags & BT_KMUTEX_RECURSIVE) {
+		return (xSemaphoreTakeRecursive(m->h, oTimeoutTicks) == pdPASS) ? BT_TRUE : BT_FALSE;
+	}
+
+	return (xSemaphoreTake(m->h, oTimeoutTicks) == pdPASS) ? BT_TRUE : BT_FALSE;
+}
+
+static BT_BOOL kmutex_pend(struct bt_kmutex *m, BT_TICK oTimeoutTicks) {
+	if(m->ulFlags & BT_KMUTEX_SEMAPHORE) {
+		return kmutex_take(m, oTimeoutTicks);
+	}
+
+	if(!kmutex_take(m, 0)) {
+		if(!oTimeoutTicks) {
+			return BT_FALSE;
+		}
+
+		BT_u64 ullStart = BT_GetGlobalTimer();
+		if(!kmutex_take(m, oTimeoutTicks)) {
+			return BT_FALSE;
+		}
+
+		BT_u64 ullBlocked = BT_GetGlobalTimer() - ullStart;
+		if(ullBlocked > m->ullWorstBlocked) {
+			m->ullWorstBlocked = ullBlocked;
+		}
+		m->ulContended++;
+	}
+
+	m->ulAcquired++;
+
+	return BT_TRUE;
+}
+
+BT_u32 BT_kMutexGetStats(struct bt_kmutex_stats *pStats, BT_u32 ulMax) {
+	struct bt_list_head *pos;
+	BT_u32 ulRate = BT_GetGlobalTimerRate();
+	BT_u32 n = 0;
+
+	BT_kEnterCritical();
+	{
+		bt_list_for_each(pos, &g_kmutexes) {
+			struct bt_kmutex *m = bt_list_entry(pos, struct bt_kmutex, item);
+			if(m->ulFlags & BT_KMUTEX_SEMAPHORE) {
+				continue;
+			}
+
+			if(n == ulMax) {
+				break;
+			}
+
+			pStats[n].pMutex			= m;
+			pStats[n].pCreator			= m->pCreator;
+			pStats[n].bRecursive		= (m->ulFlags & BT_KMUTEX_RECURSIVE) ? BT_TRUE : BT_FALSE;
+			pStats[n].ulAcquired		= m->ulAcquired;
+			pStats[n].ulContended		= m->ulContended;
+			pStats[n].ulWorstBlockedUs	= ulRate ? (BT_u32) ((m->ullWorstBlocked * 1000000) / ulRate) : 0;
+			n++;
+		}
+	}
+	BT_kExitCritical();
+
+	return n;
+}
+
+void BT_kMutexResetStats(void) {
+	struct bt_list_head *pos;
+
+	BT_kEnterCritical();
+	{
+		bt_list_for_each(pos, &g_kmutexes) {
+			struct bt_kmutex *m = bt_list_entry(pos, struct bt_kmutex, item);
+			m->ulAcquired = 0;
+			m->ulContended = 0;
+			m->ullWorstBlocked = 0;
+		}
+	}
+	BT_kExitCritical();
+}
+
+#else
+
+#define KMUTEX_HANDLE(p)	((xSemaphoreHandle) (p))
+
+#endif
+
+void *BT_kMutexCreate() {
+#ifdef BT_CONFIG_KERNEL_MUTEX_STATS
+	return kmutex_wrap(xSemaphoreCreateMutex(), 0, __builtin_return_address(0));
+#else
+	return xSemaphoreCreateMutex();
+#endif
+}
+
 void *BT_kRecursiveMutexCreate() {
+#ifdef BT_CONFIG_KERNEL_MUTEX_STATS
+	return kmutex_wrap(xSemaphoreCreateRecursiveMutex(), BT_KMUTEX_RECURSIVE, __builtin_return_address(0));
+#else
 	return xSemaphoreCreateRecursiveMutex();
+#endif
+}
+
+void *BT_kSemaphoreCreate() {
+	xSemaphoreHandle s;
+	vSemaphoreCreateBinary(s);
+#ifdef BT_CONFIG_KERNEL_MUTEX_STATS
+	return kmutex_wrap(s, BT_KMUTEX_SEMAPHORE, __builtin_return_address(0));
+#else
+	return s;
+#endif
 }
 
 void BT_kMutexDestroy(void *pMutex) {
-	vSemaphoreDelete(pMutex);
+	vSemaphoreDelete(KMUTEX_HANDLE(pMutex));
+#ifdef BT_CONFIG_KERNEL_MUTEX_STATS
+	struct bt_kmutex *m = (struct bt_kmutex *) pMutex;
+	BT_kEnterCritical();
+	{
+		bt_list_del(&m->item);
+	}
+	BT_kExitCritical();
+	BT_kFree(m);
+#endif
 }
 
 BT_BOOL BT_kMutexPend(void *pMutex, BT_TICK oTimeoutTicks) {
-
+#ifdef BT_CONFIG_KERNEL_MUTEX_STATS
+	return kmutex_pend((struct bt_kmutex *) pMutex, oTimeoutTicks);
+#else
 	if(xSemaphoreTake(pMutex, oTimeoutTicks) == pdPASS) {
 		return BT_TRUE;
 	}
 
 	return BT_FALSE;
+#endif
 }
 
 BT_BOOL  BT_kMutexRelease(void *pMutex) {
-	if(xSemaphoreGive(pMutex) == pdTRUE) {
+	if(xSemaphoreGive(KMUTEX_HANDLE(pMutex)) == pdTRUE) {
 		return BT_TRUE;
 	}
 	return BT_FALSE;
@@ -124,14 +295,18 @@ BT_BOOL BT_kMutexPendRecursive(void *pMutex, BT_TICK oTimeoutTicks) {
 		oTimeoutTicks = portMAX_DELAY;
 	}
 
+#ifdef BT_CONFIG_KERNEL_MUTEX_STATS
+	return kmutex_pend((struct bt_kmutex *) pMutex, oTimeoutTicks);
+#else
 	if(xSemaphoreTakeRecursive(pMutex, oTimeoutTicks) == pdPASS) {
 		return BT_TRUE;
 	}
 	return BT_FALSE;
+#endif
 }
 
 BT_BOOL  BT_kMutexReleaseRecursive(void *pMutex) {
-	if(xSemaphoreGiveRecursive(pMutex) == pdTRUE) {
+	if(xSemaphoreGiveRecursive(KMUTEX_HANDLE(pMutex)) == pdTRUE) {
 		return BT_TRUE;
 	}
 	return BT_FALSE;
@@ -140,7 +315,7 @@ BT_BOOL  BT_kMutexReleaseRecursive(void *pMutex) {
 BT_BOOL BT_kMutexReleaseFromISR(void *pMutex, BT_BOOL *pbHigherPriorityTaskWoken) {
 	portBASE_TYPE val;
 
-	BT_BOOL bReturn =  xSemaphoreGiveFromISR(pMutex, &val);
+	BT_BOOL bReturn =  xSemaphoreGiveFromISR(KMUTEX_HANDLE(pMutex), &val);
 	if(pbHigherPriorityTaskWoken) {
 		*pbHigherPriorityTaskWoken = (BT_BOOL) val;
 	}
@@ -202,6 +377,74 @@ BT_ERROR BT_kQueueReceiveFromISR(void *pQueue, void* pMessage, BT_BOOL *pbHigher
 
 
 
+#ifdef BT_CONFIG_SMP
+
+/*
+ *	The scheduler only runs on CPU0, where a critical section still enters the FreeRTOS
+ *	one. A thread may block inside it, so the outermost section is found from the
+ *	FreeRTOS nesting count, which is saved with each thread's context, and the kernel
+ *	spinlock is held by that thread, not by the CPU. The secondary CPUs are only started
+ *	once the scheduler runs. They run no threads, they mask their IRQs and keep a count
+ *	of their own.
+ */
+static bt_spinlock_t g_kernel_lock = BT_SPINLOCK_INIT;
+
+extern volatile BT_u32 ulCriticalNesting;
+
+static struct {
+	BT_u32			ulNesting;
+	bt_irqflags_t	flags;
+} g_critical[BT_CONFIG_CPU_CORES];
+
+void BT_kEnterCritical() {
+	BT_u32 ulCPU = BT_GetCoreID();
+
+	if(!ulCPU) {
+		taskENTER_CRITICAL();
+		if(ulCriticalNesting == 1) {
+			bt_spin_lock(&g_kernel_lock);
+		}
+		return;
+	}
+
+	bt_irqflags_t flags = bt_local_irq_save();
+	if(!g_critical[ulCPU].ulNesting++) {
+		bt_spin_lock(&g_kernel_lock);
+		g_critical[ulCPU].flags = flags;
+	}
+}
+
+void BT_kExitCritical() {
+	BT_u32 ulCPU = BT_GetCoreID();
+
+	if(!ulCPU) {
+		if(ulCriticalNesting == 1) {
+			bt_spin_unlock(&g_kernel_lock);
+		}
+		taskEXIT_CRITICAL();
+		return;
+	}
+
+	if(!--g_critical[ulCPU].ulNesting) {
+		bt_irqflags_t flags = g_critical[ulCPU].flags;
+		bt_spin_unlock(&g_kernel_lock);
+		bt_local_irq_restore(flags);
+	}
+}
+
+BT_u32 BT_kEnterCriticalFromISR() {
+	BT_u32 ulState = taskENTER_CRITICAL_FROM_ISR();
+	bt_spin_lock(&g_kernel_lock);
+	return ulState;
+}
+
+void BT_kExitCriticalFromISR(BT_u32 ulState) {
+	bt_spin_unlock(&g_kernel_lock);
+	taskEXIT_CRITICAL_FROM_ISR(ulState);
+}
+
+#else
+
 void BT_kEnterCritical() {
 	taskENTER_CRITICAL();
 }
@@ -209,3 +452,48 @@ void BT_kEnterCritical() {
 void BT_kExitCritical() {
 	taskEXIT_CRITICAL();
 }
+
+BT_u32 BT_kEnterCriticalFromISR() {
+	BT_u32 ulState = taskENTER_CRITICAL_FROM_ISR();
+	return ulState;
+}
+
+void BT_kExitCriticalFromISR(BT_u32 ulState) {
+	taskEXIT_CRITICAL_FROM_ISR(ulState);
+}
+
+#endif
+
+void BT_kYieldFromISR(BT_BOOL bHigherPriorityTaskWoken) {
+#ifdef portEND_SWITCHING_ISR
+	portEND_SWITCHING_ISR(bHigherPriorityTaskWoken);
+#else
+	if(bHigherPriorityTaskWoken) {
+		portYIELD_FROM_ISR();
+	}
+#endif
+}
+
+#ifdef BT_CONFIG_KERNEL_TICKLESS_IDLE
+/*
+ *	portSUPPRESS_TICKS_AND_SLEEP, called by the idle thread with the scheduler suspended.
+ *	Stepping the tick count onto the wakeup tick itself would leave the woken thread
+ *	blocked for another tick, so that one and any overslept ones are counted as pended
+ *	ticks, which xTaskResumeAll() then processes.
+ */
+void bt_suppress_ticks_and_sleep(BT_u32 ulExpectedIdleTime) {
+	bt_irqflags_t flags = bt_local_irq_save();
+
+	if(eTaskConfirmSleepModeStatus() != eAbortSleep) {
+		BT_u32 ulTicks = bt_tickless_sleep(ulExpectedIdleTime);
+		BT_u32 ulStep = (ulTicks < ulExpectedIdleTime) ? ulTicks : ulExpectedIdleTime - 1;
+
+		vTaskStepTick(ulStep);
+		while(ulStep++ < ulTicks) {
+			xTaskIncrementTick();
+		}
+	}
+
+	bt_local_irq_restore(flags);
+}
+#endif
@@ -71,6 +71,10 @@ void *BT_kMutexCreate() {
 	return p;
 }
 
+void *BT_kSemaphoreCreate() {
+	return BT_kMutexCreate();
+}
+
 /*void *BT_kRecursiveMutexCreate() {
 	return xSemaphoreCreateRecursiveMutex();
 	}*/
@@ -176,3 +180,15 @@ void BT_kEnterCritical() {
 void BT_kExitCritical() {
 	BT_EnableInterrupts();
 }
+
+BT_u32 BT_kEnterCriticalFromISR() {
+	return 0;		// ISRs run with interrupts disabled, and there is no scheduler.
+}
+
+void BT_kExitCriticalFromISR(BT_u32 ulState) {
+	(void) ulState;
+}
+
+void BT_kYieldFromISR(BT_BOOL bHigherPriorityTaskWoken) {
+	(void) bHigherPriorityTaskWoken;
+}
@@ -32,6 +32,8 @@
 		{												\
 			BT_MODULE_NAME,								\
 		}
+
+	#define BT_MODULE_DEF_INFO_NO_AUTHOR	BT_MODULE_DEF_INFO
 #else
 	typedef struct _BT_MODULE_INFO {
 		const BT_i8		   *szpModuleName;
@@ -47,6 +49,17 @@
 			BT_MODULE_AUTHOR,							\
 			BT_MODULE_EMAIL,							\
 		}
+
+	/*
+	 *	For modules that define no author or email.
+	 */
+	#define BT_MODULE_DEF_INFO_NO_AUTHOR				\
+		{												\
+			BT_MODULE_NAME,								\
+			BT_MODULE_DESCRIPTION,						\
+			NULL,										\
+			NULL,										\
+		}
 #endif
 
 struct bt_kernel_symbol {
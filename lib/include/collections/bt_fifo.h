@@ -7,6 +7,7 @@
 
 #include <bt_types.h>
 #include <fs/bt_file.h>
+#include <fs/bt_poll.h>
 
 
 #define	BT_FIFO_NONBLOCKING		BT_FILE_NON_BLOCK
@@ -54,5 +55,12 @@ BT_s32 BT_FifoFillLevel(BT_HANDLE hFifo);
 BT_s32 BT_FifoGetAvailable(BT_HANDLE hFifo);
 BT_s32 BT_FifoSize(BT_HANDLE hFifo);
 
+/**
+ *	@brief	BT_IF_FILE pfnPoll of a FIFO, for drivers that build on FIFOs.
+ *
+ *	Reports BT_POLLIN while the FIFO holds elements, and BT_POLLOUT while it has room.
+ **/
+BT_u32 BT_FifoPoll(BT_HANDLE hFifo, struct bt_poll_table *pTable);
+
 
 #endif
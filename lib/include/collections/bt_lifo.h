@@ -0,0 +1,148 @@
+/**
+ *	Lock-free LIFO of intrusive nodes, e.g. for free lists.
+ *
+ *	On ARMv7 push and pop can be used from any thread or ISR without a lock. Pop
+ *	takes the head with a single load-exclusive / store-exclusive sequence, so a
+ *	head that is popped and pushed back in between (ABA) fails the store instead of
+ *	corrupting the list. Every exclusive load is completed by a store or a CLREX.
+ *
+ *	Other architectures fall back to BT_kEnterCriticalFromISR(), which masks interrupts
+ *	and so may also be used from either context, but only on a single core.
+ **/
+
+#ifndef _BT_LIFO_H_
+#define _BT_LIFO_H_
+
+#include <bt_types.h>
+
+struct bt_lifo_node {
+	struct bt_lifo_node	   *next;
+};
+
+struct bt_lifo {
+	struct bt_lifo_node	   *volatile head;
+};
+
+#define BT_LIFO_INIT	{ NULL }
+
+#if defined(__ARM_ARCH_7A__) || defined(__ARM_ARCH_7R__) || defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+
+#define BT_LIFO_LOCKFREE	1
+
+#define bt_lifo_barrier()	__asm volatile("dmb" ::: "memory")
+
+static inline void bt_lifo_push(struct bt_lifo *pLifo, struct bt_lifo_node *pNode) {
+	struct bt_lifo_node *head;
+	BT_u32 failed;
+
+	do {
+		head = pLifo->head;
+		pNode->next = head;
+		bt_lifo_barrier();		// The node is complete before it is published.
+
+		__asm volatile(
+			"	ldrex	%0, [%2]		\n"
+			"	cmp		%0, %3			\n"
+			"	beq		2f				\n"
+			"	clrex					\n"		// Changed since it was read, start over.
+			"	mov		%0, #1			\n"
+			"	b		1f				\n"
+			"2:	strex	%0, %4, [%2]	\n"
+			"1:							\n"
+			: "=&r" (failed), "+m" (pLifo->head)
+			: "r" (&pLifo->head), "r" (head), "r" (pNode)
+			: "cc", "memory");
+	} while(failed);
+}
+
+static inline struct bt_lifo_node *bt_lifo_pop(struct bt_lifo *pLifo) {
+	struct bt_lifo_node *head, *next;
+	BT_u32 failed;
+
+	do {
+		__asm volatile(
+			"	ldrex	%0, [%4]		\n"
+			"	cmp		%0, #0			\n"
+			"	bne		2f				\n"
+			"	clrex					\n"		// Empty.
+			"	mov		%1, #0			\n"
+			"	b		1f				\n"
+			"2:	ldr		%2, [%0]		\n"		// head->next
+			"	strex	%1, %2, [%4]	\n"
+			"1:							\n"
+			: "=&r" (head), "=&r" (failed), "=&r" (next), "+m" (pLifo->head)
+			: "r" (&pLifo->head)
+			: "cc", "memory");
+	} while(failed);
+
+	(void) next;
+	bt_lifo_barrier();
+
+	return head;
+}
+
+/**
+ *	Takes the whole list, newest node first.
+ **/
+static inline struct bt_lifo_node *bt_lifo_pop_all(struct bt_lifo *pLifo) {
+	struct bt_lifo_node *head;
+	BT_u32 failed;
+
+	do {
+		__asm volatile(
+			"	ldrex	%0, [%3]		\n"
+			"	strex	%1, %4, [%3]	\n"
+			: "=&r" (head), "=&r" (failed), "+m" (pLifo->head)
+			: "r" (&pLifo->head), "r" (0)
+			: "cc", "memory");
+	} while(failed);
+
+	bt_lifo_barrier();
+
+	return head;
+}
+
+#else
+
+#include <bt_kernel.h>
+
+#ifdef BT_CONFIG_SMP
+#error "bt_lifo: no lock-free implementation for this architecture, required on SMP."
+#endif
+
+#define BT_LIFO_LOCKFREE	0
+
+static inline void bt_lifo_push(struct bt_lifo *pLifo, struct bt_lifo_node *pNode) {
+	BT_u32 ulState = BT_kEnterCriticalFromISR();
+	pNode->next = pLifo->head;
+	pLifo->head = pNode;
+	BT_kExitCriticalFromISR(ulState);
+}
+
+static inline struct bt_lifo_node *bt_lifo_pop(struct bt_lifo *pLifo) {
+	struct bt_lifo_node *head;
+
+	BT_u32 ulState = BT_kEnterCriticalFromISR();
+	head = pLifo->head;
+	if(head) {
+		pLifo->head = head->next;
+	}
+	BT_kExitCriticalFromISR(ulState);
+
+	return head;
+}
+
+static inline struct bt_lifo_node *bt_lifo_pop_all(struct bt_lifo *pLifo) {
+	struct bt_lifo_node *head;
+
+	BT_u32 ulState = BT_kEnterCriticalFromISR();
+	head = pLifo->head;
+	pLifo->head = NULL;
+	BT_kExitCriticalFromISR(ulState);
+
+	return head;
+}
+
+#endif
+
+#endif
@@ -94,7 +94,7 @@ static inline void bt_list_splice_tail_init(struct bt_list_head *list,
 	bt_container_of(ptr, type, member)
 
 #define bt_list_first_entry(ptr, type, member)		 					\
-	list_entry((ptr)->next, type, member)
+	bt_list_entry((ptr)->next, type, member)
 
 #define bt_list_for_each(pos, head) \
 	for(pos = (head)->next; pos != (head); pos = pos->next)
@@ -108,6 +108,11 @@ static inline void bt_list_splice_tail_init(struct bt_list_head *list,
 		&pos->member != (head);											\
 		pos = bt_list_entry(pos->member.next, typeof(*pos), member))
 
+#define bt_list_for_each_entry_continue(pos, head, member)				\
+	for(pos = bt_list_entry(pos->member.next, typeof(*pos), member);	\
+		&pos->member != (head);											\
+		pos = bt_list_entry(pos->member.next, typeof(*pos), member))
+
 #define bt_list_for_each_entry_safe(pos, n, head, member)				\
 	for (pos = bt_list_entry((head)->next, typeof(*pos), member),		\
 		n = bt_list_entry(pos->member.next, typeof(*pos), member);		\
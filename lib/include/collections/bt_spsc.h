@@ -0,0 +1,77 @@
+/**
+ *	Lock-free single-producer single-consumer ring of pointers.
+ *
+ *	One thread (or ISR) pushes and one other thread pops, each without a lock. The
+ *	producer owns head and the consumer owns tail; each reads the other's index with
+ *	acquire ordering, so a slot is written before it is published, and read before
+ *	it is handed back. The two indices are kept on separate cache lines.
+ *
+ *	The number of slots must be a power of two.
+ **/
+
+#ifndef _BT_SPSC_H_
+#define _BT_SPSC_H_
+
+#include <bt_types.h>
+
+#define BT_SPSC_ALIGN	32		// Cache line size.
+
+struct bt_spsc {
+	BT_u32	head __attribute__((aligned(BT_SPSC_ALIGN)));	///< Next slot to fill, written by the producer.
+	BT_u32	tail __attribute__((aligned(BT_SPSC_ALIGN)));	///< Next slot to empty, written by the consumer.
+	BT_u32	mask;
+	void  **slots;
+};
+
+static inline void bt_spsc_init(struct bt_spsc *q, void **slots, BT_u32 ulSlots) {
+	q->head = 0;
+	q->tail = 0;
+	q->mask = ulSlots - 1;
+	q->slots = slots;
+}
+
+/**
+ *	Producer side, returns BT_FALSE if the ring is full.
+ **/
+static inline BT_BOOL bt_spsc_push(struct bt_spsc *q, void *p) {
+	BT_u32 head = q->head;
+
+	if(head - __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE) > q->mask) {
+		return BT_FALSE;
+	}
+
+	q->slots[head & q->mask] = p;
+	__atomic_store_n(&q->head, head + 1, __ATOMIC_RELEASE);
+
+	return BT_TRUE;
+}
+
+static inline BT_BOOL bt_spsc_full(struct bt_spsc *q) {
+	return (q->head - __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE) > q->mask) ? BT_TRUE : BT_FALSE;
+}
+
+/**
+ *	Consumer side, returns NULL if the ring is empty.
+ **/
+static inline void *bt_spsc_pop(struct bt_spsc *q) {
+	BT_u32 tail = q->tail;
+	void *p;
+
+	if(tail == __atomic_load_n(&q->head, __ATOMIC_ACQUIRE)) {
+		return NULL;
+	}
+
+	p = q->slots[tail & q->mask];
+	__atomic_store_n(&q->tail, tail + 1, __ATOMIC_RELEASE);
+
+	return p;
+}
+
+/**
+ *	May be called from either side.
+ **/
+static inline BT_BOOL bt_spsc_empty(struct bt_spsc *q) {
+	return (__atomic_load_n(&q->head, __ATOMIC_ACQUIRE) == __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE)) ? BT_TRUE : BT_FALSE;
+}
+
+#endif
@@ -35,7 +35,7 @@
 typedef struct _BT_HANDLE_HEADER {
 	struct bt_list_head		item;
 	const BT_IF_HANDLE	   *pIf;				///< Pointer to the handle interface.
-	BT_u32					ulReferenceCount;	///< The number of times the handle is used.
+	BT_u32					ulReferenceCount;	///< The number of times the handle is used, only change it atomically.
 	//BT_u32 					ulFlags;			///<
 } BT_HANDLE_HEADER;
 
@@ -79,6 +79,19 @@ BT_HANDLE BT_CreateHandleAttached(BT_HANDLE hProcess, const BT_IF_HANDLE *pIf, B
 
 #define BT_CreateHandle(interface, size, error_pointer)	BT_CreateHandleAttached(NULL, interface, size, error_pointer)
 
+/**
+ *	@brief	Remove a BT_HANDLE from the process it is attached to.
+ *
+ *	Removal is O(1), and detaching a handle twice is harmless. Handles are detached by
+ *	@ref BT_CloseHandle(), call this only to undo @ref BT_AttachHandle() on error paths.
+ *
+ *	@param[in]	hProcess	Unused, the handle knows its place on the process' list.
+ *	@param[in]	h			The Handle that is to be detached.
+ *
+ *	@return	BT_ERR_NONE on success.
+ **/
+BT_ERROR BT_DetachHandle(BT_HANDLE hProcess, BT_HANDLE h);
+
 /**
  *	@brief	Destroy a BT_HANDLE object, and detach it from any associated process.
  *
@@ -115,10 +128,25 @@ BT_ERROR BT_CloseHandle(BT_HANDLE h);
 /**
  *	@brief	Increment a HANDLE's reference count.
  *
+ *	The caller must already hold a reference, or know that one is held meanwhile,
+ *	e.g. by a table it looked the handle up in while that table was locked.
  *
  **/
 BT_ERROR BT_RefHandle(BT_HANDLE h);
 
+/**
+ *	@brief	Increment a HANDLE's reference count, unless it already dropped to 0.
+ *
+ *	For lookups in structures that do not hold a reference of their own: a handle whose
+ *	last reference is being closed can no longer be taken. The handle's memory must
+ *	still be valid, so the lookup must be done under the lock of that structure, and
+ *	the handle removed from it under the same lock before it is destroyed.
+ *
+ *	@return	BT_TRUE if a reference was taken, release it with @ref BT_CloseHandle().
+ *
+ **/
+BT_BOOL BT_TryRefHandle(BT_HANDLE h);
+
  /**
   *	@brief	Decrement a HANDLE's reference count.
   *
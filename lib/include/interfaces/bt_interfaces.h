@@ -33,6 +33,7 @@ typedef enum _BT_HANDLE_TYPE {
 	BT_HANDLE_T_SHELL,
 	BT_HANDLE_T_RTC,
 	BT_HANDLE_T_I2C_BUS,
+	BT_HANDLE_T_POLL,
 #endif
 } BT_HANDLE_TYPE;
 
@@ -18,6 +18,7 @@ struct _BT_OPAQUE_HANDLE {
 	BT_u32	 		 ulElements;
 	BT_u32	 		 ulElementWidth;
 	BT_u32	 		 ulFlags;
+	struct bt_poll_queue poll;
 };
 
 static const BT_IF_HANDLE oHandleInterface;
@@ -51,6 +52,8 @@ BT_HANDLE BT_FifoCreate(BT_u32 ulElements, BT_u32 ulElementWidth, BT_u32 ulFlags
 	hFifo->ulElements     = ulElements;
 	hFifo->ulFlags        = ulFlags;
 
+	bt_poll_queue_init(&hFifo->poll);
+
 	return hFifo;
 
 err_free_out:
@@ -77,7 +80,7 @@ BT_s32 BT_FifoWrite(BT_HANDLE hFifo, BT_u32 ulElements, const void *pData, BT_u3
 
 	for(ulWritten = 0; ulWritten < ulElements; ulWritten++) {
 		if (ulFlags & BT_FIFO_NONBLOCKING) {						// We should prevent overflow, and block!
-			if (BT_FifoIsFull(hFifo->hQueue, &Error)) {
+			if (BT_FifoIsFull(hFifo, &Error)) {
 				break;
 			}
 		}
@@ -86,6 +89,10 @@ BT_s32 BT_FifoWrite(BT_HANDLE hFifo, BT_u32 ulElements, const void *pData, BT_u3
 		pSrc += hFifo->ulElementWidth;
 	}
 
+	if(ulWritten) {
+		bt_poll_wake(&hFifo->poll, BT_POLLIN);
+	}
+
 	return ulWritten;
 }
 BT_EXPORT_SYMBOL(BT_FifoWrite);
@@ -103,7 +110,7 @@ BT_s32 BT_FifoWriteFromISR(BT_HANDLE hFifo, BT_u32 ulElements, const void *pData
 
 	for(ulWritten = 0; ulWritten < ulElements; ulWritten++) {
 		if (hFifo->ulFlags & BT_FIFO_NONBLOCKING) {				// We should prevent overflow, and block!
-			if (BT_FifoIsFull(hFifo->hQueue, &Error)) {
+			if (BT_FifoIsFull(hFifo, &Error)) {
 				break;
 			}
 		}
@@ -112,6 +119,10 @@ BT_s32 BT_FifoWriteFromISR(BT_HANDLE hFifo, BT_u32 ulElements, const void *pData
 		pSrc += hFifo->ulElementWidth;
 	}
 
+	if(ulWritten) {
+		bt_poll_wake_from_isr(&hFifo->poll, BT_POLLIN);
+	}
+
 	return ulWritten;
 }
 BT_EXPORT_SYMBOL(BT_FifoWriteFromISR);
@@ -135,10 +146,14 @@ BT_s32 BT_FifoRead(BT_HANDLE hFifo, BT_u32 ulElements, void *pData, BT_u32 ulFla
 				break;
 			}
 		}
-		BT_QueueReceive(hFifo->hQueue, pData, BT_INFINITE_TIMEOUT);
+		BT_QueueReceive(hFifo->hQueue, pSrc, BT_INFINITE_TIMEOUT);
 		pSrc += hFifo->ulElementWidth;
 	}
 
+	if(ulRead) {
+		bt_poll_wake(&hFifo->poll, BT_POLLOUT);
+	}
+
 	return ulRead;
 }
 BT_EXPORT_SYMBOL(BT_FifoRead);
@@ -160,10 +175,14 @@ BT_s32 BT_FifoReadFromISR(BT_HANDLE hFifo, BT_u32 ulElements, void *pData) {
 				break;
 			}
 		}
-		BT_QueueReceiveFromISR(hFifo->hQueue, pData, &bHigherPriorityTaskWoken);
+		BT_QueueReceiveFromISR(hFifo->hQueue, pSrc, &bHigherPriorityTaskWoken);
 		pSrc += hFifo->ulElementWidth;
 	}
 
+	if(ulRead) {
+		bt_poll_wake_from_isr(&hFifo->poll, BT_POLLOUT);
+	}
+
 	return ulRead;
 }
 BT_EXPORT_SYMBOL(BT_FifoReadFromISR);
@@ -247,13 +266,63 @@ BT_s32 BT_FifoSize(BT_HANDLE hFifo) {
 }
 BT_EXPORT_SYMBOL(BT_FifoSize);
 
+BT_u32 BT_FifoPoll(BT_HANDLE hFifo, struct bt_poll_table *pTable) {
+
+	BT_u32 ulEvents = 0;
+
+	if(!isFifoHandle(hFifo)) {
+		return BT_POLLERR;
+	}
+
+	bt_poll_wait(pTable, &hFifo->poll);
+
+	BT_u32 messages = BT_QueueMessagesWaiting(hFifo->hQueue);
+	if(messages) {
+		ulEvents |= BT_POLLIN;
+	}
+	if(messages < hFifo->ulElements) {
+		ulEvents |= BT_POLLOUT;
+	}
+
+	return ulEvents;
+}
+BT_EXPORT_SYMBOL(BT_FifoPoll);
+
+static BT_s32 fifo_read(BT_HANDLE hFifo, BT_u32 ulFlags, BT_u32 ulSize, void *pBuffer) {
+	BT_s32 slRead = BT_FifoRead(hFifo, ulSize / hFifo->ulElementWidth, pBuffer, ulFlags);
+	if(slRead < 0) {
+		return slRead;
+	}
+	return slRead * hFifo->ulElementWidth;
+}
+
+static BT_s32 fifo_write(BT_HANDLE hFifo, BT_u32 ulFlags, BT_u32 ulSize, const void *pBuffer) {
+	BT_s32 slWritten = BT_FifoWrite(hFifo, ulSize / hFifo->ulElementWidth, pBuffer, ulFlags);
+	if(slWritten < 0) {
+		return slWritten;
+	}
+	return slWritten * hFifo->ulElementWidth;
+}
+
 static BT_ERROR fifo_cleanup(BT_HANDLE hFifo) {
+	bt_poll_queue_release(&hFifo->poll);
 	BT_CloseHandle(hFifo->hQueue);
 	return BT_ERR_NONE;
 }
 
+/**
+ *	FIFO handles can be used with BT_Read/BT_Write (in whole elements) and BT_PollCtl.
+ **/
+static const BT_IF_FILE oFileInterface = {
+	.pfnRead		= fifo_read,
+	.pfnWrite		= fifo_write,
+	.pfnPoll		= BT_FifoPoll,
+	.ulSupported	= BT_FILE_NON_BLOCK,
+};
+
 static const BT_IF_HANDLE oHandleInterface = {
 	BT_MODULE_DEF_INFO,
 	.eType		= BT_HANDLE_T_FIFO,
 	.pfnCleanup	= fifo_cleanup,
+	.pFileIF	= &oFileInterface,
 };
@@ -13,33 +13,91 @@ struct _BT_OPAQUE_HANDLE {
 	BT_HANDLE_HEADER h;
 };
 
+/*
+ *	Reference counts are updated with atomic instructions where the target has them
+ *	(LDREX/STREX on ARMv7), and in a critical section otherwise.
+ */
+#ifdef __GCC_HAVE_SYNC_COMPARE_AND_SWAP_4
+
+static inline void handle_get(BT_HANDLE h) {
+	__atomic_add_fetch(&h->h.ulReferenceCount, 1, __ATOMIC_RELAXED);
+}
+
+static inline BT_u32 handle_put(BT_HANDLE h) {
+	return __atomic_sub_fetch(&h->h.ulReferenceCount, 1, __ATOMIC_ACQ_REL);
+}
+
+static inline BT_BOOL handle_get_unless_zero(BT_HANDLE h) {
+	BT_u32 ulCount = __atomic_load_n(&h->h.ulReferenceCount, __ATOMIC_RELAXED);
+	do {
+		if(!ulCount) {
+			return BT_FALSE;
+		}
+	} while(!__atomic_compare_exchange_n(&h->h.ulReferenceCount, &ulCount, ulCount + 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+	return BT_TRUE;
+}
+
+#else
+
+static inline void handle_get(BT_HANDLE h) {
+	BT_kEnterCritical();
+	h->h.ulReferenceCount += 1;
+	BT_kExitCritical();
+}
+
+static inline BT_u32 handle_put(BT_HANDLE h) {
+	BT_kEnterCritical();
+	BT_u32 ulCount = --h->h.ulReferenceCount;
+	BT_kExitCritical();
+	return ulCount;
+}
+
+static inline BT_BOOL handle_get_unless_zero(BT_HANDLE h) {
+	BT_BOOL bRef = BT_FALSE;
+	BT_kEnterCritical();
+	if(h->h.ulReferenceCount) {
+		h->h.ulReferenceCount += 1;
+		bRef = BT_TRUE;
+	}
+	BT_kExitCritical();
+	return bRef;
+}
+
+#endif
+
 BT_ERROR BT_AttachHandle(BT_HANDLE hProcess, const BT_IF_HANDLE *pIf, BT_HANDLE h) {
 	h->h.pIf = pIf;
+	h->h.ulReferenceCount = 1;		// Complete before the handle is published on the list.
+
 	struct bt_task *task = BT_GetProcessTask(hProcess);
-	switch(pIf->eType) {
-	case BT_HANDLE_T_THREAD:
-		bt_list_add(&h->h.item, &task->threads);
-		break;
-
-	default:
-		bt_list_add(&h->h.item, &task->handles);
-		break;
-	}
+	struct bt_list_head *list = (pIf->eType == BT_HANDLE_T_THREAD) ? &task->threads : &task->handles;
 
-	h->h.ulReferenceCount = 1;
+	BT_kEnterCritical();
+	bt_list_add(&h->h.item, list);
+	BT_kExitCritical();
 
 	return BT_ERR_NONE;
 }
 BT_EXPORT_SYMBOL(BT_AttachHandle);
 
 BT_ERROR BT_DetachHandle(BT_HANDLE hProcess, BT_HANDLE h) {
-	bt_list_del(&h->h.item);
+	BT_kEnterCritical();
+	bt_list_del_init(&h->h.item);	// Detaching again is harmless.
+	BT_kExitCritical();
 	return BT_ERR_NONE;
 }
 BT_EXPORT_SYMBOL(BT_DetachHandle);
 
 BT_HANDLE BT_CreateHandleAttached(BT_HANDLE hProcess, const BT_IF_HANDLE *pIf, BT_u32 ulHandleMemory, BT_ERROR *pError) {
 	BT_HANDLE h = BT_Calloc(ulHandleMemory);
+	if(!h) {
+		if(pError) {
+			*pError = BT_ERR_NO_MEMORY;
+		}
+		return NULL;
+	}
+
 	BT_AttachHandle(hProcess, pIf, h);
 	return h;
 }
@@ -56,17 +114,26 @@ BT_ERROR BT_RefHandle(BT_HANDLE h) {
 		return BT_ERR_NULL_POINTER;
 	}
 
-	h->h.ulReferenceCount += 1;
+	handle_get(h);
 	return BT_ERR_NONE;
 }
 BT_EXPORT_SYMBOL(BT_RefHandle);
 
+BT_BOOL BT_TryRefHandle(BT_HANDLE h) {
+	if(!h) {
+		return BT_FALSE;
+	}
+
+	return handle_get_unless_zero(h);
+}
+BT_EXPORT_SYMBOL(BT_TryRefHandle);
+
 BT_ERROR BT_UnrefHandle(BT_HANDLE h) {
 	if(!h) {
 		return BT_ERR_NULL_POINTER;
 	}
 
-	h->h.ulReferenceCount -= 1;
+	handle_put(h);
 	return BT_ERR_NONE;
 }
 BT_EXPORT_SYMBOL(BT_UnrefHandle);
@@ -84,9 +151,8 @@ BT_ERROR BT_CloseHandle(BT_HANDLE h) {
 		return BT_ERR_INVALID_HANDLE;
 	}
 
-	BT_UnrefHandle(h);
-	if(h->h.ulReferenceCount) {
-		return BT_ERR_NONE;
+	if(handle_put(h)) {
+		return BT_ERR_NONE;		// Only the thread that dropped the last reference cleans up.
 	}
 
 	BT_ERROR Error = BT_ERR_NONE;
@@ -94,7 +160,7 @@ BT_ERROR BT_CloseHandle(BT_HANDLE h) {
 		h->h.pIf->pfnCleanup(h);
 	}
 
-	BT_DetachHandle(NULL, h);	// Detach the handle from the current process.
+	BT_DetachHandle(NULL, h);	// Detach the handle from its process.
 
 	if(!(h->h.pIf->ulFlags & BT_HANDLE_FLAGS_NO_DESTROY)) {
 		BT_DestroyHandle(h);
@@ -161,6 +161,16 @@
    __data1_end = .;
 } > BT_LINKER_DATA_SECTION
 
+#ifdef BT_CONFIG_DRIVERS_BLOCK_RAMDISK_LINKED_IMAGE
+.bt.ramdisk : {
+   . = ALIGN(4096);
+   __bt_ramdisk_start = .;
+   KEEP(*(.bt.ramdisk))
+   KEEP(*(.bt.ramdisk.*))
+   __bt_ramdisk_end = .;
+} > BT_LINKER_DATA_SECTION
+#endif
+
 .got : {
    *(.got)
 } > BT_LINKER_TEXT_SECTION
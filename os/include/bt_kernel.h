@@ -56,8 +56,15 @@ BT_u32 		BT_kEventGroupSetBits(const BT_EVGROUP_T oEventGroup, const BT_u32 ulBi
 void 	   *BT_kGetThreadTag	(void *pThreadID);
 void		BT_kSetThreadTag	(void *pThreadID, void *pTagData);
 
+/*
+ *	Mutexes inherit the priority of the threads blocked on them, and must be released
+ *	by the thread that holds them, never from an ISR. Semaphores are created available,
+ *	and can be released by any thread or ISR to signal a waiter. BT_kMutexPend,
+ *	BT_kMutexRelease and BT_kMutexReleaseFromISR operate on either.
+ */
 void 	   *BT_kMutexCreate		(void);
 void 	   *BT_kRecursiveMutexCreate(void);
+void 	   *BT_kSemaphoreCreate	(void);
 void	    BT_kMutexDestroy	(void *pMutex);
 BT_BOOL		BT_kMutexPend		(void *pMutex, BT_TICK oTimeoutTicks);
 #define 	BT_kMutexAcquire 	BT_kMutexPend
@@ -66,6 +73,23 @@ BT_BOOL		BT_kMutexPendRecursive		(void *pMutex, BT_u32 ulTimeout);
 BT_BOOL		BT_kMutexReleaseRecursive	(void *pMutex);
 BT_BOOL		BT_kMutexReleaseFromISR		(void *pMutex, BT_BOOL *pbHigherPriorityTaskWoken);
 
+#ifdef BT_CONFIG_KERNEL_MUTEX_STATS
+struct bt_kmutex_stats {
+	void	   *pMutex;
+	void	   *pCreator;			///< Return address of the call that created the mutex.
+	BT_BOOL		bRecursive;
+	BT_u32		ulAcquired;
+	BT_u32		ulContended;		///< Acquisitions that had to block.
+	BT_u32		ulWorstBlockedUs;	///< Longest time a thread was blocked acquiring it.
+};
+
+/**
+ *	@brief	Fills pStats with the counters of up to ulMax mutexes, returns the number filled in.
+ **/
+BT_u32		BT_kMutexGetStats	(struct bt_kmutex_stats *pStats, BT_u32 ulMax);
+void		BT_kMutexResetStats	(void);
+#endif
+
 void 	   *BT_kQueueCreate				(BT_u32 ulElements, BT_u32 ulElementWidth);
 void 		BT_kQueueDestroy			(void *pQueue);
 BT_ERROR 	BT_kQueueSend				(void *pQueue, const void* pMessage, BT_TICK oTimeoutTicks);
@@ -79,6 +103,18 @@ BT_u32		BT_kQueueMessagesWaiting	(void *pQueue);
 void 		BT_kEnterCritical	();
 void 		BT_kExitCritical	();
 
+/*
+ *	The ISR variants mask the interrupts that may use the kernel and, on SMP, exclude the
+ *	other CPUs. They do not nest, and must not be taken with BT_kEnterCritical() held.
+ */
+BT_u32		BT_kEnterCriticalFromISR	(void);
+void		BT_kExitCriticalFromISR		(BT_u32 ulState);
+
+/**
+ *	@brief	Switches to the woken thread on ISR exit, if a FromISR call woke a higher priority one.
+ **/
+void		BT_kYieldFromISR			(BT_BOOL bHigherPriorityTaskWoken);
+
 bt_kernel_params *bt_get_kernel_params();
 
 #endif
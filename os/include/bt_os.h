@@ -3,6 +3,8 @@
 
 #include "bt_export.h"
 #include "bt_kernel.h"
+#include "process/bt_lock.h"
+#include "process/bt_spinlock.h"
 #include "module/bt_module_init.h"
 #include "mm/bt_ioremap.h"
 #include "mm/bt_mm.h"
@@ -17,6 +19,7 @@
 #include "devman/bt_devman.h"
 #include "devman/bt_block.h"
 #include "devman/bt_i2c.h"
+#include "devman/bt_dma.h"
 #include "devman/bt_mtd.h"
 #include "volumes/bt_volume.h"
 #include "volumes/bt_partition.h"
@@ -31,6 +34,7 @@
 #include "fs/bt_file.h"
 #include "fs/bt_dir.h"
 #include "fs/bt_inode.h"
+#include "fs/bt_poll.h"
 #include "net/bt_net.h"
 #include "lib/getmem.h"
 #include "lib/printf.h"
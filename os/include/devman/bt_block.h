@@ -13,6 +13,7 @@
 typedef struct _BT_BLOCK_GEOMETRY {
 	BT_u32	ulBlockSize;
 	BT_u32	ulTotalBlocks;
+	BT_u32	ulEraseBlocks;		///< Erase unit size in blocks, 0 if unknown.
 } BT_BLOCK_GEOMETRY;
 
 typedef struct _BT_BLKDEV_DESCRIPTOR {
@@ -32,6 +33,7 @@ BT_ERROR BT_RegisterBlockDevice(BT_HANDLE hDevice, const char *szpName, BT_BLKDE
 
 BT_s32 BT_BlockRead			(BT_HANDLE hBlock, BT_u32 ulAddress, BT_u32 ulBlocks, void *pBuffer);
 BT_s32 BT_BlockWrite		(BT_HANDLE hBlock, BT_u32 ulAddress, BT_u32 ulBlocks, void *pBuffer);
+void *BT_BlockMap			(BT_HANDLE hBlock, BT_u32 ulAddress, BT_u32 ulBlocks, BT_ERROR *pError);
 BT_ERROR BT_GetBlockGeometry(BT_HANDLE hBlock, BT_BLOCK_GEOMETRY *pGeometry);
 BT_HANDLE BT_BlockGetInode	(BT_HANDLE hDevice);
 
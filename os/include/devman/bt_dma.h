@@ -0,0 +1,20 @@
+/**
+ *	DMA Engine Controllers for the BitThunder device manager.
+ *
+ **/
+
+#ifndef _BT_DMA_H_
+#define _BT_DMA_H_
+
+#include <bitthunder.h>
+#include <interfaces/bt_dev_if_dma.h>
+
+BT_ERROR	BT_DmaRegisterController	(BT_HANDLE hDma, BT_u32 ulID);
+BT_HANDLE	BT_DmaGetController			(BT_u32 ulID);
+
+BT_s32		BT_DmaRequestChannel		(BT_HANDLE hDma, BT_ERROR *pError);
+BT_ERROR	BT_DmaReleaseChannel		(BT_HANDLE hDma, BT_u32 ulChannel);
+BT_ERROR	BT_DmaSubmit				(BT_HANDLE hDma, BT_u32 ulChannel, const BT_DMA_SEGMENT *pSegments, BT_u32 ulSegments, BT_DMA_COMPLETE pfnComplete, void *pContext);
+BT_ERROR	BT_DmaAbort					(BT_HANDLE hDma, BT_u32 ulChannel);
+
+#endif
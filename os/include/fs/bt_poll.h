@@ -0,0 +1,80 @@
+#ifndef _BT_POLL_H_
+#define _BT_POLL_H_
+
+#include <collections/bt_list.h>
+
+/**
+ *	Readiness flags, used in bt_poll_event.ulEvents and returned by BT_IF_FILE pfnPoll.
+ *	BT_POLLERR and BT_POLLHUP are always reported, they need not be requested.
+ **/
+#define BT_POLLIN			0x00000001		///< Data can be read without blocking.
+#define BT_POLLOUT			0x00000004		///< Data can be written without blocking.
+#define BT_POLLERR			0x00000008
+#define BT_POLLHUP			0x00000010
+#define BT_POLLONESHOT		0x40000000		///< Disarm after one report, until re-armed with BT_POLL_CTL_MOD.
+#define BT_POLLET			0x80000000		///< Edge-triggered, report only when the readiness changes.
+
+#define BT_POLL_CTL_ADD		1
+#define BT_POLL_CTL_DEL		2
+#define BT_POLL_CTL_MOD		3
+
+struct bt_poll_event {
+	BT_u32	ulEvents;
+	void   *pData;				///< Returned as-is with the events.
+};
+
+/**
+ *	A readiness source, embedded in the object implementing pfnPoll.
+ **/
+struct bt_poll_queue {
+	struct bt_list_head watchers;
+};
+
+struct bt_poll_table;
+
+/**
+ *	@brief	Creates an interest set.
+ *
+ *	The set is released with BT_CloseHandle(), which also removes any files still in it.
+ **/
+BT_HANDLE	BT_PollCreate	(BT_ERROR *pError);
+
+/**
+ *	@brief	Adds, modifies or removes a file in an interest set.
+ *
+ *	The file must implement pfnPoll in its BT_IF_FILE, pEvent is not used by BT_POLL_CTL_DEL.
+ **/
+BT_ERROR	BT_PollCtl		(BT_HANDLE hPoll, BT_u32 ulOp, BT_HANDLE hFile, const struct bt_poll_event *pEvent);
+
+/**
+ *	@brief	Waits for files in the set to become ready.
+ *
+ *	@param[IN]	slTimeout	Milliseconds to wait, 0 returns immediately, BT_INFINITE_TIMEOUT waits forever.
+ *
+ *	@return		Number of events stored into pEvents, 0 on timeout.
+ *	@return		< 0 on Error, (A BT_ERROR code).
+ **/
+BT_s32		BT_PollWait		(BT_HANDLE hPoll, struct bt_poll_event *pEvents, BT_u32 ulMaxEvents, BT_s32 slTimeout);
+
+/*
+ *	Driver side, for pfnPoll implementations:
+ *
+ *	bt_poll_wait()			Called from pfnPoll with its pTable (which may be NULL), to subscribe to a queue.
+ *	bt_poll_wake()			Signals a readiness change of ulEvents to the subscribers of a queue.
+ *	bt_poll_queue_release()	Detaches all subscribers, before the object owning the queue is freed.
+ */
+#ifdef BT_CONFIG_POLL
+void bt_poll_queue_init(struct bt_poll_queue *pQueue);
+void bt_poll_wait(struct bt_poll_table *pTable, struct bt_poll_queue *pQueue);
+void bt_poll_wake(struct bt_poll_queue *pQueue, BT_u32 ulEvents);
+void bt_poll_wake_from_isr(struct bt_poll_queue *pQueue, BT_u32 ulEvents);
+void bt_poll_queue_release(struct bt_poll_queue *pQueue);
+#else
+static inline void bt_poll_queue_init(struct bt_poll_queue *pQueue) { }
+static inline void bt_poll_wait(struct bt_poll_table *pTable, struct bt_poll_queue *pQueue) { }
+static inline void bt_poll_wake(struct bt_poll_queue *pQueue, BT_u32 ulEvents) { }
+static inline void bt_poll_wake_from_isr(struct bt_poll_queue *pQueue, BT_u32 ulEvents) { }
+static inline void bt_poll_queue_release(struct bt_poll_queue *pQueue) { }
+#endif
+
+#endif
@@ -67,6 +67,16 @@
 
 #define ffconfigOPTIMISE_UNALIGNED_ACCESS   1
 
+#ifdef BT_CONFIG_FS_FULLFAT_EXTENT_CACHE
+#define ffconfigEXTENT_CACHE                1
+#define ffconfigEXTENT_CACHE_MAX            BT_CONFIG_FS_FULLFAT_EXTENT_CACHE_MAX
+#endif
+
+#ifdef BT_CONFIG_FS_FULLFAT_DIR_CACHE
+#define ffconfigDIR_CACHE                   1
+#define ffconfigDIR_CACHE_MEMORY            BT_CONFIG_FS_FULLFAT_DIR_CACHE_MEMORY
+#endif
+
 #define ffconfigWRITE_BOTH_FATS             1
 
 #define	ffconfigNAMES_ON_HEAP				BT_CONFIG_FS_FULLFAT_LFN_ON_HEAP
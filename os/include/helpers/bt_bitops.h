@@ -73,12 +73,11 @@ static inline int bt_test_bit(BT_u32 nr, const volatile BT_u32 *addr) {
 	return 1UL & (addr[BT_BIT_WORD(nr)] >> (nr & (BT_BITS_PER_LONG-1)));
 }
 
-#ifndef BT_CONFIG_SMP
+/*
+ *	With BT_CONFIG_SMP kernel critical sections also exclude the other CPUs.
+ */
 #define  _bitops_lock() 	do { BT_kEnterCritical();} while (0)
 #define	 _bitops_unlock() 	do { BT_kExitCritical(); } while (0)
-#else
-#error "Bitops does not currently support SMP systems."
-#endif
 
 static inline void bt_set_bit(BT_u32 nr, volatile BT_u32 *addr) {
         BT_u32 mask = BT_BIT_MASK(nr);
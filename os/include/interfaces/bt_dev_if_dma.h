@@ -0,0 +1,31 @@
+#ifndef _BT_DEV_IF_DMA_H_
+#define _BT_DEV_IF_DMA_H_
+
+#include "bt_types.h"
+
+/**
+ *	A single contiguous copy within a DMA program.
+ *
+ *	Addresses are physical (bus) addresses. A controller may chain any number of
+ *	segments into a single program, and signals completion once, after the last
+ *	segment has been written.
+ **/
+typedef struct _BT_DMA_SEGMENT {
+	bt_paddr_t	src;
+	bt_paddr_t	dst;
+	BT_u32		len;
+	BT_u32		flags;
+	#define BT_DMA_SEG_SRC_FIXED	0x00000001		///< Source is a FIFO register, don't increment.
+	#define BT_DMA_SEG_DST_FIXED	0x00000002		///< Destination is a FIFO register, don't increment.
+} BT_DMA_SEGMENT;
+
+typedef void (*BT_DMA_COMPLETE)(void *pContext, BT_ERROR Status);
+
+typedef struct _BT_DEV_IF_DMA {
+	BT_s32		(*pfnRequestChannel)	(BT_HANDLE hDma, BT_ERROR *pError);
+	BT_ERROR	(*pfnReleaseChannel)	(BT_HANDLE hDma, BT_u32 ulChannel);
+	BT_ERROR	(*pfnSubmit)			(BT_HANDLE hDma, BT_u32 ulChannel, const BT_DMA_SEGMENT *pSegments, BT_u32 ulSegments, BT_DMA_COMPLETE pfnComplete, void *pContext);
+	BT_ERROR	(*pfnAbort)				(BT_HANDLE hDma, BT_u32 ulChannel);
+} BT_DEV_IF_DMA;
+
+#endif
@@ -5,6 +5,8 @@ typedef enum _BT_NET_IF_EVENT {
 	BT_NET_IF_RX_READY,
 	BT_NET_IF_ADD_IF,
 	BT_NET_IF_REMOVE_IF,
+	BT_NET_IF_RX_DROPPED,		///< A frame was lost because the receive ring was full.
+	BT_NET_IF_TX_COMPLETE,		///< Frames were sent after the MAC had reported its ring as full.
 } BT_NET_IF_EVENT;
 
 typedef enum _BT_MAC_EVENT {
@@ -16,12 +18,35 @@ typedef struct _BT_NET_IF BT_NET_IF;
 
 typedef void (*BT_NET_IF_EVENTRECEIVER)(BT_NET_IF *pIF, BT_NET_IF_EVENT eEvent, BT_BOOL bInterruptContext);
 
+/**
+ *	A network stack buffer lent to a MAC by the zero-copy frame interface.
+ *
+ *	pBuffer is opaque to the MAC (for lwIP it is a pbuf) and is handed back as-is.
+ *	Receive buffers are aligned to, and sized in multiples of BT_NET_BUFFER_ALIGN,
+ *	so that a MAC can invalidate them without touching neighbouring data.
+ **/
+typedef struct _BT_NET_BUFFER {
+	void 	   *pBuffer;		///< Network stack's handle for the buffer.
+	void 	   *pData;			///< Frame data (virtual address).
+	BT_u32		ulLength;		///< Buffer size for receive, data length for transmit.
+} BT_NET_BUFFER;
+
+#define BT_NET_BUFFER_ALIGN		32
+
 typedef struct _BT_DEV_IF_EMAC {
 	BT_u32 		ulCapabilities;			///< Primary Capability flags.
 #define	BT_NET_IF_CAPABILITIES_ETHERNET				0x00000001
 #define	BT_NET_IF_CAPABILITIES_100MBPS				0x00000002
 #define	BT_NET_IF_CAPABILITIES_1000MBPS				0x00000004
 #define	BT_NET_IF_CAPABILITIES_MDIX					0x00000008
+#define	BT_NET_IF_CAPABILITIES_ZEROCOPY				0x00000010		///< Implements the zero-copy frame interface below.
+#define	BT_NET_IF_CAPABILITIES_SCATTER_GATHER		0x00000020		///< pfnTxFrame accepts frames of several segments.
+#define	BT_NET_IF_CAPABILITIES_TX_CSUM_IP			0x00000100		///< Generates IPv4 header checksums.
+#define	BT_NET_IF_CAPABILITIES_TX_CSUM_TCP			0x00000200
+#define	BT_NET_IF_CAPABILITIES_TX_CSUM_UDP			0x00000400
+#define	BT_NET_IF_CAPABILITIES_RX_CSUM_IP			0x00001000		///< Drops received frames with a bad IPv4 header checksum.
+#define	BT_NET_IF_CAPABILITIES_RX_CSUM_TCP			0x00002000
+#define	BT_NET_IF_CAPABILITIES_RX_CSUM_UDP			0x00004000
 
 	BT_ERROR 	(*pfnEventSubscribe)	(BT_HANDLE hIF, BT_NET_IF_EVENTRECEIVER pfnReceiver, BT_NET_IF *pIF);
 	BT_ERROR	(*pfnInitialise)		(BT_HANDLE hIF);
@@ -38,6 +63,36 @@ typedef struct _BT_DEV_IF_EMAC {
 	BT_ERROR	(*pfnSendFrame)			(BT_HANDLE hIF);
 	BT_ERROR	(*pfnSendEvent)			(BT_HANDLE hIF, BT_u32 ulEvent);
 
+	/*
+	 *	Zero-copy frame interface, used instead of pfnDataReady .. pfnSendFrame by MACs
+	 *	with BT_NET_IF_CAPABILITIES_ZEROCOPY. The MAC never calls back into the stack,
+	 *	buffers are posted and collected by the stack, under the same protection as pfnWrite.
+	 *
+	 *	pfnRxPostBuffer		Places an empty receive buffer on the RX ring, BT_ERR_GENERIC when the ring is full.
+	 *	pfnRxFrame			Takes the next received frame, returns its pBuffer or NULL.
+	 *	pfnTxFrame			Queues a frame of ulSegments buffers (only one without SCATTER_GATHER),
+	 *						pBuffer is returned by pfnTxReclaim once sent.
+	 *	pfnTxReclaim		Collects up to ulMax pBuffers of frames that have been sent.
+	 *
+	 *	Sent frames are reclaimed in batches by the stack rather than on every completion.
+	 *	After pfnTxFifoReady or pfnTxFrame has reported a full ring, the MAC signals
+	 *	BT_NET_IF_TX_COMPLETE once there is room again.
+	 */
+	BT_ERROR	(*pfnRxPostBuffer)		(BT_HANDLE hIF, const BT_NET_BUFFER *pBuffer);
+	void	   *(*pfnRxFrame)			(BT_HANDLE hIF, BT_u32 *pulLength, BT_ERROR *pError);
+	BT_ERROR	(*pfnTxFrame)			(BT_HANDLE hIF, const BT_NET_BUFFER *pSegments, BT_u32 ulSegments, void *pBuffer);
+	BT_u32		(*pfnTxReclaim)			(BT_HANDLE hIF, void **ppBuffers, BT_u32 ulMax);
+
+	/*
+	 *	Polled receive. A MAC implementing pfnRxInterrupt masks its receive interrupt before
+	 *	signalling BT_NET_IF_RX_READY, the stack then polls the ring and re-enables it once
+	 *	the ring is drained.
+	 *
+	 *	pfnSetRxModeration	Optional, delays receive interrupts by up to ulMicroseconds (0 disables).
+	 */
+	BT_ERROR	(*pfnRxInterrupt)		(BT_HANDLE hIF, BT_BOOL bEnable);
+	BT_ERROR	(*pfnSetRxModeration)	(BT_HANDLE hIF, BT_u32 ulMicroseconds);
+
 	void 		(*adjust_link)			(BT_HANDLE hIF, struct bt_phy_device *phy);
 	void 		(*adjust_state)			(BT_HANDLE hIF, struct bt_phy_device *phy);
 
@@ -2,10 +2,14 @@
 #define _BT_DEV_IF_GTIMER_H_
 
 #include "bt_types.h"
+#include <interrupts/bt_interrupts.h>
 
 typedef struct _BT_DEV_IF_GTIMER {
-	BT_u32	(*pfnGetClockRate)		(BT_HANDLE hTimer, BT_ERROR *pError);
-	BT_u64	(*pfnGetValue)			(BT_HANDLE hTimer, BT_ERROR *pError);
+	BT_u32		(*pfnGetClockRate)		(BT_HANDLE hTimer, BT_ERROR *pError);
+	BT_u64		(*pfnGetValue)			(BT_HANDLE hTimer, BT_ERROR *pError);
+	BT_ERROR	(*pfnRegisterInterrupt)	(BT_HANDLE hTimer, BT_FN_INTERRUPT_HANDLER pfnHandler, void *pParam);
+	BT_ERROR	(*pfnSetCompare)		(BT_HANDLE hTimer, BT_u64 ullValue);	///< Interrupt once the value reaches ullValue.
+	BT_ERROR	(*pfnClearCompare)		(BT_HANDLE hTimer);
 } BT_DEV_IF_GTIMER;
 
 #endif
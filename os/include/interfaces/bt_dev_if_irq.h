@@ -21,6 +21,8 @@ typedef struct _BT_DEV_IF_IRQ {
 	BT_ERROR 		(*pfnUnmaskInterrupts)	(BT_HANDLE hIRQ, BT_u32 ulNewMaskValue);
 	BT_u32			(*pfnGetCount)			(BT_HANDLE hIRQ, BT_u32 ulIRQ);
 	BT_s32			(*pfnGetActiveInterrupt)(BT_HANDLE hIRQ, BT_ERROR *pError);
+	BT_ERROR		(*pfnInitCPU)			(BT_HANDLE hIRQ);												///< Optional, sets up the calling CPU's interface.
+	BT_ERROR		(*pfnSendSGI)			(BT_HANDLE hIRQ, BT_u32 ulSGI, BT_u32 ulCPUMask);				///< Optional, raises a software interrupt on other CPUs.
 } BT_DEV_IF_IRQ;
 
 
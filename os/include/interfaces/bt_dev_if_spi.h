@@ -20,7 +20,7 @@ typedef struct _BT_SPI_MASTER {
 	const BT_DEVICE    *pDevice;
 	BT_u16 				bus_num;
 	BT_u16				num_chipselect;
-	BT_u16				dma_alignment;
+	BT_u16				dma_alignment;				//< pfnTransferDma buffers, and receive lengths, must be multiples of this.
 	BT_u16				mode_bits;
 	BT_u16				flags;
 #define SPI_MASTER_HALF_DUPLEX	BT_BIT(0)		/* can't do full duplex */
@@ -28,6 +28,7 @@ typedef struct _BT_SPI_MASTER {
 #define SPI_MASTER_NO_TX		BT_BIT(2)		/* can't do buffer write */
 #define SPI_MASTER_U_PAGE		BT_BIT(3)		/* select upper flash */
 #define SPI_MASTER_QUAD_MODE	BT_BIT(4)		/* support quad mode */
+	BT_u32				dma_threshold;				//< messages this long or longer use pfnTransferDma (0 disables).
 	struct spi_bus_item *bus_item; 				//< internal data
 } BT_SPI_MASTER;
 
@@ -79,6 +80,12 @@ typedef struct _BT_SPI_MESSAGE {
 typedef struct {
 	BT_ERROR	(*pfnSetup)		(BT_HANDLE hMaster, BT_SPI_DEVICE *pDevice);
 	BT_s32	 	(*pfnTransfer) 	(BT_HANDLE hMaster, BT_SPI_MESSAGE *message);
+	/*
+	 *	Optional, may return BT_ERR_UNSUPPORTED_FLAG for messages it cannot offload, in
+	 *	which case the message is passed to pfnTransfer instead.
+	 *	The message's complete callback may be called from interrupt context.
+	 */
+	BT_s32		(*pfnTransferDma)	(BT_HANDLE hMaster, BT_SPI_MESSAGE *message);
 } BT_DEV_IF_SPI;
 
 /*
@@ -90,6 +97,7 @@ void BT_SpiMessageAddTail(BT_SPI_TRANSFER *pTransfer, BT_SPI_MESSAGE *pMessage);
 void BT_SpiTransferDel(BT_SPI_TRANSFER *pTransfer);
 BT_ERROR BT_SpiSetup(BT_SPI_DEVICE *pDevice);
 BT_ERROR BT_SpiSync(BT_SPI_DEVICE *pDevice, BT_SPI_MESSAGE *pMessage);
+BT_ERROR BT_SpiAsync(BT_SPI_DEVICE *pDevice, BT_SPI_MESSAGE *pMessage);
 BT_ERROR BT_SpiBusLock(BT_SPI_MASTER *pMaster);
 BT_ERROR BT_SpiBusUnlock(BT_SPI_MASTER *pMaster);
 
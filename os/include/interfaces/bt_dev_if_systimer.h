@@ -14,6 +14,7 @@ typedef struct _BT_DEV_IF_SYSTIMER {
 	BT_u32		(*pfnGetOffset)			(BT_HANDLE hTimer, BT_ERROR *pError);
 	BT_ERROR	(*pfnStart)				(BT_HANDLE hTimer);
 	BT_ERROR	(*pfnStop)				(BT_HANDLE hTimer);
+	BT_ERROR	(*pfnRestart)			(BT_HANDLE hTimer, BT_u32 ulOffset);	///< Restart a stopped timer ulOffset counts into its period.
 } BT_DEV_IF_SYSTIMER;
 
 #endif
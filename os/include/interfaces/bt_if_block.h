@@ -15,11 +15,14 @@
  *	@pfnReadBlocks	[OPTIONAL]	Reads the specified blocks from the block device.
  *	@pfnWriteBlocks	[OPTIONAL]	Writes the specified blocks from the block device.
  *	@pfnRequest		[OPTIONAL]	Implements a request queue processor callback function.
+ *	@pfnMapBlocks	[OPTIONAL]	Returns a CPU pointer to the backing storage of the specified blocks,
+ *								for memory based devices that can be accessed without copying.
  *
  **/
 typedef struct _BT_IF_BLOCK {
 	BT_s32		(*pfnReadBlocks)	(BT_HANDLE hBlock, BT_u32 ulBlock, BT_u32 ulCount, void *pBuffer);
 	BT_s32		(*pfnWriteBlocks)	(BT_HANDLE hBlock, BT_u32 ulBlock, BT_u32 ulCount, void *pBuffer);
+	void	   *(*pfnMapBlocks)		(BT_HANDLE hBlock, BT_u32 ulBlock, BT_u32 ulCount, BT_ERROR *pError);
 } BT_IF_BLOCK;
 
 
@@ -22,6 +22,7 @@
 #include "bt_dev_if_emac.h"
 #include "bt_dev_if_qei.h"
 #include "bt_dev_if_mcpwm.h"
+#include "bt_dev_if_dma.h"
 
 typedef enum _BT_DEV_IF_TYPE {
 	BT_DEV_IF_T_NONE=0,
@@ -46,6 +47,7 @@ typedef enum _BT_DEV_IF_TYPE {
 	BT_DEV_IF_T_PHY,
 	BT_DEV_IF_T_RTC,
 	BT_DEV_IF_T_QEI,
+	BT_DEV_IF_T_DMA,
 } BT_DEV_IF_TYPE;
 
 /**
@@ -88,6 +90,7 @@ typedef union {
 	const BT_DEV_IF_PHY		   *pPhyIF;
 	const BT_DEV_IF_RTC		   *pRTCIF;
 	const BT_DEV_IF_QEI		   *pQEIIF;
+	const BT_DEV_IF_DMA		   *pDmaIF;
 } BT_DEV_IFS;
 
 #define BT_IF_GPIO_OPS(handle)		BT_IF_DEV_CONFIG(handle).pGpioIF
@@ -110,6 +113,7 @@ typedef union {
 #define BT_IF_SDIO_OPS(handle)		BT_IF_DEV_CONFIG(handle).pSdioIF
 #define	BT_IF_RTC_OPS(handle)		BT_IF_DEV_CONFIG(handle).pRTCIF
 #define	BT_IF_QEI_OPS(handle)		BT_IF_DEV_CONFIG(handle).pQEIIF
+#define	BT_IF_DMA_OPS(handle)		BT_IF_DEV_CONFIG(handle).pDmaIF
 
 typedef struct _BT_IF_DEVICE {
 	const BT_IF_POWER	   *pPowerIF;
@@ -1,6 +1,8 @@
 #ifndef _BT_IF_FILE_H_
 #define _BT_IF_FILE_H_
 
+struct bt_poll_table;
+
 /**
  *	@brief		Defines the interface for reading or writing from FILES or FILE-like devices/modules.
  *
@@ -27,6 +29,9 @@
  *
  *	@pfnEOF		[OPTIONAL]	Returs true if eof is reached
  *
+ *	@pfnPoll	[OPTIONAL]	Returns the current BT_POLL* readiness of hFile, and passes pTable to bt_poll_wait() for
+ *							each bt_poll_queue that is woken when the readiness changes. Required by BT_PollCtl().
+ *
  *	@ulSupported			A mask of FILE flags supported. @ref os/include/fs/bt_file.h for file flags.
  *
  **/
@@ -39,6 +44,7 @@ typedef struct _BT_IF_FILE {
 	BT_u64		(*pfnTell)	(BT_HANDLE hFile, BT_ERROR *pError);
 	BT_ERROR	(*pfnFlush)	(BT_HANDLE hFile);
 	BT_BOOL		(*pfnEOF)	(BT_HANDLE hFile);
+	BT_u32		(*pfnPoll)	(BT_HANDLE hFile, struct bt_poll_table *pTable);
 	BT_u32		ulSupported;
 } BT_IF_FILE;
 
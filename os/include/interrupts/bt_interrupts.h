@@ -50,4 +50,49 @@ BT_s32		BT_GetActiveInterrupt			(BT_ERROR *pError);
  **/
 BT_ERROR 	BT_SetInterruptAffinity			(BT_u32 ulIRQ, BT_u32 ulCPU, BT_BOOL bReceive);
 
+/**
+ *	@brief		Sets up the interrupt controller interface of the calling CPU.
+ *
+ *	Called by each secondary CPU as it comes online, the boot CPU's is set up by the probe.
+ **/
+BT_ERROR	BT_InitInterruptCPU				();
+
+/**
+ *	@brief		Raises software interrupt ulSGI on the CPUs in ulCPUMask.
+ *
+ *	Software interrupts are the first 16 interrupt numbers of the controller, and their
+ *	handlers are registered with BT_RegisterInterrupt() like any other.
+ **/
+BT_ERROR	BT_SendSoftwareInterrupt		(BT_u32 ulSGI, BT_u32 ulCPUMask);
+
+#define BT_IRQ_WAKE_THREAD	1		///< Returned by a hard handler to run the thread handler.
+
+struct bt_irq_thread_stats {
+	BT_u32		ulIRQ;
+	BT_u32		ulPriority;
+	BT_u32		ulWakeups;			///< Times the hard handler woke the thread.
+	BT_u32		ulRuns;				///< Times the thread handler ran, wakes before it runs are merged.
+	BT_u32		ulWorstLatencyUs;	///< Longest time from a wake to the thread handler starting.
+	BT_u32		ulWorstRunUs;		///< Longest thread handler run.
+};
+
+/**
+ *	@brief		Registers an interrupt whose work is done by a kernel thread.
+ *
+ *	@ulIRQ				Interrupt Number
+ *	@pfnHandler			Runs in the ISR, returns BT_IRQ_WAKE_THREAD to schedule pfnThreadHandler.
+ *						If NULL the line is disabled until pfnThreadHandler has run.
+ *	@pfnThreadHandler	Runs in the thread of the given kernel priority, shared by all the
+ *						threaded interrupts of that priority.
+ *
+ *	@return 	BT_ERR_NONE on success.
+ **/
+BT_ERROR	BT_RegisterThreadedInterrupt	(BT_u32 ulIRQ, BT_FN_INTERRUPT_HANDLER pfnHandler, BT_FN_INTERRUPT_HANDLER pfnThreadHandler, void *pParam, BT_u32 ulPriority);
+BT_ERROR	BT_UnregisterThreadedInterrupt	(BT_u32 ulIRQ, void *pParam);
+
+/**
+ *	@brief	Fills pStats with the counters of up to ulMax threaded interrupts, returns the number filled in.
+ **/
+BT_u32		BT_GetThreadedInterruptStats	(struct bt_irq_thread_stats *pStats, BT_u32 ulMax);
+
 #endif
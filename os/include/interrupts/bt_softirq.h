@@ -7,10 +7,6 @@
 #ifndef _BT_SOFTIRQ_H_
 #define _BT_SOFTIRQ_H_
 
-#ifndef BT_CONFIG_SOFTIRQ_MAX
-#define BT_CONFIG_SOFTIRQ_MAX	32
-#endif
-
 #ifndef BT_CONFIG_SOFTIRQ_PRIORITY
 #define BT_CONFIG_SOFTIRQ_PRIORITY	0
 #endif
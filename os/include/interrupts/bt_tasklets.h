@@ -3,11 +3,17 @@
  *
  *	BT Tasklets run in a SoftIRQ context, i.e. they run from
  *	a normal thread/process context.
+ *
+ *	Each priority has its own queue, run in the order the tasklets were scheduled.
+ *	A tasklet scheduled again while it is queued runs once; scheduled while it runs,
+ *	it runs again afterwards.
  **/
 
 #ifndef _BT_TASKLETS_H_
 #define _BT_TASKLETS_H_
 
+#include <collections/bt_lifo.h>
+
 typedef void (*BT_TASKLET_HANDLER)(void *pData);
 
 typedef enum _BT_TASKLET_STATE {
@@ -17,18 +23,31 @@ typedef enum _BT_TASKLET_STATE {
 } BT_TASKLET_STATE;
 
 typedef struct _BT_TASKLET {
-	struct _BT_TASKLET *pNext;
-	BT_TASKLET_STATE	eState;
-	BT_TASKLET_HANDLER	pfnHandler;
-	void 			   *pData;
+	struct bt_lifo_node			node;
+	volatile BT_TASKLET_STATE	eState;
+	BT_TASKLET_HANDLER			pfnHandler;
+	void 			   		   *pData;
+	BT_u32						ulQueued;			///< Times the tasklet was queued.
+	BT_u32						ulRun;				///< Times the handler ran.
+	BT_u64						ullScheduled;		///< Global timer when it was last queued.
+	BT_u64						ullWorstLatency;	///< Longest time queued, in global timer ticks.
 } BT_TASKLET;
 
+#define BT_TASKLET_INIT(handler, data)	{ .eState = BT_TASKLET_IDLE, .pfnHandler = handler, .pData = data }
 
 /**
+ *	@brief	Queues a tasklet on the normal or the high priority queue.
  *
- *
+ *	The FromISR variants must be used from interrupt handlers.
+ **/
+BT_ERROR BT_TaskletSchedule				(BT_TASKLET *pTasklet);
+BT_ERROR BT_TaskletHighSchedule			(BT_TASKLET *pTasklet);
+BT_ERROR BT_TaskletScheduleFromISR		(BT_TASKLET *pTasklet);
+BT_ERROR BT_TaskletHighScheduleFromISR	(BT_TASKLET *pTasklet);
+
+/**
+ *	@brief	Longest time the tasklet waited in its queue, in microseconds.
  **/
-BT_ERROR BT_TaskletSchedule		(BT_TASKLET *pTasklet);
-BT_ERROR BT_TaskletHighSchedule	(BT_TASKLET *pTasklet);
+BT_u32	 BT_TaskletWorstLatency			(BT_TASKLET *pTasklet);
 
 #endif
@@ -0,0 +1,53 @@
+/**
+ *	BT Work queues.
+ *
+ *	A work item is embedded in the structure it works on, and queued from any thread
+ *	or ISR without allocating or masking interrupts. Each queue has a worker thread
+ *	of its own priority, which runs the items oldest first. The worker is only woken
+ *	through the kernel when it is idle, so a burst of items costs a single wake.
+ *
+ *	An item queued again before it runs, runs once. Queued again while it runs, it
+ *	runs again afterwards.
+ **/
+
+#ifndef _BT_WORKQUEUE_H_
+#define _BT_WORKQUEUE_H_
+
+#include <collections/bt_lifo.h>
+
+struct _BT_WORK;
+
+typedef void (*BT_WORK_HANDLER)(struct _BT_WORK *pWork);
+
+typedef struct _BT_WORK {
+	struct bt_lifo_node	node;
+	volatile BT_u32		ulPending;
+	BT_WORK_HANDLER		pfnHandler;
+} BT_WORK;
+
+#define BT_WORK_INIT(handler)	{ .ulPending = 0, .pfnHandler = handler }
+
+typedef struct _BT_WORKQUEUE BT_WORKQUEUE;
+
+typedef struct _BT_WORKQUEUE_CONFIG {
+	BT_u32		ulStackDepth;
+	BT_u32		ulPriority;
+} BT_WORKQUEUE_CONFIG;
+
+static inline void BT_InitWork(BT_WORK *pWork, BT_WORK_HANDLER pfnHandler) {
+	pWork->node.next = NULL;
+	pWork->ulPending = 0;
+	pWork->pfnHandler = pfnHandler;
+}
+
+BT_WORKQUEUE   *BT_CreateWorkQueue		(const BT_WORKQUEUE_CONFIG *pConfig, BT_ERROR *pError);
+
+/**
+ *	@brief	Queues pWork on pQueue, or on the system work queue if pQueue is NULL.
+ *
+ *	@return	BT_FALSE if the item was already queued.
+ **/
+BT_BOOL			BT_QueueWork			(BT_WORKQUEUE *pQueue, BT_WORK *pWork);
+BT_BOOL			BT_QueueWorkFromISR		(BT_WORKQUEUE *pQueue, BT_WORK *pWork);
+
+#endif
@@ -20,7 +20,7 @@ typedef struct _BT_CACHE {
 	struct block_free  	   *free;
 	BT_u32					allocated;
 	BT_u32					available;
-	void 				   *slab_mutex;
+	struct bt_lock			slab_lock;
 } BT_CACHE;
 
 struct bt_cache_info {
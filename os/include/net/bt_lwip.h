@@ -3,15 +3,35 @@
 
 #include <bitthunder.h>
 #include "../src/net/lwip/src/include/lwip/netif.h"
+#include <collections/bt_lifo.h>
+#include <collections/bt_spsc.h>
+
+struct tcpip_callback_msg;
 
 typedef struct _BT_NETIF_PRIV {
 	BT_NET_IF base;
 	struct netif netif;
+	struct bt_lifo			rx_free;		///< Receive buffers of a zero-copy MAC that are not on its ring.
+	void				   *rx_pool;		///< Block the receive buffers are carved from.
+	BT_u32					rx_buffers;		///< Receive buffers reserved for a zero-copy MAC.
+	BT_u32					rx_size;
+	struct bt_spsc			rx_queue;		///< Received frames, from the interface's receive worker to the lwIP thread.
+	void				   *rx_slots[BT_CONFIG_NET_LWIP_RX_QUEUE_SIZE];
+	struct tcpip_callback_msg *rx_msg;		///< Posted to the lwIP thread when rx_queue becomes non-empty.
+	BT_u32					rx_armed;		///< rx_msg is posted and not yet running.
+	BT_u32					rx_stalled;		///< The receive worker waits for lwip_rx_drain() to make room in rx_queue.
 } BT_NETIF_PRIV;
 
+/*
+ *	Results of bt_lwip_process().
+ */
+#define BT_LWIP_RX_DONE		0	///< The MAC's ring is drained and its receive interrupt enabled.
+#define BT_LWIP_RX_MORE		1	///< The budget was used up, poll again.
+#define BT_LWIP_RX_STALLED	2	///< lwIP is behind, wait for bt_net_rx_resume().
 
 BT_ERROR	bt_lwip_netif_init	(BT_NETIF_PRIV *pIF);
-void		bt_lwip_process		(BT_NETIF_PRIV *pIF);
+BT_u32		bt_lwip_process		(BT_NETIF_PRIV *pIF);
+void		bt_lwip_tx_process	(BT_NETIF_PRIV *pIF);
 
 
 BT_ERROR bt_lwip_netif_up(BT_NETIF_PRIV *pIF);
@@ -20,5 +40,7 @@ BT_ERROR bt_lwip_netif_set_addr(BT_NETIF_PRIV *pIF, BT_IPADDRESS *ip, BT_IPADDRE
 BT_ERROR bt_lwip_netif_get_addr(BT_NETIF_PRIV *pIF, BT_IPADDRESS *ip, BT_IPADDRESS *netmask, BT_IPADDRESS *gw);
 BT_BOOL bt_lwip_netif_dhcp_done(BT_NETIF_PRIV *pIF);
 BT_ERROR bt_lwip_netif_get_hostname(BT_NETIF_PRIV *pIF, char *hostname);
+BT_u32 bt_lwip_allocations(void);
+BT_u32 bt_lwip_pool_stats(struct bt_net_pool_stats *pStats, BT_u32 ulMax);
 
 #endif
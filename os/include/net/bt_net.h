@@ -5,6 +5,18 @@
 #include <collections/bt_list.h>
 #include "bt_phy.h"
 
+/**
+ *	Receive path counters, frames per poll is ulFrames / ulPolls.
+ **/
+struct bt_netif_rx_stats {
+	BT_u32	ulInterrupts;		///< BT_NET_IF_RX_READY events signalled by the MAC.
+	BT_u32	ulPolls;			///< Passes of the network thread over the receive ring.
+	BT_u32	ulFrames;			///< Frames handed to the stack.
+	BT_u32	ulBudgetExhausted;	///< Polls that stopped at the budget with frames still pending.
+	BT_u32	ulRingFull;			///< Times the MAC dropped a frame because the receive ring was full.
+	BT_u32	ulQueueFull;		///< Polls that stopped because the lwIP thread had not taken the previous frames.
+};
+
 typedef struct _BT_NET_IF {
 	struct bt_list_head		item;
 	const BT_i8 		   *name;
@@ -15,6 +27,7 @@ typedef struct _BT_NET_IF {
 	BT_u32 					ulFlags;
 
 #define	DATA_READY			0x00000001
+#define	TX_READY			0x00000002
 
 	BT_u32 					ulIFFlags;
 #define	BT_NETIF_FLAG_UP				0x00000001
@@ -33,6 +46,8 @@ typedef struct _BT_NET_IF {
 
 	const BT_DEV_IF_EMAC   *pOps;
 	BT_u32					ulID;
+	struct bt_netif_rx_stats	rx_stats;
+	BT_u32					ulBytesCopied;	///< Frame bytes the stack copied to or from MAC buffers, or to linearise a frame.
 } BT_NET_IF;
 
 
@@ -69,6 +84,26 @@ BT_ERROR BT_NetifConfigureLink(BT_NET_IF *interface, struct bt_phy_config *confi
 BT_ERROR BT_NetifRestartLink(BT_NET_IF *interface);
 
 BT_ERROR BT_NetifGetLinkState(BT_NET_IF *interface, struct bt_phy_linkstate *linkstate);
+BT_ERROR BT_NetifGetRxStats(BT_NET_IF *interface, struct bt_netif_rx_stats *stats);
+
+/**
+ *	@brief	Total number of buffer allocations made by the TCP/IP stack, from its heap and pools.
+ **/
+BT_u32 BT_NetGetAllocations();
+
+struct bt_net_pool_stats {
+	const BT_i8	   *szpName;
+	BT_u32			ulSize;		///< Bytes per element.
+	BT_u32			ulTotal;	///< Elements reserved.
+	BT_u32			ulUsed;
+	BT_u32			ulMax;		///< High-water mark of ulUsed.
+	BT_u32			ulErrors;	///< Allocations that failed because the pool was empty.
+};
+
+/**
+ *	@brief	Usage of the TCP/IP stack's memory pools, returns the number of entries filled in.
+ **/
+BT_u32 BT_NetGetPoolStats(struct bt_net_pool_stats *pStats, BT_u32 ulMax);
 
 BT_ERROR BT_StartNetif(BT_NET_IF *interface);
 BT_ERROR BT_StopNetif(BT_NET_IF *interface);
@@ -76,5 +111,6 @@ BT_ERROR BT_StopNetif(BT_NET_IF *interface);
 BT_ERROR BT_NetifGetHostname(BT_NET_IF *interface, char *hostname);
 
 BT_ERROR bt_netif_adjust_link(BT_NET_IF *netif);
+void bt_net_rx_resume(BT_NET_IF *netif);
 
 #endif
@@ -150,6 +150,24 @@ int write(int s, const void *dataptr, size_t size);
 int ioctl(int s, long cmd, void *argp);
 int fcntl(int s, int cmd, int val);
 
+/**
+ *	@brief	Sends ulLength bytes of hFile, starting at ullOffset, on a connected TCP socket.
+ *
+ *	The file is read straight into a few chunks that are queued on the connection by
+ *	reference, without copying them into the stack's buffers. Returns once the stack
+ *	has released every reference to the chunks, i.e. all data was acknowledged by the
+ *	peer or the connection is gone.
+ *
+ *	At most BT_SENDFILE_MAX bytes are sent per call, so that the count fits the return
+ *	value. Call again from the new offset for the rest of a larger file.
+ *
+ *	@return	The number of bytes sent, or a negative BT_ERROR if reading the file or
+ *			sending failed, or the connection failed before all data was acknowledged.
+ **/
+#define BT_SENDFILE_MAX		0x7FFFFFFF
+
+BT_s32 BT_SendFile(BT_HANDLE hSocket, BT_HANDLE hFile, BT_u64 ullOffset, BT_u32 ulLength);
+
 
 
 #endif
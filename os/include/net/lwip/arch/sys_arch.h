@@ -21,6 +21,18 @@ typedef BT_s32				sys_prot_t;
 #define sys_sem_valid( x ) ( ( ( *x ) == NULL) ? BT_FALSE : BT_TRUE )
 #define sys_sem_set_invalid( x ) ( ( *x ) = NULL )
 
+/*
+ *	Statistics of the lock-free memp pools are updated atomically, rather than under SYS_ARCH_PROTECT.
+ */
+#define SYS_ARCH_INC(var, val)		__atomic_add_fetch(&(var), (val), __ATOMIC_RELAXED)
+#define SYS_ARCH_DEC(var, val)		__atomic_sub_fetch(&(var), (val), __ATOMIC_RELAXED)
+#define SYS_ARCH_MAX(var, val)																\
+	do {																					\
+		__typeof__(var) _max = (var);														\
+		while((val) > _max && !__atomic_compare_exchange_n(&(var), &_max, (val), 1,			\
+														   __ATOMIC_RELAXED, __ATOMIC_RELAXED));	\
+	} while(0)
+
 
 #endif /* __ARCH_SYS_ARCH_H__ */
 
@@ -60,14 +60,16 @@
 #define DEFAULT_TCP_RECVMBOX_SIZE       10
 #define DEFAULT_ACCEPTMBOX_SIZE         10
 
+/*
+ *	Checksums are generated and checked in software, except on interfaces whose MAC
+ *	offloads them (BT_NET_IF_CAPABILITIES_TX_CSUM_* / RX_CSUM_*).
+ */
+#define CHECKSUM_GEN_IP					1
+#define CHECKSUM_GEN_UDP				1
+#define CHECKSUM_GEN_TCP 				1
+
 #ifdef BT_CONFIG_NET_LWIP_GEN_CHECKSUM
-	#define CHECKSUM_GEN_IP					0
-	#define CHECKSUM_GEN_UDP				0
-	#define CHECKSUM_GEN_TCP 				0
-#else
-	#define CHECKSUM_GEN_IP					1
-	#define CHECKSUM_GEN_UDP				1
-	#define CHECKSUM_GEN_TCP 				1
+	#define LWIP_CHECKSUM_CTRL_PER_NETIF	1
 #endif
 
 #define MEMP_NUM_PBUF					BT_CONFIG_NET_LWIP_MEMP_NUM_PBUF
@@ -91,6 +93,31 @@
 #define ARP_TABLE_SIZE 					BT_CONFIG_NET_LWIP_ARP_TABLE_SIZE
 #define IP_REASS_MAX_PBUFS				BT_CONFIG_NET_LWIP_IP_REASS_MAX_PBUFS
 
+/*
+ *	Every pool is a cache line aligned array of its own, see memp.c.
+ */
+#define MEMP_SEPARATE_POOLS				1
+#define MEMP_ELEMENT_ALIGNMENT			BT_CONFIG_NET_LWIP_MEMP_ALIGN
+#define MEMP_POOL_ATTRIBUTE				__attribute__((aligned(BT_CONFIG_NET_LWIP_MEMP_ALIGN)))
+
+#ifdef BT_CONFIG_NET_LWIP_MEMP_LOCKFREE
+#include <collections/bt_lifo.h>
+/* Pools that are allocated from and freed to without SYS_ARCH_PROTECT */
+#if BT_CONFIG_USE_TCP
+#define MEMP_LOCKFREE_POOL(type)		((type) == MEMP_PBUF || (type) == MEMP_PBUF_POOL || (type) == MEMP_TCP_SEG)
+#else
+#define MEMP_LOCKFREE_POOL(type)		((type) == MEMP_PBUF || (type) == MEMP_PBUF_POOL)
+#endif
+#define MEMP_LOCKFREE_PUSH(head, elem)	bt_lifo_push((struct bt_lifo *) (head), (struct bt_lifo_node *) (elem))
+#define MEMP_LOCKFREE_POP(head)			((void *) bt_lifo_pop((struct bt_lifo *) (head)))
+#endif
+
+#ifdef BT_CONFIG_POLL
+/* Socket readiness changes wake BT_PollWait() callers, see os/src/net/bt_sockets.c */
+void bt_socket_event(int s, int events);
+#define LWIP_SOCKET_EVENT_HOOK(s, events)	bt_socket_event(s, events)
+#endif
+
 
 
 
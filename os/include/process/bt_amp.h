@@ -0,0 +1,73 @@
+/**
+ *	BT Asymmetric multiprocessing.
+ *
+ *	CPU0 runs the kernel, CPU1 runs a bare-metal main of its own on memory reserved
+ *	from the page allocator, without a scheduler or interrupts other than the channel's.
+ *	The two talk over a message channel in that memory: a ring of fixed size slots in
+ *	each direction, filled and emptied in place, and a software interrupt to wake the
+ *	other side only when it sleeps on an empty ring.
+ *
+ *	The same calls are used on both cores, each side sends on its own ring. Each ring
+ *	has a single producer and a single consumer, so on CPU0 only one thread may send
+ *	and only one thread may receive at a time. Received messages are released in the
+ *	order they were received.
+ *
+ *	The remote main must not call into the kernel.
+ **/
+
+#ifndef _BT_AMP_H_
+#define _BT_AMP_H_
+
+#include <bt_types.h>
+
+#define BT_AMP_REMOTE_CPU	1
+#define BT_AMP_IPI			1		///< Software interrupt used as the channel doorbell.
+
+typedef void (*BT_AMP_REMOTE_MAIN)(void *pParam);
+
+/**
+ *	@brief	Starts pfnMain on the remote core, only once.
+ *
+ *	@return	BT_ERR_BUSY if the remote core was already started.
+ **/
+BT_ERROR	BT_AmpStartRemote		(BT_AMP_REMOTE_MAIN pfnMain, void *pParam);
+BT_BOOL		BT_AmpRemoteOnline		(void);
+
+/**
+ *	@brief	Memory of the remote core that is not used by the channel or its stack.
+ **/
+void	   *BT_AmpRemoteMemory		(BT_u32 *pulSize);
+
+/**
+ *	@brief	Bytes a message can hold.
+ **/
+BT_u32		BT_AmpMessageSize		(void);
+
+/**
+ *	@brief	Returns the next free slot of this side's ring to write a message into.
+ *
+ *	@return	NULL if the ring is full.
+ **/
+void	   *BT_AmpAllocMessage		(void);
+
+/**
+ *	@brief	Hands the slot returned by BT_AmpAllocMessage() over to the other core.
+ **/
+BT_ERROR	BT_AmpSendMessage		(void *pMessage, BT_u32 ulLength);
+
+/**
+ *	@brief	Returns the oldest message from the other core, in place.
+ *
+ *	On CPU0 the thread sleeps for at most ulTimeout ticks. The remote core only polls
+ *	when ulTimeout is 0, otherwise it waits until a message arrives.
+ *
+ *	@return NULL if no message arrived in time.
+ **/
+void	   *BT_AmpReceiveMessage	(BT_u32 *pulLength, BT_TICK ulTimeout);
+
+/**
+ *	@brief	Gives the slot of the oldest received message back to the sender.
+ **/
+void		BT_AmpReleaseMessage	(void *pMessage);
+
+#endif
@@ -0,0 +1,84 @@
+/**
+ *	Lightweight kernel lock, for short critical sections in kernel code.
+ *
+ *	An uncontended bt_lock() / bt_unlock() is a single atomic compare-and-swap or
+ *	swap on the lock word (LDREX/STREX on ARMv6+ and Cortex-M3+), without entering
+ *	the scheduler or masking interrupts. Only when the lock is contended does a
+ *	thread sleep, on a binary semaphore that the releasing thread signals.
+ *
+ *	The lock word is 0 when free, 1 when held, and 2 when held with possible waiters.
+ *
+ *	Unlike BT_kMutexCreate() there is no priority inheritance, so hold it only for a
+ *	bounded number of instructions. Never use it from an ISR. Targets without a native
+ *	compare-and-swap fall back to a kernel mutex.
+ **/
+
+#ifndef _BT_LOCK_H_
+#define _BT_LOCK_H_
+
+#include <bt_types.h>
+
+#define BT_LOCK_FREE		0
+#define BT_LOCK_HELD		1
+#define BT_LOCK_WAITERS		2
+
+struct bt_lock {
+	volatile BT_u32	ulState;
+	void		   *pWait;			///< Semaphore contended threads sleep on.
+};
+
+/**
+ *	@brief	Creates the wait semaphore of a lock.
+ *
+ *	A zeroed lock may be taken before this, while only one thread can contend for it,
+ *	e.g. before the scheduler is started.
+ **/
+BT_ERROR	bt_lock_init	(struct bt_lock *pLock);
+void		bt_lock_destroy	(struct bt_lock *pLock);
+
+void		bt_lock_slow	(struct bt_lock *pLock);
+void		bt_unlock_slow	(struct bt_lock *pLock);
+
+#ifdef __GCC_HAVE_SYNC_COMPARE_AND_SWAP_4
+
+#define BT_LOCK_ATOMIC		1
+
+static inline void bt_lock(struct bt_lock *pLock) {
+	BT_u32 ulFree = BT_LOCK_FREE;
+	if(!__atomic_compare_exchange_n(&pLock->ulState, &ulFree, BT_LOCK_HELD, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+		bt_lock_slow(pLock);
+	}
+}
+
+static inline BT_BOOL bt_trylock(struct bt_lock *pLock) {
+	BT_u32 ulFree = BT_LOCK_FREE;
+	return __atomic_compare_exchange_n(&pLock->ulState, &ulFree, BT_LOCK_HELD, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED) ? BT_TRUE : BT_FALSE;
+}
+
+static inline void bt_unlock(struct bt_lock *pLock) {
+	if(__atomic_exchange_n(&pLock->ulState, BT_LOCK_FREE, __ATOMIC_RELEASE) == BT_LOCK_WAITERS) {
+		bt_unlock_slow(pLock);
+	}
+}
+
+#else
+
+#include <bt_kernel.h>
+
+#define BT_LOCK_ATOMIC		0
+
+static inline void bt_lock(struct bt_lock *pLock) {
+	bt_lock_slow(pLock);
+}
+
+static inline BT_BOOL bt_trylock(struct bt_lock *pLock) {
+	return pLock->pWait ? BT_kMutexPend(pLock->pWait, 0) : BT_TRUE;
+}
+
+static inline void bt_unlock(struct bt_lock *pLock) {
+	bt_unlock_slow(pLock);
+}
+
+#endif
+
+#endif
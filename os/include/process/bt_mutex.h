@@ -1,8 +1,31 @@
 #ifndef _BT_MUTEX_H_
 #define _BT_MUTEX_H_
 
+/**
+ *	@brief	Creates a mutex with priority inheritance.
+ *
+ *	While a thread is blocked on the mutex, the holder runs at the blocked thread's
+ *	priority. The mutex must be released by the thread that holds it, never from an
+ *	ISR; use BT_CreateSemaphore() to signal between threads or from ISRs.
+ *
+ **/
 BT_HANDLE 	BT_CreateMutex			(BT_ERROR *pError);
 
+/**
+ *	@brief	Creates a priority inheritance mutex that its holder may pend on again,
+ *			with BT_PendMutexRecursive() and BT_ReleaseMutexRecursive().
+ **/
+BT_HANDLE	BT_CreateRecursiveMutex	(BT_ERROR *pError);
+
+/**
+ *	@brief	Creates a binary semaphore, initially available.
+ *
+ *	Pended and released with the mutex calls, it may be released by any thread or
+ *	with BT_ReleaseMutexFromISR().
+ *
+ **/
+BT_HANDLE	BT_CreateSemaphore		(BT_ERROR *pError);
+
 /**
  *	@brief	Pends on a Mutex resource for the specified timeout.
  *
@@ -5,6 +5,26 @@
 
 #define BT_PATH_MAX		2600
 
+#define BT_FD_INLINE	32			///< Descriptors a process holds before its table is allocated.
+
+#define BT_FD_CLOEXEC	0x00000001	///< Descriptor flag, not inherited by child processes.
+
+/**
+ *	Descriptors index the handle array directly, and a bitmap marks the allocated ones.
+ *	The table starts out in the task itself and doubles when it runs out, up to
+ *	BT_CONFIG_PROCESS_MAX_FDS. It is only accessed in critical sections.
+ **/
+struct bt_fdtable {
+	BT_u32				ulMax;						///< Descriptors the arrays hold, a multiple of 32.
+	BT_u32				ulFree;						///< No descriptor below this one is free.
+	BT_HANDLE		   *fds;
+	BT_u32			   *open;						///< Bitmap of allocated descriptors.
+	BT_u32			   *cloexec;					///< Bitmap of descriptors with BT_FD_CLOEXEC.
+	BT_HANDLE			inline_fds[BT_FD_INLINE];
+	BT_u32				inline_open[BT_FD_INLINE / 32];
+	BT_u32				inline_cloexec[BT_FD_INLINE / 32];
+};
+
 struct bt_task {
 	BT_i8				name[BT_CONFIG_MAX_PROCESS_NAME+1];
 	BT_u32				pid;
@@ -15,11 +35,7 @@ struct bt_task {
 	struct bt_list_head threads;
 	struct bt_list_head handles;
 	BT_u64 				ullRunTimeCounter;
-	BT_u32				flags;
-    #define 			BT_PFD_BITMAP	0xFF000000	///< Bitmap of allocated primary bitmaps.
-    #define 			BT_FD_BITMAP	0x00800000	///< If fd_tbl was allocated.
-	BT_u32				free_fd;					///< Number of the last known free FD.
-	BT_HANDLE			fds[8];
+	struct bt_fdtable	fdt;
 #ifdef BT_CONFIG_PROCESS_CWD
 	BT_i8			    cwd[BT_PATH_MAX];
 #endif
@@ -72,13 +88,37 @@ struct bt_task *BT_GetProcessTask(BT_HANDLE hProces);
 BT_ERROR BT_GetProcessTime(struct bt_process_time *time, BT_u32 i);
 BT_u32 BT_GetTotalProcesses();
 
+/**
+ *	@brief	Allocates the lowest free descriptor of the current process.
+ *
+ *	@return	The descriptor, or a negative BT_ERROR once the process has BT_CONFIG_PROCESS_MAX_FDS open.
+ **/
 BT_s32 BT_AllocFileDescriptor();
+
+/**
+ *	@brief	Frees a descriptor, and releases its reference to the handle it held.
+ **/
 BT_ERROR BT_FreeFileDescriptor(BT_s32 fd);
 BT_ERROR BT_SetFileDescriptor(BT_u32 i, BT_HANDLE h);
 BT_HANDLE BT_GetFileDescriptor(BT_u32 i, BT_ERROR *pError);
 BT_ERROR BT_SetProcessFileDescriptor(BT_HANDLE hProcess, BT_u32 i, BT_HANDLE h);
 BT_HANDLE BT_GetProcessFileDescriptor(BT_HANDLE hProcess, BT_u32 i, BT_ERROR *pError);
 
+/**
+ *	@brief	Allocates the lowest free descriptor from ulMin up, for the same handle as fd.
+ *
+ *	@ulFlags	BT_FD_CLOEXEC or 0, descriptor flags are not copied from fd.
+ **/
+BT_s32 BT_DupFileDescriptor(BT_u32 fd, BT_u32 ulMin, BT_u32 ulFlags);
+
+/**
+ *	@brief	Makes newfd refer to the handle of fd, closing what newfd held before.
+ **/
+BT_s32 BT_Dup2FileDescriptor(BT_u32 fd, BT_u32 newfd, BT_u32 ulFlags);
+
+BT_s32 BT_GetFileDescriptorFlags(BT_u32 fd);
+BT_ERROR BT_SetFileDescriptorFlags(BT_u32 fd, BT_u32 ulFlags);
+
 BT_ERROR bt_process_init();
 
 #endif
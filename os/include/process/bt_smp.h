@@ -0,0 +1,33 @@
+/**
+ *	BT Symmetric multiprocessing.
+ *
+ *	The secondary CPUs are started at boot, and idle until a function is sent to them.
+ *	Threads are only scheduled on CPU0, the other CPUs run the functions sent with
+ *	BT_SMPCallFunction() in their interrupt handler, so those must be short and must
+ *	not call into the kernel.
+ **/
+
+#ifndef _BT_SMP_H_
+#define _BT_SMP_H_
+
+#include <bt_types.h>
+
+#define BT_CPU_MASK(cpu)	(1 << (cpu))
+
+#define BT_IPI_CALL			0		///< Software interrupt used to run BT_SMPCallFunction() calls.
+
+typedef void (*BT_SMP_FUNCTION)(void *pParam);
+
+/**
+ *	@brief	Mask of the CPUs that are up, CPU0 included.
+ **/
+BT_u32		BT_GetOnlineCPUs		(void);
+
+/**
+ *	@brief	Runs pfnFunction on ulCPU, and returns once it has run.
+ *
+ *	On the calling CPU the function is called directly.
+ **/
+BT_ERROR	BT_SMPCallFunction		(BT_u32 ulCPU, BT_SMP_FUNCTION pfnFunction, void *pParam);
+
+#endif
@@ -0,0 +1,103 @@
+/**
+ *	Spinlocks, for data shared between CPUs or with interrupt handlers.
+ *
+ *	A ticket lock: each locker takes the next ticket and waits, in WFE, until the owner
+ *	field reaches it, so CPUs acquire the lock in the order they asked for it. The
+ *	unlock wakes the waiters with SEV.
+ *
+ *	Without BT_CONFIG_SMP there is no other CPU to exclude, bt_spin_lock() and
+ *	bt_spin_unlock() compile to nothing and the _irqsave variants only mask the
+ *	interrupts of the local CPU.
+ *
+ *	Never sleep while holding a spinlock, and take those shared with an ISR using the
+ *	_irqsave variants.
+ **/
+
+#ifndef _BT_SPINLOCK_H_
+#define _BT_SPINLOCK_H_
+
+#include <bt_config.h>
+#include <bt_types.h>
+
+typedef struct {
+	volatile BT_u16	usOwner;		///< Ticket being served.
+	volatile BT_u16	usNext;			///< Next ticket to hand out.
+} bt_spinlock_t;
+
+#define BT_SPINLOCK_INIT	{ 0, 0 }
+
+typedef BT_u32	bt_irqflags_t;
+
+static inline bt_irqflags_t bt_local_irq_save(void) {
+	bt_irqflags_t flags;
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_6M__)
+	__asm volatile("mrs %0, primask\n\tcpsid i" : "=r" (flags) :: "memory");
+#else
+	__asm volatile("mrs %0, cpsr\n\tcpsid i" : "=r" (flags) :: "memory");
+#endif
+	return flags;
+}
+
+static inline void bt_local_irq_restore(bt_irqflags_t flags) {
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_6M__)
+	__asm volatile("msr primask, %0" :: "r" (flags) : "memory");
+#else
+	__asm volatile("msr cpsr_c, %0" :: "r" (flags) : "memory");
+#endif
+}
+
+static inline void bt_spin_lock_init(bt_spinlock_t *lock) {
+	lock->usOwner = 0;
+	lock->usNext = 0;
+}
+
+#ifdef BT_CONFIG_SMP
+
+static inline void bt_spin_lock(bt_spinlock_t *lock) {
+	BT_u16 usTicket = __atomic_fetch_add(&lock->usNext, 1, __ATOMIC_RELAXED);
+	while(__atomic_load_n(&lock->usOwner, __ATOMIC_ACQUIRE) != usTicket) {
+		__asm volatile("wfe" ::: "memory");
+	}
+}
+
+static inline BT_BOOL bt_spin_trylock(bt_spinlock_t *lock) {
+	BT_u16 usOwner = __atomic_load_n(&lock->usOwner, __ATOMIC_RELAXED);
+	BT_u16 usNext = usOwner;
+	return __atomic_compare_exchange_n(&lock->usNext, &usNext, (BT_u16) (usOwner + 1), 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED) ? BT_TRUE : BT_FALSE;
+}
+
+static inline void bt_spin_unlock(bt_spinlock_t *lock) {
+	__atomic_store_n(&lock->usOwner, (BT_u16) (lock->usOwner + 1), __ATOMIC_RELEASE);
+	__asm volatile("dsb\n\tsev" ::: "memory");
+}
+
+#else
+
+static inline void bt_spin_lock(bt_spinlock_t *lock) {
+	(void) lock;
+}
+
+static inline BT_BOOL bt_spin_trylock(bt_spinlock_t *lock) {
+	(void) lock;
+	return BT_TRUE;
+}
+
+static inline void bt_spin_unlock(bt_spinlock_t *lock) {
+	(void) lock;
+}
+
+#endif
+
+#define bt_spin_lock_irqsave(lock, flags)			\
+	do {											\
+		(flags) = bt_local_irq_save();				\
+		bt_spin_lock(lock);							\
+	} while(0)
+
+#define bt_spin_unlock_irqrestore(lock, flags)		\
+	do {											\
+		bt_spin_unlock(lock);						\
+		bt_local_irq_restore(flags);				\
+	} while(0)
+
+#endif
@@ -13,6 +13,12 @@ long bt_sys_sleep(BT_u32 ticks);
 long bt_sys_gpioset(BT_u32 flag, BT_BOOL state);
 long bt_sys_gettimeofday(struct bt_timeval *tv, struct bt_timezone *tz);
 long bt_sys_settimeofday(struct bt_timeval *tv, struct bt_timezone *tz);
+long bt_sys_epoll_create(int size);
+long bt_sys_epoll_ctl(int epfd, int op, int fd, struct bt_poll_event *event);
+long bt_sys_epoll_wait(int epfd, struct bt_poll_event *events, int maxevents, int timeout);
+long bt_sys_dup(int oldfd);
+long bt_sys_dup2(int oldfd, int newfd);
+long bt_sys_fcntl(int fd, int cmd, int arg);
 
 #define BT_SYS_yield		0
 #define BT_SYS_getpid		1
@@ -20,10 +26,17 @@ long bt_sys_settimeofday(struct bt_timeval *tv, struct bt_timezone *tz);
 #define BT_SYS_close		3
 #define BT_SYS_read			4
 #define BT_SYS_write		5
-#define BT_SYS_klog			6
-#define BT_SYS_sleep		7
-#define BT_SYS_gpioset		8
-#define BT_SYS_gettimeofday	9
-#define BT_SYS_settimeofday	10
+#define BT_SYS_lseek		6
+#define BT_SYS_klog			7
+#define BT_SYS_sleep		8
+#define BT_SYS_gpioset		9
+#define BT_SYS_gettimeofday	10
+#define BT_SYS_settimeofday	11
+#define BT_SYS_epoll_create	12
+#define BT_SYS_epoll_ctl	13
+#define BT_SYS_epoll_wait	14
+#define BT_SYS_dup			15
+#define BT_SYS_dup2			16
+#define BT_SYS_fcntl		17
 
 #endif
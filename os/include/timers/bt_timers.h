@@ -2,6 +2,7 @@
 #define _BT_TIMERS_H_
 
 #include <bitthunder.h>
+#include <collections/bt_list.h>
 
 BT_ERROR BT_SetSystemTimerHandle(BT_HANDLE hTimer);
 BT_ERROR BT_SetGlobalTimerHandle(BT_HANDLE hTimer);
@@ -11,6 +12,7 @@ BT_ERROR BT_StopSystemTimer();
 
 BT_u64 	BT_GetGlobalTimer(void);
 BT_u32	BT_GetGlobalTimerRate(void);
+BT_u32	BT_GlobalTimerKBps(BT_u64 ullBytes, BT_u64 ullTicks);	///< Throughput of ullBytes in ullTicks of the global timer.
 
 BT_u32 BT_GetKernelTime(void);
 BT_u32 BT_GetKernelTick(void);
@@ -21,5 +23,62 @@ BT_u32 BT_GetKernelTick(void);
 #define BT_GetKernelTick(x)	0
 #endif
 
+#ifdef BT_CONFIG_HRTIMERS
+/**
+ *	High resolution timers.
+ *
+ *	Expire on the global timer's comparator instead of the kernel tick, so their
+ *	resolution is that of the global timer. A timer is embedded in the structure it
+ *	works on, and its callback runs in interrupt context: it may only use the FromISR
+ *	kernel calls, but can start or cancel timers, including its own.
+ *
+ *	A periodic timer keeps its phase, a period it misses is skipped rather than run late.
+ *	On SMP, timers run on CPU0 and are started and cancelled there.
+ **/
+struct _BT_HRTIMER;
+
+typedef void (*BT_HRTIMER_CALLBACK)(struct _BT_HRTIMER *pTimer, void *pParam);
+
+typedef struct _BT_HRTIMER {
+	struct bt_list_head	item;
+	BT_u64				ullExpires;		///< Global timer value it expires at.
+	BT_u64				ullPeriod;		///< In global timer counts, 0 for a one-shot timer.
+	BT_HRTIMER_CALLBACK	pfnCallback;
+	void			   *pParam;
+} BT_HRTIMER;
+
+#define BT_HRTIMER_INIT(name, callback, param)	{ .item = BT_LIST_HEAD_INIT(name.item), .pfnCallback = callback, .pParam = param }
+
+static inline void BT_InitHrTimer(BT_HRTIMER *pTimer, BT_HRTIMER_CALLBACK pfnCallback, void *pParam) {
+	BT_LIST_INIT_HEAD(&pTimer->item);
+	pTimer->ullExpires = 0;
+	pTimer->ullPeriod = 0;
+	pTimer->pfnCallback = pfnCallback;
+	pTimer->pParam = pParam;
+}
+
+/**
+ *	@brief	Nanoseconds on the global timer.
+ **/
+BT_u64		BT_HrTimerNow		(void);
+
+/**
+ *	@brief	(Re)starts pTimer to expire after ullDelayNs, then every ullPeriodNs unless that is 0.
+ *
+ *	@return	BT_ERR_UNSUPPORTED_INTERFACE if the global timer has no comparator interrupt.
+ **/
+BT_ERROR	BT_HrTimerStart		(BT_HRTIMER *pTimer, BT_u64 ullDelayNs, BT_u64 ullPeriodNs);
+
+/**
+ *	@brief	Stops pTimer.
+ *
+ *	@return	BT_FALSE if it was not running.
+ **/
+BT_BOOL		BT_HrTimerCancel	(BT_HRTIMER *pTimer);
+#endif
+
+#ifdef BT_CONFIG_KERNEL_TICKLESS_IDLE
+BT_u32 bt_tickless_sleep(BT_u32 ulTicks);
+#endif
 
 #endif
@@ -17,10 +17,22 @@ typedef struct _BT_VOLUME_DESCRIPTOR {
     void                   *kMutex;
 } BT_VOLUME_DESCRIPTOR;
 
+/**
+ *	Placement of a volume relative to the erase units of its block device.
+ *	Filesystems can use this to align their clusters with the erase unit.
+ **/
+typedef struct _BT_VOLUME_ALIGNMENT {
+	BT_u32	ulStartBlock;		///< First block of the volume on the device.
+	BT_u32	ulEraseBlocks;		///< Erase unit size in blocks, 0 if unknown.
+	BT_u32	ulEraseOffset;		///< ulStartBlock modulo the erase unit, 0 when aligned.
+	BT_u32	ulAlignment;		///< Largest power of two (in blocks) the start is aligned to, capped at the erase unit.
+} BT_VOLUME_ALIGNMENT;
+
 
 BT_ERROR 	BT_EnumerateVolumes	(BT_HANDLE hBlock);
 BT_s32 		BT_VolumeRead		(BT_HANDLE hVolume, BT_u32 ulAddress, BT_u32 ulBlocks, void *pBuffer);
 BT_s32 		BT_VolumeWrite		(BT_HANDLE hVolume, BT_u32 ulAddress, BT_u32 ulBlocks, void *pBuffer);
 BT_ERROR    BT_GetVolumeGeometry(BT_HANDLE hVolume, BT_BLOCK_GEOMETRY *pGeometry);
+BT_ERROR	BT_GetVolumeAlignment(BT_HANDLE hVolume, BT_VOLUME_ALIGNMENT *pAlignment);
 
 #endif
@@ -16,12 +16,17 @@ BT_OS_OBJECTS-$(BT_CONFIG_THREADS) += $(BUILD_DIR)/os/src/process/bt_threads.o
 BT_OS_OBJECTS-$(BT_CONFIG_ALIVE_LED) += $(BUILD_DIR)/os/src/process/bt_alive_led.o
 BT_OS_OBJECTS-$(BT_CONFIG_OS) += $(BUILD_DIR)/os/src/interrupts/bt_interrupts.o
 BT_OS_OBJECTS-$(BT_CONFIG_INTERRUPTS_SOFTIRQ) += $(BUILD_DIR)/os/src/interrupts/bt_softirq.o
+BT_OS_OBJECTS-$(BT_CONFIG_INTERRUPTS_THREADED) += $(BUILD_DIR)/os/src/interrupts/bt_threaded_irq.o
 BT_OS_OBJECTS-$(BT_CONFIG_TASKLETS) += $(BUILD_DIR)/os/src/interrupts/bt_tasklets.o
+BT_OS_OBJECTS-$(BT_CONFIG_WORKQUEUE) += $(BUILD_DIR)/os/src/interrupts/bt_workqueue.o
 BT_OS_OBJECTS-$(BT_CONFIG_OS) += $(BUILD_DIR)/os/src/gpio/bt_gpio.o
 BT_OS_OBJECTS-$(BT_CONFIG_OS) += $(BUILD_DIR)/os/src/module/bt_module_init.o
 BT_OS_OBJECTS-$(BT_CONFIG_OS) += $(BUILD_DIR)/os/src/machines/bt_machines.o
 BT_OS_OBJECTS-$(BT_CONFIG_TIMERS) += $(BUILD_DIR)/os/src/timers/bt_timers.o
 BT_OS_OBJECTS-$(BT_CONFIG_OS) += $(BUILD_DIR)/os/src/process/bt_mutex.o
+BT_OS_OBJECTS-$(BT_CONFIG_OS) += $(BUILD_DIR)/os/src/process/bt_lock.o
+BT_OS_OBJECTS-$(BT_CONFIG_SMP) += $(BUILD_DIR)/os/src/process/bt_smp.o
+BT_OS_OBJECTS-$(BT_CONFIG_AMP) += $(BUILD_DIR)/os/src/process/bt_amp.o
 BT_OS_OBJECTS-$(BT_CONFIG_OS) += $(BUILD_DIR)/os/src/process/bt_queue.o
 BT_OS_OBJECTS-$(BT_CONFIG_LIB_PRINTF) += $(BUILD_DIR)/os/src/lib/printf.o
 BT_OS_OBJECTS-$(BT_CONFIG_OS) += $(BUILD_DIR)/os/src/lib/getmem.o
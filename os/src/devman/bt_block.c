@@ -155,6 +155,45 @@ BT_s32 BT_BlockWrite(BT_HANDLE hBlock, BT_u32 ulAddress, BT_u32 ulBlocks, void *
 }
 BT_EXPORT_SYMBOL(BT_BlockWrite);
 
+/**
+ *	Returns a direct pointer to the storage backing the given blocks, for devices
+ *	whose contents live in addressable memory. Returns NULL with BT_ERR_UNSUPPORTED_INTERFACE
+ *	if the device cannot be mapped, in which case the caller should use BT_BlockRead().
+ **/
+void *BT_BlockMap(BT_HANDLE hBlock, BT_u32 ulAddress, BT_u32 ulBlocks, BT_ERROR *pError) {
+
+	BT_ERROR Error = BT_ERR_NONE;
+	void *p = NULL;
+
+	if(!isHandleValid(hBlock)) {
+		Error = BT_ERR_INVALID_HANDLE;
+		goto err_out;
+	}
+
+	BT_BLKDEV_DESCRIPTOR *blkdev = (BT_BLKDEV_DESCRIPTOR *) hBlock;
+
+	const BT_IF_BLOCK *pOps = blkdev->hBlkDev->b.h.pIf->oIfs.pDevIF->pBlockIF;
+	if(!pOps->pfnMapBlocks) {
+		Error = BT_ERR_UNSUPPORTED_INTERFACE;
+		goto err_out;
+	}
+
+	if(ulAddress >= blkdev->oGeometry.ulTotalBlocks || ulBlocks > blkdev->oGeometry.ulTotalBlocks - ulAddress) {
+		Error = BT_ERR_INVALID_VALUE;
+		goto err_out;
+	}
+
+	p = pOps->pfnMapBlocks(blkdev->hBlkDev, ulAddress, ulBlocks, &Error);
+
+err_out:
+	if(pError) {
+		*pError = Error;
+	}
+
+	return p;
+}
+BT_EXPORT_SYMBOL(BT_BlockMap);
+
 BT_ERROR BT_GetBlockGeometry(BT_HANDLE hBlock, BT_BLOCK_GEOMETRY *pGeometry) {
 
 	if(!isHandleValid(hBlock)) {
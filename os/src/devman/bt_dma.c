@@ -0,0 +1,99 @@
+#include <bitthunder.h>
+#include <collections/bt_list.h>
+#include <devman/bt_dma.h>
+
+BT_DEF_MODULE_NAME			("BT DMA Manager")
+BT_DEF_MODULE_DESCRIPTION	("Keeps track of DMA engine controllers for use by device drivers")
+
+static BT_LIST_HEAD(g_dma_controllers);
+
+struct _BT_OPAQUE_HANDLE {
+	BT_HANDLE_HEADER h;
+};
+
+struct dma_controller_item {
+	struct bt_list_head item;
+	BT_HANDLE 			hDma;
+	BT_u32				ulID;
+};
+
+BT_HANDLE BT_DmaGetController(BT_u32 ulID) {
+	struct dma_controller_item *controller;
+
+	bt_list_for_each_entry(controller, &g_dma_controllers, item) {
+		if(controller->ulID == ulID) {
+			return controller->hDma;
+		}
+	}
+
+	return NULL;
+}
+BT_EXPORT_SYMBOL(BT_DmaGetController);
+
+BT_ERROR BT_DmaRegisterController(BT_HANDLE hDma, BT_u32 ulID) {
+	struct dma_controller_item *controller;
+
+	if(BT_IF_DEVICE_TYPE(hDma) != BT_DEV_IF_T_DMA) {
+		return BT_ERR_INVALID_HANDLE_TYPE;
+	}
+
+	if(BT_DmaGetController(ulID)) {
+		return BT_ERR_INVALID_RESOURCE;
+	}
+
+	controller = BT_kMalloc(sizeof(*controller));
+	if(!controller) {
+		return BT_ERR_NO_MEMORY;
+	}
+
+	controller->hDma = hDma;
+	controller->ulID = ulID;
+
+	bt_list_add(&controller->item, &g_dma_controllers);
+
+	return BT_ERR_NONE;
+}
+BT_EXPORT_SYMBOL(BT_DmaRegisterController);
+
+BT_s32 BT_DmaRequestChannel(BT_HANDLE hDma, BT_ERROR *pError) {
+	if(!hDma) {
+		if(pError) {
+			*pError = BT_ERR_INVALID_HANDLE;
+		}
+		return -1;
+	}
+
+	return BT_IF_DMA_OPS(hDma)->pfnRequestChannel(hDma, pError);
+}
+BT_EXPORT_SYMBOL(BT_DmaRequestChannel);
+
+BT_ERROR BT_DmaReleaseChannel(BT_HANDLE hDma, BT_u32 ulChannel) {
+	if(!hDma) {
+		return BT_ERR_INVALID_HANDLE;
+	}
+
+	return BT_IF_DMA_OPS(hDma)->pfnReleaseChannel(hDma, ulChannel);
+}
+BT_EXPORT_SYMBOL(BT_DmaReleaseChannel);
+
+BT_ERROR BT_DmaSubmit(BT_HANDLE hDma, BT_u32 ulChannel, const BT_DMA_SEGMENT *pSegments, BT_u32 ulSegments, BT_DMA_COMPLETE pfnComplete, void *pContext) {
+	if(!hDma) {
+		return BT_ERR_INVALID_HANDLE;
+	}
+
+	if(!pSegments || !ulSegments) {
+		return BT_ERR_INVALID_VALUE;
+	}
+
+	return BT_IF_DMA_OPS(hDma)->pfnSubmit(hDma, ulChannel, pSegments, ulSegments, pfnComplete, pContext);
+}
+BT_EXPORT_SYMBOL(BT_DmaSubmit);
+
+BT_ERROR BT_DmaAbort(BT_HANDLE hDma, BT_u32 ulChannel) {
+	if(!hDma) {
+		return BT_ERR_INVALID_HANDLE;
+	}
+
+	return BT_IF_DMA_OPS(hDma)->pfnAbort(hDma, ulChannel);
+}
+BT_EXPORT_SYMBOL(BT_DmaAbort);
@@ -134,7 +134,7 @@ BT_I2C_BUS *BT_I2C_GetBusObject(BT_HANDLE hBus) {
 }
 BT_EXPORT_SYMBOL(BT_I2C_GetBusObject);
 
-static BT_TASKLET sm_tasklet = {NULL, BT_TASKLET_IDLE, i2c_sm, NULL};
+static BT_TASKLET sm_tasklet = BT_TASKLET_INIT(i2c_sm, NULL);
 
 static const BT_IF_HANDLE oHandleInterface = {
 	BT_MODULE_DEF_INFO,
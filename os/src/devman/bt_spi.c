@@ -104,7 +104,7 @@ static void spi_sm(void *pData) {
 	}
 }
 
-static BT_TASKLET spi_sm_tasklet = {NULL, BT_TASKLET_IDLE, spi_sm, NULL};
+static BT_TASKLET spi_sm_tasklet = BT_TASKLET_INIT(spi_sm, NULL);
 
 BT_ERROR BT_SpiRegisterMaster(BT_HANDLE hMaster, BT_SPI_MASTER *pMaster) {
   struct spi_bus_item *master;
@@ -190,6 +190,36 @@ void BT_SpiComplete(void *arg) {
 }
 BT_EXPORT_SYMBOL(BT_SpiComplete);
 
+#ifdef BT_CONFIG_SPI_DMA
+/**
+ *	A message is offloaded to the master's DMA path when its total length reaches
+ *	the bus threshold, and every buffer satisfies the master's DMA alignment. Receive
+ *	buffers must also span whole alignment units, as masters align to the cache line
+ *	and invalidate the buffer after the transfer.
+ **/
+static BT_BOOL spi_use_dma(BT_SPI_MASTER *master, BT_SPI_MESSAGE *pMessage) {
+	BT_SPI_TRANSFER *xfer;
+	BT_u32 total = 0;
+	BT_u32 align_mask = master->dma_alignment ? master->dma_alignment - 1 : 0;
+
+	if(!master->dma_threshold || !BT_IF_SPI_OPS(master->bus_item->hMaster)->pfnTransferDma) {
+		return BT_FALSE;
+	}
+
+	bt_list_for_each_entry(xfer, &pMessage->transfers, transfer_list) {
+		if(((BT_u32) xfer->tx_buf & align_mask) || ((BT_u32) xfer->rx_buf & align_mask)) {
+			return BT_FALSE;
+		}
+		if(xfer->rx_buf && (xfer->len & align_mask)) {
+			return BT_FALSE;
+		}
+		total += xfer->len;
+	}
+
+	return (total >= master->dma_threshold);
+}
+#endif
+
 BT_ERROR __BT_SpiAsync(BT_SPI_DEVICE *pDevice, BT_SPI_MESSAGE *pMessage) {
 	BT_SPI_MASTER *master = pDevice->pMaster;
 	BT_SPI_TRANSFER *xfer;
@@ -228,6 +258,15 @@ BT_ERROR __BT_SpiAsync(BT_SPI_DEVICE *pDevice, BT_SPI_MESSAGE *pMessage) {
 	pMessage->spi_device = pDevice;
 	pMessage->status = 1;
 
+#ifdef BT_CONFIG_SPI_DMA
+	if(spi_use_dma(master, pMessage)) {
+		BT_ERROR Error = BT_IF_SPI_OPS(master->bus_item->hMaster)->pfnTransferDma(master->bus_item->hMaster, pMessage);
+		if(Error != BT_ERR_UNSUPPORTED_FLAG) {
+			return Error;
+		}
+	}
+#endif
+
 	return BT_IF_SPI_OPS(pDevice->pMaster->bus_item->hMaster)->pfnTransfer(pDevice->pMaster->bus_item->hMaster, pMessage);
 }
 BT_EXPORT_SYMBOL(__BT_SpiAsync);
@@ -271,9 +310,10 @@ BT_ERROR __BT_SpiSync(BT_SPI_DEVICE *pDevice, BT_SPI_MESSAGE *pMessage, BT_u32 b
 
 	status = BT_SpiAsync_locked(pDevice, pMessage);
 
-	if(!bus_locked)
-		BT_kMutexRelease(pDevice->pMaster->bus_item->bus_mutex);
-
+	/*
+	 *	Hold the bus until the message completes, a DMA transfer may still be running
+	 *	after the master's transfer function has returned.
+	 */
 	if(status == BT_ERR_NONE)
 	{
 		while(done != BT_TRUE) {
@@ -281,6 +321,10 @@ BT_ERROR __BT_SpiSync(BT_SPI_DEVICE *pDevice, BT_SPI_MESSAGE *pMessage, BT_u32 b
 		}
 		status = pMessage->status;
 	}
+
+	if(!bus_locked)
+		BT_kMutexRelease(pDevice->pMaster->bus_item->bus_mutex);
+
 	pMessage->context = NULL;
 	return status;
 }
@@ -3,6 +3,7 @@ BT_OS_OBJECTS-$(BT_CONFIG_OS) += $(BUILD_DIR)/os/src/devman/bt_device.o
 BT_OS_OBJECTS-$(BT_CONFIG_OS) += $(BUILD_DIR)/os/src/devman/bt_resources.o
 BT_OS_OBJECTS-$(BT_CONFIG_I2C) += $(BUILD_DIR)/os/src/devman/bt_i2c.o
 BT_OS_OBJECTS-$(BT_CONFIG_SPI) += $(BUILD_DIR)/os/src/devman/bt_spi.o
+BT_OS_OBJECTS-$(BT_CONFIG_DMA) += $(BUILD_DIR)/os/src/devman/bt_dma.o
 BT_OS_OBJECTS-$(BT_CONFIG_BLOCK) += $(BUILD_DIR)/os/src/devman/bt_block.o
 
 
@@ -0,0 +1,603 @@
+/**
+ *	BitThunder readiness notification (epoll-like).
+ *
+ *	An interest set keeps one item per file. While registering, the file's pfnPoll
+ *	subscribes the item to the queues that signal its readiness (up to
+ *	BT_POLL_MAX_QUEUES), a wake moves interested items onto the set's ready list
+ *	and signals the waiter. BT_PollWait() only looks at the ready list, so its cost
+ *	does not depend on the size of the set.
+ *
+ *	The interest list is guarded by the set's lock, the ready list and the queues'
+ *	subscriber lists by a critical section, as queues are also woken from ISRs. A
+ *	wake signals the sets it made ready only after leaving the critical section.
+ **/
+#include <bitthunder.h>
+#include <string.h>
+
+BT_DEF_MODULE_NAME			("Poll")
+BT_DEF_MODULE_DESCRIPTION	("Readiness notification for file handles")
+
+#define BT_POLL_MAX_QUEUES		2
+#define BT_POLL_EVENT_MASK		(BT_POLLIN | BT_POLLOUT | BT_POLLERR | BT_POLLHUP)
+
+struct bt_poll_item;
+
+struct bt_poll_entry {
+	struct bt_list_head		item;			///< On the queue's watchers list.
+	struct bt_poll_queue   *pQueue;
+	struct bt_poll_item	   *pItem;
+};
+
+struct bt_poll_item {
+	struct bt_list_head		item;			///< On the set's interest list.
+	struct bt_list_head		ready;			///< On the set's ready list, while bReady.
+	BT_BOOL					bReady;
+	BT_HANDLE				hPoll;
+	BT_HANDLE				hFile;			///< NULL once the file's queues were released.
+	BT_HANDLE				hKey;			///< The file it was added for, still matched after that.
+	struct bt_poll_event	oEvent;
+	BT_u32					ulEntries;
+	struct bt_poll_entry	entries[BT_POLL_MAX_QUEUES];
+};
+
+struct bt_poll_table {
+	struct bt_poll_item	   *pItem;
+};
+
+struct _BT_OPAQUE_HANDLE {
+	BT_HANDLE_HEADER		h;
+	void				   *pLock;			///< Guards the interest list and serialises waiters.
+	void				   *pSignal;		///< Given whenever an item becomes ready.
+	struct bt_list_head		items;
+	struct bt_list_head		ready;
+	struct bt_list_head		signal;			///< On a waker's list, while bSignal.
+	BT_BOOL					bSignal;		///< A waker is going to give pSignal.
+	BT_u32					ulWaking;		///< Wakers that have yet to give pSignal.
+	BT_BOOL					bClosing;		///< poll_cleanup() waits on pDrained for ulWaking.
+	void				   *pDrained;		///< Given by the last waker, once bClosing.
+};
+
+static const BT_IF_HANDLE oHandleInterface;
+
+void bt_poll_queue_init(struct bt_poll_queue *pQueue) {
+	BT_LIST_INIT_HEAD(&pQueue->watchers);
+}
+BT_EXPORT_SYMBOL(bt_poll_queue_init);
+
+static BT_u32 poll_enter_critical(BT_BOOL bFromISR) {
+	if(bFromISR) {
+		return BT_kEnterCriticalFromISR();
+	}
+
+	BT_kEnterCritical();
+	return 0;
+}
+
+static void poll_exit_critical(BT_BOOL bFromISR, BT_u32 ulState) {
+	if(bFromISR) {
+		BT_kExitCriticalFromISR(ulState);
+	} else {
+		BT_kExitCritical();
+	}
+}
+
+/*
+ *	Queues an item on its set's ready list, with the critical section held. When that
+ *	makes it ready, its set is put onto pSignal for poll_signal(), unless another
+ *	waker is already going to signal it.
+ */
+static void poll_item_ready(struct bt_poll_item *pItem, struct bt_list_head *pSignal) {
+	BT_HANDLE hPoll = pItem->hPoll;
+
+	if(pItem->bReady) {
+		return;		// Whoever queued it signals the set.
+	}
+
+	bt_list_add_tail(&pItem->ready, &hPoll->ready);
+	pItem->bReady = BT_TRUE;
+
+	if(!hPoll->bSignal) {
+		bt_list_add_tail(&hPoll->signal, pSignal);
+		hPoll->bSignal = BT_TRUE;
+		hPoll->ulWaking++;
+	}
+}
+
+/*
+ *	Gives the signal of the sets poll_item_ready() put onto pSignal, outside of the
+ *	critical section. poll_cleanup() waits for ulWaking, so a set stays valid until
+ *	its waker is done with it.
+ */
+static void poll_signal(struct bt_list_head *pSignal, BT_BOOL bFromISR) {
+	BT_BOOL bWoken = BT_FALSE;
+
+	while(1) {
+		BT_HANDLE hPoll = NULL;
+		BT_u32 ulState = poll_enter_critical(bFromISR);
+		{
+			if(!bt_list_empty(pSignal)) {
+				hPoll = bt_list_first_entry(pSignal, struct _BT_OPAQUE_HANDLE, signal);
+				bt_list_del(&hPoll->signal);
+				hPoll->bSignal = BT_FALSE;		// Items made ready from now on signal again.
+			}
+		}
+		poll_exit_critical(bFromISR, ulState);
+
+		if(!hPoll) {
+			break;
+		}
+
+		if(bFromISR) {
+			BT_BOOL bSetWoken = BT_FALSE;
+			BT_kMutexReleaseFromISR(hPoll->pSignal, &bSetWoken);
+			bWoken |= bSetWoken;
+		} else {
+			BT_kMutexRelease(hPoll->pSignal);
+		}
+
+		BT_BOOL bDrained;
+		ulState = poll_enter_critical(bFromISR);
+		{
+			hPoll->ulWaking--;
+			bDrained = hPoll->bClosing && !hPoll->ulWaking;
+		}
+		poll_exit_critical(bFromISR, ulState);
+
+		// The set may be freed as soon as this is given, it is the last access.
+		if(bDrained) {
+			if(bFromISR) {
+				BT_BOOL bSetWoken = BT_FALSE;
+				BT_kMutexReleaseFromISR(hPoll->pDrained, &bSetWoken);
+				bWoken |= bSetWoken;
+			} else {
+				BT_kMutexRelease(hPoll->pDrained);
+			}
+		}
+	}
+
+	if(bFromISR) {
+		BT_kYieldFromISR(bWoken);
+	}
+}
+
+void bt_poll_wait(struct bt_poll_table *pTable, struct bt_poll_queue *pQueue) {
+	if(!pTable) {
+		return;
+	}
+
+	struct bt_poll_item *pItem = pTable->pItem;
+	if(pItem->ulEntries == BT_POLL_MAX_QUEUES) {
+		BT_kPrint("Poll: more than %d queues for one file", BT_POLL_MAX_QUEUES);
+		return;
+	}
+
+	struct bt_poll_entry *pEntry = &pItem->entries[pItem->ulEntries++];
+	pEntry->pQueue = pQueue;
+	pEntry->pItem = pItem;
+
+	BT_kEnterCritical();
+	{
+		bt_list_add_tail(&pEntry->item, &pQueue->watchers);
+	}
+	BT_kExitCritical();
+}
+BT_EXPORT_SYMBOL(bt_poll_wait);
+
+static void poll_wake(struct bt_poll_queue *pQueue, BT_u32 ulEvents, BT_BOOL bFromISR) {
+	struct bt_list_head oSignal;
+	struct bt_list_head *pos;
+
+	BT_LIST_INIT_HEAD(&oSignal);
+
+	BT_u32 ulState = poll_enter_critical(bFromISR);
+	{
+		bt_list_for_each(pos, &pQueue->watchers) {
+			struct bt_poll_entry *pEntry = bt_list_entry(pos, struct bt_poll_entry, item);
+			struct bt_poll_item *pItem = pEntry->pItem;
+			BT_u32 ulInterest = pItem->oEvent.ulEvents & BT_POLL_EVENT_MASK;
+
+			// A disarmed oneshot item has no interest left, not even in errors.
+			if(ulInterest && (ulEvents & (ulInterest | BT_POLLERR | BT_POLLHUP))) {
+				poll_item_ready(pItem, &oSignal);
+			}
+		}
+	}
+	poll_exit_critical(bFromISR, ulState);
+
+	poll_signal(&oSignal, bFromISR);
+}
+
+void bt_poll_wake(struct bt_poll_queue *pQueue, BT_u32 ulEvents) {
+	poll_wake(pQueue, ulEvents, BT_FALSE);
+}
+BT_EXPORT_SYMBOL(bt_poll_wake);
+
+void bt_poll_wake_from_isr(struct bt_poll_queue *pQueue, BT_u32 ulEvents) {
+	poll_wake(pQueue, ulEvents, BT_TRUE);
+}
+BT_EXPORT_SYMBOL(bt_poll_wake_from_isr);
+
+void bt_poll_queue_release(struct bt_poll_queue *pQueue) {
+	struct bt_list_head *pos, *next;
+
+	BT_kEnterCritical();
+	{
+		bt_list_for_each_safe(pos, next, &pQueue->watchers) {
+			struct bt_poll_entry *pEntry = bt_list_entry(pos, struct bt_poll_entry, item);
+			bt_list_del_init(&pEntry->item);
+			pEntry->pQueue = NULL;
+			pEntry->pItem->hFile = NULL;		// Stays in the set until BT_POLL_CTL_DEL, but is never reported again.
+		}
+	}
+	BT_kExitCritical();
+}
+BT_EXPORT_SYMBOL(bt_poll_queue_release);
+
+static BT_u32 poll_file(BT_HANDLE hFile, struct bt_poll_table *pTable) {
+	return hFile->h.pIf->pFileIF->pfnPoll(hFile, pTable);
+}
+
+/*
+ *	Takes an item off every list it is on, the set's lock must be held.
+ */
+static void poll_item_free(struct bt_poll_item *pItem) {
+	BT_u32 i;
+
+	BT_kEnterCritical();
+	{
+		for(i = 0; i < pItem->ulEntries; i++) {
+			if(pItem->entries[i].pQueue) {
+				bt_list_del(&pItem->entries[i].item);
+			}
+		}
+
+		if(pItem->bReady) {
+			bt_list_del(&pItem->ready);
+		}
+	}
+	BT_kExitCritical();
+
+	bt_list_del(&pItem->item);
+	BT_kFree(pItem);
+}
+
+/*
+ *	Queues an item that pfnPoll reported ready, from BT_PollCtl().
+ */
+static void poll_ready(struct bt_poll_item *pItem) {
+	struct bt_list_head oSignal;
+
+	BT_LIST_INIT_HEAD(&oSignal);
+
+	BT_kEnterCritical();
+	{
+		poll_item_ready(pItem, &oSignal);
+	}
+	BT_kExitCritical();
+
+	poll_signal(&oSignal, BT_FALSE);
+}
+
+static struct bt_poll_item *poll_find(BT_HANDLE hPoll, BT_HANDLE hFile) {
+	struct bt_poll_item *pItem;
+
+	bt_list_for_each_entry(pItem, &hPoll->items, item) {
+		if(pItem->hKey == hFile) {
+			return pItem;
+		}
+	}
+
+	return NULL;
+}
+
+BT_HANDLE BT_PollCreate(BT_ERROR *pError) {
+
+	BT_ERROR Error = BT_ERR_NO_MEMORY;
+
+	BT_HANDLE hPoll = BT_CreateHandle(&oHandleInterface, sizeof(struct _BT_OPAQUE_HANDLE), pError);
+	if(!hPoll) {
+		goto err_out;
+	}
+
+	BT_LIST_INIT_HEAD(&hPoll->items);
+	BT_LIST_INIT_HEAD(&hPoll->ready);
+	hPoll->bSignal = BT_FALSE;
+	hPoll->ulWaking = 0;
+	hPoll->bClosing = BT_FALSE;
+
+	hPoll->pLock = BT_kMutexCreate();
+	if(!hPoll->pLock) {
+		goto err_free_out;
+	}
+
+	hPoll->pSignal = BT_kSemaphoreCreate();
+	if(!hPoll->pSignal) {
+		goto err_lock_out;
+	}
+
+	hPoll->pDrained = BT_kSemaphoreCreate();
+	if(!hPoll->pDrained) {
+		goto err_signal_out;
+	}
+
+	BT_kMutexPend(hPoll->pSignal, 0);		// Created signalled.
+	BT_kMutexPend(hPoll->pDrained, 0);
+
+	return hPoll;
+
+err_signal_out:
+	BT_kMutexDestroy(hPoll->pSignal);
+
+err_lock_out:
+	BT_kMutexDestroy(hPoll->pLock);
+
+err_free_out:
+	BT_DestroyHandle(hPoll);
+
+err_out:
+	if(pError) {
+		*pError = Error;
+	}
+
+	return NULL;
+}
+BT_EXPORT_SYMBOL(BT_PollCreate);
+
+BT_ERROR BT_PollCtl(BT_HANDLE hPoll, BT_u32 ulOp, BT_HANDLE hFile, const struct bt_poll_event *pEvent) {
+
+	BT_ERROR Error = BT_ERR_NONE;
+	struct bt_poll_item *pItem;
+
+	if(!hPoll || BT_HANDLE_TYPE(hPoll) != BT_HANDLE_T_POLL) {
+		return BT_ERR_INVALID_HANDLE_TYPE;
+	}
+
+	if(!hFile || hFile == hPoll) {
+		return BT_ERR_INVALID_HANDLE;
+	}
+
+	if(!hFile->h.pIf->pFileIF || !hFile->h.pIf->pFileIF->pfnPoll) {
+		return BT_ERR_UNSUPPORTED_INTERFACE;
+	}
+
+	if(ulOp != BT_POLL_CTL_DEL && !pEvent) {
+		return BT_ERR_NULL_POINTER;
+	}
+
+	BT_kMutexPend(hPoll->pLock, BT_INFINITE_TIMEOUT);
+
+	pItem = poll_find(hPoll, hFile);
+
+	switch(ulOp) {
+	case BT_POLL_CTL_ADD: {
+		if(pItem && !pItem->hFile) {
+			poll_item_free(pItem);		// Released, and the handle since reused for hFile.
+			pItem = NULL;
+		}
+
+		if(pItem) {
+			Error = BT_ERR_BUSY;
+			break;
+		}
+
+		pItem = BT_kMalloc(sizeof(*pItem));
+		if(!pItem) {
+			Error = BT_ERR_NO_MEMORY;
+			break;
+		}
+
+		memset(pItem, 0, sizeof(*pItem));
+		pItem->hPoll = hPoll;
+		pItem->hFile = hFile;
+		pItem->hKey = hFile;
+		pItem->oEvent = *pEvent;
+		bt_list_add_tail(&pItem->item, &hPoll->items);
+
+		struct bt_poll_table oTable = { pItem };
+		BT_u32 ulReady = poll_file(hFile, &oTable);
+		if(ulReady & (pEvent->ulEvents | BT_POLLERR | BT_POLLHUP)) {
+			poll_ready(pItem);
+		}
+		break;
+	}
+
+	case BT_POLL_CTL_MOD: {
+		if(!pItem || !pItem->hFile) {
+			Error = BT_ERR_INVALID_HANDLE;
+			break;
+		}
+
+		BT_kEnterCritical();
+		pItem->oEvent = *pEvent;
+		BT_kExitCritical();
+
+		// Re-arming reports a file that is already ready, also edge-triggered.
+		BT_u32 ulReady = poll_file(hFile, NULL);
+		if(ulReady & (pEvent->ulEvents | BT_POLLERR | BT_POLLHUP)) {
+			poll_ready(pItem);
+		}
+		break;
+	}
+
+	case BT_POLL_CTL_DEL:
+		if(!pItem) {
+			Error = BT_ERR_INVALID_HANDLE;
+			break;
+		}
+		poll_item_free(pItem);
+		break;
+
+	default:
+		Error = BT_ERR_INVALID_VALUE;
+		break;
+	}
+
+	BT_kMutexRelease(hPoll->pLock);
+
+	return Error;
+}
+BT_EXPORT_SYMBOL(BT_PollCtl);
+
+/*
+ *	Reports the items on the ready list that are still ready, the set's lock must be held.
+ *
+ *	Every item is re-checked with pfnPoll, as wakes may be spurious. Level-triggered
+ *	items that were reported go back onto the ready list, so the next call checks
+ *	them again, edge-triggered ones only return with the next wake.
+ */
+static BT_u32 poll_scan(BT_HANDLE hPoll, struct bt_poll_event *pEvents, BT_u32 ulMaxEvents) {
+	struct bt_list_head oReady;
+	BT_u32 ulReported = 0;
+
+	BT_LIST_INIT_HEAD(&oReady);
+
+	BT_kEnterCritical();
+	bt_list_splice_tail_init(&hPoll->ready, &oReady);
+	BT_kExitCritical();
+
+	while(ulReported < ulMaxEvents) {
+		struct bt_poll_item *pItem;
+		BT_HANDLE hFile;
+
+		BT_kEnterCritical();
+		{
+			if(bt_list_empty(&oReady)) {
+				BT_kExitCritical();
+				break;
+			}
+
+			pItem = bt_list_first_entry(&oReady, struct bt_poll_item, ready);
+			bt_list_del(&pItem->ready);
+			pItem->bReady = BT_FALSE;		// A wake from now on queues it again.
+
+			/*
+			 *	bt_poll_queue_release() clears hFile under this critical section before
+			 *	the file is freed, so a reference taken here keeps it alive for pfnPoll.
+			 */
+			hFile = pItem->hFile;
+			if(hFile && !BT_TryRefHandle(hFile)) {
+				hFile = NULL;		// Already closing.
+			}
+		}
+		BT_kExitCritical();
+
+		BT_u32 ulEvents = pItem->oEvent.ulEvents;
+		if(!hFile) {
+			continue;
+		}
+
+		BT_u32 ulReady = 0;
+		if(ulEvents & BT_POLL_EVENT_MASK) {
+			ulReady = poll_file(hFile, NULL) & (ulEvents | BT_POLLERR | BT_POLLHUP) & BT_POLL_EVENT_MASK;
+		}
+
+		BT_CloseHandle(hFile);
+
+		if(!ulReady) {
+			continue;
+		}
+
+		pEvents[ulReported].ulEvents = ulReady;
+		pEvents[ulReported].pData = pItem->oEvent.pData;
+		ulReported++;
+
+		BT_kEnterCritical();
+		{
+			if(ulEvents & BT_POLLONESHOT) {
+				pItem->oEvent.ulEvents &= ~BT_POLL_EVENT_MASK;
+			} else if(!(ulEvents & BT_POLLET) && !pItem->bReady) {
+				bt_list_add_tail(&pItem->ready, &hPoll->ready);
+				pItem->bReady = BT_TRUE;
+			}
+		}
+		BT_kExitCritical();
+	}
+
+	// Out of room, the rest stays queued for the next call.
+	BT_kEnterCritical();
+	{
+		bt_list_splice(&oReady, &hPoll->ready);
+	}
+	BT_kExitCritical();
+
+	return ulReported;
+}
+
+BT_s32 BT_PollWait(BT_HANDLE hPoll, struct bt_poll_event *pEvents, BT_u32 ulMaxEvents, BT_s32 slTimeout) {
+
+	BT_TICK oStart = BT_kTickCount();
+	BT_u32 ulReported;
+
+	if(!hPoll || BT_HANDLE_TYPE(hPoll) != BT_HANDLE_T_POLL) {
+		return BT_ERR_INVALID_HANDLE_TYPE;
+	}
+
+	if(!pEvents || !ulMaxEvents) {
+		return BT_ERR_INVALID_VALUE;
+	}
+
+	BT_kMutexPend(hPoll->pLock, BT_INFINITE_TIMEOUT);
+
+	while(1) {
+		ulReported = poll_scan(hPoll, pEvents, ulMaxEvents);
+		if(ulReported || !slTimeout) {
+			break;
+		}
+
+		BT_TICK oWait = BT_INFINITE_TIMEOUT;
+		if(slTimeout > 0) {
+			BT_TICK oElapsed = BT_kTickCount() - oStart;
+			if(oElapsed >= (BT_TICK) slTimeout) {
+				break;
+			}
+			oWait = slTimeout - oElapsed;
+		}
+
+		/*
+		 *	Wakes that arrive after the scan leave the signal given, so nothing is
+		 *	missed while the lock is dropped.
+		 */
+		BT_kMutexRelease(hPoll->pLock);
+		BT_kMutexPend(hPoll->pSignal, oWait);
+		BT_kMutexPend(hPoll->pLock, BT_INFINITE_TIMEOUT);
+	}
+
+	BT_kMutexRelease(hPoll->pLock);
+
+	return (BT_s32) ulReported;
+}
+BT_EXPORT_SYMBOL(BT_PollWait);
+
+static BT_ERROR poll_cleanup(BT_HANDLE hPoll) {
+	struct bt_poll_item *pItem, *pNext;
+
+	bt_list_for_each_entry_safe(pItem, pNext, &hPoll->items, item) {
+		poll_item_free(pItem);
+	}
+
+	// No new waker can find the set now, wait for those still about to signal it.
+	BT_u32 ulWaking;
+
+	BT_kEnterCritical();
+	{
+		hPoll->bClosing = BT_TRUE;
+		ulWaking = hPoll->ulWaking;
+	}
+	BT_kExitCritical();
+
+	if(ulWaking) {
+		BT_kMutexPend(hPoll->pDrained, BT_INFINITE_TIMEOUT);
+	}
+
+	BT_kMutexDestroy(hPoll->pDrained);
+	BT_kMutexDestroy(hPoll->pSignal);
+	BT_kMutexDestroy(hPoll->pLock);
+
+	return BT_ERR_NONE;
+}
+
+static const BT_IF_HANDLE oHandleInterface = {
+	BT_MODULE_DEF_INFO_NO_AUTHOR,
+	.eType		= BT_HANDLE_T_POLL,
+	.pfnCleanup = poll_cleanup,
+};
@@ -131,6 +131,15 @@ static BaseType_t FF_ValidLongChar( char cChar );
 	static void FF_MakeNameCompliant( char *pcName );
 #endif
 
+#if( ffconfigDIR_CACHE != 0 )
+	/* Most slots with the same hash that a lookup will verify before falling
+	back to a scan of the directory. */
+	#define ffDIR_CACHE_CANDIDATES		4
+	/* Initial size of a directory table, must be a power of 2. */
+	#define ffDIR_CACHE_MIN_SLOTS		64
+
+#endif /* ffconfigDIR_CACHE */
+
 #if ( FF_NOSTRCASECMP == 1 ) && !defined( WIN32 )
 	static portINLINE unsigned char prvToLower( unsigned char c )
 	{
@@ -210,6 +219,664 @@ uint8_t	ChkSum = 0;
 }	/* FF_CreateChkSum() */
 /*-----------------------------------------------------------*/
 
+#if( ffconfigDIR_CACHE != 0 )
+/*
+ *	Directory cache.
+ *
+ *	A directory is scanned in full the first time a name is looked up in it, and
+ *	the hash of every name (the case-folded long name and the short name) is
+ *	stored in an open-addressed table together with the index of its entry.
+ *	Later lookups read only the entries whose hash matches, and a name that is
+ *	not in the table does not exist.  FF_CreateDirent(), FF_RmFile(), FF_RmDir()
+ *	and FF_Move() keep the tables up to date.
+ *
+ *	The tables of one I/O manager are kept in a list, most recently used first,
+ *	and the least recently used ones are freed to stay within
+ *	ffconfigDIR_CACHE_MEMORY.  The list is protected by pxIOManager->pvSemaphore,
+ *	which is never held while reading the disk.  ulDirCacheStamp changes with
+ *	every modification, so that a table built while a directory was being
+ *	changed by another task is thrown away instead of being published.
+ */
+
+#define ffDIR_CACHE_SIZE( ulSlots )		( sizeof( FF_DirCache_t ) + ( ( ulSlots ) * sizeof( FF_DirCacheSlot_t ) ) )
+
+	/* FNV-1a over the case-folded characters, folded the same way as the name
+	comparison in FF_FindEntryInDir(). */
+	#if( ffconfigUNICODE_UTF16_SUPPORT != 0 )
+	static uint32_t prvDirCacheHashName( const FF_T_WCHAR *pcName )
+	#else
+	static uint32_t prvDirCacheHashName( const char *pcName )
+	#endif
+	{
+	uint32_t ulHash = 2166136261ul;
+	uint32_t ulChar;
+
+		for( ; *pcName != 0; pcName++ )
+		{
+			#if( ffconfigUNICODE_UTF16_SUPPORT != 0 )
+			{
+				ulChar = ( uint32_t ) towlower( *pcName );
+			}
+			#else
+			{
+				ulChar = ( uint8_t ) *pcName;
+				if( ( ulChar >= 'A' ) && ( ulChar <= 'Z' ) )
+				{
+					ulChar += 'a' - 'A';
+				}
+			}
+			#endif
+			ulHash = ( ulHash ^ ulChar ) * 16777619ul;
+		}
+
+		/* Zero marks an empty slot. */
+		if( ulHash == 0ul )
+		{
+			ulHash = 1ul;
+		}
+
+		return ulHash;
+	}	/* prvDirCacheHashName() */
+	/*-----------------------------------------------------------*/
+
+	/* Hash a short name as returned by FF_ProcessShortName(), e.g. "README.TXT". */
+	static uint32_t prvDirCacheHashShortName( const char *pcShortName )
+	{
+	#if( ffconfigUNICODE_UTF16_SUPPORT != 0 )
+		FF_T_WCHAR pcName[ 13 ];
+
+		strcpy( ( char * ) pcName, pcShortName );
+		FF_ShortNameExpand( pcName );
+
+		return prvDirCacheHashName( pcName );
+	#else
+		return prvDirCacheHashName( pcShortName );
+	#endif
+	}	/* prvDirCacheHashShortName() */
+	/*-----------------------------------------------------------*/
+
+	static FF_DirCache_t *prvDirCacheCreate( uint32_t ulDirCluster, uint32_t ulSlots )
+	{
+	FF_DirCache_t *pxCache = NULL;
+
+		if( ffDIR_CACHE_SIZE( ulSlots ) <= ffconfigDIR_CACHE_MEMORY )
+		{
+			pxCache = ( FF_DirCache_t * ) ffconfigMALLOC( ffDIR_CACHE_SIZE( ulSlots ) );
+		}
+
+		if( pxCache != NULL )
+		{
+			memset( pxCache, '\0', ffDIR_CACHE_SIZE( ulSlots ) );
+			pxCache->ulDirCluster = ulDirCluster;
+			pxCache->ulSlots = ulSlots;
+			pxCache->pxSlots = ( FF_DirCacheSlot_t * ) ( pxCache + 1 );
+		}
+
+		return pxCache;
+	}	/* prvDirCacheCreate() */
+	/*-----------------------------------------------------------*/
+
+	static void prvDirCachePut( FF_DirCache_t *pxCache, uint32_t ulHash, uint16_t usFirst, uint16_t usItem )
+	{
+	uint32_t ulMask = pxCache->ulSlots - 1;
+	uint32_t ulIndex = ulHash & ulMask;
+
+		while( pxCache->pxSlots[ ulIndex ].ulHash != 0ul )
+		{
+			ulIndex = ( ulIndex + 1 ) & ulMask;
+		}
+
+		pxCache->pxSlots[ ulIndex ].ulHash = ulHash;
+		pxCache->pxSlots[ ulIndex ].usFirst = usFirst;
+		pxCache->pxSlots[ ulIndex ].usItem = usItem;
+		pxCache->ulUsed++;
+	}	/* prvDirCachePut() */
+	/*-----------------------------------------------------------*/
+
+	/* Empty a slot, moving later slots of the same probe sequence back so that no
+	tombstones are needed. */
+	static void prvDirCacheDelete( FF_DirCache_t *pxCache, uint32_t ulIndex )
+	{
+	uint32_t ulMask = pxCache->ulSlots - 1;
+	uint32_t ulNext = ulIndex;
+	uint32_t ulHome;
+
+		for( ; ; )
+		{
+			pxCache->pxSlots[ ulIndex ].ulHash = 0ul;
+
+			for( ; ; )
+			{
+				ulNext = ( ulNext + 1 ) & ulMask;
+				if( pxCache->pxSlots[ ulNext ].ulHash == 0ul )
+				{
+					pxCache->ulUsed--;
+					return;
+				}
+
+				/* The slot can fill the hole if its home position does not lie
+				between the hole and the slot. */
+				ulHome = pxCache->pxSlots[ ulNext ].ulHash & ulMask;
+				if( ( ( ulNext - ulHome ) & ulMask ) >= ( ( ulNext - ulIndex ) & ulMask ) )
+				{
+					break;
+				}
+			}
+
+			pxCache->pxSlots[ ulIndex ] = pxCache->pxSlots[ ulNext ];
+			ulIndex = ulNext;
+		}
+	}	/* prvDirCacheDelete() */
+	/*-----------------------------------------------------------*/
+
+	/* Add one hash to a table, doubling the table when it is three quarters full.
+	*ppxCache may be replaced by the larger table.  Returns pdFALSE if the table
+	could not grow within ffconfigDIR_CACHE_MEMORY. */
+	static BaseType_t prvDirCacheAdd( FF_DirCache_t **ppxCache, uint32_t ulHash, uint16_t usFirst, uint16_t usItem )
+	{
+	FF_DirCache_t *pxCache = *ppxCache;
+	FF_DirCache_t *pxLarger;
+	uint32_t ulIndex;
+	BaseType_t xReturn = pdTRUE;
+
+		if( ( ( pxCache->ulUsed + 1 ) * 4 ) > ( pxCache->ulSlots * 3 ) )
+		{
+			pxLarger = prvDirCacheCreate( pxCache->ulDirCluster, pxCache->ulSlots * 2 );
+			if( pxLarger == NULL )
+			{
+				xReturn = pdFALSE;
+			}
+			else
+			{
+				pxLarger->pxNext = pxCache->pxNext;
+				pxLarger->ulStamp = pxCache->ulStamp;
+				pxLarger->usFreeHint = pxCache->usFreeHint;
+				pxLarger->usEndOfDir = pxCache->usEndOfDir;
+
+				for( ulIndex = 0; ulIndex < pxCache->ulSlots; ulIndex++ )
+				{
+					if( pxCache->pxSlots[ ulIndex ].ulHash != 0ul )
+					{
+						prvDirCachePut( pxLarger, pxCache->pxSlots[ ulIndex ].ulHash,
+							pxCache->pxSlots[ ulIndex ].usFirst, pxCache->pxSlots[ ulIndex ].usItem );
+					}
+				}
+
+				ffconfigFREE( pxCache );
+				*ppxCache = pxCache = pxLarger;
+			}
+		}
+
+		if( xReturn != pdFALSE )
+		{
+			prvDirCachePut( pxCache, ulHash, usFirst, usItem );
+		}
+
+		return xReturn;
+	}	/* prvDirCacheAdd() */
+	/*-----------------------------------------------------------*/
+
+	/* Add the names of the entry whose short name entry is pucEntryBuffer.
+	ulNameHash is the hash of its long name, or 0 when it only has a short name. */
+	static BaseType_t prvDirCacheAddNames( FF_DirCache_t **ppxCache, uint32_t ulNameHash, const uint8_t *pucEntryBuffer, uint16_t usFirst, uint16_t usItem )
+	{
+	char pcShortName[ 13 ];
+	uint32_t ulShortHash;
+	BaseType_t xReturn = pdTRUE;
+
+		memcpy( pcShortName, pucEntryBuffer, 11 );
+		FF_ProcessShortName( pcShortName );
+		ulShortHash = prvDirCacheHashShortName( pcShortName );
+
+		if( ( ulNameHash != 0ul ) && ( ulNameHash != ulShortHash ) )
+		{
+			xReturn = prvDirCacheAdd( ppxCache, ulNameHash, usFirst, usItem );
+		}
+
+		if( xReturn != pdFALSE )
+		{
+			xReturn = prvDirCacheAdd( ppxCache, ulShortHash, usFirst, usItem );
+		}
+
+		return xReturn;
+	}	/* prvDirCacheAddNames() */
+	/*-----------------------------------------------------------*/
+
+	/* Returns the link that points to the table of ulDirCluster, or the link at
+	the end of the list.  pvSemaphore must be held. */
+	static FF_DirCache_t **prvDirCacheLink( FF_IOManager_t *pxIOManager, uint32_t ulDirCluster )
+	{
+	FF_DirCache_t **ppxLink = &pxIOManager->pxDirCache;
+
+		while( ( *ppxLink != NULL ) && ( ( *ppxLink )->ulDirCluster != ulDirCluster ) )
+		{
+			ppxLink = &( *ppxLink )->pxNext;
+		}
+
+		return ppxLink;
+	}	/* prvDirCacheLink() */
+	/*-----------------------------------------------------------*/
+
+	/* Free the least recently used tables until the rest fits within
+	ffconfigDIR_CACHE_MEMORY.  pvSemaphore must be held. */
+	static void prvDirCacheTrim( FF_IOManager_t *pxIOManager )
+	{
+	FF_DirCache_t **ppxLink;
+	FF_DirCache_t **ppxLast;
+	size_t uxTotal;
+
+		for( ; ; )
+		{
+			uxTotal = 0;
+			ppxLast = NULL;
+			for( ppxLink = &pxIOManager->pxDirCache; *ppxLink != NULL; ppxLink = &( *ppxLink )->pxNext )
+			{
+				uxTotal += ffDIR_CACHE_SIZE( ( *ppxLink )->ulSlots );
+				ppxLast = ppxLink;
+			}
+
+			if( ( uxTotal <= ffconfigDIR_CACHE_MEMORY ) || ( ppxLast == &pxIOManager->pxDirCache ) )
+			{
+				break;
+			}
+
+			ffconfigFREE( *ppxLast );
+			*ppxLast = NULL;
+		}
+	}	/* prvDirCacheTrim() */
+	/*-----------------------------------------------------------*/
+
+	/* Make a table built by a scan of its directory available, unless the
+	directory may have changed during the scan. */
+	static void prvDirCachePublish( FF_IOManager_t *pxIOManager, FF_DirCache_t *pxCache )
+	{
+	FF_DirCache_t **ppxLink;
+
+		FF_PendSemaphore( pxIOManager->pvSemaphore );
+		{
+			ppxLink = prvDirCacheLink( pxIOManager, pxCache->ulDirCluster );
+			if( ( *ppxLink == NULL ) && ( pxCache->ulStamp == pxIOManager->ulDirCacheStamp ) )
+			{
+				pxCache->pxNext = pxIOManager->pxDirCache;
+				pxIOManager->pxDirCache = pxCache;
+				prvDirCacheTrim( pxIOManager );
+				pxCache = NULL;
+			}
+		}
+		FF_ReleaseSemaphore( pxIOManager->pvSemaphore );
+
+		if( pxCache != NULL )
+		{
+			ffconfigFREE( pxCache );
+		}
+	}	/* prvDirCachePublish() */
+	/*-----------------------------------------------------------*/
+
+	static FF_Error_t prvDirCacheReadEntry( FF_IOManager_t *pxIOManager, uint32_t ulDirCluster, uint16_t usItem, uint8_t *pucEntryBuffer )
+	{
+	FF_FetchContext_t xFetchContext;
+	FF_Error_t xError;
+
+		xError = FF_InitEntryFetch( pxIOManager, ulDirCluster, &xFetchContext );
+		if( FF_isERR( xError ) == pdFALSE )
+		{
+		FF_Error_t xTempError;
+
+			xError = FF_FetchEntryWithContext( pxIOManager, usItem, &xFetchContext, pucEntryBuffer );
+			xTempError = FF_CleanupEntryFetch( pxIOManager, &xFetchContext );
+			if( FF_isERR( xError ) == pdFALSE )
+			{
+				xError = xTempError;
+			}
+		}
+
+		return xError;
+	}	/* prvDirCacheReadEntry() */
+	/*-----------------------------------------------------------*/
+
+	/* Collect the slots that hold ulHash.  Returns pdFALSE if there are more of
+	them than fit in pxSlots.  pvSemaphore must be held. */
+	static BaseType_t prvDirCacheCollect( FF_DirCache_t *pxCache, uint32_t ulHash, FF_DirCacheSlot_t *pxSlots, BaseType_t *pxCount )
+	{
+	uint32_t ulMask = pxCache->ulSlots - 1;
+	uint32_t ulIndex;
+
+		*pxCount = 0;
+		for( ulIndex = ulHash & ulMask; pxCache->pxSlots[ ulIndex ].ulHash != 0ul; ulIndex = ( ulIndex + 1 ) & ulMask )
+		{
+			if( pxCache->pxSlots[ ulIndex ].ulHash == ulHash )
+			{
+				if( *pxCount == ffDIR_CACHE_CANDIDATES )
+				{
+					return pdFALSE;
+				}
+				pxSlots[ ( *pxCount )++ ] = pxCache->pxSlots[ ulIndex ];
+			}
+		}
+
+		return pdTRUE;
+	}	/* prvDirCacheCollect() */
+	/*-----------------------------------------------------------*/
+
+	/* Look up a name using the table of the directory.  Returns pdTRUE when the
+	directory must be scanned instead, in which case *ppxBuild may be set to an
+	empty table for the scan to fill in. */
+	#if( ffconfigUNICODE_UTF16_SUPPORT != 0 )
+	static BaseType_t prvDirCacheFind( FF_IOManager_t *pxIOManager, FF_FindParams_t *pxFindParams, const FF_T_WCHAR *pcName,
+		uint8_t ucAttrib, BaseType_t xTestShortName, FF_DirEnt_t *pxDirEntry, uint32_t *pulResult, FF_Error_t *pxError, FF_DirCache_t **ppxBuild )
+	#else
+	static BaseType_t prvDirCacheFind( FF_IOManager_t *pxIOManager, FF_FindParams_t *pxFindParams, const char *pcName,
+		uint8_t ucAttrib, BaseType_t xTestShortName, FF_DirEnt_t *pxDirEntry, uint32_t *pulResult, FF_Error_t *pxError, FF_DirCache_t **ppxBuild )
+	#endif
+	{
+	FF_DirCache_t **ppxLink;
+	FF_DirCache_t *pxCache;
+	FF_DirCacheSlot_t xNames[ ffDIR_CACHE_CANDIDATES ];
+	FF_DirCacheSlot_t xShortNames[ ffDIR_CACHE_CANDIDATES ];
+	BaseType_t xNameCount = 0;
+	BaseType_t xShortCount = 0;
+	BaseType_t xIndex;
+	BaseType_t xScan = pdFALSE;
+	uint32_t ulDirCluster = pxFindParams->ulDirCluster;
+	uint32_t ulNameHash;
+	uint32_t ulShortHash = 0ul;
+	uint32_t ulStamp = 0ul;
+	uint16_t usFreeHint = 0;
+	uint16_t usEndOfDir = 0;
+	char pcShortName[ 13 ];
+	uint8_t pucEntryBuffer[ FF_SIZEOF_DIRECTORY_ENTRY ];
+
+		*ppxBuild = NULL;
+
+		ulNameHash = prvDirCacheHashName( pcName );
+		if( xTestShortName != pdFALSE )
+		{
+			memcpy( pcShortName, pxFindParams->pcEntryBuffer, 11 );
+			FF_ProcessShortName( pcShortName );
+			ulShortHash = prvDirCacheHashShortName( pcShortName );
+		}
+
+		FF_PendSemaphore( pxIOManager->pvSemaphore );
+		{
+			ppxLink = prvDirCacheLink( pxIOManager, ulDirCluster );
+			pxCache = *ppxLink;
+			if( pxCache == NULL )
+			{
+				xScan = pdTRUE;
+				ulStamp = pxIOManager->ulDirCacheStamp;
+			}
+			else
+			{
+				/* Move the table to the front of the list. */
+				*ppxLink = pxCache->pxNext;
+				pxCache->pxNext = pxIOManager->pxDirCache;
+				pxIOManager->pxDirCache = pxCache;
+
+				if( ( prvDirCacheCollect( pxCache, ulNameHash, xNames, &xNameCount ) == pdFALSE ) ||
+					( ( xTestShortName != pdFALSE ) && ( prvDirCacheCollect( pxCache, ulShortHash, xShortNames, &xShortCount ) == pdFALSE ) ) )
+				{
+					xScan = pdTRUE;
+				}
+				usFreeHint = pxCache->usFreeHint;
+				usEndOfDir = pxCache->usEndOfDir;
+			}
+		}
+		FF_ReleaseSemaphore( pxIOManager->pvSemaphore );
+
+		if( pxCache == NULL )
+		{
+			*ppxBuild = prvDirCacheCreate( ulDirCluster, ffDIR_CACHE_MIN_SLOTS );
+			if( *ppxBuild != NULL )
+			{
+				( *ppxBuild )->ulStamp = ulStamp;
+			}
+		}
+
+		if( xScan == pdFALSE )
+		{
+			*pxError = FF_ERR_NONE;
+			*pulResult = 0ul;
+
+			/* Verify the candidates, the hashes may collide. */
+			for( xIndex = 0; xIndex < xShortCount; xIndex++ )
+			{
+				*pxError = prvDirCacheReadEntry( pxIOManager, ulDirCluster, xShortNames[ xIndex ].usItem, pucEntryBuffer );
+				if( FF_isERR( *pxError ) )
+				{
+					break;
+				}
+				if( memcmp( pucEntryBuffer, pxFindParams->pcEntryBuffer, 11 ) == 0 )
+				{
+					pxFindParams->ulFlags |= FIND_FLAG_SHORTNAME_CHECKED | FIND_FLAG_SHORTNAME_FOUND;
+					break;
+				}
+			}
+
+			for( xIndex = 0; ( xIndex < xNameCount ) && ( FF_isERR( *pxError ) == pdFALSE ); xIndex++ )
+			{
+				pxDirEntry->usCurrentItem = xNames[ xIndex ].usFirst;
+				*pxError = FF_GetEntry( pxIOManager, xNames[ xIndex ].usFirst, ulDirCluster, pxDirEntry );
+				if( FF_isERR( *pxError ) )
+				{
+					break;
+				}
+
+				/* FF_GetEntry() leaves usCurrentItem just past the short name
+				entry, unless the entry was deleted. */
+				if( ( pxDirEntry->usCurrentItem == ( uint16_t ) ( xNames[ xIndex ].usItem + 1 ) ) &&
+					( ( pxDirEntry->ucAttrib & ucAttrib ) == ucAttrib ) &&
+				#if( ffconfigUNICODE_UTF16_SUPPORT != 0 )
+					( wcsicmp( ( const char * )pcName, ( const char * )pxDirEntry->pcFileName ) == 0 ) )
+				#else
+					( FF_stricmp( ( const char * )pcName, ( const char * )pxDirEntry->pcFileName ) == 0 ) )
+				#endif
+				{
+					*pulResult = pxDirEntry->ulObjectCluster;
+					break;
+				}
+			}
+
+			if( xIndex == xNameCount )
+			{
+				/* Not found, as if the directory had been scanned to its end. */
+				pxDirEntry->usCurrentItem = usEndOfDir;
+			}
+
+			if( pxFindParams->lFreeEntry < 0 )
+			{
+				pxFindParams->lFreeEntry = usFreeHint;
+			}
+		}
+
+		return xScan;
+	}	/* prvDirCacheFind() */
+	/*-----------------------------------------------------------*/
+
+	/* Returns -1 if the directory has no table, otherwise whether a short name
+	entry called pcShortName (e.g. "README~1.TXT") exists. */
+	static BaseType_t prvDirCacheShortNameExists( FF_IOManager_t *pxIOManager, uint32_t ulDirCluster, const char *pcShortName, FF_Error_t *pxError )
+	{
+	FF_DirCache_t *pxCache;
+	FF_DirCacheSlot_t xShortNames[ ffDIR_CACHE_CANDIDATES ];
+	BaseType_t xCount = 0;
+	BaseType_t xIndex;
+	BaseType_t xResult = -1;
+	uint32_t ulHash;
+	char pcMyShortName[ 13 ];
+	uint8_t pucEntryBuffer[ FF_SIZEOF_DIRECTORY_ENTRY ];
+
+		ulHash = prvDirCacheHashShortName( pcShortName );
+
+		FF_PendSemaphore( pxIOManager->pvSemaphore );
+		{
+			pxCache = *prvDirCacheLink( pxIOManager, ulDirCluster );
+			if( ( pxCache != NULL ) && ( prvDirCacheCollect( pxCache, ulHash, xShortNames, &xCount ) != pdFALSE ) )
+			{
+				xResult = pdFALSE;
+			}
+		}
+		FF_ReleaseSemaphore( pxIOManager->pvSemaphore );
+
+		for( xIndex = 0; ( xResult == pdFALSE ) && ( xIndex < xCount ); xIndex++ )
+		{
+			*pxError = prvDirCacheReadEntry( pxIOManager, ulDirCluster, xShortNames[ xIndex ].usItem, pucEntryBuffer );
+			if( FF_isERR( *pxError ) )
+			{
+				break;
+			}
+			if( FF_isDeleted( pucEntryBuffer ) == pdFALSE )
+			{
+				memcpy( pcMyShortName, pucEntryBuffer, 11 );
+				FF_ProcessShortName( pcMyShortName );
+				if( strcmp( pcShortName, pcMyShortName ) == 0 )
+				{
+					xResult = pdTRUE;
+				}
+			}
+		}
+
+		return xResult;
+	}	/* prvDirCacheShortNameExists() */
+	/*-----------------------------------------------------------*/
+
+	/* Record an entry written by FF_CreateDirent(), from usFirst (the first LFN
+	entry) to usItem (the short name entry).  pcName is NULL when the entry has no
+	long name.  The DIR lock must be held. */
+	#if( ffconfigUNICODE_UTF16_SUPPORT != 0 )
+	static void prvDirCacheInsert( FF_IOManager_t *pxIOManager, uint32_t ulDirCluster, const FF_T_WCHAR *pcName, const uint8_t *pucEntryBuffer,
+		uint16_t usFirst, uint16_t usItem )
+	#else
+	static void prvDirCacheInsert( FF_IOManager_t *pxIOManager, uint32_t ulDirCluster, const char *pcName, const uint8_t *pucEntryBuffer,
+		uint16_t usFirst, uint16_t usItem )
+	#endif
+	{
+	FF_DirCache_t **ppxLink;
+	FF_DirCache_t *pxCache;
+	uint32_t ulNameHash = 0ul;
+
+		if( pcName != NULL )
+		{
+			ulNameHash = prvDirCacheHashName( pcName );
+		}
+
+		FF_PendSemaphore( pxIOManager->pvSemaphore );
+		{
+			pxIOManager->ulDirCacheStamp++;
+
+			ppxLink = prvDirCacheLink( pxIOManager, ulDirCluster );
+			pxCache = *ppxLink;
+			if( pxCache != NULL )
+			{
+				if( ( pxCache->usFreeHint >= usFirst ) && ( pxCache->usFreeHint <= usItem ) )
+				{
+					pxCache->usFreeHint = usItem + 1;
+				}
+				if( pxCache->usEndOfDir <= usItem )
+				{
+					pxCache->usEndOfDir = usItem + 1;
+				}
+
+				if( prvDirCacheAddNames( ppxLink, ulNameHash, pucEntryBuffer, usFirst, usItem ) == pdFALSE )
+				{
+					/* The directory has outgrown the cache: forget it, lookups
+					will scan it again. */
+					pxCache = *ppxLink;
+					*ppxLink = pxCache->pxNext;
+					ffconfigFREE( pxCache );
+				}
+				else
+				{
+					prvDirCacheTrim( pxIOManager );
+				}
+			}
+		}
+		FF_ReleaseSemaphore( pxIOManager->pvSemaphore );
+	}	/* prvDirCacheInsert() */
+	/*-----------------------------------------------------------*/
+
+	/* Forget the entry whose short name entry is at usItem, after it has been
+	deleted. */
+	void FF_DirCacheRemove( FF_IOManager_t *pxIOManager, uint32_t ulDirCluster, uint16_t usItem )
+	{
+	FF_DirCache_t *pxCache;
+	uint32_t ulIndex = 0;
+
+		FF_PendSemaphore( pxIOManager->pvSemaphore );
+		{
+			pxIOManager->ulDirCacheStamp++;
+
+			pxCache = *prvDirCacheLink( pxIOManager, ulDirCluster );
+			if( pxCache != NULL )
+			{
+				if( pxCache->usFreeHint > usItem )
+				{
+					pxCache->usFreeHint = usItem;
+				}
+
+				/* Entries are found by name, so look at every slot.  A slot that
+				has just been emptied may be refilled by prvDirCacheDelete(), so it
+				is examined again. */
+				while( ulIndex < pxCache->ulSlots )
+				{
+					if( ( pxCache->pxSlots[ ulIndex ].ulHash != 0ul ) && ( pxCache->pxSlots[ ulIndex ].usItem == usItem ) )
+					{
+						if( pxCache->usFreeHint > pxCache->pxSlots[ ulIndex ].usFirst )
+						{
+							pxCache->usFreeHint = pxCache->pxSlots[ ulIndex ].usFirst;
+						}
+						prvDirCacheDelete( pxCache, ulIndex );
+					}
+					else
+					{
+						ulIndex++;
+					}
+				}
+			}
+		}
+		FF_ReleaseSemaphore( pxIOManager->pvSemaphore );
+	}	/* FF_DirCacheRemove() */
+	/*-----------------------------------------------------------*/
+
+	/* Forget a directory, e.g. because it was removed and its cluster may be
+	reused. */
+	void FF_DirCacheInvalidate( FF_IOManager_t *pxIOManager, uint32_t ulDirCluster )
+	{
+	FF_DirCache_t **ppxLink;
+	FF_DirCache_t *pxCache;
+
+		FF_PendSemaphore( pxIOManager->pvSemaphore );
+		{
+			pxIOManager->ulDirCacheStamp++;
+
+			ppxLink = prvDirCacheLink( pxIOManager, ulDirCluster );
+			pxCache = *ppxLink;
+			if( pxCache != NULL )
+			{
+				*ppxLink = pxCache->pxNext;
+				ffconfigFREE( pxCache );
+			}
+		}
+		FF_ReleaseSemaphore( pxIOManager->pvSemaphore );
+	}	/* FF_DirCacheInvalidate() */
+	/*-----------------------------------------------------------*/
+
+	/* Free all tables, the caller must hold pvSemaphore. */
+	void FF_DirCacheFlush( FF_IOManager_t *pxIOManager )
+	{
+	FF_DirCache_t *pxCache;
+
+		pxIOManager->ulDirCacheStamp++;
+
+		while( pxIOManager->pxDirCache != NULL )
+		{
+			pxCache = pxIOManager->pxDirCache;
+			pxIOManager->pxDirCache = pxCache->pxNext;
+			ffconfigFREE( pxCache );
+		}
+	}	/* FF_DirCacheFlush() */
+	/*-----------------------------------------------------------*/
+#endif /* ffconfigDIR_CACHE */
+
 /* _HT_ Does not need a wchar version because a short name is treated  a normal string of bytes */
 static BaseType_t FF_ShortNameExists( FF_IOManager_t *pxIOManager, uint32_t ulDirCluster, char *szShortName, FF_Error_t *pxError )
 {
@@ -250,6 +917,15 @@ BaseType_t xResult = -1;
 	}
 	#endif
 
+	#if( ffconfigDIR_CACHE != 0 )
+	{
+		if( xResult < 0 )
+		{
+			xResult = prvDirCacheShortNameExists( pxIOManager, ulDirCluster, szShortName, pxError );
+		}
+	}
+	#endif
+
 	if( xResult < 0 )
 	{
 		xResult = pdFALSE;
@@ -347,6 +1023,15 @@ uint32_t xResult = 0ul;
 
 	BaseType_t xIndex;
 #endif /* ffconfigLFN_SUPPORT */
+BaseType_t xScan = pdTRUE;
+#if( ffconfigDIR_CACHE != 0 )
+	/* The table being built by this scan, and the first match found by it. */
+	FF_DirCache_t *pxBuild = NULL;
+	BaseType_t xMatched = pdFALSE;
+	uint16_t usMatch = 0;
+	uint16_t usFirst;
+	uint16_t usFirstFree = FF_MAX_ENTRIES_PER_DIRECTORY;
+#endif
 
 	#if( ffconfigLFN_SUPPORT != 0 )
 	{
@@ -386,9 +1071,18 @@ uint32_t xResult = 0ul;
 		pxFindParams->lFreeEntry = 0;
 	}
 
-	xError = FF_InitEntryFetch( pxIOManager, pxFindParams->ulDirCluster, &xFetchContext );
+	#if( ffconfigDIR_CACHE != 0 )
+	{
+		xScan = prvDirCacheFind( pxIOManager, pxFindParams, name, pa_Attrib, testShortname, pxDirEntry, &xResult, &xError, &pxBuild );
+	}
+	#endif
+
+	if( xScan != pdFALSE )
+	{
+		xError = FF_InitEntryFetch( pxIOManager, pxFindParams->ulDirCluster, &xFetchContext );
+	}
 
-	if( FF_isERR( xError ) == pdFALSE )
+	if( ( xScan != pdFALSE ) && ( FF_isERR( xError ) == pdFALSE ) )
 	{
 		for( pxDirEntry->usCurrentItem = 0; pxDirEntry->usCurrentItem < FF_MAX_ENTRIES_PER_DIRECTORY; pxDirEntry->usCurrentItem++ )
 		{
@@ -419,6 +1113,14 @@ uint32_t xResult = 0ul;
 			{
 				/* Entry not used or deleted. */
 				pxDirEntry->ucAttrib = 0;
+				#if( ffconfigDIR_CACHE != 0 )
+				{
+					if( usFirstFree == FF_MAX_ENTRIES_PER_DIRECTORY )
+					{
+						usFirstFree = pxDirEntry->usCurrentItem;
+					}
+				}
+				#endif
 				if( ( pxFindParams->lFreeEntry < 0 ) && ( ++freeCount == entriesNeeded ) )
 				{
 					/* Remember the beginning entry in the sequential sequence. */
@@ -563,6 +1265,17 @@ uint32_t xResult = 0ul;
 					xLFNTotal = 0;
 				}
 				#endif /* ffconfigLFN_SUPPORT */
+				#if( ffconfigDIR_CACHE != 0 )
+				{
+					/* Only its short name is used, see FF_ShortNameExists(). */
+					if( ( pxBuild != NULL ) &&
+						( prvDirCacheAddNames( &pxBuild, 0ul, src, pxDirEntry->usCurrentItem, pxDirEntry->usCurrentItem ) == pdFALSE ) )
+					{
+						ffconfigFREE( pxBuild );
+						pxBuild = NULL;
+					}
+				}
+				#endif
 				continue;
 			}
 
@@ -588,6 +1301,27 @@ uint32_t xResult = 0ul;
 				#endif /* ffconfigLFN_SUPPORT */
 			}
 
+			#if( ffconfigDIR_CACHE != 0 )
+			{
+				usFirst = pxDirEntry->usCurrentItem;
+				#if( ffconfigLFN_SUPPORT != 0 )
+				{
+					if( xLFNTotal != 0 )
+					{
+						usFirst = lfnItem;
+					}
+				}
+				#endif
+				if( ( pxBuild != NULL ) &&
+					( prvDirCacheAddNames( &pxBuild, prvDirCacheHashName( pxDirEntry->pcFileName ), src, usFirst, pxDirEntry->usCurrentItem ) == pdFALSE ) )
+				{
+					/* Too large to cache. */
+					ffconfigFREE( pxBuild );
+					pxBuild = NULL;
+				}
+			}
+			#endif
+
 			/* This function FF_FindEntryInDir( ) is either called with
 			 * pa_Attrib==0 or with pa_Attrib==FF_FAT_ATTR_DIR
 			 * In the last case the caller is looking for a directory */
@@ -609,26 +1343,41 @@ uint32_t xResult = 0ul;
 				if( FF_stricmp( ( const char * )name, ( const char * )pxDirEntry->pcFileName ) == 0 )
 			#endif /* ffconfigUNICODE_UTF16_SUPPORT */
 				{
-					/* Finally get the complete information. */
-				#if( ffconfigLFN_SUPPORT != 0 )
-					if( xLFNTotal )
+				#if( ffconfigDIR_CACHE != 0 )
+					if( pxBuild != NULL )
 					{
-						xError = FF_PopulateLongDirent( pxIOManager, pxDirEntry, ( uint16_t ) lfnItem, &xFetchContext );
-						if( FF_isERR( xError ) )
+						/* Scan the rest of the directory to complete the table, the
+						entry is read again at the end. */
+						if( xMatched == pdFALSE )
 						{
-							break;
+							xMatched = pdTRUE;
+							usMatch = usFirst;
 						}
 					}
 					else
-				#endif /* ffconfigLFN_SUPPORT */
+				#endif /* ffconfigDIR_CACHE */
 					{
-						FF_PopulateShortDirent( pxIOManager, pxDirEntry, src );
-						/* HT: usCurrentItem wasn't increased here. */
-						pxDirEntry->usCurrentItem++;
+						/* Finally get the complete information. */
+					#if( ffconfigLFN_SUPPORT != 0 )
+						if( xLFNTotal )
+						{
+							xError = FF_PopulateLongDirent( pxIOManager, pxDirEntry, ( uint16_t ) lfnItem, &xFetchContext );
+							if( FF_isERR( xError ) )
+							{
+								break;
+							}
+						}
+						else
+					#endif /* ffconfigLFN_SUPPORT */
+						{
+							FF_PopulateShortDirent( pxIOManager, pxDirEntry, src );
+							/* HT: usCurrentItem wasn't increased here. */
+							pxDirEntry->usCurrentItem++;
+						}
+						/* Object found, the cluster number will be returned. */
+						xResult = pxDirEntry->ulObjectCluster;
+						break;
 					}
-					/* Object found, the cluster number will be returned. */
-					xResult = pxDirEntry->ulObjectCluster;
-					break;
 				}
 			}
 			#if( ffconfigLFN_SUPPORT != 0 )
@@ -664,6 +1413,34 @@ uint32_t xResult = 0ul;
 		}
 	}
 
+	#if( ffconfigDIR_CACHE != 0 )
+	{
+		if( pxBuild != NULL )
+		{
+			if( FF_isERR( xError ) == pdFALSE )
+			{
+				pxBuild->usEndOfDir = pxDirEntry->usCurrentItem;
+				pxBuild->usFreeHint = ( usFirstFree < pxDirEntry->usCurrentItem ) ? usFirstFree : pxDirEntry->usCurrentItem;
+				prvDirCachePublish( pxIOManager, pxBuild );
+			}
+			else
+			{
+				ffconfigFREE( pxBuild );
+			}
+		}
+
+		if( ( xMatched != pdFALSE ) && ( FF_isERR( xError ) == pdFALSE ) )
+		{
+			pxDirEntry->usCurrentItem = usMatch;
+			xError = FF_GetEntry( pxIOManager, usMatch, pxFindParams->ulDirCluster, pxDirEntry );
+			if( FF_isERR( xError ) == pdFALSE )
+			{
+				xResult = pxDirEntry->ulObjectCluster;
+			}
+		}
+	}
+	#endif /* ffconfigDIR_CACHE */
+
 	if( pxError != NULL )
 	{
 		*pxError = xError;
@@ -2825,6 +3602,13 @@ int32_t lFitShort;
 				break;
 			}
 
+			#if( ffconfigDIR_CACHE != 0 )
+			{
+				prvDirCacheInsert( pxIOManager, ulDirCluster, ( xLFNCount > 0 ) ? pxDirEntry->pcFileName : NULL, pucEntryBuffer,
+					( uint16_t ) lFreeEntry, ( uint16_t ) ( lFreeEntry + xLFNCount ) );
+			}
+			#endif
+
 			#if( ffconfigHASH_CACHE != 0 )
 			{
 				if( FF_DirHashed( pxIOManager, ulDirCluster ) == pdFALSE )
@@ -472,6 +472,11 @@ FF_PRINTF("FF_Open[%s]: Conflicting WR mode\n", pcPath );
 				ffconfigFREE( pxFile->pucBuffer );
 			}
 			#endif
+			#if( ffconfigEXTENT_CACHE != 0 )
+			{
+				ffconfigFREE( pxFile->pxExtents );
+			}
+			#endif
 			ffconfigFREE( pxFile );
 		}
 		pxFile = NULL;
@@ -578,6 +583,23 @@ BaseType_t xReturn;
 /*-----------------------------------------------------------*/
 
 
+#if( ffconfigDIR_CACHE != 0 )
+	/* Update the directory cache after the entry at usDirEntry was deleted, or
+	forget the directory when the deletion may have been incomplete. */
+	static void prvDirCacheRemoved( FF_IOManager_t *pxIOManager, uint32_t ulDirCluster, uint16_t usDirEntry, FF_Error_t xError )
+	{
+		if( FF_isERR( xError ) == pdFALSE )
+		{
+			FF_DirCacheRemove( pxIOManager, ulDirCluster, usDirEntry );
+		}
+		else
+		{
+			FF_DirCacheInvalidate( pxIOManager, ulDirCluster );
+		}
+	}
+#endif /* ffconfigDIR_CACHE */
+/*-----------------------------------------------------------*/
+
 #if( ffconfigUNICODE_UTF16_SUPPORT != 0 )
 FF_Error_t FF_RmDir( FF_IOManager_t *pxIOManager, const FF_T_WCHAR *pcPath )
 #else
@@ -628,6 +650,13 @@ FF_Error_t			xError = FF_ERR_NONE;
 					break;
 				}
 
+				#if( ffconfigDIR_CACHE != 0 )
+				{
+					/* The clusters of the directory may be reused. */
+					FF_DirCacheInvalidate( pxIOManager, pxFile->ulObjectCluster );
+				}
+				#endif
+
 				/* Now remove this directory from its parent directory.
 				Initialise the dirent Fetch Context object for faster removal of
 				dirents. */
@@ -666,6 +695,12 @@ FF_Error_t			xError = FF_ERR_NONE;
 				}
 				#endif
 			} while( pdFALSE );
+
+			#if( ffconfigDIR_CACHE != 0 )
+			{
+				prvDirCacheRemoved( pxIOManager, pxFile->ulDirCluster, pxFile->usDirEntry, xError );
+			}
+			#endif
 			{
 			FF_Error_t xTempError;
 				xTempError = FF_CleanupEntryFetch( pxIOManager, &xFetchContext );
@@ -761,6 +796,12 @@ FF_FetchContext_t xFetchContext;
 					xError = FF_PushEntryWithContext( pxIOManager, pxFile->usDirEntry, &xFetchContext, EntryBuffer );
 				}
 			} while( pdFALSE );
+
+			#if( ffconfigDIR_CACHE != 0 )
+			{
+				prvDirCacheRemoved( pxIOManager, pxFile->ulDirCluster, pxFile->usDirEntry, xError );
+			}
+			#endif
 			{
 			FF_Error_t xTempError;
 				xTempError = FF_CleanupEntryFetch( pxIOManager, &xFetchContext );
@@ -951,6 +992,12 @@ FF_FetchContext_t xFetchContext;
 								xError = FF_PushEntryWithContext( pxIOManager, pSrcFile->usDirEntry, &xFetchContext, EntryBuffer );
 							}
 						}
+
+						#if( ffconfigDIR_CACHE != 0 )
+						{
+							prvDirCacheRemoved( pxIOManager, pSrcFile->ulDirCluster, pSrcFile->usDirEntry, xError );
+						}
+						#endif
 					}
 					FF_unlockDIR( pxIOManager );
 				}
@@ -1141,6 +1188,232 @@ uint32_t ulIndex = 0;
 }	/* FF_GetSequentialClusters() */
 /*-----------------------------------------------------------*/
 
+#if( ffconfigEXTENT_CACHE != 0 )
+/*
+ * The extent cache records the cluster chain of an open file as runs of
+ * contiguous clusters.  It always describes a prefix of the chain: clusters
+ * 0..n of the file, in order, so a cluster in that range is found with a
+ * binary search.  Clusters beyond it are found by walking the FAT from the
+ * last cached cluster, extending the cache on the way.
+ */
+
+/* Forget every cached cluster at or beyond file cluster ulFrom. */
+static void prvExtentTrim( FF_FILE *pxFile, uint32_t ulFrom )
+{
+	while( pxFile->usExtentCount != 0 )
+	{
+	FF_Extent_t *pxLast = &( pxFile->pxExtents[ pxFile->usExtentCount - 1 ] );
+
+		if( pxLast->ulFileCluster >= ulFrom )
+		{
+			pxFile->usExtentCount--;
+		}
+		else
+		{
+			if( ( pxLast->ulFileCluster + pxLast->ulLength ) > ulFrom )
+			{
+				pxLast->ulLength = ulFrom - pxLast->ulFileCluster;
+			}
+			break;
+		}
+	}
+}	/* prvExtentTrim() */
+/*-----------------------------------------------------------*/
+
+/* Record that file cluster ulFileCluster is stored in ulDiskCluster.  Clusters
+must be added in order.  Returns pdFALSE when the cache is full. */
+static BaseType_t prvExtentAppend( FF_FILE *pxFile, uint32_t ulFileCluster, uint32_t ulDiskCluster )
+{
+FF_Extent_t *pxExtent;
+
+	if( pxFile->usExtentCount != 0 )
+	{
+		pxExtent = &( pxFile->pxExtents[ pxFile->usExtentCount - 1 ] );
+		if( ( ( pxExtent->ulFileCluster + pxExtent->ulLength ) == ulFileCluster ) &&
+			( ( pxExtent->ulDiskCluster + pxExtent->ulLength ) == ulDiskCluster ) )
+		{
+			pxExtent->ulLength++;
+			return pdTRUE;
+		}
+	}
+
+	if( pxFile->usExtentCount == pxFile->usExtentMax )
+	{
+	uint32_t ulNewMax;
+	FF_Extent_t *pxNew;
+
+		if( pxFile->usExtentMax >= ffconfigEXTENT_CACHE_MAX )
+		{
+			return pdFALSE;
+		}
+
+		ulNewMax = ( pxFile->usExtentMax != 0 ) ? ( pxFile->usExtentMax * 2 ) : 8;
+		if( ulNewMax > ffconfigEXTENT_CACHE_MAX )
+		{
+			ulNewMax = ffconfigEXTENT_CACHE_MAX;
+		}
+
+		pxNew = ( FF_Extent_t * ) ffconfigMALLOC( ulNewMax * sizeof( FF_Extent_t ) );
+		if( pxNew == NULL )
+		{
+			return pdFALSE;
+		}
+
+		if( pxFile->pxExtents != NULL )
+		{
+			memcpy( pxNew, pxFile->pxExtents, pxFile->usExtentCount * sizeof( FF_Extent_t ) );
+			ffconfigFREE( pxFile->pxExtents );
+		}
+
+		pxFile->pxExtents = pxNew;
+		pxFile->usExtentMax = ( uint16_t ) ulNewMax;
+	}
+
+	pxExtent = &( pxFile->pxExtents[ pxFile->usExtentCount++ ] );
+	pxExtent->ulFileCluster = ulFileCluster;
+	pxExtent->ulDiskCluster = ulDiskCluster;
+	pxExtent->ulLength = 1;
+
+	return pdTRUE;
+}	/* prvExtentAppend() */
+/*-----------------------------------------------------------*/
+
+/* Binary search for the cached run holding file cluster ulCluster. */
+static FF_Extent_t *prvExtentFind( FF_FILE *pxFile, uint32_t ulCluster )
+{
+uint32_t ulLow = 0;
+uint32_t ulHigh = pxFile->usExtentCount;
+
+	while( ulLow < ulHigh )
+	{
+	uint32_t ulMid = ( ulLow + ulHigh ) / 2;
+	FF_Extent_t *pxExtent = &( pxFile->pxExtents[ ulMid ] );
+
+		if( ulCluster < pxExtent->ulFileCluster )
+		{
+			ulHigh = ulMid;
+		}
+		else if( ulCluster >= ( pxExtent->ulFileCluster + pxExtent->ulLength ) )
+		{
+			ulLow = ulMid + 1;
+		}
+		else
+		{
+			return pxExtent;
+		}
+	}
+
+	return NULL;
+}	/* prvExtentFind() */
+/*-----------------------------------------------------------*/
+
+/* Returns the disk cluster holding file cluster ulCluster.  Like
+FF_TraverseFAT( ulObjectCluster, ulCluster ), it returns the last cluster of
+the chain when ulCluster is beyond its end. */
+static uint32_t prvExtentLookup( FF_FILE *pxFile, uint32_t ulCluster, FF_Error_t *pxError )
+{
+FF_IOManager_t *pxIOManager = pxFile->pxIOManager;
+FF_Extent_t *pxExtent;
+FF_FATBuffers_t xFATBuffers;
+FF_Error_t xError = FF_ERR_NONE;
+FF_Error_t xTempError;
+uint32_t ulFileCluster;
+uint32_t ulDiskCluster;
+uint32_t ulNext;
+BaseType_t xCaching = pdTRUE;
+
+	*pxError = FF_ERR_NONE;
+
+	if( pxFile->ulObjectCluster == 0 )
+	{
+		return 0;
+	}
+
+	pxExtent = prvExtentFind( pxFile, ulCluster );
+	if( pxExtent != NULL )
+	{
+		return pxExtent->ulDiskCluster + ( ulCluster - pxExtent->ulFileCluster );
+	}
+
+	/* Continue from the last cached cluster, or the start of the chain. */
+	if( pxFile->usExtentCount == 0 )
+	{
+		ulFileCluster = 0;
+		ulDiskCluster = pxFile->ulObjectCluster;
+		xCaching = prvExtentAppend( pxFile, ulFileCluster, ulDiskCluster );
+	}
+	else
+	{
+		pxExtent = &( pxFile->pxExtents[ pxFile->usExtentCount - 1 ] );
+		ulFileCluster = pxExtent->ulFileCluster + pxExtent->ulLength - 1;
+		ulDiskCluster = pxExtent->ulDiskCluster + pxExtent->ulLength - 1;
+	}
+
+	FF_InitFATBuffers( &xFATBuffers, FF_MODE_READ );
+
+	while( ulFileCluster < ulCluster )
+	{
+		ulNext = FF_getFATEntry( pxIOManager, ulDiskCluster, &xError, &xFATBuffers );
+		if( FF_isERR( xError ) )
+		{
+			ulDiskCluster = 0;
+			break;
+		}
+
+		if( FF_isEndOfChain( pxIOManager, ulNext ) )
+		{
+			break;
+		}
+
+		ulFileCluster++;
+		ulDiskCluster = ulNext;
+
+		if( xCaching != pdFALSE )
+		{
+			xCaching = prvExtentAppend( pxFile, ulFileCluster, ulDiskCluster );
+		}
+	}
+
+	xTempError = FF_ReleaseFATBuffers( pxIOManager, &xFATBuffers );
+	if( FF_isERR( xError ) == pdFALSE )
+	{
+		xError = xTempError;
+	}
+
+	*pxError = xError;
+
+	return ulDiskCluster;
+}	/* prvExtentLookup() */
+/*-----------------------------------------------------------*/
+
+/* The number of clusters following the current one that are contiguous
+with it on the disk, up to ulLimit.  Equivalent to FF_GetSequentialClusters(). */
+static uint32_t prvExtentSequential( FF_FILE *pxFile, uint32_t ulLimit, FF_Error_t *pxError )
+{
+FF_Extent_t *pxExtent;
+uint32_t ulRun;
+
+	/* Make sure that the clusters to be transferred are cached. */
+	prvExtentLookup( pxFile, pxFile->ulCurrentCluster + ulLimit, pxError );
+	if( FF_isERR( *pxError ) )
+	{
+		return 0;
+	}
+
+	pxExtent = prvExtentFind( pxFile, pxFile->ulCurrentCluster );
+	if( pxExtent == NULL )
+	{
+		/* Not cached, the cache must be full. */
+		return FF_GetSequentialClusters( pxFile->pxIOManager, pxFile->ulAddrCurrentCluster, ulLimit, pxError );
+	}
+
+	ulRun = pxExtent->ulFileCluster + pxExtent->ulLength - 1 - pxFile->ulCurrentCluster;
+
+	return ( ulRun < ulLimit ) ? ulRun : ulLimit;
+}	/* prvExtentSequential() */
+/*-----------------------------------------------------------*/
+#endif	/* ffconfigEXTENT_CACHE */
+
 static FF_Error_t FF_ReadClusters( FF_FILE *pxFile, uint32_t ulCount, uint8_t *buffer )
 {
 uint32_t ulSectors;
@@ -1152,8 +1425,16 @@ FF_Error_t xError = FF_ERR_NONE;
 	{
 		if( ( ulCount - 1 ) > 0 )
 		{
-			ulSequentialClusters =
-				FF_GetSequentialClusters( pxFile->pxIOManager, pxFile->ulAddrCurrentCluster, ulCount - 1, &xError );
+			#if( ffconfigEXTENT_CACHE != 0 )
+			{
+				ulSequentialClusters = prvExtentSequential( pxFile, ulCount - 1, &xError );
+			}
+			#else
+			{
+				ulSequentialClusters =
+					FF_GetSequentialClusters( pxFile->pxIOManager, pxFile->ulAddrCurrentCluster, ulCount - 1, &xError );
+			}
+			#endif
 			if( FF_isERR( xError ) )
 			{
 				break;
@@ -1171,8 +1452,17 @@ FF_Error_t xError = FF_ERR_NONE;
 		}
 
 		ulCount -= ( ulSequentialClusters + 1 );
-		pxFile->ulAddrCurrentCluster =
-			FF_TraverseFAT( pxFile->pxIOManager, pxFile->ulAddrCurrentCluster, ulSequentialClusters + 1, &xError );
+		#if( ffconfigEXTENT_CACHE != 0 )
+		{
+			pxFile->ulAddrCurrentCluster =
+				prvExtentLookup( pxFile, pxFile->ulCurrentCluster + ulSequentialClusters + 1, &xError );
+		}
+		#else
+		{
+			pxFile->ulAddrCurrentCluster =
+				FF_TraverseFAT( pxFile->pxIOManager, pxFile->ulAddrCurrentCluster, ulSequentialClusters + 1, &xError );
+		}
+		#endif
 		if( FF_isERR( xError ) )
 		{
 			break;
@@ -1235,6 +1525,11 @@ FF_FATBuffers_t xFATBuffers;
 					if( FF_isERR( xError ) == pdFALSE )
 					{
 						pxFile->ulObjectCluster = pxFile->ulAddrCurrentCluster;
+						#if( ffconfigEXTENT_CACHE != 0 )
+						{
+							prvExtentTrim( pxFile, 0 );
+						}
+						#endif
 						pxFile->ulChainLength = 1;
 						pxFile->ulCurrentCluster = 0;
 						pxFile->ulEndOfChain = pxFile->ulAddrCurrentCluster;
@@ -1362,8 +1657,16 @@ FF_Error_t xError = FF_ERR_NONE;
 	{
 		if( ( ulCount - 1 ) > 0 )
 		{
-			ulSequentialClusters =
-				FF_GetSequentialClusters( pxFile->pxIOManager, pxFile->ulAddrCurrentCluster, ulCount - 1, &xError );
+			#if( ffconfigEXTENT_CACHE != 0 )
+			{
+				ulSequentialClusters = prvExtentSequential( pxFile, ulCount - 1, &xError );
+			}
+			#else
+			{
+				ulSequentialClusters =
+					FF_GetSequentialClusters( pxFile->pxIOManager, pxFile->ulAddrCurrentCluster, ulCount - 1, &xError );
+			}
+			#endif
 			if( FF_isERR( xError ) )
 			{
 				break;
@@ -1382,8 +1685,17 @@ FF_Error_t xError = FF_ERR_NONE;
 		}
 
 		ulCount -= ulSequentialClusters + 1;
-		pxFile->ulAddrCurrentCluster =
-			FF_TraverseFAT( pxFile->pxIOManager, pxFile->ulAddrCurrentCluster, ulSequentialClusters + 1, &xError );
+		#if( ffconfigEXTENT_CACHE != 0 )
+		{
+			pxFile->ulAddrCurrentCluster =
+				prvExtentLookup( pxFile, pxFile->ulCurrentCluster + ulSequentialClusters + 1, &xError );
+		}
+		#else
+		{
+			pxFile->ulAddrCurrentCluster =
+				FF_TraverseFAT( pxFile->pxIOManager, pxFile->ulAddrCurrentCluster, ulSequentialClusters + 1, &xError );
+		}
+		#endif
 		if( FF_isERR( xError ) )
 		{
 			break;
@@ -1443,6 +1755,13 @@ uint32_t nNewCluster = FF_getClusterChainNumber( pxIOManager, pxFile->ulFilePoin
 FF_Error_t xResult = FF_ERR_NONE;
 uint32_t ulReturn;
 
+#if( ffconfigEXTENT_CACHE != 0 )
+	if( nNewCluster != pxFile->ulCurrentCluster )
+	{
+		( void ) pxIOManager;
+		pxFile->ulAddrCurrentCluster = prvExtentLookup( pxFile, nNewCluster, &xResult );
+	}
+#else
 	if( nNewCluster > pxFile->ulCurrentCluster )
 	{
 		pxFile->ulAddrCurrentCluster = FF_TraverseFAT( pxIOManager, pxFile->ulAddrCurrentCluster,
@@ -1456,6 +1775,7 @@ uint32_t ulReturn;
 	{
 		/* Well positioned. */
 	}
+#endif
 
 	if( FF_isERR( xResult ) == pdFALSE )
 	{
@@ -2873,6 +3193,11 @@ FF_Error_t xError;
 					ffconfigFREE( pxFile->pucBuffer );
 				}
 				#endif	/* ffconfigOPTIMISE_UNALIGNED_ACCESS */
+				#if( ffconfigEXTENT_CACHE != 0 )
+				{
+					ffconfigFREE( pxFile->pxExtents );
+				}
+				#endif
 				ffconfigFREE( pxFile );	/* So at least we have freed the pointer. */
 				xError = FF_ERR_NONE;
 				break;
@@ -2986,6 +3311,11 @@ FF_Error_t xError;
 			}
 		}
 		#endif
+		#if( ffconfigEXTENT_CACHE != 0 )
+		{
+			ffconfigFREE( pxFile->pxExtents );
+		}
+		#endif
 		ffconfigFREE( pxFile );
 	}
 	while( pdFALSE );
@@ -3070,6 +3400,11 @@ uint32_t nClusters;
 			if( !pxFile->ulFileSize )
 			{
 				xError = FF_UnlinkClusterChain( pxFile->pxIOManager, pxFile->ulObjectCluster, 0 );
+				#if( ffconfigEXTENT_CACHE != 0 )
+				{
+					prvExtentTrim( pxFile, 0 );
+				}
+				#endif
 			}
 			else
 			{
@@ -3079,6 +3414,11 @@ uint32_t nClusters;
 				{
 					xError = FF_UnlinkClusterChain( pxFile->pxIOManager, truncateCluster, 1 );
 				}
+				#if( ffconfigEXTENT_CACHE != 0 )
+				{
+					prvExtentTrim( pxFile, nClusters );
+				}
+				#endif
 			}
 		}
 
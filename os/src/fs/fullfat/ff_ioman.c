@@ -1599,6 +1599,12 @@ FF_IOManager_t *pxIOManager;
 				{
 					pxIOManager->xPartition.ucPartitionMounted = pdFALSE;
 
+					#if( ffconfigDIR_CACHE != 0 )
+					{
+						FF_DirCacheFlush( pxIOManager );
+					}
+					#endif
+
 					#if( ffconfigMIRROR_FATS_UMOUNT != 0 )
 					{
 						FF_ReleaseSemaphore( pxIOManager->pvSemaphore );
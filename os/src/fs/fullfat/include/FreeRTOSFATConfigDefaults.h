@@ -166,6 +166,24 @@ will be removed. */
 	#define	ffconfigOPTIMISE_UNALIGNED_ACCESS	0
 #endif
 
+#if !defined( ffconfigEXTENT_CACHE )
+	/* When set to 1 each file handle keeps a cache of the runs of contiguous
+	clusters in its cluster chain, so that seeking within a large file does not
+	walk the FAT from the start of the chain. */
+	#define ffconfigEXTENT_CACHE				0
+#endif
+
+#if !defined( ffconfigEXTENT_CACHE_MAX )
+	/* The maximum number of runs cached per file handle.  Once the cache is full,
+	clusters beyond the last cached run are found by walking the FAT. */
+	#define ffconfigEXTENT_CACHE_MAX			256
+#endif
+
+#if( ( ffconfigEXTENT_CACHE_MAX < 1 ) || ( ffconfigEXTENT_CACHE_MAX > 65535 ) )
+	/* The extent counts of a file handle are 16 bits. */
+	#error Invalid FreeRTOSFATConfig.h file: ffconfigEXTENT_CACHE_MAX must be between 1 and 65535
+#endif
+
 #if !defined( ffconfigCACHE_WRITE_THROUGH )
 	/* Input and output to a disk uses buffers that are only flushed at the
 	following times:
@@ -295,6 +313,23 @@ will be removed. */
 	#endif
 #endif	/* ffconfigHASH_CACHE != 0 */
 
+#if !defined( ffconfigDIR_CACHE )
+	/* Set to 1 to keep a hash table of the names in recently used directories,
+	so that looking up or creating a file in a large directory does not read
+	every directory entry.  The table of a directory is built by the first
+	full scan of it, and updated when files are created, deleted or renamed. */
+	#define ffconfigDIR_CACHE					0
+#endif
+
+#if !defined( ffconfigDIR_CACHE_MEMORY )
+	/* Only used if ffconfigDIR_CACHE is set to 1.
+
+	The number of bytes that the directory tables of one I/O manager may use.
+	The least recently used tables are freed to stay within this limit, and a
+	directory too large to fit is not cached. */
+	#define ffconfigDIR_CACHE_MEMORY			65536
+#endif
+
 #if !defined( ffconfigMKDIR_RECURSIVE )
 	/* Set to 1 to add a parameter to ff_mkdir() that allows an entire directory
 	tree to be created in one go, rather than having to create one directory in
@@ -223,6 +223,12 @@ FF_Error_t FF_RmLFNs( FF_IOManager_t *pxIOManager, uint16_t usDirEntry, FF_Fetch
 	FF_Error_t FF_HashDir( FF_IOManager_t *pxIOManager, uint32_t ulDirCluster );
 #endif
 
+#if( ffconfigDIR_CACHE != 0 )
+	void FF_DirCacheRemove( FF_IOManager_t *pxIOManager, uint32_t ulDirCluster, uint16_t usItem );
+	void FF_DirCacheInvalidate( FF_IOManager_t *pxIOManager, uint32_t ulDirCluster );
+	void FF_DirCacheFlush( FF_IOManager_t *pxIOManager );
+#endif
+
 struct SBuffStats {
 	unsigned sectorMatch;
 	unsigned sectorMiss;
@@ -78,6 +78,16 @@ struct xDEV_NODE
 };
 #endif
 
+#if( ffconfigEXTENT_CACHE != 0 )
+/* A run of contiguous clusters in a file's cluster chain. */
+typedef struct xFF_EXTENT
+{
+	uint32_t ulFileCluster;			/* First cluster of the run, relative to the start of the file. */
+	uint32_t ulDiskCluster;			/* First cluster of the run on the partition. */
+	uint32_t ulLength;				/* Number of clusters in the run. */
+} FF_Extent_t;
+#endif
+
 typedef struct _FF_FILE
 {
 	FF_IOManager_t *pxIOManager;			/* Ioman Pointer! */
@@ -94,6 +104,11 @@ typedef struct _FF_FILE
 #if( ffconfigOPTIMISE_UNALIGNED_ACCESS != 0 )
 	uint8_t *pucBuffer;				/* A buffer for providing fast unaligned access. */
 	uint8_t ucState;				/* State information about the buffer. */
+#endif
+#if( ffconfigEXTENT_CACHE != 0 )
+	FF_Extent_t *pxExtents;			/* Known runs of the cluster chain, sorted, covering clusters 0..n of the file. */
+	uint16_t usExtentCount;			/* Number of valid entries in pxExtents. */
+	uint16_t usExtentMax;			/* Allocated size of pxExtents. */
 #endif
 	uint8_t ucMode;					/* Mode that File Was opened in. */
 	uint16_t usDirEntry;			/* Dirent Entry Number describing this file. */
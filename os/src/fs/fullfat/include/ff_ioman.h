@@ -122,6 +122,29 @@ typedef struct
 	BaseType_t FF_isHashSet( FF_HashTable_t *pxHash, uint32_t ulHash );
 #endif /* ffconfigHASH_CACHE */
 
+#if( ffconfigDIR_CACHE != 0 )
+	/* One hashed name in a directory cache. */
+	typedef struct xDIR_CACHE_SLOT
+	{
+		uint32_t ulHash;		/* Hash of the case-folded name, 0 marks an empty slot. */
+		uint16_t usItem;		/* Index of the short name entry. */
+		uint16_t usFirst;		/* Index of the first LFN entry, or usItem when there are none. */
+	} FF_DirCacheSlot_t;
+
+	/* Maps the names in one directory to their entries, see FF_FindEntryInDir(). */
+	typedef struct xDIR_CACHE
+	{
+		struct xDIR_CACHE *pxNext;	/* The next, less recently used, directory. */
+		uint32_t ulDirCluster;		/* The Starting Cluster of the dir that the table represents. */
+		uint32_t ulStamp;			/* Value of ulDirCacheStamp when the directory was scanned. */
+		uint32_t ulSlots;			/* Size of the open-addressed table, a power of 2. */
+		uint32_t ulUsed;			/* Number of occupied slots. */
+		uint16_t usFreeHint;		/* There are no free entries below this index. */
+		uint16_t usEndOfDir;		/* Index of the end-of-directory entry. */
+		FF_DirCacheSlot_t *pxSlots;
+	} FF_DirCache_t;
+#endif /* ffconfigDIR_CACHE */
+
 /* A forward declaration for the I/O manager, to be used in 'struct xFFDisk'. */
 struct _FF_IOMAN;
 
@@ -276,6 +299,10 @@ typedef struct _FF_IOMAN
 #if( ffconfigHASH_CACHE != 0 )
 	FF_HashTable_t	xHashCache[ ffconfigHASH_CACHE_DEPTH ];
 #endif
+#if( ffconfigDIR_CACHE != 0 )
+	FF_DirCache_t	*pxDirCache;		/* Directory name tables, most recently used first. */
+	uint32_t		ulDirCacheStamp;	/* Incremented on every change to a directory's names. */
+#endif
 } FF_IOManager_t;
 
 /* Bit values for 'FF_IOManager_t::ucFlags': */
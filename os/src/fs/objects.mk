@@ -2,6 +2,7 @@ BT_OS_OBJECTS-$(BT_CONFIG_OS) 		+= $(BUILD_DIR)/os/src/fs/bt_devfs.o
 BT_OS_OBJECTS-$(BT_CONFIG_FS)	 	+= $(BUILD_DIR)/os/src/fs/bt_mountfs.o
 BT_OS_OBJECTS-$(BT_CONFIG_FS) 		+= $(BUILD_DIR)/os/src/fs/bt_fs.o
 BT_OS_OBJECTS-$(BT_CONFIG_FILE) 	+= $(BUILD_DIR)/os/src/fs/bt_file.o
+BT_OS_OBJECTS-$(BT_CONFIG_POLL) 	+= $(BUILD_DIR)/os/src/fs/bt_poll.o
 BT_OS_OBJECTS-$(BT_CONFIG_DIR) 		+= $(BUILD_DIR)/os/src/fs/bt_dir.o
 BT_OS_OBJECTS-$(BT_CONFIG_INODE) 	+= $(BUILD_DIR)/os/src/fs/bt_inode.o
 
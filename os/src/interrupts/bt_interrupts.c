@@ -213,3 +213,19 @@ BT_ERROR BT_UnmaskInterrupts(BT_u32 ulNewMaskValue) {
 	return BT_ERR_NONE;
 }
 BT_EXPORT_SYMBOL(BT_UnmaskInterrupts);
+
+BT_ERROR BT_InitInterruptCPU() {
+	if(g_oController.hIRQ && g_oController.BT_IF_IRQ_OPS(hIRQ)->pfnInitCPU) {
+		return g_oController.BT_IF_IRQ_OPS(hIRQ)->pfnInitCPU(g_oController.hIRQ);
+	}
+	return BT_ERR_UNSUPPORTED_INTERFACE;
+}
+BT_EXPORT_SYMBOL(BT_InitInterruptCPU);
+
+BT_ERROR BT_SendSoftwareInterrupt(BT_u32 ulSGI, BT_u32 ulCPUMask) {
+	if(g_oController.hIRQ && g_oController.BT_IF_IRQ_OPS(hIRQ)->pfnSendSGI) {
+		return g_oController.BT_IF_IRQ_OPS(hIRQ)->pfnSendSGI(g_oController.hIRQ, ulSGI, ulCPUMask);
+	}
+	return BT_ERR_UNSUPPORTED_INTERFACE;
+}
+BT_EXPORT_SYMBOL(BT_SendSoftwareInterrupt);
@@ -12,10 +12,14 @@
 BT_DEF_MODULE_NAME	("SoftIRQ")
 
 static BT_SOFTIRQ 	g_SoftIRQ[BT_CONFIG_INTERRUPTS_SOFTIRQ_MAX];
-static BT_u32 		g_ulPending;
+static volatile BT_u32 g_ulPending;
 static void 	   *g_pvMutex;
 
 BT_ERROR BT_OpenSoftIRQ(BT_u32 ulSoftIRQ, BT_SOFTIRQ_HANDLER pfnHandler, void *pData) {
+	if(ulSoftIRQ >= BT_CONFIG_INTERRUPTS_SOFTIRQ_MAX) {
+		return BT_ERR_GENERIC;
+	}
+
 	g_SoftIRQ[ulSoftIRQ].pfnHandler = pfnHandler;
 	g_SoftIRQ[ulSoftIRQ].pData		= pData;
 	return BT_ERR_NONE;
@@ -24,21 +28,24 @@ BT_EXPORT_SYMBOL(BT_OpenSoftIRQ);
 
 BT_ERROR BT_RaiseSoftIRQ(BT_u32 ulSoftIRQ) {
 
-	BT_ERROR Error;
-
-	// Enter Critical Section
-	{
-		Error = BT_RaiseSoftIRQFromISR(ulSoftIRQ);
+	if(ulSoftIRQ >= BT_CONFIG_INTERRUPTS_SOFTIRQ_MAX) {
+		return BT_ERR_GENERIC;
 	}
-	// Exit Critical Section
-	return Error;
+
+	__atomic_fetch_or(&g_ulPending, (1U << ulSoftIRQ), __ATOMIC_RELAXED);
+
+	BT_kMutexRelease(g_pvMutex);
+
+	return BT_ERR_NONE;
 }
 BT_EXPORT_SYMBOL(BT_RaiseSoftIRQ);
 
 BT_ERROR BT_RaiseSoftIRQFromISR(BT_u32 ulSoftIRQ) {
-	if(ulSoftIRQ < BT_CONFIG_SOFTIRQ_MAX) {
-		g_ulPending |= (1 << ulSoftIRQ);
-		BT_kMutexReleaseFromISR(g_pvMutex, NULL);
+	if(ulSoftIRQ < BT_CONFIG_INTERRUPTS_SOFTIRQ_MAX) {
+		BT_BOOL bWoken = BT_FALSE;
+		__atomic_fetch_or(&g_ulPending, (1U << ulSoftIRQ), __ATOMIC_RELAXED);		// Nested interrupts may raise too.
+		BT_kMutexReleaseFromISR(g_pvMutex, &bWoken);
+		BT_kYieldFromISR(bWoken);
 		return BT_ERR_NONE;
 	}
 
@@ -54,9 +61,8 @@ static BT_ERROR softirq_dispatcher(BT_HANDLE hThread, void *pParam) {
 	while(1) {
 		BT_kMutexPend(g_pvMutex, BT_INFINITE_TIMEOUT);
 
-		ulPending = g_ulPending;
+		ulPending = __atomic_exchange_n(&g_ulPending, 0, __ATOMIC_RELAXED);
 		if(ulPending) {
-			g_ulPending = 0;
 			p = g_SoftIRQ;
 			do {
 				if(ulPending & 1) {
@@ -80,7 +86,7 @@ static BT_ERROR bt_softirq_init() {
 	oConfig.ulStackDepth 	= 256;
 	oConfig.ulPriority 		= BT_CONFIG_INTERRUPTS_SOFTIRQ_PRIORITY;
 
-	g_pvMutex = BT_kMutexCreate();
+	g_pvMutex = BT_kSemaphoreCreate();
 	if(!g_pvMutex) {
 		return BT_ERR_GENERIC;
 	}
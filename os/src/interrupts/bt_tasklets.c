@@ -1,7 +1,11 @@
 /**
  *	BT Tasklets Implementation.
  *
- *
+ *	Tasklets are pushed onto a lock-free list per priority, from any thread or ISR.
+ *	The softirq of that priority takes the whole list, reverses it onto the tail of
+ *	its backlog so that tasklets run oldest first, and runs at most
+ *	BT_CONFIG_TASKLETS_BUDGET of them. Anything left raises the softirq again, so
+ *	that other softirqs run in between.
  **/
 
 #include <bitthunder.h>
@@ -10,98 +14,176 @@
 
 BT_DEF_MODULE_NAME	("Tasklets")
 
-static BT_TASKLET *g_Tasklets = NULL;
-static BT_TASKLET *g_HighTasklets = NULL;
+struct tasklet_queue {
+	struct bt_lifo		incoming;		///< Newest first, pushed from any context.
+	struct bt_lifo_node *pBacklog;		///< Oldest first, only used by the softirq.
+	struct bt_lifo_node **ppTail;
+	BT_u32				ulSoftIRQ;
+};
+
+static struct tasklet_queue g_Tasklets 		= { BT_LIFO_INIT, NULL, &g_Tasklets.pBacklog, BT_SOFTIRQ_TASKLET };
+static struct tasklet_queue g_HighTasklets 	= { BT_LIFO_INIT, NULL, &g_HighTasklets.pBacklog, BT_SOFTIRQ_HI };
 
-BT_ERROR BT_TaskletSchedule(BT_TASKLET *pTasklet) {
+#define tasklet_of(n)		bt_container_of(n, BT_TASKLET, node)
 
-	BT_kEnterCritical();
+/*
+ *	Moves the tasklet from idle or running to scheduled, only one caller succeeds.
+ */
+static BT_BOOL tasklet_claim(BT_TASKLET *pTasklet) {
+	BT_TASKLET_STATE eState = pTasklet->eState;
+
+#if BT_LIFO_LOCKFREE
+	do {
+		if(eState == BT_TASKLET_SCHEDULED) {
+			return BT_FALSE;
+		}
+	} while(!__atomic_compare_exchange_n(&pTasklet->eState, &eState, BT_TASKLET_SCHEDULED, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+#else
+	BT_u32 ulState = BT_kEnterCriticalFromISR();	// Also claimed from ISRs.
 	{
-		if(pTasklet->eState == BT_TASKLET_IDLE) {
+		eState = pTasklet->eState;
+		if(eState != BT_TASKLET_SCHEDULED) {
 			pTasklet->eState = BT_TASKLET_SCHEDULED;
-
-			if(!g_Tasklets) {
-				g_Tasklets = pTasklet;
-			} else {
-				pTasklet->pNext = g_Tasklets;
-				g_Tasklets = pTasklet;
-			}
 		}
 	}
-	BT_kExitCritical();
+	BT_kExitCriticalFromISR(ulState);
 
-	BT_RaiseSoftIRQ(BT_SOFTIRQ_TASKLET);
+	if(eState == BT_TASKLET_SCHEDULED) {
+		return BT_FALSE;
+	}
+#endif
 
-	return BT_ERR_NONE;
+	return BT_TRUE;
 }
-BT_EXPORT_SYMBOL(BT_TaskletSchedule);
 
-BT_ERROR BT_TaskletHighSchedule(BT_TASKLET *pTasklet) {
-
-	BT_kEnterCritical();
+/*
+ *	Back to idle after the handler ran, unless it was scheduled again meanwhile.
+ */
+static void tasklet_release(BT_TASKLET *pTasklet) {
+#if BT_LIFO_LOCKFREE
+	BT_TASKLET_STATE eState = BT_TASKLET_RUNNING;
+	__atomic_compare_exchange_n(&pTasklet->eState, &eState, BT_TASKLET_IDLE, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+#else
+	BT_u32 ulState = BT_kEnterCriticalFromISR();
 	{
-		if(pTasklet->eState == BT_TASKLET_IDLE) {
-			pTasklet->eState = BT_TASKLET_SCHEDULED;
-
-			if(!g_HighTasklets) {
-				g_HighTasklets = pTasklet;
-			} else {
-				pTasklet->pNext = g_HighTasklets;
-				g_HighTasklets = pTasklet;
-			}
+		if(pTasklet->eState == BT_TASKLET_RUNNING) {
+			pTasklet->eState = BT_TASKLET_IDLE;
 		}
 	}
-	BT_kExitCritical();
+	BT_kExitCriticalFromISR(ulState);
+#endif
+}
+
+static BT_BOOL tasklet_queue(struct tasklet_queue *pQueue, BT_TASKLET *pTasklet) {
+	if(!tasklet_claim(pTasklet)) {
+		return BT_FALSE;
+	}
 
-	BT_RaiseSoftIRQ(BT_SOFTIRQ_HI);
+	pTasklet->ulQueued++;
+	pTasklet->ullScheduled = BT_GetGlobalTimer();
+	bt_lifo_push(&pQueue->incoming, &pTasklet->node);
+
+	return BT_TRUE;
+}
+
+BT_ERROR BT_TaskletSchedule(BT_TASKLET *pTasklet) {
+	if(tasklet_queue(&g_Tasklets, pTasklet)) {
+		BT_RaiseSoftIRQ(BT_SOFTIRQ_TASKLET);
+	}
 
 	return BT_ERR_NONE;
 }
-BT_EXPORT_SYMBOL(BT_TaskletHighSchedule);
+BT_EXPORT_SYMBOL(BT_TaskletSchedule);
 
-static void tasklet_action(struct _BT_SOFTIRQ *pSoftIRQ) {
+BT_ERROR BT_TaskletHighSchedule(BT_TASKLET *pTasklet) {
+	if(tasklet_queue(&g_HighTasklets, pTasklet)) {
+		BT_RaiseSoftIRQ(BT_SOFTIRQ_HI);
+	}
 
-	BT_TASKLET *pTasklets;
+	return BT_ERR_NONE;
+}
+BT_EXPORT_SYMBOL(BT_TaskletHighSchedule);
 
-	BT_kEnterCritical();
-	{
-		pTasklets = g_Tasklets;
-		g_Tasklets = NULL;
+BT_ERROR BT_TaskletScheduleFromISR(BT_TASKLET *pTasklet) {
+	if(tasklet_queue(&g_Tasklets, pTasklet)) {
+		BT_RaiseSoftIRQFromISR(BT_SOFTIRQ_TASKLET);
 	}
-	BT_kExitCritical();
 
-	while(pTasklets) {
-		BT_TASKLET *t = pTasklets;
-		pTasklets = pTasklets->pNext;
+	return BT_ERR_NONE;
+}
+BT_EXPORT_SYMBOL(BT_TaskletScheduleFromISR);
 
-		t->eState = BT_TASKLET_RUNNING;
-		t->pfnHandler(t->pData);
-		t->pNext = NULL;
-		t->eState = BT_TASKLET_IDLE;
+BT_ERROR BT_TaskletHighScheduleFromISR(BT_TASKLET *pTasklet) {
+	if(tasklet_queue(&g_HighTasklets, pTasklet)) {
+		BT_RaiseSoftIRQFromISR(BT_SOFTIRQ_HI);
 	}
+
+	return BT_ERR_NONE;
 }
+BT_EXPORT_SYMBOL(BT_TaskletHighScheduleFromISR);
 
-static void tasklet_action_hi(struct _BT_SOFTIRQ *pSoftIRQ) {
-	BT_TASKLET *pTasklets;
+BT_u32 BT_TaskletWorstLatency(BT_TASKLET *pTasklet) {
+	BT_u32 ulRate = BT_GetGlobalTimerRate();
+	return ulRate ? (BT_u32) ((pTasklet->ullWorstLatency * 1000000) / ulRate) : 0;
+}
+BT_EXPORT_SYMBOL(BT_TaskletWorstLatency);
+
+static void tasklet_run(struct tasklet_queue *pQueue) {
+
+	BT_u32 ulBudget = BT_CONFIG_TASKLETS_BUDGET;
+
+	/*
+	 *	Reverse the newest first list onto the tail of the backlog.
+	 */
+	struct bt_lifo_node *n = bt_lifo_pop_all(&pQueue->incoming);
+	struct bt_lifo_node *pNewest = n;
+	struct bt_lifo_node *pOldest = NULL;
+	while(n) {
+		struct bt_lifo_node *next = n->next;
+		n->next = pOldest;
+		pOldest = n;
+		n = next;
+	}
 
-	BT_kEnterCritical();
-	{
-		pTasklets = g_HighTasklets;
-		g_HighTasklets = NULL;
+	if(pOldest) {
+		*pQueue->ppTail = pOldest;
+		pQueue->ppTail = &pNewest->next;
 	}
-	BT_kExitCritical();
 
-	while(pTasklets) {
-		BT_TASKLET *t = pTasklets;
-		pTasklets = pTasklets->pNext;
+	while(pQueue->pBacklog && ulBudget) {
+		BT_TASKLET *t = tasklet_of(pQueue->pBacklog);
+		pQueue->pBacklog = t->node.next;
+		if(!pQueue->pBacklog) {
+			pQueue->ppTail = &pQueue->pBacklog;
+		}
+
+		BT_u64 now = BT_GetGlobalTimer();
+		if(now - t->ullScheduled > t->ullWorstLatency) {
+			t->ullWorstLatency = now - t->ullScheduled;
+		}
 
+		t->node.next = NULL;
 		t->eState = BT_TASKLET_RUNNING;
 		t->pfnHandler(t->pData);
-		t->pNext = NULL;
-		t->eState = BT_TASKLET_IDLE;
+		t->ulRun++;
+		tasklet_release(t);
+
+		ulBudget--;
+	}
+
+	if(pQueue->pBacklog) {
+		BT_RaiseSoftIRQ(pQueue->ulSoftIRQ);
 	}
 }
 
+static void tasklet_action(struct _BT_SOFTIRQ *pSoftIRQ) {
+	tasklet_run(&g_Tasklets);
+}
+
+static void tasklet_action_hi(struct _BT_SOFTIRQ *pSoftIRQ) {
+	tasklet_run(&g_HighTasklets);
+}
+
 static BT_ERROR bt_tasklets_init() {
 
 	BT_OpenSoftIRQ(BT_SOFTIRQ_HI, 		tasklet_action_hi, NULL);
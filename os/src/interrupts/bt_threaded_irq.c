@@ -0,0 +1,301 @@
+/**
+ *	Threaded interrupt handlers.
+ *
+ *	A threaded interrupt is split into a hard handler, run in the ISR to quiet the
+ *	device, and a thread handler run by a kernel thread at the priority it was
+ *	registered with. Interrupts registered at the same priority share one thread, so
+ *	a slow handler only delays those of its own priority, and is preempted by the
+ *	handlers of higher priorities.
+ *
+ *	Without a hard handler the line is disabled in the ISR, and enabled again once
+ *	the thread handler has run. A wake still pending on unregistration is handled
+ *	there, so the line is never left disabled.
+ **/
+
+#include <bitthunder.h>
+#include <interrupts/bt_interrupts.h>
+#include <collections/bt_list.h>
+#include <string.h>
+
+BT_DEF_MODULE_NAME	("Threaded IRQs")
+
+struct irq_class {
+	struct bt_list_head		item;
+	struct bt_list_head		irqs;
+	BT_u32					ulPriority;
+	void				   *pSignal;			///< Released by the hard handlers.
+	void				   *pMutex;				///< Guards irqs against registration while handlers run.
+};
+
+struct irq_thread {
+	struct bt_list_head		item;
+	struct irq_class	   *pClass;
+	BT_u32					ulIRQ;
+	BT_FN_INTERRUPT_HANDLER	pfnHandler;
+	BT_FN_INTERRUPT_HANDLER	pfnThreadHandler;
+	void				   *pParam;
+	volatile BT_u32			ulPending;
+	BT_u64					ullRaised;			///< Global timer at the first wake not yet handled.
+	BT_u32					ulWakeups;
+	BT_u32					ulRuns;
+	BT_u64					ullWorstLatency;
+	BT_u64					ullWorstRun;
+};
+
+static BT_LIST_HEAD(g_classes);
+static void *g_pMutex;
+
+static BT_ERROR threaded_isr(BT_u32 ulIRQ, void *pParam) {
+	struct irq_thread *t = (struct irq_thread *) pParam;
+	BT_BOOL bWoken = BT_FALSE;
+
+	if(t->pfnHandler) {
+		if(t->pfnHandler(ulIRQ, t->pParam) != BT_IRQ_WAKE_THREAD) {
+			return BT_ERR_NONE;
+		}
+	} else {
+		BT_DisableInterrupt(t->ulIRQ);
+	}
+
+	if(!t->ulPending) {
+		t->ullRaised = BT_GetGlobalTimer();
+		__atomic_store_n(&t->ulPending, 1, __ATOMIC_RELEASE);
+	}
+
+	t->ulWakeups++;
+	BT_kMutexReleaseFromISR(t->pClass->pSignal, &bWoken);
+	BT_kYieldFromISR(bWoken);
+
+	return BT_ERR_NONE;
+}
+
+static BT_ERROR irq_class_thread(BT_HANDLE hThread, void *pParam) {
+	struct irq_class *c = (struct irq_class *) pParam;
+	struct irq_thread *t;
+
+	while(1) {
+		BT_kMutexPend(c->pSignal, BT_INFINITE_TIMEOUT);
+
+		BT_kMutexPend(c->pMutex, BT_INFINITE_TIMEOUT);
+		bt_list_for_each_entry(t, &c->irqs, item) {
+			BT_u64 raised = t->ullRaised;		// Only written while nothing is pending.
+			if(!__atomic_exchange_n(&t->ulPending, 0, __ATOMIC_ACQUIRE)) {
+				continue;
+			}
+
+			BT_u64 start = BT_GetGlobalTimer();
+			t->pfnThreadHandler(t->ulIRQ, t->pParam);
+			BT_u64 end = BT_GetGlobalTimer();
+
+			if(!t->pfnHandler) {
+				BT_EnableInterrupt(t->ulIRQ);
+			}
+
+			t->ulRuns++;
+			if(start - raised > t->ullWorstLatency) {
+				t->ullWorstLatency = start - raised;
+			}
+			if(end - start > t->ullWorstRun) {
+				t->ullWorstRun = end - start;
+			}
+		}
+		BT_kMutexRelease(c->pMutex);
+	}
+
+	return BT_ERR_NONE;
+}
+
+/*
+ *	Called with g_pMutex held.
+ */
+static struct irq_class *get_class(BT_u32 ulPriority) {
+	struct irq_class *c;
+	BT_ERROR Error;
+
+	bt_list_for_each_entry(c, &g_classes, item) {
+		if(c->ulPriority == ulPriority) {
+			return c;
+		}
+	}
+
+	c = BT_kMalloc(sizeof(*c));
+	if(!c) {
+		return NULL;
+	}
+
+	BT_LIST_INIT_HEAD(&c->irqs);
+	c->ulPriority = ulPriority;
+	c->pSignal = BT_kSemaphoreCreate();
+	c->pMutex = BT_kMutexCreate();
+	if(!c->pSignal || !c->pMutex) {
+		goto err_free_out;
+	}
+
+	BT_kMutexPend(c->pSignal, 0);
+
+	BT_THREAD_CONFIG oConfig = {
+		.ulStackDepth	= BT_CONFIG_INTERRUPTS_THREADED_STACK,
+		.ulPriority		= ulPriority,
+		.pParam			= c,
+	};
+
+	if(!BT_CreateThread(irq_class_thread, &oConfig, &Error)) {
+		goto err_free_out;
+	}
+
+	bt_list_add_tail(&c->item, &g_classes);
+
+	return c;
+
+err_free_out:
+	if(c->pMutex) {
+		BT_kMutexDestroy(c->pMutex);
+	}
+	if(c->pSignal) {
+		BT_kMutexDestroy(c->pSignal);
+	}
+	BT_kFree(c);
+
+	return NULL;
+}
+
+BT_ERROR BT_RegisterThreadedInterrupt(BT_u32 ulIRQ, BT_FN_INTERRUPT_HANDLER pfnHandler, BT_FN_INTERRUPT_HANDLER pfnThreadHandler, void *pParam, BT_u32 ulPriority) {
+	BT_ERROR Error;
+
+	if(!pfnThreadHandler) {
+		return BT_ERR_NULL_POINTER;
+	}
+
+	struct irq_thread *t = BT_kMalloc(sizeof(*t));
+	if(!t) {
+		return BT_ERR_NO_MEMORY;
+	}
+
+	memset(t, 0, sizeof(*t));
+	t->ulIRQ			= ulIRQ;
+	t->pfnHandler		= pfnHandler;
+	t->pfnThreadHandler	= pfnThreadHandler;
+	t->pParam			= pParam;
+
+	BT_kMutexPend(g_pMutex, BT_INFINITE_TIMEOUT);
+
+	t->pClass = get_class(ulPriority);
+	if(!t->pClass) {
+		Error = BT_ERR_NO_MEMORY;
+		goto err_unlock_out;
+	}
+
+	BT_kMutexPend(t->pClass->pMutex, BT_INFINITE_TIMEOUT);
+	bt_list_add_tail(&t->item, &t->pClass->irqs);
+	BT_kMutexRelease(t->pClass->pMutex);
+
+	Error = BT_RegisterInterrupt(ulIRQ, threaded_isr, t);
+	if(Error) {
+		BT_kMutexPend(t->pClass->pMutex, BT_INFINITE_TIMEOUT);
+		bt_list_del(&t->item);
+		BT_kMutexRelease(t->pClass->pMutex);
+		goto err_unlock_out;
+	}
+
+	BT_kMutexRelease(g_pMutex);
+
+	return BT_ERR_NONE;
+
+err_unlock_out:
+	BT_kMutexRelease(g_pMutex);
+	BT_kFree(t);
+
+	return Error;
+}
+BT_EXPORT_SYMBOL(BT_RegisterThreadedInterrupt);
+
+BT_ERROR BT_UnregisterThreadedInterrupt(BT_u32 ulIRQ, void *pParam) {
+	struct irq_class *c;
+	struct irq_thread *t;
+	BT_ERROR Error = BT_ERR_INVALID_VALUE;
+
+	BT_kMutexPend(g_pMutex, BT_INFINITE_TIMEOUT);
+
+	bt_list_for_each_entry(c, &g_classes, item) {
+		bt_list_for_each_entry(t, &c->irqs, item) {
+			if(t->ulIRQ == ulIRQ && t->pParam == pParam) {
+				goto found;
+			}
+		}
+	}
+
+	goto out;
+
+found:
+	BT_kMutexPend(c->pMutex, BT_INFINITE_TIMEOUT);
+
+	Error = BT_UnregisterInterrupt(ulIRQ, threaded_isr, t);
+	bt_list_del(&t->item);
+
+	// The ISR cannot wake it any more, handle a wake the thread has not got to yet.
+	if(__atomic_exchange_n(&t->ulPending, 0, __ATOMIC_ACQUIRE)) {
+		t->pfnThreadHandler(t->ulIRQ, t->pParam);
+		if(!t->pfnHandler) {
+			BT_EnableInterrupt(t->ulIRQ);
+		}
+	}
+
+	BT_kMutexRelease(c->pMutex);
+
+	BT_kFree(t);
+
+out:
+	BT_kMutexRelease(g_pMutex);
+
+	return Error;
+}
+BT_EXPORT_SYMBOL(BT_UnregisterThreadedInterrupt);
+
+static BT_u32 to_us(BT_u64 ticks) {
+	BT_u32 ulRate = BT_GetGlobalTimerRate();
+	return ulRate ? (BT_u32) ((ticks * 1000000) / ulRate) : 0;
+}
+
+BT_u32 BT_GetThreadedInterruptStats(struct bt_irq_thread_stats *pStats, BT_u32 ulMax) {
+	struct irq_class *c;
+	struct irq_thread *t;
+	BT_u32 i = 0;
+
+	BT_kMutexPend(g_pMutex, BT_INFINITE_TIMEOUT);
+
+	bt_list_for_each_entry(c, &g_classes, item) {
+		bt_list_for_each_entry(t, &c->irqs, item) {
+			if(i == ulMax) {
+				goto out;
+			}
+
+			pStats[i].ulIRQ				= t->ulIRQ;
+			pStats[i].ulPriority		= c->ulPriority;
+			pStats[i].ulWakeups			= t->ulWakeups;
+			pStats[i].ulRuns			= t->ulRuns;
+			pStats[i].ulWorstLatencyUs	= to_us(t->ullWorstLatency);
+			pStats[i].ulWorstRunUs		= to_us(t->ullWorstRun);
+			i++;
+		}
+	}
+
+out:
+	BT_kMutexRelease(g_pMutex);
+
+	return i;
+}
+BT_EXPORT_SYMBOL(BT_GetThreadedInterruptStats);
+
+static BT_ERROR bt_threaded_irq_init() {
+	g_pMutex = BT_kMutexCreate();
+	if(!g_pMutex) {
+		return BT_ERR_NO_MEMORY;
+	}
+
+	return BT_ERR_NONE;
+}
+
+BT_MODULE_INIT_0_DEF oModuleEntry = {
+	BT_MODULE_NAME,
+	bt_threaded_irq_init,
+};
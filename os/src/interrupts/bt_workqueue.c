@@ -0,0 +1,202 @@
+/**
+ *	BT Work queue Implementation.
+ *
+ *	Producers push onto a lock-free list, newest first. The worker takes the whole
+ *	list, reverses it and runs it. Before sleeping the worker sets ulIdle and checks
+ *	the list once more; a producer that swaps ulIdle from 1 to 0 is the one that must
+ *	wake it, so a wake is never lost and never doubled.
+ **/
+
+#include <bitthunder.h>
+#include <interrupts/bt_workqueue.h>
+
+BT_DEF_MODULE_NAME	("Work queues")
+
+struct _BT_WORKQUEUE {
+	struct bt_lifo		incoming;
+	volatile BT_u32		ulIdle;
+	void			   *pSignal;
+};
+
+static BT_WORKQUEUE *g_pSystemQueue;
+
+#define work_of(n)		bt_container_of(n, BT_WORK, node)
+
+#if BT_LIFO_LOCKFREE
+
+static BT_u32 swap(volatile BT_u32 *p, BT_u32 ulValue) {
+	return __atomic_exchange_n(p, ulValue, __ATOMIC_SEQ_CST);
+}
+
+static BT_BOOL list_empty(struct bt_lifo *pLifo) {
+	return __atomic_load_n(&pLifo->head, __ATOMIC_SEQ_CST) ? BT_FALSE : BT_TRUE;
+}
+
+#else
+
+/*
+ *	Masks interrupts, as BT_QueueWorkFromISR() swaps too. Single core only, see bt_lifo.h.
+ */
+static BT_u32 swap(volatile BT_u32 *p, BT_u32 ulValue) {
+	BT_u32 ulOld;
+	BT_u32 ulState = BT_kEnterCriticalFromISR();
+	{
+		ulOld = *p;
+		*p = ulValue;
+	}
+	BT_kExitCriticalFromISR(ulState);
+
+	return ulOld;
+}
+
+static BT_BOOL list_empty(struct bt_lifo *pLifo) {
+	return pLifo->head ? BT_FALSE : BT_TRUE;
+}
+
+#endif
+
+static BT_BOOL queue_work(BT_WORKQUEUE *pQueue, BT_WORK *pWork) {
+	if(swap(&pWork->ulPending, 1)) {
+		return BT_FALSE;
+	}
+
+	bt_lifo_push(&pQueue->incoming, &pWork->node);
+
+	return BT_TRUE;
+}
+
+BT_BOOL BT_QueueWork(BT_WORKQUEUE *pQueue, BT_WORK *pWork) {
+	if(!pQueue) {
+		pQueue = g_pSystemQueue;
+	}
+
+	if(!queue_work(pQueue, pWork)) {
+		return BT_FALSE;
+	}
+
+	if(swap(&pQueue->ulIdle, 0)) {
+		BT_kMutexRelease(pQueue->pSignal);
+	}
+
+	return BT_TRUE;
+}
+BT_EXPORT_SYMBOL(BT_QueueWork);
+
+BT_BOOL BT_QueueWorkFromISR(BT_WORKQUEUE *pQueue, BT_WORK *pWork) {
+	if(!pQueue) {
+		pQueue = g_pSystemQueue;
+	}
+
+	if(!queue_work(pQueue, pWork)) {
+		return BT_FALSE;
+	}
+
+	if(swap(&pQueue->ulIdle, 0)) {
+		BT_BOOL bWoken = BT_FALSE;
+		BT_kMutexReleaseFromISR(pQueue->pSignal, &bWoken);
+		BT_kYieldFromISR(bWoken);
+	}
+
+	return BT_TRUE;
+}
+BT_EXPORT_SYMBOL(BT_QueueWorkFromISR);
+
+static BT_ERROR worker(BT_HANDLE hThread, void *pParam) {
+	BT_WORKQUEUE *pQueue = (BT_WORKQUEUE *) pParam;
+
+	while(1) {
+		struct bt_lifo_node *n = bt_lifo_pop_all(&pQueue->incoming);
+		struct bt_lifo_node *pOldest = NULL;
+		while(n) {
+			struct bt_lifo_node *next = n->next;
+			n->next = pOldest;
+			pOldest = n;
+			n = next;
+		}
+
+		while(pOldest) {
+			BT_WORK *pWork = work_of(pOldest);
+			pOldest = pOldest->next;
+
+			pWork->node.next = NULL;
+			swap(&pWork->ulPending, 0);		// May be queued again from here on.
+			pWork->pfnHandler(pWork);
+		}
+
+		swap(&pQueue->ulIdle, 1);
+		if(!list_empty(&pQueue->incoming)) {
+			if(swap(&pQueue->ulIdle, 0)) {
+				continue;			// No producer saw the worker idle.
+			}
+		}
+
+		BT_kMutexPend(pQueue->pSignal, BT_INFINITE_TIMEOUT);
+	}
+
+	return BT_ERR_NONE;
+}
+
+BT_WORKQUEUE *BT_CreateWorkQueue(const BT_WORKQUEUE_CONFIG *pConfig, BT_ERROR *pError) {
+	BT_ERROR Error = BT_ERR_NO_MEMORY;
+
+	BT_WORKQUEUE *pQueue = BT_kMalloc(sizeof(*pQueue));
+	if(!pQueue) {
+		goto err_out;
+	}
+
+	pQueue->incoming.head = NULL;
+	pQueue->ulIdle = 0;
+	pQueue->pSignal = BT_kSemaphoreCreate();
+	if(!pQueue->pSignal) {
+		goto err_free_out;
+	}
+
+	BT_kMutexPend(pQueue->pSignal, 0);
+
+	BT_THREAD_CONFIG oThreadConfig = {
+		.ulStackDepth	= pConfig->ulStackDepth,
+		.ulPriority		= pConfig->ulPriority,
+		.pParam			= pQueue,
+	};
+
+	if(!BT_CreateThread(worker, &oThreadConfig, &Error)) {
+		goto err_signal_out;
+	}
+
+	return pQueue;
+
+err_signal_out:
+	BT_kMutexDestroy(pQueue->pSignal);
+
+err_free_out:
+	BT_kFree(pQueue);
+
+err_out:
+	if(pError) {
+		*pError = Error;
+	}
+
+	return NULL;
+}
+BT_EXPORT_SYMBOL(BT_CreateWorkQueue);
+
+static BT_ERROR bt_workqueue_init() {
+	BT_ERROR Error;
+
+	BT_WORKQUEUE_CONFIG oConfig = {
+		.ulStackDepth	= BT_CONFIG_WORKQUEUE_STACK,
+		.ulPriority		= BT_CONFIG_WORKQUEUE_PRIORITY,
+	};
+
+	g_pSystemQueue = BT_CreateWorkQueue(&oConfig, &Error);
+	if(!g_pSystemQueue) {
+		return Error;
+	}
+
+	return BT_ERR_NONE;
+}
+
+BT_MODULE_INIT_0_DEF oModuleEntry = {
+	BT_MODULE_NAME,
+	bt_workqueue_init,
+};
@@ -279,6 +279,10 @@ void bt_initialise_pages(void) {
 	len = &__absolute_end - &_heap_end;
 
 	bt_page_reserve(start, len);
+
+#ifdef BT_CONFIG_AMP
+	bt_page_reserve(BT_CONFIG_AMP_MEMORY_BASE, BT_CONFIG_AMP_MEMORY_SIZE);	// Owned by the remote core.
+#endif
 }
 
 void bt_initialise_pages_second_stage() {
@@ -23,8 +23,8 @@
 #undef BT_kFree
 #endif
 
-#define SLAB_LOCK(cache)	if(cache->slab_mutex) BT_kMutexPend(cache->slab_mutex, BT_INFINITE_TIMEOUT)
-#define SLAB_UNLOCK(cache)	if(cache->slab_mutex) BT_kMutexRelease(cache->slab_mutex)
+#define SLAB_LOCK(cache)	bt_lock(&cache->slab_lock)
+#define SLAB_UNLOCK(cache)	bt_unlock(&cache->slab_lock)
 
 #define BT_CACHE_FLAGS_OBJECT		0x00000001	///< Unset if standard allocation cache.
 #define BT_CACHE_FLAGS_UNALIGNED	0x00000002
@@ -102,7 +102,9 @@ static BT_ERROR init_cache(BT_CACHE *pCache, BT_u32 ulObjectSize) {
 }
 
 BT_ERROR BT_CacheInit(BT_CACHE *pCache, BT_u32 ulObjectSize) {
-	pCache->slab_mutex = BT_kMutexCreate();
+	pCache->slab_lock.ulState = BT_LOCK_FREE;
+	pCache->slab_lock.pWait = NULL;
+	bt_lock_init(&pCache->slab_lock);
 	return init_cache(pCache, ulObjectSize);
 }
 BT_EXPORT_SYMBOL(BT_CacheInit);
@@ -299,7 +301,8 @@ void bt_initialise_slab() {
 			break;
 		}
 		init_cache(pCache, i);
-		pCache->slab_mutex = NULL;
+		pCache->slab_lock.ulState = BT_LOCK_FREE;
+		pCache->slab_lock.pWait = NULL;
 		i = i << 1;
 	}
 }
@@ -313,7 +316,7 @@ void bt_initialise_slab_second_stage() {
 		if(!pCache) {
 			break;
 		}
-		pCache->slab_mutex = BT_kMutexCreate();
+		bt_lock_init(&pCache->slab_lock);
 		i = i << 1;
 	}
 }
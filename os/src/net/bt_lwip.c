@@ -7,6 +7,10 @@
 #include <collections/bt_fifo.h>
 #include <lwip/sys.h>
 #include <lwip/stats.h>
+#include <lwip/memp.h>
+#include <lwip/ip.h>
+#include <lwip/udp.h>
+#include <lwip/inet_chksum.h>
 #include <netif/etharp.h>
 #include <lwip/tcpip.h>
 #include <string.h>
@@ -86,6 +90,237 @@ static BT_u32 write_packet(BT_NET_IF *pIF, struct pbuf *pBuf) {
 	return(ret);
 }
 
+/**
+ * Zero-copy MACs (BT_NET_IF_CAPABILITIES_ZEROCOPY) receive directly into these
+ * buffers, which are handed to lwIP as custom pbufs and recycled when freed.
+ *
+ * The pbuf is typed PBUF_RAM rather than PBUF_REF, so that lwIP can move back
+ * over headers it has stripped (e.g. for ICMP replies). The frame data starts
+ * on a cache line of its own.
+ *
+ * All of an interface's buffers are reserved in one block when it is
+ * initialised. Freed buffers go back on a lock-free list, so they can be
+ * recycled from any context without taking the lwIP lock.
+ */
+typedef struct _BT_LWIP_RXBUF {
+	struct bt_lifo_node		node;
+	BT_NETIF_PRIV		   *pIF;
+	BT_u8				   *payload;
+	struct pbuf_custom		pc;
+} BT_LWIP_RXBUF;
+
+#define BT_LWIP_RXBUF_HEADER	((sizeof(BT_LWIP_RXBUF) + BT_NET_BUFFER_ALIGN - 1) & ~(BT_NET_BUFFER_ALIGN - 1))
+
+#define BT_LWIP_TX_SEGMENTS		16
+
+static BT_BOOL lwip_zerocopy(BT_NETIF_PRIV *pIF) {
+	return (pIF->base.pOps->ulCapabilities & BT_NET_IF_CAPABILITIES_ZEROCOPY) ? BT_TRUE : BT_FALSE;
+}
+
+#if LWIP_CHECKSUM_CTRL_PER_NETIF
+/**
+ * Software checksums that are no longer needed when the MAC offloads them.
+ * ICMP checksums are always handled by lwIP.
+ */
+static const struct {
+	BT_u32	ulCapability;
+	u16_t	usChecksum;
+} g_checksum_offloads[] = {
+	{ BT_NET_IF_CAPABILITIES_TX_CSUM_IP, 	NETIF_CHECKSUM_GEN_IP },
+	{ BT_NET_IF_CAPABILITIES_TX_CSUM_TCP, 	NETIF_CHECKSUM_GEN_TCP },
+	{ BT_NET_IF_CAPABILITIES_TX_CSUM_UDP, 	NETIF_CHECKSUM_GEN_UDP },
+	{ BT_NET_IF_CAPABILITIES_RX_CSUM_IP, 	NETIF_CHECKSUM_CHECK_IP },
+	{ BT_NET_IF_CAPABILITIES_RX_CSUM_TCP, 	NETIF_CHECKSUM_CHECK_TCP },
+	{ BT_NET_IF_CAPABILITIES_RX_CSUM_UDP, 	NETIF_CHECKSUM_CHECK_UDP },
+};
+#endif
+
+static void lwip_rxbuf_free(struct pbuf *p) {
+	BT_LWIP_RXBUF *pBuf = bt_container_of(p, BT_LWIP_RXBUF, pc.pbuf);
+
+	bt_lifo_push(&pBuf->pIF->rx_free, &pBuf->node);
+}
+
+/**
+ * Reserves the receive buffers of a zero-copy MAC, fewer if memory is short.
+ */
+static void lwip_rx_reserve(BT_NETIF_PRIV *pIF) {
+	BT_u32 ulStride = BT_LWIP_RXBUF_HEADER + pIF->rx_size;
+	BT_u32 ulBuffers = BT_CONFIG_NET_LWIP_ZEROCOPY_RX_BUFFERS;
+	BT_u32 i;
+
+	while(ulBuffers) {
+		pIF->rx_pool = BT_kMalloc(ulStride * ulBuffers + BT_NET_BUFFER_ALIGN - 1);
+		if(pIF->rx_pool) {
+			break;
+		}
+		ulBuffers /= 2;
+	}
+
+	BT_u8 *p = (BT_u8 *) (((BT_u32) pIF->rx_pool + BT_NET_BUFFER_ALIGN - 1) & ~(BT_NET_BUFFER_ALIGN - 1));
+	for(i = 0; i < ulBuffers; i++, p += ulStride) {
+		BT_LWIP_RXBUF *pBuf = (BT_LWIP_RXBUF *) p;
+		pBuf->pIF = pIF;
+		pBuf->payload = p + BT_LWIP_RXBUF_HEADER;
+		bt_lifo_push(&pIF->rx_free, &pBuf->node);
+	}
+
+	pIF->rx_buffers = ulBuffers;
+}
+
+/**
+ * Posts receive buffers until the MAC's ring is full, or the interface has
+ * lent out all of its buffers.
+ */
+static void lwip_rx_refill(BT_NETIF_PRIV *pIF) {
+	struct bt_lifo_node *pNode;
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	SYS_ARCH_PROTECT(lev);
+
+	while((pNode = bt_lifo_pop(&pIF->rx_free))) {
+		BT_LWIP_RXBUF *pBuf = bt_container_of(pNode, BT_LWIP_RXBUF, node);
+
+		BT_NET_BUFFER oBuffer = {
+			.pBuffer 	= pBuf,
+			.pData 		= pBuf->payload,
+			.ulLength 	= pIF->rx_size,
+		};
+
+		if(pIF->base.pOps->pfnRxPostBuffer(pIF->base.hIF, &oBuffer)) {
+			bt_lifo_push(&pIF->rx_free, &pBuf->node);
+			break;
+		}
+	}
+
+	SYS_ARCH_UNPROTECT(lev);
+}
+
+static struct pbuf *lwip_receive_zerocopy(BT_NETIF_PRIV *pIF) {
+	BT_ERROR Error = BT_ERR_NONE;
+	BT_LWIP_RXBUF *pBuf;
+	struct pbuf *p = NULL;
+	BT_u32 ulLength;
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	while(!p) {
+		SYS_ARCH_PROTECT(lev);
+		pBuf = pIF->base.pOps->pfnRxFrame(pIF->base.hIF, &ulLength, &Error);
+		SYS_ARCH_UNPROTECT(lev);
+
+		if(!pBuf) {
+			break;
+		}
+
+		// Replace the buffer on the ring straight away.
+		lwip_rx_refill(pIF);
+
+		pBuf->pc.custom_free_function = lwip_rxbuf_free;
+		p = pbuf_alloced_custom(PBUF_RAW, ulLength, PBUF_RAM, &pBuf->pc, pBuf->payload, pIF->rx_size);
+		if(!p) {
+			lwip_rxbuf_free(&pBuf->pc.pbuf);
+			LINK_STATS_INC(link.lenerr);
+			LINK_STATS_INC(link.drop);
+		}
+	}
+
+	return p;
+}
+
+/**
+ * Returns BT_TRUE if the chain references data that is only valid until the
+ * output call returns: PBUF_REF or PBUF_ROM pbufs without a custom free function.
+ */
+static BT_BOOL lwip_tx_borrowed(struct pbuf *p) {
+	for(; p != NULL; p = p->next) {
+		if((p->type == PBUF_REF || p->type == PBUF_ROM) && !(p->flags & PBUF_FLAG_IS_CUSTOM)) {
+			return BT_TRUE;
+		}
+	}
+
+	return BT_FALSE;
+}
+
+/**
+ * Frees the pbufs of frames that a zero-copy MAC has finished sending.
+ */
+static void lwip_tx_reclaim(BT_NETIF_PRIV *pIF) {
+	void *pBuffers[BT_LWIP_TX_SEGMENTS];
+	BT_u32 i, n;
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	do {
+		SYS_ARCH_PROTECT(lev);
+		n = pIF->base.pOps->pfnTxReclaim(pIF->base.hIF, pBuffers, BT_LWIP_TX_SEGMENTS);
+		SYS_ARCH_UNPROTECT(lev);
+
+		for(i = 0; i < n; i++) {
+			pbuf_free((struct pbuf *) pBuffers[i]);
+		}
+	} while(n == BT_LWIP_TX_SEGMENTS);
+}
+
+/**
+ * Places the pbuf chain on the MAC's TX ring, one segment per pbuf, or as a
+ * single copied buffer for MACs without scatter-gather. The MAC keeps the
+ * reference that lwip_output() took until the frame has been sent.
+ *
+ * PBUF_RAM and PBUF_POOL pbufs, and custom pbufs whose free function releases
+ * the data, are sent in place. lwip_output() has already copied frames with
+ * other PBUF_REF or PBUF_ROM data, which belongs to the caller and may be
+ * reused as soon as e.g. sendto() returns.
+ */
+static err_t lwip_transmit_zerocopy(BT_NETIF_PRIV *pIF, struct pbuf *p) {
+	BT_NET_BUFFER oSegments[BT_LWIP_TX_SEGMENTS];
+	BT_u32 ulMaxSegments = BT_LWIP_TX_SEGMENTS;
+	BT_ERROR Error;
+	struct pbuf *q;
+	BT_u32 n = 0;
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	if(!(pIF->base.pOps->ulCapabilities & BT_NET_IF_CAPABILITIES_SCATTER_GATHER)) {
+		ulMaxSegments = 1;
+	}
+
+	if(pbuf_clen(p) > ulMaxSegments) {
+		q = pbuf_alloc(PBUF_RAW, p->tot_len, PBUF_RAM);
+		if(q) {
+			pbuf_copy(q, p);
+			pIF->base.ulBytesCopied += p->tot_len;
+		}
+		pbuf_free(p);
+		if(!q) {
+			LINK_STATS_INC(link.memerr);
+			LINK_STATS_INC(link.drop);
+			return ERR_MEM;
+		}
+		p = q;
+	}
+
+	for(q = p; q != NULL; q = q->next) {
+		if(q->len) {
+			oSegments[n].pBuffer 	= NULL;
+			oSegments[n].pData 		= q->payload;
+			oSegments[n].ulLength 	= q->len;
+			n++;
+		}
+	}
+
+	SYS_ARCH_PROTECT(lev);
+	Error = pIF->base.pOps->pfnTxFrame(pIF->base.hIF, oSegments, n, p);
+	SYS_ARCH_UNPROTECT(lev);
+
+	if(Error) {
+		pbuf_free(p);
+		LINK_STATS_INC(link.drop);
+		return ERR_MEM;
+	}
+
+	LINK_STATS_INC(link.xmit);
+
+	return ERR_OK;
+}
+
 /**
  * This function should do the actual transmission of the packet. The packet is
  * contained in the pbuf that is passed to the function. This pbuf might be
@@ -102,6 +337,10 @@ static err_t lwIPif_transmit(struct netif *netif, struct pbuf *p) {
 	BT_NET_IF *pIF = (BT_NET_IF*)netif->state;
 	struct pbuf *q;
 
+	if(lwip_zerocopy((BT_NETIF_PRIV *) pIF)) {
+		return lwip_transmit_zerocopy((BT_NETIF_PRIV *) pIF, p);
+	}
+
 	#ifdef BT_CONFIG_MACH_LM3Sxx
 	*((unsigned short *)(p->payload)) = p->tot_len - 16;
 	#endif
@@ -111,6 +350,8 @@ static err_t lwIPif_transmit(struct netif *netif, struct pbuf *p) {
 		pIF->pOps->pfnWrite(pIF->hIF, q->len, q->payload);
 	}
 
+	pIF->ulBytesCopied += p->tot_len;
+
 	/* Wakeup the transmitter. */
 	pIF->pOps->pfnSendFrame(pIF->hIF);
 
@@ -136,8 +377,26 @@ static err_t lwIPif_transmit(struct netif *netif, struct pbuf *p) {
 static err_t lwip_output(struct netif *netif, struct pbuf *p) {
 	BT_NET_IF *pIF = (BT_NET_IF*)netif->state;
 	BT_ERROR Error = BT_ERR_NONE;
+	struct pbuf *q = NULL;
 	SYS_ARCH_DECL_PROTECT(lev);
 
+	if(lwip_zerocopy((BT_NETIF_PRIV *) pIF)) {
+		lwip_tx_reclaim((BT_NETIF_PRIV *) pIF);
+
+		/* The frame outlives this call, copy data that nothing keeps alive until it is sent. */
+		if(lwip_tx_borrowed(p)) {
+			q = pbuf_alloc(PBUF_RAW, p->tot_len, PBUF_RAM);
+			if(!q) {
+				LINK_STATS_INC(link.memerr);
+				LINK_STATS_INC(link.drop);
+				return ERR_MEM;
+			}
+			pbuf_copy(q, p);
+			pIF->ulBytesCopied += p->tot_len;
+			p = q;
+		}
+	}
+
 	/**
 	* This entire function must run within a "critical section" to preserve
 	* the integrity of the transmit pbuf queue.
@@ -146,9 +405,11 @@ static err_t lwip_output(struct netif *netif, struct pbuf *p) {
 
 	/**
 	* Bump the reference count on the pbuf to prevent it from being
-	* freed till we are done with it.
+	* freed till we are done with it. A copy is ours already.
 	*/
-	pbuf_ref(p);
+	if(!q) {
+		pbuf_ref(p);
+	}
 
 	/**
 	* If the transmitter is idle, and there is nothing on the queue,
@@ -195,6 +456,18 @@ static struct pbuf * lwip_receive(struct netif *netif) {
 	lwIPHostGetTime(&time_s, &time_ns);
 	#endif
 
+	if(lwip_zerocopy((BT_NETIF_PRIV *) pIF)) {
+		p = lwip_receive_zerocopy((BT_NETIF_PRIV *) pIF);
+		if(p) {
+			LINK_STATS_INC(link.recv);
+
+			#if LWIP_PTPD
+			p->time_s = time_s;
+			p->time_ns = time_ns;
+			#endif
+		}
+		return p;
+	}
 
 	/* Check if a packet is available, if not, return NULL packet. */
 	BT_u32 ulTemp = pIF->pOps->pfnDataReady(pIF->hIF, &Error);
@@ -228,6 +501,8 @@ static struct pbuf * lwip_receive(struct netif *netif) {
 			q = q->next;
 		}
 
+		pIF->ulBytesCopied += pos;
+
 		#ifdef BT_CONFIG_MACH_LM3Sxx
 		/* Restore the first pbuf parameters to their original values. */
 		p->payload = (char *)(p->payload) - 4;
@@ -256,30 +531,197 @@ static struct pbuf * lwip_receive(struct netif *netif) {
 	return(p);
 }
 
+/**
+ * Verifies the IP header checksum, and the TCP or UDP checksum of unfragmented
+ * packets, in the receive worker rather than in the lwIP thread. Frames that
+ * fail, or cannot be checked here, are left to lwIP to check and count.
+ */
+static void lwip_rx_classify(BT_NETIF_PRIV *pIF, struct pbuf *p) {
+	struct eth_hdr *ethhdr = (struct eth_hdr *) p->payload;
+	struct ip_hdr *iphdr = (struct ip_hdr *) ((u8_t *) p->payload + SIZEOF_ETH_HDR);
+	ip_addr_t src, dest;
+	u16_t hlen, len;
+	u8_t proto;
+
+#if LWIP_CHECKSUM_CTRL_PER_NETIF
+	if(!(pIF->netif.chksum_flags & (NETIF_CHECKSUM_CHECK_IP | NETIF_CHECKSUM_CHECK_UDP | NETIF_CHECKSUM_CHECK_TCP))) {
+		return;		// Offloaded to the MAC.
+	}
+#endif
+
+	if(p->len < SIZEOF_ETH_HDR + IP_HLEN || ethhdr->type != PP_HTONS(ETHTYPE_IP)) {
+		return;
+	}
+
+	hlen = IPH_HL(iphdr) * 4;
+	if(IPH_V(iphdr) != 4 || hlen < IP_HLEN || p->len < SIZEOF_ETH_HDR + hlen) {
+		return;
+	}
+
+	if(inet_chksum(iphdr, hlen) != 0) {
+		return;
+	}
+
+	p->flags |= PBUF_FLAG_IP_CSUM_OK;
+
+	/*
+	 *	The sum covers the whole pbuf, so frames with Ethernet padding or fragments are left to lwIP.
+	 */
+	len = ntohs(IPH_LEN(iphdr));
+	proto = IPH_PROTO(iphdr);
+	if((IPH_OFFSET(iphdr) & PP_HTONS(IP_OFFMASK | IP_MF)) || len < hlen || p->tot_len != SIZEOF_ETH_HDR + len) {
+		return;
+	}
+
+	if(proto != IP_PROTO_TCP && proto != IP_PROTO_UDP) {
+		return;
+	}
+
+	ip_addr_copy(src, iphdr->src);
+	ip_addr_copy(dest, iphdr->dest);
+
+	pbuf_header(p, -(s16_t) (SIZEOF_ETH_HDR + hlen));
+	if(inet_chksum_pseudo(p, &src, &dest, proto, len - hlen) == 0) {
+		p->flags |= PBUF_FLAG_L4_CSUM_OK;
+	}
+	pbuf_header(p, (s16_t) (SIZEOF_ETH_HDR + hlen));
+}
+
+/**
+ * Posts lwip_rx_drain() to the lwIP thread, unless it is already pending.
+ *
+ * @return BT_FALSE if the lwIP mailbox was full, the caller must try again later.
+ */
+static BT_BOOL lwip_rx_kick(BT_NETIF_PRIV *pIF) {
+	if(!__atomic_exchange_n(&pIF->rx_armed, 1, __ATOMIC_SEQ_CST)) {
+		if(tcpip_trycallback(pIF->rx_msg) != ERR_OK) {
+			__atomic_store_n(&pIF->rx_armed, 0, __ATOMIC_SEQ_CST);
+			return BT_FALSE;
+		}
+	}
+
+	return BT_TRUE;
+}
+
+/**
+ * Runs in the lwIP thread, passes the frames queued by the receive worker to the
+ * stack. A queue that is not emptied within one pass is posted again, so that
+ * other interfaces and API calls are served in between.
+ */
+static void lwip_rx_drain(void *ctx) {
+	BT_NETIF_PRIV *pIF = (BT_NETIF_PRIV *) ctx;
+	struct netif *netif = &pIF->netif;
+	struct pbuf *p;
+	BT_u32 i;
+
+	// Frames queued from here on post the message again.
+	__atomic_store_n(&pIF->rx_armed, 0, __ATOMIC_SEQ_CST);
+
+	for(i = 0; i < BT_CONFIG_NET_LWIP_RX_QUEUE_SIZE; i++) {
+		p = bt_spsc_pop(&pIF->rx_queue);
+		if(!p) {
+			break;
+		}
+
+		ethernet_input(p, netif);
+	}
+
+	// There is room again, let a worker that stopped on the full queue carry on.
+	if(i && __atomic_exchange_n(&pIF->rx_stalled, 0, __ATOMIC_SEQ_CST)) {
+		bt_net_rx_resume(&pIF->base);
+	}
+
+	// The mailbox is full, the worker posts the queue once it gets room.
+	if(!bt_spsc_empty(&pIF->rx_queue) && !lwip_rx_kick(pIF)) {
+		bt_net_rx_resume(&pIF->base);
+	}
+}
+
+/**
+ * Hands a received frame to the lwIP thread, through the interface's queue when
+ * it has one, otherwise as a message of its own.
+ */
+static err_t lwip_input(BT_NETIF_PRIV *pIF, struct pbuf *p) {
+	if(!pIF->rx_msg) {
+		return tcpip_input(p, &pIF->netif);
+	}
+
+	lwip_rx_classify(pIF, p);
+
+	if(!bt_spsc_push(&pIF->rx_queue, p)) {
+		return ERR_MEM;
+	}
+
+	lwip_rx_kick(pIF);
+
+	return ERR_OK;
+}
+
 /**
  * Process tx and rx packets at the low-level interrupt.
  *
- * Should be called from the lwIP Ethernet Interrupt Handler.  This
- * function will read packets from the lwIP Ethernet fifo and place them
- * into a pbuf queue.  If the transmitter is idle and there is at least one packet
- * on the transmit queue, it will place it in the transmit fifo and start the
- * transmitter.
+ * Called from the interface's receive worker when the MAC signals received frames.
+ * This function will read up to BT_CONFIG_NET_LWIP_RX_BUDGET packets from the lwIP
+ * Ethernet fifo and queue them for the lwIP thread. If the transmitter is idle and
+ * there is at least one packet on the transmit queue, it will place it in the
+ * transmit fifo and start the transmitter.
  *
+ * @return BT_LWIP_RX_MORE if the budget was used up with frames still pending, and
+ *         BT_LWIP_RX_STALLED if the queue to the lwIP thread filled up or could not
+ *         be posted. In both cases the MAC's receive interrupt is left masked. A stalled
+ *         interface is resumed by lwip_rx_drain() through bt_net_rx_resume().
  */
-void bt_lwip_process(BT_NETIF_PRIV *pIF) {
+BT_u32 bt_lwip_process(BT_NETIF_PRIV *pIF) {
 	struct netif *netif = &pIF->netif;
 	struct pbuf *p;
 	BT_ERROR Error = BT_ERR_NONE;
+	BT_u32 ulFrames = 0;
+	BT_BOOL bQueueFull = BT_FALSE;
+
+	if(lwip_zerocopy(pIF)) {
+		lwip_tx_reclaim(pIF);
+		lwip_rx_refill(pIF);
+	}
+
+	pIF->base.rx_stats.ulPolls++;
 
 	/**
 	* Process the transmit and receive queues as long as there is receive
-	* data available
+	* data available, and the budget allows.
 	*
 	*/
-	p = lwip_receive(netif);
-	while(p != NULL) {
+	while(ulFrames < BT_CONFIG_NET_LWIP_RX_BUDGET) {
+		if(pIF->rx_msg && bt_spsc_full(&pIF->rx_queue)) {
+			/* lwIP is behind, leave the frames on the MAC's ring until it catches up.
+			   Checked again once stalled, in case the queue was drained meanwhile. */
+			__atomic_store_n(&pIF->rx_stalled, 1, __ATOMIC_SEQ_CST);
+			if(bt_spsc_full(&pIF->rx_queue)) {
+				bQueueFull = BT_TRUE;
+				break;
+			}
+			__atomic_store_n(&pIF->rx_stalled, 0, __ATOMIC_SEQ_CST);
+		}
+
+		p = lwip_receive(netif);
+		if(p == NULL) {
+			if(!pIF->base.pOps->pfnRxInterrupt) {
+				break;
+			}
+
+			/* Drained, unmask and catch a frame that arrived before the interrupt was enabled. */
+			pIF->base.pOps->pfnRxInterrupt(pIF->base.hIF, BT_TRUE);
+			p = lwip_receive(netif);
+			if(p == NULL) {
+				break;
+			}
+
+			pIF->base.pOps->pfnRxInterrupt(pIF->base.hIF, BT_FALSE);
+		}
+
+		ulFrames++;
+
 		/* process the packet */
-		if(tcpip_input(p, netif)!=ERR_OK) {
+		if(lwip_input(pIF, p)!=ERR_OK) {
 			/* drop the packet */
 			LWIP_DEBUGF(NETIF_DEBUG, ("lwIPif_input: input error\n"));
 			pbuf_free(p);
@@ -296,9 +738,6 @@ void bt_lwip_process(BT_NETIF_PRIV *pIF) {
 				lwIPif_transmit(netif, p);
 			}
 		}
-
-		/* Read another packet from the RX fifo */
-		p = lwip_receive(netif);
 	}
 
 	/* One more check of the transmit queue/fifo */
@@ -308,6 +747,52 @@ void bt_lwip_process(BT_NETIF_PRIV *pIF) {
 			lwIPif_transmit(netif, p);
 		}
 	}
+
+	/* Frames are queued but the lwIP mailbox was full, retry later. */
+	if(pIF->rx_msg && !bt_spsc_empty(&pIF->rx_queue) && !lwip_rx_kick(pIF)) {
+		bQueueFull = BT_TRUE;
+	}
+
+	pIF->base.rx_stats.ulFrames += ulFrames;
+	if(bQueueFull) {
+		pIF->base.rx_stats.ulQueueFull++;
+		return BT_LWIP_RX_STALLED;
+	}
+
+	if(ulFrames < BT_CONFIG_NET_LWIP_RX_BUDGET) {
+		return BT_LWIP_RX_DONE;
+	}
+
+	pIF->base.rx_stats.ulBudgetExhausted++;
+	return BT_LWIP_RX_MORE;
+}
+
+/**
+ * Called from the network thread when the MAC has sent frames after its transmit
+ * ring had filled up. Sent buffers are reclaimed as one batch, and as many queued
+ * frames as fit are moved from the transmit fifo onto the ring.
+ */
+void bt_lwip_tx_process(BT_NETIF_PRIV *pIF) {
+	struct pbuf *p;
+	BT_ERROR Error = BT_ERR_NONE;
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	if(lwip_zerocopy(pIF)) {
+		lwip_tx_reclaim(pIF);
+	}
+
+	SYS_ARCH_PROTECT(lev);
+
+	while(pIF->base.pOps->pfnTxFifoReady(pIF->base.hIF, &Error)) {
+		p = read_packet(&pIF->base);
+		if(p == NULL) {
+			break;
+		}
+
+		lwIPif_transmit(&pIF->netif, p);
+	}
+
+	SYS_ARCH_UNPROTECT(lev);
 }
 
 /**
@@ -364,10 +849,30 @@ BT_ERROR bt_lwip_netif_init(BT_NETIF_PRIV *pIF) {
 	netif->output = etharp_output;
 	netif->linkoutput = lwip_output;
 
+	/* frames are passed from the receive worker to lwIP through rx_queue */
+	if(!pIF->rx_msg) {
+		bt_spsc_init(&pIF->rx_queue, pIF->rx_slots, BT_CONFIG_NET_LWIP_RX_QUEUE_SIZE);
+		pIF->rx_msg = tcpip_callbackmsg_new(lwip_rx_drain, pIF);
+	}
+
 	/* initialize the hardware */
 
+	if(lwip_zerocopy(pIF)) {
+		/* stock the receive ring before the MAC is enabled */
+		pIF->rx_size = pIF->base.pOps->pfnGetMTU(pIF->base.hIF, &Error);
+		pIF->rx_size = (pIF->rx_size + BT_NET_BUFFER_ALIGN - 1) & ~(BT_NET_BUFFER_ALIGN - 1);
+		if(!pIF->rx_pool) {
+			lwip_rx_reserve(pIF);
+		}
+		lwip_rx_refill(pIF);
+	}
+
 	pIF->base.pOps->pfnInitialise(pIF->base.hIF);
 
+	if(pIF->base.pOps->pfnSetRxModeration) {
+		pIF->base.pOps->pfnSetRxModeration(pIF->base.hIF, BT_CONFIG_NET_LWIP_RX_MODERATION_US);
+	}
+
 	/* set MAC hardware address length */
 	netif->hwaddr_len = ETHARP_HWADDR_LEN;
 
@@ -380,6 +885,15 @@ BT_ERROR bt_lwip_netif_init(BT_NETIF_PRIV *pIF) {
 	/* device capabilities */
 	/* don't set NETIF_FLAG_ETHARP if this device is not an ethernet one */
 	netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP;
+
+	#if LWIP_CHECKSUM_CTRL_PER_NETIF
+	BT_u32 i;
+	for(i = 0; i < BT_ARRAY_SIZE(g_checksum_offloads); i++) {
+		if(pIF->base.pOps->ulCapabilities & g_checksum_offloads[i].ulCapability) {
+			netif->chksum_flags &= ~g_checksum_offloads[i].usChecksum;
+		}
+	}
+	#endif
 	pIF->base.smFlags |= NET_IF_INITIALISED;
 	pIF->base.name = netif->name;
 
@@ -439,3 +953,66 @@ BT_ERROR bt_lwip_netif_get_hostname(BT_NETIF_PRIV *pIF, char *hostname)
 	}
 	return BT_ERR_NONE;
 }
+
+/**
+ * Counts successful allocations from the lwIP heap and memory pools, pbufs
+ * included. Requires MEM_STATS and MEMP_STATS, otherwise returns 0.
+ */
+BT_u32 bt_lwip_allocations(void) {
+	BT_u32 ulAllocations = 0;
+#if MEM_STATS
+	ulAllocations += lwip_stats.mem.alloc;
+#endif
+#if MEMP_STATS
+	BT_u32 i;
+	for(i = 0; i < MEMP_MAX; i++) {
+		ulAllocations += lwip_stats.memp[i].alloc;
+	}
+#endif
+	return ulAllocations;
+}
+
+static const struct {
+	const BT_i8	   *szpName;
+	BT_u32			ulTotal;
+} g_memp_pools[] = {
+#define LWIP_MEMPOOL(name,num,size,desc)	{ desc, num },
+#include <lwip/memp_std.h>
+};
+
+/**
+ * Fills pStats with the lwIP memory pools, followed by the lwIP heap. The
+ * used, max and error counts require MEMP_STATS and MEM_STATS.
+ */
+BT_u32 bt_lwip_pool_stats(struct bt_net_pool_stats *pStats, BT_u32 ulMax) {
+	BT_u32 i, n = 0;
+
+	for(i = 0; i < MEMP_MAX && n < ulMax; i++, n++) {
+		memset(&pStats[n], 0, sizeof(pStats[n]));
+		pStats[n].szpName	= g_memp_pools[i].szpName;
+		pStats[n].ulSize	= memp_sizes[i];
+		pStats[n].ulTotal	= g_memp_pools[i].ulTotal;
+#if MEMP_STATS
+		pStats[n].ulUsed	= lwip_stats.memp[i].used;
+		pStats[n].ulMax		= lwip_stats.memp[i].max;
+		pStats[n].ulErrors	= lwip_stats.memp[i].err;
+#endif
+	}
+
+#if !MEM_LIBC_MALLOC && !MEM_USE_POOLS
+	if(n < ulMax) {
+		memset(&pStats[n], 0, sizeof(pStats[n]));
+		pStats[n].szpName	= "HEAP";
+		pStats[n].ulSize	= 1;
+		pStats[n].ulTotal	= MEM_SIZE;
+#if MEM_STATS
+		pStats[n].ulUsed	= lwip_stats.mem.used;
+		pStats[n].ulMax		= lwip_stats.mem.max;
+		pStats[n].ulErrors	= lwip_stats.mem.err;
+#endif
+		n++;
+	}
+#endif
+
+	return n;
+}
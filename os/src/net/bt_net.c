@@ -21,9 +21,17 @@ struct _BT_OPAQUE_HANDLE {
 static BT_LIST_HEAD(g_interfaces);
 static BT_u32 n_interfaces=0;
 
-static BT_HANDLE g_hMutex = NULL;
+/*
+ *	Each interface is served by one receive worker, which harvests its rings and
+ *	queues the frames for the lwIP thread. Worker 0 is the net_task thread.
+ */
+static BT_HANDLE g_hWorkers[BT_CONFIG_NET_LWIP_RX_WORKERS];
 static BT_TASKLET sm_tasklet;
 
+static BT_u32 net_worker_of(BT_NET_IF *pIF) {
+	return pIF->ulID % BT_CONFIG_NET_LWIP_RX_WORKERS;
+}
+
 static BT_BOOL g_bDone = BT_FALSE;
 
 static void net_event_handler(BT_NET_IF *pIF, BT_NET_IF_EVENT eEvent,
@@ -33,14 +41,28 @@ static void net_event_handler(BT_NET_IF *pIF, BT_NET_IF_EVENT eEvent,
 	switch (eEvent) {
 
 	case BT_NET_IF_RX_READY: {
+		pIF->rx_stats.ulInterrupts++;
 		pIF->ulFlags |= DATA_READY;
 		if (bInterruptContext) {
-			BT_ReleaseMutexFromISR(g_hMutex, &ulWake);
+			BT_ReleaseMutexFromISR(g_hWorkers[net_worker_of(pIF)], &ulWake);
+		} else {
+			BT_ReleaseMutex(g_hWorkers[net_worker_of(pIF)]);
+		}
+		break;
+	}
+	case BT_NET_IF_TX_COMPLETE: {
+		pIF->ulFlags |= TX_READY;
+		if (bInterruptContext) {
+			BT_ReleaseMutexFromISR(g_hWorkers[net_worker_of(pIF)], &ulWake);
 		} else {
-			BT_ReleaseMutex(g_hMutex);
+			BT_ReleaseMutex(g_hWorkers[net_worker_of(pIF)]);
 		}
 		break;
 	}
+	case BT_NET_IF_RX_DROPPED:
+		pIF->rx_stats.ulRingFull++;
+		break;
+
 	default:
 		break;
 	}
@@ -236,6 +258,22 @@ BT_ERROR BT_NetifGetLinkState(BT_NET_IF *interface, struct bt_phy_linkstate *lin
 }
 BT_EXPORT_SYMBOL(BT_NetifGetLinkState);
 
+BT_ERROR BT_NetifGetRxStats(BT_NET_IF *interface, struct bt_netif_rx_stats *stats) {
+	*stats = interface->rx_stats;
+	return BT_ERR_NONE;
+}
+BT_EXPORT_SYMBOL(BT_NetifGetRxStats);
+
+BT_u32 BT_NetGetAllocations() {
+	return bt_lwip_allocations();
+}
+BT_EXPORT_SYMBOL(BT_NetGetAllocations);
+
+BT_u32 BT_NetGetPoolStats(struct bt_net_pool_stats *pStats, BT_u32 ulMax) {
+	return bt_lwip_pool_stats(pStats, ulMax);
+}
+BT_EXPORT_SYMBOL(BT_NetGetPoolStats);
+
 BT_ERROR BT_NetifConfigureLink(BT_NET_IF *interface, struct bt_phy_config *config) {
 	if(!interface->phy) {
 		return BT_ERR_GENERIC;
@@ -263,39 +301,103 @@ static void tcpip_init_done(void *arg) {
 	*bDone = BT_TRUE;
 }
 
-static BT_ERROR net_task(BT_HANDLE hThread, void *pParam) {
-	BT_NETIF_PRIV *pIF;
-
-	volatile BT_BOOL bDone = BT_FALSE;
-
-	tcpip_init(tcpip_init_done, (BT_BOOL *) &bDone);
-
-	while (!bDone) {
-		BT_ThreadYield();
-	}
+/*
+ *	Called from the lwIP thread when it has made room in the queue of an interface
+ *	whose worker stalled on it, or could not post the queue itself.
+ */
+void bt_net_rx_resume(BT_NET_IF *pIF) {
+	BT_kEnterCritical();
+	pIF->ulFlags |= DATA_READY;
+	BT_kExitCritical();
 
-	g_bDone = BT_TRUE;
+	BT_ReleaseMutex(g_hWorkers[net_worker_of(pIF)]);
+}
 
-	BT_TaskletHighSchedule(&sm_tasklet);
+static BT_ERROR net_worker(BT_HANDLE hThread, void *pParam) {
+	BT_u32 ulWorker = (BT_u32) pParam;
+	BT_NETIF_PRIV *pIF;
+	BT_BOOL bPending = BT_FALSE;
+	BT_BOOL bStalled = BT_FALSE;
 
 	while (1) {
-		BT_PendMutex(g_hMutex, BT_INFINITE_TIMEOUT);
+		// Interfaces left with frames after their budget are polled again without waiting.
+		// Stalled ones wait for lwIP, with a tick's timeout for a full lwIP mailbox.
+		if (!bPending) {
+			BT_PendMutex(g_hWorkers[ulWorker], bStalled ? 1 : BT_INFINITE_TIMEOUT);
+		}
+
+		bPending = BT_FALSE;
+		bStalled = BT_FALSE;
 
 		struct bt_list_head *pos;
 		bt_list_for_each(pos, &g_interfaces) {
 			pIF = (BT_NETIF_PRIV *) pos;
+			if (net_worker_of(&pIF->base) != ulWorker) {
+				continue;
+			}
+
+			if (pIF->base.ulFlags & TX_READY) {
+				BT_kEnterCritical();
+				pIF->base.ulFlags &= ~TX_READY;
+				BT_kExitCritical();
+
+				// The MAC's ring has room again, reclaim sent frames and move queued ones on.
+				bt_lwip_tx_process(pIF);
+			}
+
 			if (pIF->base.ulFlags & DATA_READY) {
-				// Processes any packets waiting to be sent or received.
-				bt_lwip_process(pIF);
+				// Cleared first, DATA_READY is also set from the MAC's interrupt.
+				BT_kEnterCritical();
 				pIF->base.ulFlags &= ~DATA_READY;
-				pIF->base.pOps->pfnSendEvent(pIF->base.hIF, BT_MAC_RECEIVED);
+				BT_kExitCritical();
+
+				// Processes any packets waiting to be sent or received.
+				switch (bt_lwip_process(pIF)) {
+				case BT_LWIP_RX_MORE:
+					BT_kEnterCritical();
+					pIF->base.ulFlags |= DATA_READY;
+					BT_kExitCritical();
+					bPending = BT_TRUE;
+					break;
+
+				case BT_LWIP_RX_STALLED:
+					BT_kEnterCritical();
+					pIF->base.ulFlags |= DATA_READY;
+					BT_kExitCritical();
+					bStalled = BT_TRUE;
+					break;
+
+				default:
+					pIF->base.pOps->pfnSendEvent(pIF->base.hIF, BT_MAC_RECEIVED);
+					break;
+				}
 			}
 		}
+
+		if (bPending) {
+			BT_ThreadYield();
+		}
 	}
 
 	return BT_ERR_NONE;
 }
 
+static BT_ERROR net_task(BT_HANDLE hThread, void *pParam) {
+	volatile BT_BOOL bDone = BT_FALSE;
+
+	tcpip_init(tcpip_init_done, (BT_BOOL *) &bDone);
+
+	while (!bDone) {
+		BT_ThreadSleep(1);	// The lwIP thread may run at a lower priority.
+	}
+
+	g_bDone = BT_TRUE;
+
+	BT_TaskletHighSchedule(&sm_tasklet);
+
+	return net_worker(hThread, (void *) 0);
+}
+
 static err_t lwip_init(struct netif *netif) {
 	bt_lwip_netif_init((BT_NETIF_PRIV *) netif->state);
 
@@ -340,21 +442,29 @@ BT_BOOL BT_isNetworkingReady() {
 }
 BT_EXPORT_SYMBOL(BT_isNetworkingReady);
 
-static BT_TASKLET sm_tasklet = { NULL, BT_TASKLET_IDLE, net_manager_sm, NULL };
+static BT_TASKLET sm_tasklet = BT_TASKLET_INIT(net_manager_sm, NULL);
 
 static BT_ERROR bt_net_manager_init() {
 	BT_ERROR Error = BT_ERR_NONE;
 
-	g_hMutex = BT_CreateMutex(&Error);
-	BT_PendMutex(g_hMutex, BT_INFINITE_TIMEOUT);
+	BT_u32 i;
+	for (i = 0; i < BT_CONFIG_NET_LWIP_RX_WORKERS; i++) {
+		g_hWorkers[i] = BT_CreateSemaphore(&Error);
+		BT_PendMutex(g_hWorkers[i], BT_INFINITE_TIMEOUT);
+	}
 
 	BT_THREAD_CONFIG oThreadConfig = {
 		.ulStackDepth = 256,
-		.ulPriority = 0,
+		.ulPriority = BT_CONFIG_NET_LWIP_RX_WORKER_PRIORITY,
 	};
 
 	BT_CreateThread(net_task, &oThreadConfig, &Error);
 
+	for (i = 1; i < BT_CONFIG_NET_LWIP_RX_WORKERS; i++) {
+		oThreadConfig.pParam = (void *) i;
+		BT_CreateThread(net_worker, &oThreadConfig, &Error);
+	}
+
 	return BT_ERR_NONE;
 }
 
@@ -10,11 +10,70 @@ BT_DEF_MODULE_EMAIL			("rsteinbauer@riegl.com")
 struct _BT_OPAQUE_HANDLE {
 	BT_HANDLE_HEADER	h;				///< All handles must include a handle header.
 	int					socket;
+	struct bt_poll_queue poll;
 };
 
 static const BT_IF_HANDLE oHandleInterface;
 
+#ifdef BT_CONFIG_POLL
+static BT_HANDLE g_sockets[MEMP_NUM_NETCONN];		///< Handle of each lwIP socket, for bt_socket_event().
+
+/*
+ *	Guards g_sockets. A lock rather than a critical section, as bt_socket_event() keeps
+ *	it across bt_poll_wake(), so that socket_cleanup() cannot free the handle meanwhile.
+ */
+static struct bt_lock g_sockets_lock;
+
+static void socket_register(BT_HANDLE hSocket, BT_BOOL bRegister) {
+	int s = hSocket->socket;
+	if(s < 0 || s >= MEMP_NUM_NETCONN) {
+		return;
+	}
+
+	bt_lock(&g_sockets_lock);
+	{
+		if(bRegister) {
+			g_sockets[s] = hSocket;
+		} else if(g_sockets[s] == hSocket) {
+			g_sockets[s] = NULL;
+		}
+	}
+	bt_unlock(&g_sockets_lock);
+}
+
+/**
+ *	Called by lwIP (LWIP_SOCKET_EVENT_HOOK) whenever a socket's readiness changes.
+ **/
+void bt_socket_event(int s, int events) {
+	if(s < 0 || s >= MEMP_NUM_NETCONN) {
+		return;
+	}
+
+	bt_lock(&g_sockets_lock);
+	{
+		BT_HANDLE hSocket = g_sockets[s];
+		if(hSocket) {
+			bt_poll_wake(&hSocket->poll, (BT_u32) events);
+		}
+	}
+	bt_unlock(&g_sockets_lock);
+}
+
+static BT_ERROR bt_sockets_init(void) {
+	return bt_lock_init(&g_sockets_lock);
+}
+
+BT_MODULE_INIT_DEF oModuleEntry = {
+	BT_MODULE_NAME,
+	.pfnInit = bt_sockets_init,
+};
+#else
+static void socket_register(BT_HANDLE hSocket, BT_BOOL bRegister) { }
+#endif
+
 static BT_ERROR socket_cleanup(BT_HANDLE hSocket) {
+	socket_register(hSocket, BT_FALSE);
+	bt_poll_queue_release(&hSocket->poll);
 	lwip_close(hSocket->socket);
 	return BT_ERR_NONE;
 }
@@ -32,6 +91,8 @@ int accept(int s, struct sockaddr *addr, socklen_t *addrlen) {
 			return 0;
 		}
 		h->socket = new_socket;
+		bt_poll_queue_init(&h->poll);
+		socket_register(h, BT_TRUE);
 		return (int)h;
 	}
 
@@ -150,6 +211,8 @@ int socket(int domain, int type, int protocol) {
 	}
 
 	hSocket->socket = lwip_socket(domain, type, protocol);
+	bt_poll_queue_init(&hSocket->poll);
+	socket_register(hSocket, BT_TRUE);
 
 	return (int)hSocket;
 }
@@ -181,6 +244,225 @@ int fcntl(int s, int cmd, int val) {
 }
 BT_EXPORT_SYMBOL(fcntl);
 
+/*
+ *	BT_SendFile() reads the file into a ring of chunks, each of which is queued on the
+ *	connection by reference. Every pbuf lwIP allocates for a chunk is a custom PBUF_REF
+ *	holding a reference on it, which its free function drops, so a chunk is refilled
+ *	only once neither the stack nor the MAC's DMA can read from it any more.
+ *
+ *	The pbufs are freed in thread context: by the tcpip thread, or by the netif's
+ *	transmit reclaim.
+ */
+#define SENDFILE_CHUNKS			3
+#define SENDFILE_CHUNK_SIZE		TCP_SND_BUF
+#define SENDFILE_REFS			(TCP_SND_QUEUELEN + SENDFILE_CHUNKS)	///< When they run out, lwIP retries the write after the next ACK.
+
+struct sendfile;
+
+struct sendfile_chunk {
+	BT_u8				   *p;
+	BT_u32					ulRefs;			///< One per pbuf, plus one held by BT_SendFile() while queueing.
+	BT_u32					ulIndex;
+	struct sendfile		   *pSendFile;
+};
+
+struct sendfile_ref {
+	struct pbuf_custom		pc;				///< Must be first, the pbuf is cast back to its sendfile_ref.
+	struct sendfile_chunk  *pChunk;			///< NULL while the sendfile_ref is unused.
+};
+
+struct sendfile {
+	struct sendfile_chunk	chunks[SENDFILE_CHUNKS];
+	struct sendfile_ref		refs[SENDFILE_REFS];
+	void				   *pReleased;		///< Queue of the indices of chunks whose last reference was dropped.
+};
+
+/*
+ *	Drops a reference on pChunk, and frees pRef if not NULL. Whoever drops the last one
+ *	posts the chunk to pReleased, after which it must not touch the sendfile any more.
+ */
+static void sendfile_put(struct sendfile_chunk *pChunk, struct sendfile_ref *pRef) {
+	BT_u32 ulRefs;
+
+	BT_kEnterCritical();
+	{
+		if(pRef) {
+			pRef->pChunk = NULL;
+		}
+		ulRefs = --pChunk->ulRefs;
+	}
+	BT_kExitCritical();
+
+	if(!ulRefs) {
+		BT_kQueueSend(pChunk->pSendFile->pReleased, &pChunk->ulIndex, 0);
+	}
+}
+
+static void sendfile_free(struct pbuf *p) {
+	struct sendfile_ref *pRef = (struct sendfile_ref *) p;
+	sendfile_put(pRef->pChunk, pRef);
+}
+
+/*
+ *	tcp_ref_fn called from the tcpip thread for each pbuf that references a chunk.
+ */
+static struct pbuf *sendfile_ref(void *arg, const void *payload, u16_t len) {
+	struct sendfile_chunk *pChunk = (struct sendfile_chunk *) arg;
+	struct sendfile *pSendFile = pChunk->pSendFile;
+	struct sendfile_ref *pRef = NULL;
+	BT_u32 i;
+
+	BT_kEnterCritical();
+	{
+		for(i = 0; i < SENDFILE_REFS; i++) {
+			if(!pSendFile->refs[i].pChunk) {
+				pRef = &pSendFile->refs[i];
+				pRef->pChunk = pChunk;
+				pChunk->ulRefs++;
+				break;
+			}
+		}
+	}
+	BT_kExitCritical();
+
+	if(!pRef) {
+		return NULL;
+	}
+
+	pRef->pc.custom_free_function = sendfile_free;
+	return pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &pRef->pc, (void *) payload, len);
+}
+
+/*
+ *	Blocks until the next chunk is released, and marks it as no longer busy.
+ */
+static void sendfile_wait(struct sendfile *pSendFile, BT_BOOL *bBusy) {
+	BT_u32 ulIndex = SENDFILE_CHUNKS;
+
+	BT_kQueueReceive(pSendFile->pReleased, &ulIndex, BT_INFINITE_TIMEOUT);
+	if(ulIndex < SENDFILE_CHUNKS) {
+		bBusy[ulIndex] = BT_FALSE;
+	}
+}
+
+BT_s32 BT_SendFile(BT_HANDLE hSocket, BT_HANDLE hFile, BT_u64 ullOffset, BT_u32 ulLength) {
+	BT_BOOL bBusy[SENDFILE_CHUNKS] = { BT_FALSE };	// Chunks that may still be referenced.
+	BT_u32 ulSent = 0;
+	BT_u32 i;
+
+	// BT_SENDFILE_MAX, bt_sockets.h does not build alongside lwIP's sockets.h.
+	if(ulLength > 0x7FFFFFFF) {
+		ulLength = 0x7FFFFFFF;
+	}
+
+	BT_ERROR Error = BT_Seek(hFile, ullOffset, BT_SEEK_SET);
+	if(Error) {
+		return Error;
+	}
+
+	struct sendfile *pSendFile = BT_kMalloc(sizeof(*pSendFile));
+	if(!pSendFile) {
+		return BT_ERR_NO_MEMORY;
+	}
+
+	BT_u8 *pBuffer = BT_kMalloc(SENDFILE_CHUNKS * SENDFILE_CHUNK_SIZE);
+	pSendFile->pReleased = BT_kQueueCreate(SENDFILE_CHUNKS, sizeof(BT_u32));
+	if(!pBuffer || !pSendFile->pReleased) {
+		Error = BT_ERR_NO_MEMORY;
+		goto free_out;
+	}
+
+	for(i = 0; i < SENDFILE_CHUNKS; i++) {
+		pSendFile->chunks[i].p = pBuffer + (i * SENDFILE_CHUNK_SIZE);
+		pSendFile->chunks[i].ulRefs = 0;
+		pSendFile->chunks[i].ulIndex = i;
+		pSendFile->chunks[i].pSendFile = pSendFile;
+	}
+
+	for(i = 0; i < SENDFILE_REFS; i++) {
+		pSendFile->refs[i].pChunk = NULL;
+	}
+
+	i = 0;
+	while(ulSent < ulLength) {
+		struct sendfile_chunk *pChunk = &pSendFile->chunks[i];
+
+		while(bBusy[i]) {
+			sendfile_wait(pSendFile, bBusy);
+		}
+
+		BT_u32 ulSize = ulLength - ulSent;
+		if(ulSize > SENDFILE_CHUNK_SIZE) {
+			ulSize = SENDFILE_CHUNK_SIZE;
+		}
+
+		BT_s32 slRead = BT_Read(hFile, 0, ulSize, pChunk->p);
+		if(slRead <= 0) {
+			Error = slRead;
+			break;
+		}
+
+		int flags = 0;
+		if(ulSent + slRead < ulLength) {
+			flags |= MSG_MORE;
+		}
+
+		pChunk->ulRefs = 1;
+		bBusy[i] = BT_TRUE;
+
+		BT_u32 ulQueued = 0;
+		while(ulQueued < (BT_u32) slRead) {
+			int written = lwip_send_ref(hSocket->socket, pChunk->p + ulQueued, slRead - ulQueued, flags, sendfile_ref, pChunk);
+			if(written < 0) {
+				Error = BT_ERR_GENERIC;
+				break;
+			}
+			ulQueued += written;
+		}
+
+		sendfile_put(pChunk, NULL);
+		ulSent += ulQueued;
+
+		if(Error) {
+			break;
+		}
+
+		i += 1;
+		if(i == SENDFILE_CHUNKS) {
+			i = 0;
+		}
+	}
+
+	// The stack may still reference every chunk, it lets go of them once the data was
+	// acknowledged or the connection is gone.
+	for(i = 0; i < SENDFILE_CHUNKS; i++) {
+		while(bBusy[i]) {
+			sendfile_wait(pSendFile, bBusy);
+		}
+	}
+
+	if(!Error) {
+		int err = 0;
+		socklen_t len = sizeof(err);
+		if(lwip_getsockopt(hSocket->socket, SOL_SOCKET, SO_ERROR, &err, &len) || err) {
+			Error = BT_ERR_GENERIC;
+		}
+	}
+
+free_out:
+	if(pSendFile->pReleased) {
+		BT_kQueueDestroy(pSendFile->pReleased);
+	}
+	BT_kFree(pBuffer);
+	BT_kFree(pSendFile);
+
+	if(Error) {
+		return Error;
+	}
+
+	return ulSent;
+}
+BT_EXPORT_SYMBOL(BT_SendFile);
 
 static BT_s32 socket_read(BT_HANDLE hSocket, BT_u32 ulFlags, BT_u32 ulSize, void *pBuffer) {
 
@@ -194,6 +476,21 @@ static BT_s32 socket_write(BT_HANDLE hSocket, BT_u32 ulFlags, BT_u32 ulSize, con
 	//return BT_ERR_GENERIC;
 }
 
+#ifdef BT_CONFIG_POLL
+static BT_u32 socket_poll(BT_HANDLE hSocket, struct bt_poll_table *pTable) {
+
+	bt_poll_wait(pTable, &hSocket->poll);
+
+	// The LWIP_POLL* flags have the values of their BT_POLL* counterparts.
+	int events = lwip_poll(hSocket->socket);
+	if(events < 0) {
+		return BT_POLLERR;
+	}
+
+	return (BT_u32) events;
+}
+#endif
+
 /**
  *	Here we allow socket handles to be passed into BT_Read and BT_Write apis.
  *
@@ -203,6 +500,9 @@ static const BT_IF_FILE oFileOperations = {
 	.ulSupported = MSG_DONTWAIT,
 	.pfnRead 	 = socket_read,
 	.pfnWrite	 = socket_write,
+#ifdef BT_CONFIG_POLL
+	.pfnPoll	 = socket_poll,
+#endif
 };
 
 static const BT_IF_HANDLE oHandleInterface = {
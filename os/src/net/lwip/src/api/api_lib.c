@@ -597,6 +597,37 @@ netconn_send(struct netconn *conn, struct netbuf *buf)
 err_t
 netconn_write_partly(struct netconn *conn, const void *dataptr, size_t size,
                      u8_t apiflags, size_t *bytes_written)
+{
+#if LWIP_TCP
+  return netconn_write_ref_partly(conn, dataptr, size, apiflags, NULL, NULL, bytes_written);
+#else /* LWIP_TCP */
+  LWIP_UNUSED_ARG(conn);
+  LWIP_UNUSED_ARG(dataptr);
+  LWIP_UNUSED_ARG(size);
+  LWIP_UNUSED_ARG(apiflags);
+  LWIP_UNUSED_ARG(bytes_written);
+  return ERR_VAL;
+#endif /* LWIP_TCP */
+}
+
+#if LWIP_TCP
+/**
+ * Send data over a TCP netconn. Data written without NETCONN_COPY is
+ * referenced by pbufs allocated by 'ref' (see tcp_write_ref).
+ *
+ * @param conn the TCP netconn over which to send data
+ * @param dataptr pointer to the application buffer that contains the data to send
+ * @param size size of the application data to send
+ * @param apiflags see netconn_write_partly
+ * @param ref allocates the pbufs referencing the data, NULL for PBUF_ROMs
+ * @param ref_arg argument passed to 'ref'
+ * @param bytes_written pointer to a location that receives the number of written bytes
+ * @return ERR_OK if data was sent, any other err_t on error
+ */
+err_t
+netconn_write_ref_partly(struct netconn *conn, const void *dataptr, size_t size,
+                         u8_t apiflags, tcp_ref_fn ref, void *ref_arg,
+                         size_t *bytes_written)
 {
   struct api_msg msg;
   err_t err;
@@ -620,6 +651,8 @@ netconn_write_partly(struct netconn *conn, const void *dataptr, size_t size,
   msg.msg.msg.w.dataptr = dataptr;
   msg.msg.msg.w.apiflags = apiflags;
   msg.msg.msg.w.len = size;
+  msg.msg.msg.w.ref = ref;
+  msg.msg.msg.w.ref_arg = ref_arg;
 #if LWIP_SO_SNDTIMEO
   if (conn->send_timeout != 0) {
     /* get the time we started, which is later compared to
@@ -651,6 +684,7 @@ netconn_write_partly(struct netconn *conn, const void *dataptr, size_t size,
   NETCONN_SET_SAFE_ERR(conn, err);
   return err;
 }
+#endif /* LWIP_TCP */
 
 /**
  * Close ot shutdown a TCP netconn (doesn't delete it).
@@ -1267,7 +1267,8 @@ do_writemore(struct netconn *conn)
       }
     }
     LWIP_ASSERT("do_writemore: invalid length!", ((conn->write_offset + len) <= conn->current_msg->msg.w.len));
-    err = tcp_write(conn->pcb.tcp, dataptr, len, apiflags);
+    err = tcp_write_ref(conn->pcb.tcp, dataptr, len, apiflags,
+      conn->current_msg->msg.w.ref, conn->current_msg->msg.w.ref_arg);
     /* if OK or memory error, check available space */
     if ((err == ERR_OK) || (err == ERR_MEM)) {
 err_mem:
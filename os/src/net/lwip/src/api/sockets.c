@@ -786,6 +786,85 @@ lwip_send(int s, const void *data, size_t size, int flags)
   return (err == ERR_OK ? (int)written : -1);
 }
 
+#if LWIP_TCP
+/**
+ * Send on a TCP socket without copying: the data is referenced by pbufs that
+ * 'ref' allocates (see tcp_write_ref), and must stay unchanged until all of
+ * them have been freed.
+ */
+int
+lwip_send_ref(int s, const void *data, size_t size, int flags,
+    tcp_ref_fn ref, void *ref_arg)
+{
+  struct lwip_sock *sock;
+  err_t err;
+  u8_t write_flags;
+  size_t written;
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_send_ref(%d, data=%p, size=%"SZT_F", flags=0x%x)\n",
+                              s, data, size, flags));
+
+  sock = get_socket(s);
+  if (!sock) {
+    return -1;
+  }
+
+  if (sock->conn->type != NETCONN_TCP) {
+    sock_set_errno(sock, err_to_errno(ERR_ARG));
+    return -1;
+  }
+
+  write_flags = ((flags & MSG_MORE)     ? NETCONN_MORE      : 0) |
+                ((flags & MSG_DONTWAIT) ? NETCONN_DONTBLOCK : 0);
+  written = 0;
+  err = netconn_write_ref_partly(sock->conn, data, size, write_flags, ref, ref_arg, &written);
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_send_ref(%d) err=%d written=%"SZT_F"\n", s, err, written));
+  sock_set_errno(sock, err_to_errno(err));
+  return (err == ERR_OK ? (int)written : -1);
+}
+#endif /* LWIP_TCP */
+
+/** Readiness of a socket as LWIP_POLL* flags, called with SYS_ARCH protected */
+static int
+lwip_sock_events(struct lwip_sock *sock)
+{
+  int events = 0;
+
+  if (sock->lastdata || sock->rcvevent > 0) {
+    events |= LWIP_POLLIN;
+  }
+  if (sock->sendevent) {
+    events |= LWIP_POLLOUT;
+  }
+  if (sock->errevent) {
+    events |= LWIP_POLLERR;
+  }
+  return events;
+}
+
+/**
+ * Current readiness of a socket (LWIP_POLLIN, LWIP_POLLOUT, LWIP_POLLERR),
+ * -1 if s is not a socket.
+ */
+int
+lwip_poll(int s)
+{
+  struct lwip_sock *sock;
+  int events;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  sock = get_socket(s);
+  if (!sock) {
+    return -1;
+  }
+
+  SYS_ARCH_PROTECT(lev);
+  events = lwip_sock_events(sock);
+  SYS_ARCH_UNPROTECT(lev);
+  return events;
+}
+
 int
 lwip_sendto(int s, const void *data, size_t size, int flags,
        const struct sockaddr *to, socklen_t tolen)
@@ -1250,6 +1329,9 @@ event_callback(struct netconn *conn, enum netconn_evt evt, u16_t len)
   struct lwip_sock *sock;
   struct lwip_select_cb *scb;
   int last_select_cb_ctr;
+#ifdef LWIP_SOCKET_EVENT_HOOK
+  int events;
+#endif
   SYS_ARCH_DECL_PROTECT(lev);
 
   LWIP_UNUSED_ARG(len);
@@ -1306,9 +1388,16 @@ event_callback(struct netconn *conn, enum netconn_evt evt, u16_t len)
       break;
   }
 
+#ifdef LWIP_SOCKET_EVENT_HOOK
+  events = lwip_sock_events(sock);
+#endif
+
   if (sock->select_waiting == 0) {
     /* noone is waiting for this socket, no need to check select_cb_list */
     SYS_ARCH_UNPROTECT(lev);
+#ifdef LWIP_SOCKET_EVENT_HOOK
+    LWIP_SOCKET_EVENT_HOOK(s, events);
+#endif
     return;
   }
 
@@ -1357,6 +1446,9 @@ again:
     }
   }
   SYS_ARCH_UNPROTECT(lev);
+#ifdef LWIP_SOCKET_EVENT_HOOK
+  LWIP_SOCKET_EVENT_HOOK(s, events);
+#endif
 }
 
 /**
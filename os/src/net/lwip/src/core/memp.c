@@ -61,6 +61,42 @@
 
 #include <string.h>
 
+/** Elements are padded to a multiple of MEMP_ELEMENT_ALIGNMENT (e.g. a cache line) */
+#ifndef MEMP_ELEMENT_ALIGNMENT
+#define MEMP_ELEMENT_ALIGNMENT MEM_ALIGNMENT
+#endif
+#define MEMP_ELEMENT_SIZE(x) ((LWIP_MEM_ALIGN_SIZE(x) + MEMP_ELEMENT_ALIGNMENT - 1) & ~(MEMP_ELEMENT_ALIGNMENT - 1))
+
+/** Attributes of the pool memory, e.g. its alignment or section */
+#ifndef MEMP_POOL_ATTRIBUTE
+#define MEMP_POOL_ATTRIBUTE
+#endif
+
+/** Pools for which MEMP_LOCKFREE_POOL(type) is true are kept on a lock-free
+ * free list by the port's MEMP_LOCKFREE_PUSH/POP(head, elem), instead of being
+ * guarded by SYS_ARCH_PROTECT. Their statistics are updated with SYS_ARCH_INC,
+ * SYS_ARCH_DEC and SYS_ARCH_MAX. */
+#if defined(MEMP_LOCKFREE_POOL) && !MEMP_OVERFLOW_CHECK && !MEMP_MEM_MALLOC
+#define MEMP_LOCKFREE 1
+#if MEMP_STATS
+#if !defined(SYS_ARCH_INC) || !defined(SYS_ARCH_DEC) || !defined(SYS_ARCH_MAX)
+#error "MEMP_LOCKFREE_POOL needs SYS_ARCH_INC, SYS_ARCH_DEC and SYS_ARCH_MAX"
+#endif
+#define MEMP_LOCKFREE_STATS_INC_USED(i) do { \
+    mem_size_t _used = SYS_ARCH_INC(lwip_stats.memp[i].used, 1); \
+    SYS_ARCH_INC(lwip_stats.memp[i].alloc, 1); \
+    SYS_ARCH_MAX(lwip_stats.memp[i].max, _used); } while(0)
+#define MEMP_LOCKFREE_STATS_DEC_USED(i) SYS_ARCH_DEC(lwip_stats.memp[i].used, 1)
+#define MEMP_LOCKFREE_STATS_INC_ERR(i)  SYS_ARCH_INC(lwip_stats.memp[i].err, 1)
+#else /* MEMP_STATS */
+#define MEMP_LOCKFREE_STATS_INC_USED(i)
+#define MEMP_LOCKFREE_STATS_DEC_USED(i)
+#define MEMP_LOCKFREE_STATS_INC_ERR(i)
+#endif /* MEMP_STATS */
+#else
+#define MEMP_LOCKFREE 0
+#endif
+
 #if !MEMP_MEM_MALLOC /* don't build if not configured for use in lwipopts.h */
 
 struct memp {
@@ -99,7 +135,7 @@ struct memp {
 
 /* MEMP_SIZE: save space for struct memp and for sanity check */
 #define MEMP_SIZE          (LWIP_MEM_ALIGN_SIZE(sizeof(struct memp)) + MEMP_SANITY_REGION_BEFORE_ALIGNED)
-#define MEMP_ALIGN_SIZE(x) (LWIP_MEM_ALIGN_SIZE(x) + MEMP_SANITY_REGION_AFTER_ALIGNED)
+#define MEMP_ALIGN_SIZE(x) (MEMP_ELEMENT_SIZE(x) + MEMP_SANITY_REGION_AFTER_ALIGNED)
 
 #else /* MEMP_OVERFLOW_CHECK */
 
@@ -108,7 +144,7 @@ struct memp {
  * can save a little space and set MEMP_SIZE to 0.
  */
 #define MEMP_SIZE           0
-#define MEMP_ALIGN_SIZE(x) (LWIP_MEM_ALIGN_SIZE(x))
+#define MEMP_ALIGN_SIZE(x) (MEMP_ELEMENT_SIZE(x))
 
 #endif /* MEMP_OVERFLOW_CHECK */
 
@@ -123,11 +159,8 @@ static struct memp *memp_tab[MEMP_MAX];
 #endif /* MEMP_MEM_MALLOC */
 
 /** This array holds the element sizes of each pool. */
-#if !MEM_USE_POOLS && !MEMP_MEM_MALLOC
-static
-#endif
 const u16_t memp_sizes[MEMP_MAX] = {
-#define LWIP_MEMPOOL(name,num,size,desc)  LWIP_MEM_ALIGN_SIZE(size),
+#define LWIP_MEMPOOL(name,num,size,desc)  MEMP_ELEMENT_SIZE(size),
 #include "lwip/memp_std.h"
 };
 
@@ -155,7 +188,7 @@ static const char *memp_desc[MEMP_MAX] = {
  *   extern u8_t __attribute__((section(".onchip_mem"))) memp_memory_UDP_PCB_base[];
  */
 #define LWIP_MEMPOOL(name,num,size,desc) u8_t memp_memory_ ## name ## _base \
-  [((num) * (MEMP_SIZE + MEMP_ALIGN_SIZE(size)))];   
+  [((num) * (MEMP_SIZE + MEMP_ALIGN_SIZE(size)))] MEMP_POOL_ATTRIBUTE;
 #include "lwip/memp_std.h"
 
 /** This array holds the base of each memory pool. */
@@ -170,7 +203,7 @@ static u8_t *const memp_bases[] = {
 static u8_t memp_memory[MEM_ALIGNMENT - 1 
 #define LWIP_MEMPOOL(name,num,size,desc) + ( (num) * (MEMP_SIZE + MEMP_ALIGN_SIZE(size) ) )
 #include "lwip/memp_std.h"
-];
+] MEMP_POOL_ATTRIBUTE;
 
 #endif /* MEMP_SEPARATE_POOLS */
 
@@ -397,6 +430,19 @@ memp_malloc_fn(memp_t type, const char* file, const int line)
  
   LWIP_ERROR("memp_malloc: type < MEMP_MAX", (type < MEMP_MAX), return NULL;);
 
+#if MEMP_LOCKFREE
+  if (MEMP_LOCKFREE_POOL(type)) {
+    memp = (struct memp *)MEMP_LOCKFREE_POP(&memp_tab[type]);
+    if (memp != NULL) {
+      MEMP_LOCKFREE_STATS_INC_USED(type);
+    } else {
+      LWIP_DEBUGF(MEMP_DEBUG | LWIP_DBG_LEVEL_SERIOUS, ("memp_malloc: out of memory in pool %s\n", memp_desc[type]));
+      MEMP_LOCKFREE_STATS_INC_ERR(type);
+    }
+    return memp;
+  }
+#endif /* MEMP_LOCKFREE */
+
   SYS_ARCH_PROTECT(old_level);
 #if MEMP_OVERFLOW_CHECK >= 2
   memp_overflow_check_all();
@@ -445,6 +491,14 @@ memp_free(memp_t type, void *mem)
 
   memp = (struct memp *)(void *)((u8_t*)mem - MEMP_SIZE);
 
+#if MEMP_LOCKFREE
+  if (MEMP_LOCKFREE_POOL(type)) {
+    MEMP_LOCKFREE_STATS_DEC_USED(type);
+    MEMP_LOCKFREE_PUSH(&memp_tab[type], memp);
+    return;
+  }
+#endif /* MEMP_LOCKFREE */
+
   SYS_ARCH_PROTECT(old_level);
 #if MEMP_OVERFLOW_CHECK
 #if MEMP_OVERFLOW_CHECK >= 2
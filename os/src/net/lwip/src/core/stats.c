@@ -116,7 +116,8 @@ stats_display_mem(struct stats_mem *mem, const char *name)
   LWIP_PLATFORM_DIAG(("avail: %"U32_F"\n\t", (u32_t)mem->avail)); 
   LWIP_PLATFORM_DIAG(("used: %"U32_F"\n\t", (u32_t)mem->used)); 
   LWIP_PLATFORM_DIAG(("max: %"U32_F"\n\t", (u32_t)mem->max)); 
-  LWIP_PLATFORM_DIAG(("err: %"U32_F"\n", (u32_t)mem->err));
+  LWIP_PLATFORM_DIAG(("err: %"U32_F"\n\t", (u32_t)mem->err));
+  LWIP_PLATFORM_DIAG(("alloc: %"U32_F"\n", (u32_t)mem->alloc));
 }
 
 #if MEMP_STATS
@@ -80,6 +80,26 @@
 /* Forward declarations.*/
 static void tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb);
 
+#if CHECKSUM_GEN_TCP
+/** Whether TCP checksums towards remote_ip are generated in software, or
+ * offloaded by the outgoing netif (see LWIP_CHECKSUM_CTRL_PER_NETIF).
+ */
+static u8_t
+tcp_chksum_gen(ip_addr_t *remote_ip)
+{
+#if LWIP_CHECKSUM_CTRL_PER_NETIF
+  struct netif *netif = ip_route(remote_ip);
+  IF__NETIF_CHECKSUM_ENABLED(netif, NETIF_CHECKSUM_GEN_TCP) {
+    return 1;
+  }
+  return 0;
+#else /* LWIP_CHECKSUM_CTRL_PER_NETIF */
+  LWIP_UNUSED_ARG(remote_ip);
+  return 1;
+#endif /* LWIP_CHECKSUM_CTRL_PER_NETIF */
+}
+#endif /* CHECKSUM_GEN_TCP */
+
 /** Allocate a pbuf and create a tcphdr at p->payload, used for output
  * functions other than the default tcp_output -> tcp_output_segment
  * (e.g. tcp_send_empty_ack, etc.)
@@ -352,6 +372,44 @@ tcp_write_checks(struct tcp_pcb *pcb, u16_t len)
  */
 err_t
 tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
+{
+  return tcp_write_ref(pcb, arg, len, apiflags, NULL, NULL);
+}
+
+/**
+ * Allocate the pbuf that references data written without TCP_WRITE_FLAG_COPY:
+ * from the caller's ref function if there is one, a PBUF_ROM otherwise.
+ */
+static struct pbuf *
+tcp_pbuf_ref(tcp_ref_fn ref, void *ref_arg, pbuf_layer layer, const void *payload, u16_t len)
+{
+  struct pbuf *p;
+
+  if (ref != NULL) {
+    return ref(ref_arg, payload, len);
+  }
+
+  p = pbuf_alloc(layer, len, PBUF_ROM);
+  if (p != NULL) {
+    /* reference the non-volatile payload data */
+    p->payload = (void *)payload;
+  }
+  return p;
+}
+
+/**
+ * Like tcp_write, but data written without TCP_WRITE_FLAG_COPY is referenced
+ * by pbufs that 'ref' allocates, instead of by PBUF_ROMs. 'ref' must return a
+ * PBUF_RAW pbuf referencing exactly 'len' bytes at 'payload', usually one from
+ * pbuf_alloced_custom(): its free function is then called once the stack and
+ * the netif are both done with the data, which is not before it was ACKed.
+ *
+ * @param ref allocates the pbufs referencing the data, NULL to use PBUF_ROMs
+ * @param ref_arg argument passed to 'ref'
+ */
+err_t
+tcp_write_ref(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags,
+              tcp_ref_fn ref, void *ref_arg)
 {
   struct pbuf *concat_p = NULL;
   struct tcp_seg *last_unsent = NULL, *seg = NULL, *prev_seg = NULL, *queue = NULL;
@@ -488,7 +546,7 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
 #endif /* TCP_CHECKSUM_ON_COPY */
       } else {
         /* Data is not copied */
-        if ((concat_p = pbuf_alloc(PBUF_RAW, seglen, PBUF_ROM)) == NULL) {
+        if ((concat_p = tcp_pbuf_ref(ref, ref_arg, PBUF_RAW, (u8_t*)arg + pos, seglen)) == NULL) {
           LWIP_DEBUGF(TCP_OUTPUT_DEBUG | 2,
                       ("tcp_write: could not allocate memory for zero-copy pbuf\n"));
           goto memerr;
@@ -499,8 +557,6 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
           &concat_chksum, &concat_chksum_swapped);
         concat_chksummed += seglen;
 #endif /* TCP_CHECKSUM_ON_COPY */
-        /* reference the non-volatile payload data */
-        concat_p->payload = (u8_t*)arg + pos;
       }
 
       pos += seglen;
@@ -549,7 +605,7 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
 #if TCP_OVERSIZE
       LWIP_ASSERT("oversize == 0", oversize == 0);
 #endif /* TCP_OVERSIZE */
-      if ((p2 = pbuf_alloc(PBUF_TRANSPORT, seglen, PBUF_ROM)) == NULL) {
+      if ((p2 = tcp_pbuf_ref(ref, ref_arg, PBUF_TRANSPORT, (u8_t*)arg + pos, seglen)) == NULL) {
         LWIP_DEBUGF(TCP_OUTPUT_DEBUG | 2, ("tcp_write: could not allocate memory for zero-copy pbuf\n"));
         goto memerr;
       }
@@ -557,8 +613,6 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
       /* calculate the checksum of nocopy-data */
       chksum = ~inet_chksum((u8_t*)arg + pos, seglen);
 #endif /* TCP_CHECKSUM_ON_COPY */
-      /* reference the non-volatile payload data */
-      p2->payload = (u8_t*)arg + pos;
 
       /* Second, allocate a pbuf for the headers. */
       if ((p = pbuf_alloc(PBUF_TRANSPORT, optlen, PBUF_RAM)) == NULL) {
@@ -872,8 +926,10 @@ tcp_send_empty_ack(struct tcp_pcb *pcb)
 #endif 
 
 #if CHECKSUM_GEN_TCP
-  tcphdr->chksum = inet_chksum_pseudo(p, &(pcb->local_ip), &(pcb->remote_ip),
-        IP_PROTO_TCP, p->tot_len);
+  if (tcp_chksum_gen(&(pcb->remote_ip))) {
+    tcphdr->chksum = inet_chksum_pseudo(p, &(pcb->local_ip), &(pcb->remote_ip),
+          IP_PROTO_TCP, p->tot_len);
+  }
 #endif
 #if LWIP_NETIF_HWADDRHINT
   ip_output_hinted(p, &(pcb->local_ip), &(pcb->remote_ip), pcb->ttl, pcb->tos,
@@ -1052,6 +1108,12 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb)
   struct netif *netif;
   u32_t *opts;
 
+  /* A zero-copy netif may still hold this segment on its DMA ring, don't
+     rewrite its headers underneath it (as in lwIP 2.0). */
+  if (seg->p->ref != 1) {
+    return;
+  }
+
   /** @bug Exclude retransmitted segments from this count. */
   snmp_inc_tcpoutsegs();
 
@@ -1122,7 +1184,7 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb)
   seg->tcphdr->chksum = 0;
 #if CHECKSUM_GEN_TCP
 #if TCP_CHECKSUM_ON_COPY
-  {
+  if (tcp_chksum_gen(&(pcb->remote_ip))) {
     u32_t acc;
 #if TCP_CHECKSUM_ON_COPY_SANITY_CHECK
     u16_t chksum_slow = inet_chksum_pseudo(seg->p, &(pcb->local_ip),
@@ -1155,9 +1217,11 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb)
 #endif /* TCP_CHECKSUM_ON_COPY_SANITY_CHECK */
   }
 #else /* TCP_CHECKSUM_ON_COPY */
-  seg->tcphdr->chksum = inet_chksum_pseudo(seg->p, &(pcb->local_ip),
-         &(pcb->remote_ip),
-         IP_PROTO_TCP, seg->p->tot_len);
+  if (tcp_chksum_gen(&(pcb->remote_ip))) {
+    seg->tcphdr->chksum = inet_chksum_pseudo(seg->p, &(pcb->local_ip),
+           &(pcb->remote_ip),
+           IP_PROTO_TCP, seg->p->tot_len);
+  }
 #endif /* TCP_CHECKSUM_ON_COPY */
 #endif /* CHECKSUM_GEN_TCP */
   TCP_STATS_INC(tcp.xmit);
@@ -1217,8 +1281,10 @@ tcp_rst(u32_t seqno, u32_t ackno,
   tcphdr->urgp = 0;
 
 #if CHECKSUM_GEN_TCP
-  tcphdr->chksum = inet_chksum_pseudo(p, local_ip, remote_ip,
-              IP_PROTO_TCP, p->tot_len);
+  if (tcp_chksum_gen(remote_ip)) {
+    tcphdr->chksum = inet_chksum_pseudo(p, local_ip, remote_ip,
+                IP_PROTO_TCP, p->tot_len);
+  }
 #endif
   TCP_STATS_INC(tcp.xmit);
   snmp_inc_tcpoutrsts();
@@ -1382,8 +1448,10 @@ tcp_keepalive(struct tcp_pcb *pcb)
   tcphdr = (struct tcp_hdr *)p->payload;
 
 #if CHECKSUM_GEN_TCP
-  tcphdr->chksum = inet_chksum_pseudo(p, &pcb->local_ip, &pcb->remote_ip,
-                                      IP_PROTO_TCP, p->tot_len);
+  if (tcp_chksum_gen(&pcb->remote_ip)) {
+    tcphdr->chksum = inet_chksum_pseudo(p, &pcb->local_ip, &pcb->remote_ip,
+                                        IP_PROTO_TCP, p->tot_len);
+  }
 #endif
   TCP_STATS_INC(tcp.xmit);
 
@@ -1463,8 +1531,10 @@ tcp_zero_window_probe(struct tcp_pcb *pcb)
   }
 
 #if CHECKSUM_GEN_TCP
-  tcphdr->chksum = inet_chksum_pseudo(p, &pcb->local_ip, &pcb->remote_ip,
-                                      IP_PROTO_TCP, p->tot_len);
+  if (tcp_chksum_gen(&pcb->remote_ip)) {
+    tcphdr->chksum = inet_chksum_pseudo(p, &pcb->local_ip, &pcb->remote_ip,
+                                        IP_PROTO_TCP, p->tot_len);
+  }
 #endif
   TCP_STATS_INC(tcp.xmit);
 
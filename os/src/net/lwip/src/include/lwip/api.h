@@ -42,6 +42,7 @@
 #include "lwip/sys.h"
 #include "lwip/ip_addr.h"
 #include "lwip/err.h"
+#include "lwip/tcp.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -237,6 +238,11 @@ err_t   netconn_sendto(struct netconn *conn, struct netbuf *buf,
 err_t   netconn_send(struct netconn *conn, struct netbuf *buf);
 err_t   netconn_write_partly(struct netconn *conn, const void *dataptr, size_t size,
                              u8_t apiflags, size_t *bytes_written);
+#if LWIP_TCP
+err_t   netconn_write_ref_partly(struct netconn *conn, const void *dataptr, size_t size,
+                                 u8_t apiflags, tcp_ref_fn ref, void *ref_arg,
+                                 size_t *bytes_written);
+#endif /* LWIP_TCP */
 #define netconn_write(conn, dataptr, size, apiflags) \
           netconn_write_partly(conn, dataptr, size, apiflags, NULL)
 err_t   netconn_close(struct netconn *conn);
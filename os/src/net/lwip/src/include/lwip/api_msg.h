@@ -89,6 +89,10 @@ struct api_msg_msg {
       const void *dataptr;
       size_t len;
       u8_t apiflags;
+#if LWIP_TCP
+      tcp_ref_fn ref;
+      void *ref_arg;
+#endif /* LWIP_TCP */
 #if LWIP_SO_SNDTIMEO
       u32_t time_started;
 #endif /* LWIP_SO_SNDTIMEO */
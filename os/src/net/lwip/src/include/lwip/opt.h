@@ -1841,6 +1841,16 @@
 #define LWIP_CHECKSUM_ON_COPY           0
 #endif
 
+/**
+ * LWIP_CHECKSUM_CTRL_PER_NETIF==1: Checksum generation/check can be enabled/disabled
+ * per netif (netif->chksum_flags), for netifs that offload checksums to hardware.
+ * The CHECKSUM_GEN_* and CHECKSUM_CHECK_* defines must be enabled for this.
+ * (backported from lwIP 2.0)
+ */
+#ifndef LWIP_CHECKSUM_CTRL_PER_NETIF
+#define LWIP_CHECKSUM_CTRL_PER_NETIF    0
+#endif
+
 /*
    ---------------------------------------
    ---------- Hook options ---------------
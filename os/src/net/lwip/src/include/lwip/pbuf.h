@@ -75,6 +75,10 @@ typedef enum {
 #define PBUF_FLAG_LLMCAST   0x10U
 /** indicates this pbuf includes a TCP FIN flag */
 #define PBUF_FLAG_TCP_FIN   0x20U
+/** indicates the IP header checksum was verified before the packet reached the stack */
+#define PBUF_FLAG_IP_CSUM_OK 0x40U
+/** indicates the TCP or UDP checksum was verified before the packet reached the stack */
+#define PBUF_FLAG_L4_CSUM_OK 0x80U
 
 struct pbuf {
   /** next pbuf in singly linked pbuf chain */
@@ -42,6 +42,7 @@
 
 #include "lwip/ip_addr.h"
 #include "lwip/inet.h"
+#include "lwip/tcp.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -135,6 +136,11 @@ struct linger {
 #define MSG_DONTWAIT   0x08    /* Nonblocking i/o for this operation only */
 #define MSG_MORE       0x10    /* Sender will send more */
 
+/* Readiness flags returned by lwip_poll() */
+#define LWIP_POLLIN    0x01
+#define LWIP_POLLOUT   0x04
+#define LWIP_POLLERR   0x08
+
 
 /*
  * Options for level IPPROTO_IP
@@ -333,6 +339,11 @@ int lwip_read(int s, void *mem, size_t len);
 int lwip_recvfrom(int s, void *mem, size_t len, int flags,
       struct sockaddr *from, socklen_t *fromlen);
 int lwip_send(int s, const void *dataptr, size_t size, int flags);
+#if LWIP_TCP
+int lwip_send_ref(int s, const void *dataptr, size_t size, int flags,
+    tcp_ref_fn ref, void *ref_arg);
+#endif /* LWIP_TCP */
+int lwip_poll(int s);
 int lwip_sendto(int s, const void *dataptr, size_t size, int flags,
     const struct sockaddr *to, socklen_t tolen);
 int lwip_socket(int domain, int type, int protocol);
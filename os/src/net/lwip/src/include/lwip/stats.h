@@ -96,6 +96,7 @@ struct stats_mem {
   mem_size_t max;
   STAT_COUNTER err;
   STAT_COUNTER illegal;
+  STAT_COUNTER alloc;
 };
 
 struct stats_syselem {
@@ -231,7 +232,7 @@ void stats_init(void);
 #if MEM_STATS
 #define MEM_STATS_AVAIL(x, y) lwip_stats.mem.x = y
 #define MEM_STATS_INC(x) STATS_INC(mem.x)
-#define MEM_STATS_INC_USED(x, y) STATS_INC_USED(mem, y)
+#define MEM_STATS_INC_USED(x, y) do { STATS_INC(mem.alloc); STATS_INC_USED(mem, y); } while(0)
 #define MEM_STATS_DEC_USED(x, y) lwip_stats.mem.x -= y
 #define MEM_STATS_DISPLAY() stats_display_mem(&lwip_stats.mem, "HEAP")
 #else
@@ -246,7 +247,7 @@ void stats_init(void);
 #define MEMP_STATS_AVAIL(x, i, y) lwip_stats.memp[i].x = y
 #define MEMP_STATS_INC(x, i) STATS_INC(memp[i].x)
 #define MEMP_STATS_DEC(x, i) STATS_DEC(memp[i].x)
-#define MEMP_STATS_INC_USED(x, i) STATS_INC_USED(memp[i], 1)
+#define MEMP_STATS_INC_USED(x, i) do { STATS_INC(memp[i].alloc); STATS_INC_USED(memp[i], 1); } while(0)
 #define MEMP_STATS_DISPLAY(i) stats_display_memp(&lwip_stats.memp[i], i)
 #else
 #define MEMP_STATS_AVAIL(x, i, y)
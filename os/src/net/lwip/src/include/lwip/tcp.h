@@ -358,6 +358,13 @@ err_t            tcp_shutdown(struct tcp_pcb *pcb, int shut_rx, int shut_tx);
 err_t            tcp_write   (struct tcp_pcb *pcb, const void *dataptr, u16_t len,
                               u8_t apiflags);
 
+/** Function prototype for tcp_write_ref: returns a PBUF_RAW pbuf referencing
+ * exactly 'len' bytes at 'payload', or NULL when out of memory. */
+typedef struct pbuf *(*tcp_ref_fn)(void *arg, const void *payload, u16_t len);
+
+err_t            tcp_write_ref(struct tcp_pcb *pcb, const void *dataptr, u16_t len,
+                               u8_t apiflags, tcp_ref_fn ref, void *ref_arg);
+
 void             tcp_setprio (struct tcp_pcb *pcb, u8_t prio);
 
 #define TCP_PRIO_MIN    1
@@ -234,7 +234,7 @@ u32_t sys_arch_mbox_tryfetch( sys_mbox_t *pxMailBox, void **ppvBuffer ) {
 err_t sys_sem_new( sys_sem_t *pxSemaphore, u8_t ucCount ) {
 	err_t xReturn = ERR_MEM;
 
-	*pxSemaphore = BT_kMutexCreate();
+	*pxSemaphore = BT_kSemaphoreCreate();
 
 	if( *pxSemaphore != NULL ) {
 		if( ucCount == 0U ) {
@@ -0,0 +1,617 @@
+/**
+ *	Host (POSIX threads) implementation of the kernel interface, for the network test
+ *	harness. Stands in for kernel/bt_freertos_if.c, and for the parts of the thread,
+ *	heap, tasklet and logging modules that the network stack uses.
+ *
+ *	The target has one core and only switches threads in the kernel, the host runs
+ *	threads in parallel. A critical section takes one global lock, which also protects
+ *	the kernel objects. A thread that blocks inside a critical section gives it up until
+ *	it runs again, as FreeRTOS does with its per-task nesting count. The harness runs its
+ *	"interrupt handlers" in threads of their own, and they take the same lock through
+ *	BT_kEnterCriticalFromISR().
+ *
+ *	Priorities are ignored, a tick is a millisecond.
+ **/
+#include <bitthunder.h>
+#include <interrupts/bt_tasklets.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/mman.h>
+
+BT_DEF_MODULE_NAME			("Host kernel")
+BT_DEF_MODULE_DESCRIPTION	("POSIX threads kernel interface for host builds")
+
+static pthread_mutex_t g_kernel = PTHREAD_MUTEX_INITIALIZER;
+static __thread BT_u32 t_ulNesting;
+
+static void kernel_lock(void) {
+	if(!t_ulNesting++) {
+		pthread_mutex_lock(&g_kernel);
+	}
+}
+
+static void kernel_unlock(void) {
+	if(!--t_ulNesting) {
+		pthread_mutex_unlock(&g_kernel);
+	}
+}
+
+static void kernel_cond_init(pthread_cond_t *cond) {
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(cond, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+static struct timespec *kernel_deadline(BT_TICK oTimeoutTicks, struct timespec *ts) {
+	if(oTimeoutTicks == (BT_TICK) BT_INFINITE_TIMEOUT) {
+		return NULL;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, ts);
+	ts->tv_sec += oTimeoutTicks / 1000;
+	ts->tv_nsec += (oTimeoutTicks % 1000) * 1000000L;
+	if(ts->tv_nsec >= 1000000000L) {
+		ts->tv_sec++;
+		ts->tv_nsec -= 1000000000L;
+	}
+
+	return ts;
+}
+
+/*
+ *	Waits with the kernel lock held once by the caller, whatever its nesting.
+ *	Returns BT_FALSE once the deadline has passed.
+ */
+static BT_BOOL kernel_wait(pthread_cond_t *cond, const struct timespec *deadline) {
+	if(!deadline) {
+		pthread_cond_wait(cond, &g_kernel);
+		return BT_TRUE;
+	}
+
+	return pthread_cond_timedwait(cond, &g_kernel, deadline) ? BT_FALSE : BT_TRUE;
+}
+
+/*
+ *	Releases the kernel lock for a call that blocks outside of the kernel objects.
+ */
+static BT_u32 kernel_leave(void) {
+	BT_u32 ulNesting = t_ulNesting;
+	if(ulNesting) {
+		t_ulNesting = 0;
+		pthread_mutex_unlock(&g_kernel);
+	}
+	return ulNesting;
+}
+
+static void kernel_return(BT_u32 ulNesting) {
+	if(ulNesting) {
+		pthread_mutex_lock(&g_kernel);
+		t_ulNesting = ulNesting;
+	}
+}
+
+BT_ERROR BT_kStartScheduler() {
+	return BT_ERR_NONE;
+}
+
+void BT_kStopScheduler() {
+}
+
+struct task_start {
+	BT_FN_TASK_ENTRY	pfnStartRoutine;
+	void			   *pParam;
+};
+
+static void *task_startup(void *pParam) {
+	struct task_start oStart = *(struct task_start *) pParam;
+	BT_kFree(pParam);
+
+	oStart.pfnStartRoutine(oStart.pParam);
+	return NULL;
+}
+
+void *BT_kTaskCreate(BT_FN_TASK_ENTRY pfnStartRoutine, const BT_i8 *szpName, BT_THREAD_CONFIG *pConfig, BT_ERROR *pError) {
+	pthread_attr_t attr;
+	pthread_t thread;
+
+	struct task_start *pStart = BT_kMalloc(sizeof(*pStart));
+	if(!pStart) {
+		*pError = BT_ERR_NO_MEMORY;
+		return NULL;
+	}
+
+	pStart->pfnStartRoutine = pfnStartRoutine;
+	pStart->pParam = pConfig->pParam;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	int ret = pthread_create(&thread, &attr, task_startup, pStart);
+	pthread_attr_destroy(&attr);
+
+	if(ret) {
+		BT_kFree(pStart);
+		*pError = BT_ERR_NO_MEMORY;
+		return NULL;
+	}
+
+	*pError = BT_ERR_NONE;
+	return (void *) thread;
+}
+
+void BT_kTaskDelete(void *pTaskHandle) {
+	if(pthread_equal((pthread_t) pTaskHandle, pthread_self())) {
+		pthread_exit(NULL);
+	}
+}
+
+BT_TICK BT_kTickCount() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (BT_TICK) (ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+void BT_kTaskDelay(BT_TICK ulTicks) {
+	struct timespec ts = { ulTicks / 1000, (ulTicks % 1000) * 1000000L };
+	BT_u32 ulNesting = kernel_leave();
+	nanosleep(&ts, NULL);
+	kernel_return(ulNesting);
+}
+
+void BT_kTaskYield() {
+	BT_u32 ulNesting = kernel_leave();
+	sched_yield();
+	kernel_return(ulNesting);
+}
+
+/*
+ *	Mutexes, recursive mutexes and binary semaphores, ulCount is 1 while available.
+ */
+#define BT_KMUTEX_RECURSIVE		0x00000001
+#define BT_KMUTEX_SEMAPHORE		0x00000002
+
+struct bt_kmutex {
+	BT_u32				ulFlags;
+	BT_u32				ulCount;
+	pthread_t			owner;
+	BT_u32				ulDepth;
+	pthread_cond_t		cond;
+};
+
+static void *kmutex_create(BT_u32 ulFlags) {
+	struct bt_kmutex *m = BT_kMalloc(sizeof(*m));
+	if(!m) {
+		return NULL;
+	}
+
+	memset(m, 0, sizeof(*m));
+	m->ulFlags = ulFlags;
+	m->ulCount = 1;
+	kernel_cond_init(&m->cond);
+
+	return m;
+}
+
+static BT_BOOL kmutex_take(struct bt_kmutex *m, BT_TICK oTimeoutTicks) {
+	struct timespec ts, *deadline = kernel_deadline(oTimeoutTicks, &ts);
+	BT_BOOL bTaken = BT_FALSE;
+
+	kernel_lock();
+	{
+		if((m->ulFlags & BT_KMUTEX_RECURSIVE) && m->ulDepth && pthread_equal(m->owner, pthread_self())) {
+			m->ulDepth++;
+			bTaken = BT_TRUE;
+		} else {
+			while(!m->ulCount && oTimeoutTicks && kernel_wait(&m->cond, deadline));
+
+			if(m->ulCount) {
+				m->ulCount = 0;
+				m->owner = pthread_self();
+				m->ulDepth = 1;
+				bTaken = BT_TRUE;
+			}
+		}
+	}
+	kernel_unlock();
+
+	return bTaken;
+}
+
+static BT_BOOL kmutex_give(struct bt_kmutex *m) {
+	BT_BOOL bGiven = BT_FALSE;
+
+	kernel_lock();
+	{
+		if((m->ulFlags & BT_KMUTEX_RECURSIVE) && m->ulDepth > 1) {
+			m->ulDepth--;
+			bGiven = BT_TRUE;
+		} else if(!m->ulCount) {
+			m->ulCount = 1;
+			m->ulDepth = 0;
+			pthread_cond_signal(&m->cond);
+			bGiven = BT_TRUE;
+		}
+	}
+	kernel_unlock();
+
+	return bGiven;
+}
+
+void *BT_kMutexCreate() {
+	return kmutex_create(0);
+}
+
+void *BT_kRecursiveMutexCreate() {
+	return kmutex_create(BT_KMUTEX_RECURSIVE);
+}
+
+void *BT_kSemaphoreCreate() {
+	return kmutex_create(BT_KMUTEX_SEMAPHORE);
+}
+
+void BT_kMutexDestroy(void *pMutex) {
+	struct bt_kmutex *m = (struct bt_kmutex *) pMutex;
+	pthread_cond_destroy(&m->cond);
+	BT_kFree(m);
+}
+
+BT_BOOL BT_kMutexPend(void *pMutex, BT_TICK oTimeoutTicks) {
+	return kmutex_take((struct bt_kmutex *) pMutex, oTimeoutTicks);
+}
+
+BT_BOOL BT_kMutexRelease(void *pMutex) {
+	return kmutex_give((struct bt_kmutex *) pMutex);
+}
+
+BT_BOOL BT_kMutexPendRecursive(void *pMutex, BT_TICK oTimeoutTicks) {
+	if(!oTimeoutTicks) {
+		oTimeoutTicks = (BT_TICK) BT_INFINITE_TIMEOUT;
+	}
+
+	return kmutex_take((struct bt_kmutex *) pMutex, oTimeoutTicks);
+}
+
+BT_BOOL BT_kMutexReleaseRecursive(void *pMutex) {
+	return kmutex_give((struct bt_kmutex *) pMutex);
+}
+
+BT_BOOL BT_kMutexReleaseFromISR(void *pMutex, BT_BOOL *pbHigherPriorityTaskWoken) {
+	if(pbHigherPriorityTaskWoken) {
+		*pbHigherPriorityTaskWoken = BT_FALSE;
+	}
+
+	return kmutex_give((struct bt_kmutex *) pMutex);
+}
+
+struct bt_kqueue {
+	BT_u32				ulElements;
+	BT_u32				ulElementWidth;
+	BT_u32				ulHead;
+	BT_u32				ulWaiting;
+	pthread_cond_t		not_empty;
+	pthread_cond_t		not_full;
+	BT_u8				data[];
+};
+
+void *BT_kQueueCreate(BT_u32 ulElements, BT_u32 ulElementWidth) {
+	struct bt_kqueue *q = BT_kMalloc(sizeof(*q) + ulElements * ulElementWidth);
+	if(!q) {
+		return NULL;
+	}
+
+	memset(q, 0, sizeof(*q));
+	q->ulElements = ulElements;
+	q->ulElementWidth = ulElementWidth;
+	kernel_cond_init(&q->not_empty);
+	kernel_cond_init(&q->not_full);
+
+	return q;
+}
+
+void BT_kQueueDestroy(void *pQueue) {
+	struct bt_kqueue *q = (struct bt_kqueue *) pQueue;
+	pthread_cond_destroy(&q->not_empty);
+	pthread_cond_destroy(&q->not_full);
+	BT_kFree(q);
+}
+
+static BT_ERROR kqueue_send(struct bt_kqueue *q, const void *pMessage, BT_TICK oTimeoutTicks, BT_BOOL bFront) {
+	struct timespec ts, *deadline = kernel_deadline(oTimeoutTicks, &ts);
+	BT_ERROR bSent = BT_FALSE;
+
+	kernel_lock();
+	{
+		while(q->ulWaiting == q->ulElements && oTimeoutTicks && kernel_wait(&q->not_full, deadline));
+
+		if(q->ulWaiting < q->ulElements) {
+			BT_u32 i;
+			if(bFront) {
+				q->ulHead = (q->ulHead + q->ulElements - 1) % q->ulElements;
+				i = q->ulHead;
+			} else {
+				i = (q->ulHead + q->ulWaiting) % q->ulElements;
+			}
+
+			memcpy(&q->data[i * q->ulElementWidth], pMessage, q->ulElementWidth);
+			q->ulWaiting++;
+			pthread_cond_signal(&q->not_empty);
+			bSent = BT_TRUE;
+		}
+	}
+	kernel_unlock();
+
+	return bSent;
+}
+
+BT_ERROR BT_kQueueSend(void *pQueue, const void *pMessage, BT_TICK oTimeoutTicks) {
+	return kqueue_send((struct bt_kqueue *) pQueue, pMessage, oTimeoutTicks, BT_FALSE);
+}
+
+BT_ERROR BT_kQueueSendFromISR(void *pQueue, const void *pMessage, BT_BOOL *pbHigherPriorityTaskWoken) {
+	if(pbHigherPriorityTaskWoken) {
+		*pbHigherPriorityTaskWoken = BT_FALSE;
+	}
+
+	return kqueue_send((struct bt_kqueue *) pQueue, pMessage, 0, BT_FALSE);
+}
+
+BT_u32 BT_kQueueMessagesWaiting(void *pQueue) {
+	struct bt_kqueue *q = (struct bt_kqueue *) pQueue;
+	BT_u32 ulWaiting;
+
+	kernel_lock();
+	ulWaiting = q->ulWaiting;
+	kernel_unlock();
+
+	return ulWaiting;
+}
+
+BT_ERROR BT_kQueueSendToFront(void *pQueue, const void *pMessage, BT_TICK oTimeoutTicks) {
+	return kqueue_send((struct bt_kqueue *) pQueue, pMessage, oTimeoutTicks, BT_TRUE);
+}
+
+BT_ERROR BT_kQueueSendToBack(void *pQueue, const void *pMessage, BT_TICK oTimeoutTicks) {
+	return kqueue_send((struct bt_kqueue *) pQueue, pMessage, oTimeoutTicks, BT_FALSE);
+}
+
+BT_ERROR BT_kQueueReceive(void *pQueue, void *pMessage, BT_TICK oTimeoutTicks) {
+	struct bt_kqueue *q = (struct bt_kqueue *) pQueue;
+	struct timespec ts, *deadline = kernel_deadline(oTimeoutTicks, &ts);
+	BT_ERROR bReceived = BT_FALSE;
+
+	kernel_lock();
+	{
+		while(!q->ulWaiting && oTimeoutTicks && kernel_wait(&q->not_empty, deadline));
+
+		if(q->ulWaiting) {
+			memcpy(pMessage, &q->data[q->ulHead * q->ulElementWidth], q->ulElementWidth);
+			q->ulHead = (q->ulHead + 1) % q->ulElements;
+			q->ulWaiting--;
+			pthread_cond_signal(&q->not_full);
+			bReceived = BT_TRUE;
+		}
+	}
+	kernel_unlock();
+
+	return bReceived;
+}
+
+BT_ERROR BT_kQueueReceiveFromISR(void *pQueue, void *pMessage, BT_BOOL *pbHigherPriorityTaskWoken) {
+	if(pbHigherPriorityTaskWoken) {
+		*pbHigherPriorityTaskWoken = BT_FALSE;
+	}
+
+	return BT_kQueueReceive(pQueue, pMessage, 0);
+}
+
+void BT_kEnterCritical() {
+	kernel_lock();
+}
+
+void BT_kExitCritical() {
+	kernel_unlock();
+}
+
+BT_u32 BT_kEnterCriticalFromISR() {
+	kernel_lock();
+	return 0;
+}
+
+void BT_kExitCriticalFromISR(BT_u32 ulState) {
+	kernel_unlock();
+}
+
+void BT_kYieldFromISR(BT_BOOL bHigherPriorityTaskWoken) {
+}
+
+/*
+ *	Threads, as in os/src/process/bt_threads.c but without processes, all handles
+ *	belong to the one kernel task.
+ */
+struct _BT_OPAQUE_HANDLE {
+	BT_HANDLE_HEADER 	h;
+	BT_FN_THREAD_ENTRY 	pfnStartRoutine;
+	void 			   *pThreadParam;
+	BT_THREAD_CONFIG 	oConfig;
+	void			   *pKThreadID;
+};
+
+static struct bt_task g_kernel_task = {
+	.name		= "kernel",
+	.threads	= BT_LIST_HEAD_INIT(g_kernel_task.threads),
+	.handles	= BT_LIST_HEAD_INIT(g_kernel_task.handles),
+};
+
+static const BT_IF_HANDLE oHandleInterface = {
+	BT_MODULE_DEF_INFO_NO_AUTHOR,
+	.eType = BT_HANDLE_T_THREAD,
+};
+
+struct bt_task *BT_GetProcessTask(BT_HANDLE hProcess) {
+	return &g_kernel_task;
+}
+
+static void thread_startup(void *pParam) {
+	BT_HANDLE hThread = (BT_HANDLE) pParam;
+
+	hThread->pfnStartRoutine(hThread, hThread->pThreadParam);
+	BT_CloseHandle(hThread);
+}
+
+BT_HANDLE BT_CreateThread(BT_FN_THREAD_ENTRY pfnStartRoutine, BT_THREAD_CONFIG *pConfig, BT_ERROR *pError) {
+	BT_HANDLE hThread = BT_CreateHandle(&oHandleInterface, sizeof(struct _BT_OPAQUE_HANDLE), pError);
+	if(!hThread) {
+		return NULL;
+	}
+
+	hThread->pfnStartRoutine = pfnStartRoutine;
+	hThread->pThreadParam = pConfig->pParam;
+	hThread->oConfig = *pConfig;
+	hThread->oConfig.pParam = hThread;
+
+	hThread->pKThreadID = BT_kTaskCreate(thread_startup, NULL, &hThread->oConfig, pError);
+	if(!hThread->pKThreadID) {
+		BT_DetachHandle(NULL, hThread);
+		BT_DestroyHandle(hThread);
+		return NULL;
+	}
+
+	return hThread;
+}
+
+BT_ERROR BT_ThreadSleep(BT_u32 ulTimeMs) {
+	BT_kTaskDelay(ulTimeMs);
+	return BT_ERR_NONE;
+}
+
+BT_ERROR BT_ThreadYield() {
+	BT_kTaskYield();
+	return BT_ERR_NONE;
+}
+
+BT_u32 BT_GetKernelTick() {
+	return BT_kTickCount();
+}
+
+/*
+ *	The network stack only schedules tasklets from threads, so they run straight away.
+ */
+BT_ERROR BT_TaskletHighSchedule(BT_TASKLET *pTasklet) {
+	pTasklet->ulQueued++;
+	pTasklet->pfnHandler(pTasklet->pData);
+	pTasklet->ulRun++;
+	return BT_ERR_NONE;
+}
+
+BT_ERROR BT_TaskletSchedule(BT_TASKLET *pTasklet) {
+	return BT_TaskletHighSchedule(pTasklet);
+}
+
+/*
+ *	The heap is carved from one mapping below 2GB, in power of two size classes.
+ */
+#define HEAP_SIZE			(256 * 1024 * 1024)
+#define HEAP_MIN_SHIFT		5
+#define HEAP_CLASSES		(28 - HEAP_MIN_SHIFT)
+#define HEAP_HEADER			16
+
+static pthread_mutex_t g_heap_lock = PTHREAD_MUTEX_INITIALIZER;
+static BT_u8 *g_heap;
+static BT_u32 g_heap_used;
+static void *g_heap_free[HEAP_CLASSES];
+
+void *BT_kMalloc(BT_u32 ulSize) {
+	BT_u32 ulClass = 0;
+	void *p = NULL;
+
+	while((1U << (ulClass + HEAP_MIN_SHIFT)) < ulSize + HEAP_HEADER) {
+		if(++ulClass == HEAP_CLASSES) {
+			return NULL;
+		}
+	}
+
+	BT_u32 ulBlock = 1U << (ulClass + HEAP_MIN_SHIFT);
+
+	pthread_mutex_lock(&g_heap_lock);
+	{
+		if(!g_heap) {
+			g_heap = mmap(NULL, HEAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT | MAP_NORESERVE, -1, 0);
+			if(g_heap == MAP_FAILED) {
+				g_heap = NULL;
+			}
+		}
+
+		if(g_heap_free[ulClass]) {
+			p = g_heap_free[ulClass];
+			g_heap_free[ulClass] = *(void **) p;
+		} else if(g_heap && HEAP_SIZE - g_heap_used >= ulBlock) {
+			p = g_heap + g_heap_used;
+			g_heap_used += ulBlock;
+		}
+	}
+	pthread_mutex_unlock(&g_heap_lock);
+
+	if(!p) {
+		return NULL;
+	}
+
+	*(BT_u32 *) p = ulClass;
+	return (BT_u8 *) p + HEAP_HEADER;
+}
+
+void BT_kFree(void *ptr) {
+	if(!ptr) {
+		return;
+	}
+
+	void *p = (BT_u8 *) ptr - HEAP_HEADER;
+	BT_u32 ulClass = *(BT_u32 *) p;
+
+	pthread_mutex_lock(&g_heap_lock);
+	{
+		*(void **) p = g_heap_free[ulClass];
+		g_heap_free[ulClass] = p;
+	}
+	pthread_mutex_unlock(&g_heap_lock);
+}
+
+void *BT_Calloc(BT_u32 ulSize) {
+	void *p = BT_kMalloc(ulSize);
+	if(p) {
+		memset(p, 0, ulSize);
+	}
+	return p;
+}
+
+BT_ERROR BT_kPrint(const char *format, ...) {
+	va_list ap;
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+	fputc('\n', stderr);
+	return BT_ERR_NONE;
+}
+
+static bt_kernel_params g_params = {
+	.cmdline = "",
+};
+
+bt_kernel_params *bt_get_kernel_params(void) {
+	return &g_params;
+}
+
+/*
+ *	There are no file systems in the harness, so sendfile() has nothing to read.
+ */
+BT_s32 BT_Read(BT_HANDLE hFile, BT_u32 ulFlags, BT_u32 ulSize, void *pBuffer) {
+	return BT_ERR_UNSUPPORTED_INTERFACE;
+}
+
+BT_ERROR BT_Seek(BT_HANDLE hFile, BT_s64 ulOffset, BT_u32 whence) {
+	return BT_ERR_UNSUPPORTED_INTERFACE;
+}
@@ -0,0 +1,356 @@
+/**
+ *	Back-to-back MAC pair for the host harness.
+ *
+ *	The two ends of the wire live in different processes (one network stack each),
+ *	and the wire is a pair of single producer, single consumer frame rings in memory
+ *	shared across fork(). A transmitted frame is copied onto the wire by pfnTxFrame
+ *	and off it into a posted receive buffer by pfnRxFrame, standing in for the DMA
+ *	engines of the two MACs, so neither copy is counted against the stack.
+ *
+ *	The link is lossless, as with pause frames: a full wire ring stalls the sender
+ *	until the receiver has taken a frame, rather than dropping it.
+ *
+ *	Each MAC has an interrupt thread, woken through a process-shared semaphore when
+ *	a frame is put on an empty ring or a stalled sender gets room again. It signals
+ *	the stack from "interrupt context", under BT_kEnterCriticalFromISR. It also wakes
+ *	every millisecond, so a wakeup lost to a race only costs a tick.
+ **/
+#include <bitthunder.h>
+#include <string.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/mman.h>
+#include "host_mac.h"
+
+BT_DEF_MODULE_NAME					("Host MAC")
+BT_DEF_MODULE_DESCRIPTION			("Back-to-back ethernet interface for the host harness")
+
+#define HOST_WIRE_SLOTS				256
+#define HOST_RX_SLOTS				64
+#define HOST_TX_SLOTS				256
+#define HOST_FRAME_SIZE				1536
+
+#define ETH_ALEN					6
+
+#define HOST_CAPABILITIES_CHECKSUM	(BT_NET_IF_CAPABILITIES_TX_CSUM_IP | BT_NET_IF_CAPABILITIES_TX_CSUM_TCP | \
+									 BT_NET_IF_CAPABILITIES_TX_CSUM_UDP | BT_NET_IF_CAPABILITIES_RX_CSUM_IP | \
+									 BT_NET_IF_CAPABILITIES_RX_CSUM_TCP | BT_NET_IF_CAPABILITIES_RX_CSUM_UDP)
+
+struct host_ring {
+	BT_u32							head;			// Free-running, written by the sender.
+	BT_u32							tail;			// Free-running, written by the receiver.
+	BT_u32							len[HOST_WIRE_SLOTS];
+	BT_u8							frame[HOST_WIRE_SLOTS][HOST_FRAME_SIZE];
+};
+
+struct host_wire {
+	struct host_ring				ring[2];		// ring[n] carries frames sent by end n.
+	sem_t							irq[2];
+	BT_u32							tx_stalled[2];
+};
+
+struct _BT_OPAQUE_HANDLE {
+	BT_HANDLE_HEADER 				h;
+	BT_NET_IF					   *pIf;
+	BT_NET_IF_EVENTRECEIVER			pfnEvent;
+	struct host_wire			   *wire;
+	BT_u32							ulEnd;
+	BT_u8							addr[ETH_ALEN];
+	BT_NET_BUFFER					rx[HOST_RX_SLOTS];
+	BT_u32							rx_post;		// Free-running indices, rx_take <= rx_post.
+	BT_u32							rx_take;
+	BT_u32							rx_masked;
+	void						   *tx[HOST_TX_SLOTS];
+	BT_u32							tx_head;
+	BT_u32							tx_tail;
+	BT_u32							tx_stalled;
+	BT_u32							ulSent;
+	BT_u32							ulReceived;
+	pthread_t						irq_thread;
+};
+
+static struct host_ring *ring_out(BT_HANDLE hMac) {
+	return &hMac->wire->ring[hMac->ulEnd];
+}
+
+static struct host_ring *ring_in(BT_HANDLE hMac) {
+	return &hMac->wire->ring[!hMac->ulEnd];
+}
+
+static BT_BOOL ring_full(struct host_ring *ring) {
+	return __atomic_load_n(&ring->head, __ATOMIC_RELAXED) - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == HOST_WIRE_SLOTS;
+}
+
+static BT_BOOL ring_empty(struct host_ring *ring) {
+	return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+}
+
+static void *mac_irq_thread(void *arg) {
+	BT_HANDLE hMac = (BT_HANDLE) arg;
+	struct host_wire *wire = hMac->wire;
+	struct timespec ts;
+
+	for(;;) {
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_nsec += 1000000;
+		if(ts.tv_nsec >= 1000000000) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
+		}
+
+		while(sem_timedwait(&wire->irq[hMac->ulEnd], &ts) && errno == EINTR) {
+			;
+		}
+
+		BT_u32 ulState = BT_kEnterCriticalFromISR();
+
+		if(!ring_empty(ring_in(hMac)) && !__atomic_exchange_n(&hMac->rx_masked, BT_TRUE, __ATOMIC_SEQ_CST)) {
+			hMac->pfnEvent(hMac->pIf, BT_NET_IF_RX_READY, BT_TRUE);
+		}
+
+		if(__atomic_load_n(&hMac->tx_stalled, __ATOMIC_SEQ_CST) && !ring_full(ring_out(hMac))) {
+			__atomic_store_n(&hMac->tx_stalled, BT_FALSE, __ATOMIC_SEQ_CST);
+			__atomic_store_n(&wire->tx_stalled[hMac->ulEnd], BT_FALSE, __ATOMIC_SEQ_CST);
+			hMac->pfnEvent(hMac->pIf, BT_NET_IF_TX_COMPLETE, BT_TRUE);
+		}
+
+		BT_kExitCriticalFromISR(ulState);
+	}
+
+	return NULL;
+}
+
+static BT_ERROR mac_cleanup(BT_HANDLE hMac) {
+	return BT_ERR_NONE;
+}
+
+static BT_ERROR mac_eventsubscribe(BT_HANDLE hMac, BT_NET_IF_EVENTRECEIVER pfnReceiver, BT_NET_IF *pIf) {
+	hMac->pIf = pIf;
+	hMac->pfnEvent = pfnReceiver;
+	return BT_ERR_NONE;
+}
+
+/*
+ *	The interrupt thread is started here rather than at probe, as the stack's workers
+ *	only exist once the interface is being brought up.
+ */
+static BT_ERROR mac_init(BT_HANDLE hMac) {
+	if(hMac->irq_thread) {
+		return BT_ERR_NONE;
+	}
+
+	if(pthread_create(&hMac->irq_thread, NULL, mac_irq_thread, hMac)) {
+		return BT_ERR_GENERIC;
+	}
+
+	return BT_ERR_NONE;
+}
+
+static BT_ERROR mac_getaddr(BT_HANDLE hMac, BT_u8 *addr, BT_u32 ulLength) {
+	memcpy(addr, hMac->addr, ETH_ALEN);
+	return BT_ERR_NONE;
+}
+
+static BT_ERROR mac_setaddr(BT_HANDLE hMac, const BT_u8 *addr, BT_u32 ulLength) {
+	memcpy(hMac->addr, addr, ETH_ALEN);
+	return BT_ERR_NONE;
+}
+
+static BT_u32 mac_getmtusize(BT_HANDLE hMac, BT_ERROR *pError) {
+	return HOST_FRAME_SIZE;
+}
+
+static BT_BOOL mac_tx_ready(BT_HANDLE hMac, BT_ERROR *pError) {
+	if(hMac->tx_head - hMac->tx_tail == HOST_TX_SLOTS || ring_full(ring_out(hMac))) {
+		// Set before the peer can see it, so its next pfnRxFrame wakes us.
+		__atomic_store_n(&hMac->tx_stalled, BT_TRUE, __ATOMIC_SEQ_CST);
+		__atomic_store_n(&hMac->wire->tx_stalled[hMac->ulEnd], BT_TRUE, __ATOMIC_SEQ_CST);
+		if(!ring_full(ring_out(hMac))) {
+			sem_post(&hMac->wire->irq[hMac->ulEnd]);
+		}
+		return BT_FALSE;
+	}
+
+	return BT_TRUE;
+}
+
+static BT_ERROR mac_rx_post(BT_HANDLE hMac, const BT_NET_BUFFER *pBuffer) {
+	if(hMac->rx_post - hMac->rx_take == HOST_RX_SLOTS) {
+		return BT_ERR_GENERIC;
+	}
+
+	hMac->rx[hMac->rx_post++ % HOST_RX_SLOTS] = *pBuffer;
+
+	return BT_ERR_NONE;
+}
+
+static void *mac_rx_frame(BT_HANDLE hMac, BT_u32 *pulLength, BT_ERROR *pError) {
+	struct host_ring *ring = ring_in(hMac);
+	struct host_wire *wire = hMac->wire;
+
+	while(hMac->rx_take != hMac->rx_post && !ring_empty(ring)) {
+		BT_u32 ulSlot = ring->tail % HOST_WIRE_SLOTS;
+		BT_u32 ulLength = ring->len[ulSlot];
+		BT_NET_BUFFER *pSlot = &hMac->rx[hMac->rx_take % HOST_RX_SLOTS];
+		BT_BOOL bFits = (ulLength <= pSlot->ulLength);
+
+		if(bFits) {
+			memcpy(pSlot->pData, ring->frame[ulSlot], ulLength);
+			hMac->rx_take++;
+		}
+
+		__atomic_store_n(&ring->tail, ring->tail + 1, __ATOMIC_RELEASE);
+
+		if(__atomic_load_n(&wire->tx_stalled[!hMac->ulEnd], __ATOMIC_SEQ_CST)) {
+			sem_post(&wire->irq[!hMac->ulEnd]);
+		}
+
+		if(bFits) {
+			hMac->ulReceived++;
+			*pulLength = ulLength;
+			return pSlot->pBuffer;
+		}
+	}
+
+	return NULL;
+}
+
+static BT_ERROR mac_tx_frame(BT_HANDLE hMac, const BT_NET_BUFFER *pSegments, BT_u32 ulSegments, void *pBuffer) {
+	struct host_ring *ring = ring_out(hMac);
+	BT_u32 ulHead = ring->head;
+	BT_u32 ulSlot = ulHead % HOST_WIRE_SLOTS;
+	BT_u32 ulLength = 0;
+	BT_u32 i;
+
+	if(!mac_tx_ready(hMac, NULL)) {
+		return BT_ERR_GENERIC;
+	}
+
+	hMac->tx[hMac->tx_head++ % HOST_TX_SLOTS] = pBuffer;
+
+	for(i = 0; i < ulSegments; i++) {
+		if(ulLength + pSegments[i].ulLength > HOST_FRAME_SIZE) {
+			return BT_ERR_NONE;		// Oversized, lost on the wire.
+		}
+		memcpy(ring->frame[ulSlot] + ulLength, pSegments[i].pData, pSegments[i].ulLength);
+		ulLength += pSegments[i].ulLength;
+	}
+
+	ring->len[ulSlot] = ulLength;
+	hMac->ulSent++;
+
+	BT_BOOL bWasEmpty = (__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == ulHead);
+	__atomic_store_n(&ring->head, ulHead + 1, __ATOMIC_RELEASE);
+
+	if(bWasEmpty) {
+		sem_post(&hMac->wire->irq[!hMac->ulEnd]);
+	}
+
+	return BT_ERR_NONE;
+}
+
+static BT_u32 mac_tx_reclaim(BT_HANDLE hMac, void **ppBuffers, BT_u32 ulMax) {
+	BT_u32 n = 0;
+
+	while(n < ulMax && hMac->tx_tail != hMac->tx_head) {
+		ppBuffers[n++] = hMac->tx[hMac->tx_tail++ % HOST_TX_SLOTS];
+	}
+
+	if(n && __atomic_load_n(&hMac->tx_stalled, __ATOMIC_SEQ_CST) && !ring_full(ring_out(hMac))) {
+		__atomic_store_n(&hMac->tx_stalled, BT_FALSE, __ATOMIC_SEQ_CST);
+		__atomic_store_n(&hMac->wire->tx_stalled[hMac->ulEnd], BT_FALSE, __ATOMIC_SEQ_CST);
+		hMac->pfnEvent(hMac->pIf, BT_NET_IF_TX_COMPLETE, BT_FALSE);
+	}
+
+	return n;
+}
+
+static BT_ERROR mac_rx_interrupt(BT_HANDLE hMac, BT_BOOL bEnable) {
+	__atomic_store_n(&hMac->rx_masked, !bEnable, __ATOMIC_SEQ_CST);
+	return BT_ERR_NONE;
+}
+
+static BT_ERROR mac_send_event(BT_HANDLE hMac, BT_u32 ulEvent) {
+	return BT_ERR_NONE;
+}
+
+static const BT_DEV_IF_EMAC mac_ops = {
+	.ulCapabilities 	= BT_NET_IF_CAPABILITIES_ETHERNET | BT_NET_IF_CAPABILITIES_1000MBPS | BT_NET_IF_CAPABILITIES_ZEROCOPY |
+						  BT_NET_IF_CAPABILITIES_SCATTER_GATHER | HOST_CAPABILITIES_CHECKSUM,
+	.pfnEventSubscribe 	= mac_eventsubscribe,
+	.pfnInitialise		= mac_init,
+	.pfnGetMACAddr		= mac_getaddr,
+	.pfnSetMACAddr		= mac_setaddr,
+	.pfnGetMTU			= mac_getmtusize,
+	.pfnTxFifoReady		= mac_tx_ready,
+	.pfnRxPostBuffer	= mac_rx_post,
+	.pfnRxFrame			= mac_rx_frame,
+	.pfnTxFrame			= mac_tx_frame,
+	.pfnTxReclaim		= mac_tx_reclaim,
+	.pfnSendEvent		= mac_send_event,
+	.pfnRxInterrupt		= mac_rx_interrupt,
+};
+
+static const BT_IF_DEVICE oDeviceIF = {
+	.eConfigType	= BT_DEV_IF_T_EMAC,
+	.unConfigIfs 	= {
+		.pEMacIF = &mac_ops,
+	},
+};
+
+static const BT_IF_HANDLE oHandleInterface = {
+	BT_MODULE_DEF_INFO_NO_AUTHOR,
+	.oIfs = {
+		.pDevIF = &oDeviceIF,
+	},
+	.eType = BT_HANDLE_T_DEVICE,
+	.pfnCleanup = mac_cleanup,
+};
+
+struct host_wire *host_wire_create(void) {
+	struct host_wire *wire = mmap(NULL, sizeof(*wire), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if(wire == MAP_FAILED) {
+		return NULL;
+	}
+
+	sem_init(&wire->irq[0], 1, 0);
+	sem_init(&wire->irq[1], 1, 0);
+
+	return wire;
+}
+
+BT_HANDLE host_mac_create(struct host_wire *wire, BT_u32 ulEnd, BT_ERROR *pError) {
+
+	BT_ERROR Error;
+
+	BT_HANDLE hMac = BT_CreateHandle(&oHandleInterface, sizeof(struct _BT_OPAQUE_HANDLE), pError);
+	if(!hMac) {
+		return NULL;
+	}
+
+	static const BT_u8 addr[ETH_ALEN] = { 0x02, 0x00, 0x00, 0xbe, 0xef, 0x01 };
+
+	memcpy(hMac->addr, addr, ETH_ALEN);
+	hMac->addr[ETH_ALEN - 1] += ulEnd;
+	hMac->wire = wire;
+	hMac->ulEnd = ulEnd;
+
+	Error = BT_RegisterNetworkInterface(hMac);
+	if(Error) {
+		BT_DestroyHandle(hMac);
+		hMac = NULL;
+	}
+
+	if(pError) {
+		*pError = Error;
+	}
+
+	return hMac;
+}
+
+void host_mac_frames(BT_HANDLE hMac, BT_u32 *pulSent, BT_u32 *pulReceived) {
+	*pulSent = hMac->ulSent;
+	*pulReceived = hMac->ulReceived;
+}
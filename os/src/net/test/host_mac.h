@@ -0,0 +1,23 @@
+#ifndef _HOST_MAC_H_
+#define _HOST_MAC_H_
+
+#include <bitthunder.h>
+
+struct host_wire;
+
+/**
+ *	@brief	Creates the wire between two MACs, in memory shared across fork().
+ **/
+struct host_wire *host_wire_create(void);
+
+/**
+ *	@brief	Creates the MAC at one end (0 or 1) of the wire, and registers it with the network stack.
+ **/
+BT_HANDLE host_mac_create(struct host_wire *wire, BT_u32 ulEnd, BT_ERROR *pError);
+
+/**
+ *	@brief	Frames the MAC has put on and taken off the wire.
+ **/
+void host_mac_frames(BT_HANDLE hMac, BT_u32 *pulSent, BT_u32 *pulReceived);
+
+#endif
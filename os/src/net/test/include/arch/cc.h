@@ -0,0 +1,48 @@
+/*
+ *	lwIP compiler and platform definitions for the host build of the network test
+ *	harness, in place of os/include/net/lwip/arch/cc.h.
+ */
+#ifndef __CC_H__
+#define __CC_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+/* The C library defines struct timeval and fd_set, lwIP uses those. */
+#define LWIP_TIMEVAL_PRIVATE	0
+
+typedef uint8_t		u8_t;
+typedef int8_t		s8_t;
+typedef uint16_t	u16_t;
+typedef int16_t		s16_t;
+typedef uint32_t	u32_t;
+typedef int32_t		s32_t;
+typedef uintptr_t	mem_ptr_t;
+
+#define U16_F		"hu"
+#define S16_F		"hd"
+#define X16_F		"hx"
+#define U32_F		"u"
+#define S32_F		"d"
+#define X32_F		"x"
+#define SZT_F		"zu"
+
+#ifndef BYTE_ORDER
+#define BYTE_ORDER LITTLE_ENDIAN
+#endif
+
+#define PACK_STRUCT_BEGIN
+#define PACK_STRUCT_STRUCT __attribute__ ((__packed__))
+#define PACK_STRUCT_END
+#define PACK_STRUCT_FIELD(x) x
+
+/* lwIP provides the errno values (LWIP_PROVIDE_ERRNO), the variable is the C library's. */
+extern int *__errno_location(void);
+#define errno (*__errno_location())
+
+#define LWIP_PLATFORM_DIAG(x)	do { printf x; } while(0)
+#define LWIP_PLATFORM_ASSERT(x)	do { printf("lwIP assertion \"%s\" failed at %s:%d\n", x, __FILE__, __LINE__); abort(); } while(0)
+
+#endif /* __CC_H__ */
@@ -0,0 +1,8 @@
+#ifndef _BT_ARCH_CONFIG_H_
+#define _BT_ARCH_CONFIG_H_
+
+#include "compilers/bt_gcc.h"
+
+#define BT_CONFIG_ARCH_LITTLE_ENDIAN
+
+#endif
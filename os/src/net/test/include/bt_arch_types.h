@@ -0,0 +1,30 @@
+#ifndef _BT_ARCH_TYPES_H_
+#define _BT_ARCH_TYPES_H_
+
+/*
+ *	Host (LP64) types for the network test harness. BT_u32 is 32 bits wide, as on
+ *	the target, and so cannot hold a pointer. The harness keeps its heap and image
+ *	below 2GB for the casts that the kernel makes regardless.
+ */
+typedef unsigned long long	BT_u64;
+typedef long long			BT_i64;
+typedef signed long long	BT_s64;
+
+typedef unsigned int		BT_u32;
+typedef signed int			BT_s32;
+typedef int					BT_i32;
+
+typedef unsigned short		BT_u16;
+typedef signed short		BT_s16;
+typedef short				BT_i16;
+
+typedef unsigned char		BT_u8;
+typedef signed char			BT_s8;
+typedef	char				BT_i8;
+
+typedef BT_u32				bt_paddr_t;		///< Physical address type.
+typedef	BT_u32				bt_vaddr_t;		///< Virtual address type.
+typedef BT_u32				*bt_pgd_t;		///< Page Global Directory type. (Opaque pointer).
+typedef BT_u32				*bt_pte_t;		///< Page table entry type.
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef _BT_BSP_CONFIG_H_
+#define _BT_BSP_CONFIG_H_
+
+/*
+ *	Configuration of the network test harness, the Kconfig defaults of the lwIP
+ *	options, except for a TCP MSS that fits 1500 byte frames. Not generated, keep
+ *	in step with os/include/net/lwip/Kconfig.
+ */
+#define BT_CONFIG_LITTLE_ENDIAN 1
+
+#define BT_CONFIG_OS 1
+#define BT_CONFIG_MAX_PROCESS_NAME 10
+#define BT_CONFIG_KERNEL_LOCK_SPIN 0
+#define BT_CONFIG_POLL 1
+#define BT_CONFIG_PROCESS_MAX_FDS 64
+
+#define BT_CONFIG_NET 1
+#define BT_CONFIG_NET_LWIP 1
+#define BT_CONFIG_USE_TCP 1
+#define BT_CONFIG_USE_UDP 1
+#define BT_CONFIG_USE_DHCP 1
+#define BT_CONFIG_USE_IGMP 0
+#define BT_CONFIG_NET_LWIP_TCP_MSS 1460
+#define BT_CONFIG_NET_LWIP_MEM_SIZE 16000
+#define BT_CONFIG_NET_LWIP_GEN_CHECKSUM 1
+#define BT_CONFIG_NET_LWIP_MEMP_NUM_PBUF 256
+#define BT_CONFIG_NET_LWIP_MEMP_NUM_RAW_PCB 32
+#define BT_CONFIG_NET_LWIP_MEMP_NUM_UDP_PCB 32
+#define BT_CONFIG_NET_LWIP_MEMP_NUM_TCP_PCB 32
+#define BT_CONFIG_NET_LWIP_MEMP_NUM_TCP_PCB_LISTEN 32
+#define BT_CONFIG_NET_LWIP_MEMP_NUM_TCP_SEG 32
+#define BT_CONFIG_NET_LWIP_MEMP_NUM_REASSDATA 64
+#define BT_CONFIG_NET_LWIP_MEMP_NUM_FRAG_PBUF 32
+#define BT_CONFIG_NET_LWIP_MEMP_NUM_ARP_QUEUE 32
+#define BT_CONFIG_NET_LWIP_MEMP_NUM_IGMP_GROUP 8
+#define BT_CONFIG_NET_LWIP_MEMP_NUM_NETBUF 32
+#define BT_CONFIG_NET_LWIP_MEMP_NUM_NETCONN 32
+#define BT_CONFIG_NET_LWIP_MEMP_NUM_TCPIP_MSG_API 32
+#define BT_CONFIG_NET_LWIP_MEMP_NUM_TCPIP_MSG_INPKT 32
+#define BT_CONFIG_NET_LWIP_MEMP_NUM_SNMP_NODE 50
+#define BT_CONFIG_NET_LWIP_MEMP_NUM_SNMP_ROOTNODE 30
+#define BT_CONFIG_NET_LWIP_MEMP_NUM_SNMP_VARBIND 2
+#define BT_CONFIG_NET_LWIP_PBUF_POOL_SIZE 256
+#define BT_CONFIG_NET_LWIP_ARP_TABLE_SIZE 64
+#define BT_CONFIG_NET_LWIP_IP_REASS_MAX_PBUFS 128
+#define BT_CONFIG_NET_LWIP_MEMP_ALIGN 32
+#define BT_CONFIG_NET_LWIP_MEMP_LOCKFREE 1
+#define BT_CONFIG_NET_LWIP_ZEROCOPY_RX_BUFFERS 128
+#define BT_CONFIG_NET_LWIP_RX_BUDGET 32
+#define BT_CONFIG_NET_LWIP_RX_WORKERS 1
+#define BT_CONFIG_NET_LWIP_RX_WORKER_PRIORITY 1
+#define BT_CONFIG_NET_LWIP_RX_QUEUE_SIZE 64
+#define BT_CONFIG_NET_LWIP_RX_MODERATION_US 0
+
+#endif
@@ -0,0 +1,489 @@
+/**
+ *	Benchmarks the network stack glue on the host, over a pair of MACs connected back to back.
+ *
+ *	The harness forks into two processes, each with its own copy of the stack (bt_net.c,
+ *	bt_lwip.c, bt_sockets.c and lwIP) on the kernel in bt_host_if.c, and its own end of
+ *	the wire in host_mac.c. The parent is the client at 10.99.0.1, the child serves at
+ *	10.99.0.2, so each end of a flow runs on its own stack as it would on two boards:
+ *
+ *		netperf [tcp-bytes] [count]
+ *
+ *	Each test reports, for both ends, the bytes copied by the netif glue per payload byte
+ *	and the stack's buffer allocations per frame sent or received. Copies made by the
+ *	socket API itself, one on send and one on receive, are not included.
+ **/
+#include <bitthunder.h>
+#include <net/bt_sockets.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include "host_mac.h"
+
+// unistd.h declares read(), write() and close(), which clash with the socket API's.
+extern pid_t fork(void);
+
+#define NETPERF_TCP_PORT		5002
+#define NETPERF_UDP_PORT		5003
+#define NETPERF_RR_PORT			5004
+#define NETPERF_BUFFER_SIZE		4096
+#define NETPERF_SMALL_SIZE		64
+#define NETPERF_UDP_BURST		8		// Stays within the socket's receive mailbox.
+#define NETPERF_TIMEOUT			1000
+#define NETPERF_SETTLE_MS		20		// Lets the last acknowledgements land before sampling.
+
+#define NETPERF_ADDRESS(end)	htonl(0x0A630001 + (end))
+
+/*
+ *	Counters of each end, published to shared memory by that end's process.
+ */
+struct netperf_counters {
+	volatile BT_u32	ulCopied;
+	volatile BT_u32	ulAllocations;
+	volatile BT_u32	ulSent;
+	volatile BT_u32	ulReceived;
+};
+
+struct netperf_sample {
+	BT_u64					us;
+	struct netperf_counters	end[2];
+};
+
+static struct netperf_counters *g_shared;
+static BT_NET_IF *g_netif;
+static BT_HANDLE g_hMac;
+static BT_u32 g_ulEnd;
+
+static BT_u64 now_us(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (BT_u64) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static BT_ERROR publisher(BT_HANDLE hThread, void *pParam) {
+	struct netperf_counters *c = &g_shared[g_ulEnd];
+	BT_u32 ulSent, ulReceived;
+
+	for(;;) {
+		host_mac_frames(g_hMac, &ulSent, &ulReceived);
+		c->ulCopied = g_netif->ulBytesCopied;
+		c->ulAllocations = BT_NetGetAllocations();
+		c->ulSent = ulSent;
+		c->ulReceived = ulReceived;
+		BT_ThreadSleep(1);
+	}
+
+	return BT_ERR_NONE;
+}
+
+static void sample(struct netperf_sample *s) {
+	BT_ThreadSleep(NETPERF_SETTLE_MS);
+	memcpy(s->end, (void *) g_shared, sizeof(s->end));
+	s->us = now_us();
+}
+
+/*
+ *	Prints the counters of both ends accumulated since start, ratios with two decimals.
+ */
+static void report(const char *name, struct netperf_sample *start, BT_u32 ulPayload) {
+	struct netperf_sample end;
+	BT_u32 i;
+
+	sample(&end);
+
+	for(i = 0; i < 2; i++) {
+		struct netperf_counters *a = &start->end[i], *b = &end.end[i];
+		BT_u32 ulFrames = (b->ulSent - a->ulSent) + (b->ulReceived - a->ulReceived);
+		BT_u32 copies = ulPayload ? (BT_u32) (((BT_u64) (b->ulCopied - a->ulCopied) * 100) / ulPayload) : 0;
+		BT_u32 allocs = ulFrames ? (BT_u32) (((BT_u64) (b->ulAllocations - a->ulAllocations) * 100) / ulFrames) : 0;
+
+		printf("%-10s: %s %d frames, copies/byte %d.%02d, allocations/packet %d.%02d\n", name, i ? "server" : "client",
+			   ulFrames, copies / 100, copies % 100, allocs / 100, allocs % 100);
+	}
+}
+
+static int tcp_listener(BT_u16 usPort) {
+	struct sockaddr_in sad;
+
+	int s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if(!s) {
+		return 0;
+	}
+
+	memset(&sad, 0, sizeof(sad));
+	sad.sin_family = AF_INET;
+	sad.sin_port = htons(usPort);
+	sad.sin_addr.s_addr = INADDR_ANY;
+
+	if(bind(s, (struct sockaddr *) &sad, sizeof(sad)) || listen(s, 1)) {
+		closesocket(s);
+		return 0;
+	}
+
+	return s;
+}
+
+static int recv_all(int s, BT_u8 *buffer, BT_u32 ulLength) {
+	BT_u32 ulReceived = 0;
+
+	while(ulReceived < ulLength) {
+		int n = recv(s, buffer + ulReceived, ulLength - ulReceived, 0);
+		if(n <= 0) {
+			return -1;
+		}
+		ulReceived += n;
+	}
+
+	return 0;
+}
+
+/*
+ *	Server side, one thread per service.
+ */
+static BT_ERROR tcp_sink(BT_HANDLE hThread, void *pParam) {
+	BT_u8 *buffer = BT_kMalloc(NETPERF_BUFFER_SIZE);
+	int listener = tcp_listener(NETPERF_TCP_PORT);
+	int s, n;
+
+	/*
+	 *	The client sends the length first, lwIP cannot send on a connection once the
+	 *	peer's FIN has arrived, so a half-close would lose the reply.
+	 */
+	while(listener && (s = accept(listener, NULL, NULL))) {
+		BT_u32 ulBytes, ulReceived = 0;
+		if(!recv_all(s, (BT_u8 *) &ulBytes, sizeof(ulBytes))) {
+			while(ulReceived < ulBytes && (n = recv(s, buffer, NETPERF_BUFFER_SIZE, 0)) > 0) {
+				ulReceived += n;
+			}
+			send(s, &ulReceived, sizeof(ulReceived), 0);
+		}
+		closesocket(s);
+	}
+
+	BT_kPrint("netperf: tcp sink stopped");
+	return BT_ERR_NONE;
+}
+
+static BT_ERROR tcp_echo(BT_HANDLE hThread, void *pParam) {
+	BT_u8 buffer[NETPERF_SMALL_SIZE];
+	int listener = tcp_listener(NETPERF_RR_PORT);
+	int on = 1;
+	int s;
+
+	while(listener && (s = accept(listener, NULL, NULL))) {
+		setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+		while(!recv_all(s, buffer, sizeof(buffer))) {
+			if(send(s, buffer, sizeof(buffer), 0) != sizeof(buffer)) {
+				break;
+			}
+		}
+		closesocket(s);
+	}
+
+	BT_kPrint("netperf: tcp echo stopped");
+	return BT_ERR_NONE;
+}
+
+static BT_ERROR udp_echo(BT_HANDLE hThread, void *pParam) {
+	BT_u8 buffer[NETPERF_SMALL_SIZE];
+	struct sockaddr_in sad;
+	socklen_t len;
+	int n;
+
+	int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+	memset(&sad, 0, sizeof(sad));
+	sad.sin_family = AF_INET;
+	sad.sin_port = htons(NETPERF_UDP_PORT);
+	sad.sin_addr.s_addr = INADDR_ANY;
+
+	if(s && !bind(s, (struct sockaddr *) &sad, sizeof(sad))) {
+		for(;;) {
+			len = sizeof(sad);
+			n = recvfrom(s, buffer, sizeof(buffer), 0, (struct sockaddr *) &sad, &len);
+			if(n > 0) {
+				sendto(s, buffer, n, 0, (struct sockaddr *) &sad, len);
+			}
+		}
+	}
+
+	BT_kPrint("netperf: udp echo stopped");
+	return BT_ERR_NONE;
+}
+
+/*
+ *	Client side.
+ */
+static int connect_peer(BT_u16 usPort) {
+	struct sockaddr_in peer;
+
+	memset(&peer, 0, sizeof(peer));
+	peer.sin_family = AF_INET;
+	peer.sin_port = htons(usPort);
+	peer.sin_addr.s_addr = NETPERF_ADDRESS(1);
+
+	int s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if(!s) {
+		return 0;
+	}
+
+	if(connect(s, (struct sockaddr *) &peer, sizeof(peer))) {
+		closesocket(s);
+		return 0;
+	}
+
+	return s;
+}
+
+static int bench_tcp_stream(BT_u32 ulBytes, BT_u8 *buffer) {
+	struct netperf_sample start;
+	BT_u32 ulReceived = 0;
+	BT_u32 ulSent = 0;
+
+	int s = connect_peer(NETPERF_TCP_PORT);
+	if(!s) {
+		printf("Error: Could not connect to port %d\n", NETPERF_TCP_PORT);
+		return -1;
+	}
+
+	sample(&start);
+
+	send(s, &ulBytes, sizeof(ulBytes), 0);
+
+	while(ulSent < ulBytes) {
+		BT_u32 ulSize = ulBytes - ulSent;
+		if(ulSize > NETPERF_BUFFER_SIZE) {
+			ulSize = NETPERF_BUFFER_SIZE;
+		}
+
+		if(send(s, buffer, ulSize, 0) != (int) ulSize) {
+			break;
+		}
+
+		ulSent += ulSize;
+	}
+
+	recv_all(s, (BT_u8 *) &ulReceived, sizeof(ulReceived));
+	closesocket(s);
+
+	BT_u64 us = now_us() - start.us;
+
+	printf("tcp stream: %d bytes in %llu us, %llu KB/s\n", ulReceived, (unsigned long long) us,
+		   us ? (unsigned long long) (((BT_u64) ulReceived * 1000000) / (us * 1024)) : 0);
+	report("tcp stream", &start, ulReceived);
+
+	return ulReceived == ulBytes ? 0 : -1;
+}
+
+static int bench_tcp_rr(BT_u32 ulCount, BT_u8 *buffer) {
+	struct netperf_sample start;
+	int on = 1;
+	BT_u32 i;
+
+	int s = connect_peer(NETPERF_RR_PORT);
+	if(!s) {
+		printf("Error: Could not connect to port %d\n", NETPERF_RR_PORT);
+		return -1;
+	}
+
+	setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+	sample(&start);
+
+	for(i = 0; i < ulCount; i++) {
+		if(send(s, buffer, NETPERF_SMALL_SIZE, 0) != NETPERF_SMALL_SIZE || recv_all(s, buffer, NETPERF_SMALL_SIZE)) {
+			printf("Error: Request/response broke off\n");
+			break;
+		}
+	}
+
+	closesocket(s);
+
+	BT_u64 us = now_us() - start.us;
+
+	printf("tcp rr    : %d transactions, %llu us each\n", i, i ? (unsigned long long) (us / i) : 0);
+	report("tcp rr", &start, i * NETPERF_SMALL_SIZE * 2);
+
+	return i == ulCount ? 0 : -1;
+}
+
+static int bench_udp(BT_u32 ulCount, BT_u8 *buffer) {
+	struct netperf_sample start;
+	struct sockaddr_in peer;
+	BT_u32 ulReceived = 0;
+	BT_u32 i, n;
+	int retval = -1;
+
+	int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if(!s) {
+		return -1;
+	}
+
+	memset(&peer, 0, sizeof(peer));
+	peer.sin_family = AF_INET;
+	peer.sin_port = htons(NETPERF_UDP_PORT);
+	peer.sin_addr.s_addr = NETPERF_ADDRESS(1);
+
+	int timeout = NETPERF_TIMEOUT;
+	setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	/*
+	 *	Latency, one datagram in flight.
+	 */
+	sample(&start);
+	for(i = 0; i < ulCount / NETPERF_UDP_BURST; i++) {
+		sendto(s, buffer, NETPERF_SMALL_SIZE, 0, (struct sockaddr *) &peer, sizeof(peer));
+		if(recv(s, buffer, NETPERF_SMALL_SIZE, 0) != NETPERF_SMALL_SIZE) {
+			printf("Error: Datagram lost\n");
+			goto socket_out;
+		}
+	}
+
+	BT_u64 us = now_us() - start.us;
+	printf("udp rtt   : %d round trips, %llu us each\n", i, i ? (unsigned long long) (us / i) : 0);
+	report("udp rtt", &start, i * NETPERF_SMALL_SIZE * 2);
+
+	/*
+	 *	Packet rate, bursts of datagrams.
+	 */
+	sample(&start);
+	for(i = 0; i < ulCount; i += NETPERF_UDP_BURST) {
+		for(n = 0; n < NETPERF_UDP_BURST; n++) {
+			sendto(s, buffer, NETPERF_SMALL_SIZE, 0, (struct sockaddr *) &peer, sizeof(peer));
+		}
+		for(n = 0; n < NETPERF_UDP_BURST; n++) {
+			if(recv(s, buffer, NETPERF_SMALL_SIZE, 0) != NETPERF_SMALL_SIZE) {
+				break;
+			}
+			ulReceived++;
+		}
+	}
+
+	us = now_us() - start.us;
+	printf("udp pps   : %d of %d datagrams, %llu packets/s\n", ulReceived, i,
+		   us ? (unsigned long long) (((BT_u64) ulReceived * 1000000) / us) : 0);
+	report("udp pps", &start, ulReceived * NETPERF_SMALL_SIZE * 2);
+
+	if(ulReceived == i) {
+		retval = 0;
+	}
+
+socket_out:
+	closesocket(s);
+
+	return retval;
+}
+
+static BT_HANDLE start_thread(BT_FN_THREAD_ENTRY pfnEntry) {
+	BT_ERROR Error;
+	BT_THREAD_CONFIG oThreadConfig = {
+		.ulStackDepth 	= 512,
+		.ulPriority		= 0,
+	};
+
+	return BT_CreateThread(pfnEntry, &oThreadConfig, &Error);
+}
+
+/*
+ *	Brings up this end's stack and interface, returns once it can pass traffic.
+ */
+static int start_stack(struct host_wire *wire) {
+	BT_IPADDRESS ip, netmask, gw;
+	BT_ERROR Error;
+
+	g_hMac = host_mac_create(wire, g_ulEnd, &Error);
+	if(!g_hMac) {
+		return -1;
+	}
+
+	BT_InitialiseKernelModules(NULL);
+
+	while(!BT_isNetworkingReady() || !(g_netif = BT_GetNetif("e0", &Error))) {
+		BT_ThreadSleep(1);
+	}
+
+	ip.ulIPAddress = NETPERF_ADDRESS(g_ulEnd);
+	netmask.ulIPAddress = htonl(0xFFFFFF00);
+	gw.ulIPAddress = 0;
+
+	if(BT_NetifSetAddress(g_netif, &ip, &netmask, &gw) || BT_StartNetif(g_netif)) {
+		return -1;
+	}
+
+	return start_thread(publisher) ? 0 : -1;
+}
+
+int main(int argc, char **argv) {
+	BT_u32 ulBytes = 16 * 1024 * 1024;
+	BT_u32 ulCount = 10000;
+	int status, retval = 0;
+
+	if(argc > 3) {
+		printf("Usage: %s [tcp-bytes] [count]\n", argv[0]);
+		return 1;
+	}
+
+	if(argc > 1) {
+		ulBytes = strtoul(argv[1], NULL, 10);
+	}
+
+	if(argc > 2) {
+		ulCount = strtoul(argv[2], NULL, 10);
+	}
+
+	struct host_wire *wire = host_wire_create();
+	g_shared = mmap(NULL, sizeof(struct netperf_counters) * 2, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if(!wire || g_shared == MAP_FAILED) {
+		printf("Error: Could not map the wire\n");
+		return 1;
+	}
+
+	pid_t server = fork();
+	if(server < 0) {
+		return 1;
+	}
+
+	if(!server) {
+		prctl(PR_SET_PDEATHSIG, SIGKILL);
+		g_ulEnd = 1;
+		if(start_stack(wire) || !start_thread(tcp_sink) || !start_thread(tcp_echo) || !start_thread(udp_echo)) {
+			BT_kPrint("netperf: server did not start");
+			return 1;
+		}
+		for(;;) {
+			BT_ThreadSleep(1000);
+		}
+	}
+
+	if(start_stack(wire)) {
+		printf("Error: Client did not start\n");
+		retval = 1;
+		goto server_out;
+	}
+
+	BT_u8 *buffer = BT_kMalloc(NETPERF_BUFFER_SIZE);
+	memset(buffer, 0x5A, NETPERF_BUFFER_SIZE);
+
+	// Server threads are listening once its end has answered a connection.
+	while(!(status = connect_peer(NETPERF_RR_PORT))) {
+		BT_ThreadSleep(10);
+	}
+	closesocket(status);
+
+	if(bench_tcp_stream(ulBytes, buffer) || bench_tcp_rr(ulCount, buffer) || bench_udp(ulCount, buffer)) {
+		retval = 1;
+	}
+
+	fflush(stdout);
+
+server_out:
+	kill(server, SIGKILL);
+	waitpid(server, &status, 0);
+
+	return retval;
+}
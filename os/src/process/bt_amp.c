@@ -0,0 +1,270 @@
+/**
+ *	BT AMP Implementation.
+ *
+ *	The remote core's memory starts with the channel, and its stack grows down from
+ *	the end. Both cores map it cached and shareable, and are in the same coherency
+ *	domain, so the rings need no cache maintenance.
+ *
+ *	A consumer about to sleep sets ulSleeping and checks the ring again; a producer
+ *	checks ulSleeping after it published a message. Both with full barriers in between,
+ *	so that either the consumer sees the message or the producer sees it sleeping and
+ *	rings the doorbell.
+ **/
+
+#include <bitthunder.h>
+#include <process/bt_amp.h>
+#include <string.h>
+
+BT_DEF_MODULE_NAME	("AMP")
+
+#define AMP_SLOTS		BT_CONFIG_AMP_CHANNEL_SLOTS
+#define AMP_ALIGN		32		// Cache line size.
+
+#if (AMP_SLOTS & (AMP_SLOTS - 1))
+#error "BT_CONFIG_AMP_CHANNEL_SLOTS must be a power of two."
+#endif
+
+struct amp_slot {
+	BT_u32		ulLength;
+	BT_u8		data[BT_CONFIG_AMP_MESSAGE_SIZE];
+} __attribute__((aligned(AMP_ALIGN)));
+
+struct amp_ring {
+	BT_u32				head __attribute__((aligned(AMP_ALIGN)));	///< Written by the producer.
+	BT_u32				tail __attribute__((aligned(AMP_ALIGN)));	///< Written by the consumer.
+	BT_u32				ulSleeping;									///< Consumer waits for the doorbell.
+	struct amp_slot		slots[AMP_SLOTS];
+};
+
+struct amp_shared {
+	BT_u32				ulOnline;
+	struct amp_ring		toRemote;
+	struct amp_ring		toHost;
+};
+
+#define g_pShared		((struct amp_shared *) BT_CONFIG_AMP_MEMORY_BASE)
+
+static BT_AMP_REMOTE_MAIN g_pfnRemoteMain;
+static void *g_pRemoteParam;
+static void *g_pDoorbell;
+
+extern void bt_secondary_reset(void);
+
+static BT_BOOL is_remote(void) {
+	return BT_GetCoreID() == BT_AMP_REMOTE_CPU;
+}
+
+static struct amp_ring *tx_ring(void) {
+	return is_remote() ? &g_pShared->toHost : &g_pShared->toRemote;
+}
+
+static struct amp_ring *rx_ring(void) {
+	return is_remote() ? &g_pShared->toRemote : &g_pShared->toHost;
+}
+
+static BT_u32 peer_mask(void) {
+	return is_remote() ? 1 : (1 << BT_AMP_REMOTE_CPU);
+}
+
+BT_u32 BT_AmpMessageSize() {
+	return BT_CONFIG_AMP_MESSAGE_SIZE;
+}
+BT_EXPORT_SYMBOL(BT_AmpMessageSize);
+
+BT_BOOL BT_AmpRemoteOnline() {
+	return __atomic_load_n(&g_pShared->ulOnline, __ATOMIC_ACQUIRE) ? BT_TRUE : BT_FALSE;
+}
+BT_EXPORT_SYMBOL(BT_AmpRemoteOnline);
+
+void *BT_AmpRemoteMemory(BT_u32 *pulSize) {
+	BT_u32 ulStart = BT_CONFIG_AMP_MEMORY_BASE + ((sizeof(struct amp_shared) + AMP_ALIGN - 1) & ~(AMP_ALIGN - 1));
+	BT_u32 ulEnd = BT_CONFIG_AMP_MEMORY_BASE + BT_CONFIG_AMP_MEMORY_SIZE - BT_CONFIG_AMP_STACK;
+
+	if(pulSize) {
+		*pulSize = ulEnd - ulStart;
+	}
+
+	return (void *) ulStart;
+}
+BT_EXPORT_SYMBOL(BT_AmpRemoteMemory);
+
+void *BT_AmpAllocMessage() {
+	struct amp_ring *pRing = tx_ring();
+	BT_u32 head = pRing->head;
+
+	if(head - __atomic_load_n(&pRing->tail, __ATOMIC_ACQUIRE) >= AMP_SLOTS) {
+		return NULL;
+	}
+
+	return pRing->slots[head & (AMP_SLOTS - 1)].data;
+}
+BT_EXPORT_SYMBOL(BT_AmpAllocMessage);
+
+BT_ERROR BT_AmpSendMessage(void *pMessage, BT_u32 ulLength) {
+	struct amp_ring *pRing = tx_ring();
+	struct amp_slot *pSlot = bt_container_of(pMessage, struct amp_slot, data);
+
+	if(ulLength > BT_CONFIG_AMP_MESSAGE_SIZE || pSlot != &pRing->slots[pRing->head & (AMP_SLOTS - 1)]) {
+		return BT_ERR_INVALID_VALUE;
+	}
+
+	pSlot->ulLength = ulLength;
+	__atomic_store_n(&pRing->head, pRing->head + 1, __ATOMIC_RELEASE);
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&pRing->ulSleeping, __ATOMIC_RELAXED)) {
+		BT_SendSoftwareInterrupt(BT_AMP_IPI, peer_mask());
+	}
+
+	return BT_ERR_NONE;
+}
+BT_EXPORT_SYMBOL(BT_AmpSendMessage);
+
+static struct amp_slot *rx_peek(struct amp_ring *pRing) {
+	BT_u32 tail = pRing->tail;
+
+	if(tail == __atomic_load_n(&pRing->head, __ATOMIC_ACQUIRE)) {
+		return NULL;
+	}
+
+	return &pRing->slots[tail & (AMP_SLOTS - 1)];
+}
+
+/*
+ *	Sleeps until the doorbell rings, unless a message arrived meanwhile.
+ */
+static BT_BOOL rx_sleep(struct amp_ring *pRing, BT_TICK ulTimeout) {
+	BT_BOOL bWoken = BT_TRUE;
+
+	__atomic_store_n(&pRing->ulSleeping, 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	if(!rx_peek(pRing)) {
+		if(is_remote()) {
+			/*
+			 *	WFI wakes on a pending IRQ even with them masked, so the doorbell
+			 *	cannot be taken between the check and the WFI.
+			 */
+			__asm volatile("cpsid i" ::: "memory");
+			if(!rx_peek(pRing)) {
+				__asm volatile("wfi" ::: "memory");
+			}
+			__asm volatile("cpsie i" ::: "memory");
+		} else {
+			bWoken = BT_kMutexPend(g_pDoorbell, ulTimeout);
+		}
+	}
+
+	__atomic_store_n(&pRing->ulSleeping, 0, __ATOMIC_RELAXED);
+
+	return bWoken;
+}
+
+void *BT_AmpReceiveMessage(BT_u32 *pulLength, BT_TICK ulTimeout) {
+	struct amp_ring *pRing = rx_ring();
+	struct amp_slot *pSlot;
+
+	while(!(pSlot = rx_peek(pRing))) {
+		if(!ulTimeout || !rx_sleep(pRing, ulTimeout)) {
+			pSlot = rx_peek(pRing);
+			break;
+		}
+	}
+
+	if(!pSlot) {
+		return NULL;
+	}
+
+	if(pulLength) {
+		*pulLength = pSlot->ulLength;
+	}
+
+	return pSlot->data;
+}
+BT_EXPORT_SYMBOL(BT_AmpReceiveMessage);
+
+void BT_AmpReleaseMessage(void *pMessage) {
+	struct amp_ring *pRing = rx_ring();
+	__atomic_store_n(&pRing->tail, pRing->tail + 1, __ATOMIC_RELEASE);
+}
+BT_EXPORT_SYMBOL(BT_AmpReleaseMessage);
+
+static BT_ERROR doorbell_handler(BT_u32 ulIRQ, void *pParam) {
+	if(!is_remote()) {
+		BT_kMutexReleaseFromISR(g_pDoorbell, NULL);
+	}
+
+	return BT_ERR_NONE;		// The remote core only needed to leave WFI.
+}
+
+/*
+ *	Runs on the remote core, from bt_secondary_reset.
+ */
+static void remote_start(BT_u32 ulCPU) {
+	BT_InitInterruptCPU();
+
+	__atomic_store_n(&g_pShared->ulOnline, 1, __ATOMIC_RELEASE);
+	__asm volatile("dsb\n\tsev\n\tcpsie i" ::: "memory");
+
+	g_pfnRemoteMain(g_pRemoteParam);
+
+	__asm volatile("cpsid i" ::: "memory");
+	__atomic_store_n(&g_pShared->ulOnline, 0, __ATOMIC_RELEASE);
+
+	while(1) {
+		__asm volatile("wfe");
+	}
+}
+
+BT_ERROR BT_AmpStartRemote(BT_AMP_REMOTE_MAIN pfnMain, void *pParam) {
+	if(!pfnMain) {
+		return BT_ERR_NULL_POINTER;
+	}
+
+	if(g_pfnRemoteMain) {
+		return BT_ERR_BUSY;
+	}
+
+	g_pfnRemoteMain = pfnMain;
+	g_pRemoteParam = pParam;
+
+	bt_register_t ulTop = (BT_CONFIG_AMP_MEMORY_BASE + BT_CONFIG_AMP_MEMORY_SIZE) & ~7;
+
+	BT_ERROR Error = BT_BootCore(BT_AMP_REMOTE_CPU, (void *) bt_secondary_reset, ulTop, BT_AMP_REMOTE_CPU, (bt_register_t) remote_start, 0);
+	if(Error) {
+		return Error;
+	}
+
+	BT_u32 ulWait = 100;
+	while(!BT_AmpRemoteOnline() && ulWait--) {
+		BT_ThreadSleep(1);
+	}
+
+	return BT_AmpRemoteOnline() ? BT_ERR_NONE : BT_ERR_GENERIC;
+}
+BT_EXPORT_SYMBOL(BT_AmpStartRemote);
+
+static BT_ERROR bt_amp_init() {
+	memset(g_pShared, 0, sizeof(*g_pShared));
+
+	g_pDoorbell = BT_kSemaphoreCreate();
+	if(!g_pDoorbell) {
+		return BT_ERR_NO_MEMORY;
+	}
+
+	BT_kMutexPend(g_pDoorbell, 0);
+
+	BT_ERROR Error = BT_RegisterInterrupt(BT_AMP_IPI, doorbell_handler, NULL);
+	if(Error) {
+		return Error;
+	}
+
+	BT_EnableInterrupt(BT_AMP_IPI);
+
+	return BT_ERR_NONE;
+}
+
+BT_MODULE_INIT_DEF oModuleEntry = {
+	BT_MODULE_NAME,
+	bt_amp_init,
+};
@@ -0,0 +1,88 @@
+/**
+ *	Lightweight kernel lock, contended paths.
+ *
+ *	The uncontended paths are inline in bt_lock.h. A thread that finds the lock held
+ *	marks it as having waiters and sleeps on the lock's semaphore; the thread that
+ *	releases a lock with waiters signals the semaphore once. A woken thread marks the
+ *	lock again before retrying, so the next release signals the next waiter.
+ **/
+
+#include <bitthunder.h>
+
+BT_ERROR bt_lock_init(struct bt_lock *pLock) {
+#if BT_LOCK_ATOMIC
+	void *pWait = BT_kSemaphoreCreate();
+	if(pWait) {
+		BT_kMutexPend(pWait, 0);		// Created available, waiters must block until signalled.
+	}
+#else
+	void *pWait = BT_kMutexCreate();
+#endif
+
+	if(!pWait) {
+		return BT_ERR_NO_MEMORY;
+	}
+
+	pLock->pWait = pWait;
+
+	return BT_ERR_NONE;
+}
+BT_EXPORT_SYMBOL(bt_lock_init);
+
+void bt_lock_destroy(struct bt_lock *pLock) {
+	if(pLock->pWait) {
+		BT_kMutexDestroy(pLock->pWait);
+		pLock->pWait = NULL;
+	}
+}
+BT_EXPORT_SYMBOL(bt_lock_destroy);
+
+#if BT_LOCK_ATOMIC
+
+void bt_lock_slow(struct bt_lock *pLock) {
+
+	/*
+	 *	With another core the holder may release the lock within a few hundred cycles,
+	 *	cheaper than sleeping. On a single core the holder cannot run while we spin.
+	 */
+	BT_u32 i;
+	for(i = 0; i < BT_CONFIG_KERNEL_LOCK_SPIN; i++) {
+		if(__atomic_load_n(&pLock->ulState, __ATOMIC_RELAXED) == BT_LOCK_FREE && bt_trylock(pLock)) {
+			return;
+		}
+	}
+
+	while(__atomic_exchange_n(&pLock->ulState, BT_LOCK_WAITERS, __ATOMIC_ACQUIRE) != BT_LOCK_FREE) {
+		if(pLock->pWait) {
+			BT_kMutexPend(pLock->pWait, BT_INFINITE_TIMEOUT);
+		} else {
+			BT_kTaskYield();
+		}
+	}
+}
+BT_EXPORT_SYMBOL(bt_lock_slow);
+
+void bt_unlock_slow(struct bt_lock *pLock) {
+	if(pLock->pWait) {
+		BT_kMutexRelease(pLock->pWait);
+	}
+}
+BT_EXPORT_SYMBOL(bt_unlock_slow);
+
+#else
+
+void bt_lock_slow(struct bt_lock *pLock) {
+	if(pLock->pWait) {
+		BT_kMutexPend(pLock->pWait, BT_INFINITE_TIMEOUT);
+	}
+}
+BT_EXPORT_SYMBOL(bt_lock_slow);
+
+void bt_unlock_slow(struct bt_lock *pLock) {
+	if(pLock->pWait) {
+		BT_kMutexRelease(pLock->pWait);
+	}
+}
+BT_EXPORT_SYMBOL(bt_unlock_slow);
+
+#endif
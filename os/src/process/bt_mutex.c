@@ -23,18 +23,39 @@ static BT_ERROR mutex_cleanup(BT_HANDLE hMutex) {
 
 static const BT_IF_HANDLE oHandleInterface;
 
-BT_HANDLE BT_CreateMutex(BT_ERROR *pError) {
+static BT_HANDLE create_mutex(void *(*pfnCreate)(void), BT_ERROR *pError) {
 	BT_HANDLE hMutex = BT_CreateHandle(&oHandleInterface, sizeof(struct _BT_OPAQUE_HANDLE), pError);
 	if(!hMutex) {
 		return NULL;
 	}
 
-	hMutex->pMutex = BT_kMutexCreate();
+	hMutex->pMutex = pfnCreate();
+	if(!hMutex->pMutex) {
+		BT_DestroyHandle(hMutex);
+		if(pError) {
+			*pError = BT_ERR_NO_MEMORY;
+		}
+		return NULL;
+	}
 
 	return hMutex;
 }
+
+BT_HANDLE BT_CreateMutex(BT_ERROR *pError) {
+	return create_mutex(BT_kMutexCreate, pError);
+}
 BT_EXPORT_SYMBOL(BT_CreateMutex);
 
+BT_HANDLE BT_CreateRecursiveMutex(BT_ERROR *pError) {
+	return create_mutex(BT_kRecursiveMutexCreate, pError);
+}
+BT_EXPORT_SYMBOL(BT_CreateRecursiveMutex);
+
+BT_HANDLE BT_CreateSemaphore(BT_ERROR *pError) {
+	return create_mutex(BT_kSemaphoreCreate, pError);
+}
+BT_EXPORT_SYMBOL(BT_CreateSemaphore);
+
 BT_ERROR BT_PendMutex(BT_HANDLE hMutex, BT_TICK oTimeoutTicks) {
 	return BT_kMutexPend(hMutex->pMutex, oTimeoutTicks);
 }
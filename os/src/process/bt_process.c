@@ -5,6 +5,7 @@
 #include <bitthunder.h>
 #include <string.h>
 #include <mm/bt_vm.h>
+#include <helpers/bt_bitops.h>
 
 BT_DEF_MODULE_NAME			("Process Manager")
 BT_DEF_MODULE_DESCRIPTION	("OS Process abstraction for the BitThunder Kernel")
@@ -33,7 +34,9 @@ BT_ERROR BT_StartScheduler() {
 }
 
 
-static BT_s32 task_alloc_fd(struct bt_task *task);
+static void fdtable_init(struct bt_fdtable *fdt);
+static void fdtable_inherit(struct bt_fdtable *fdt, struct bt_fdtable *parent);
+static void fdtable_close_all(struct bt_fdtable *fdt);
 
 BT_HANDLE BT_CreateProcess(BT_FN_THREAD_ENTRY pfnStartRoutine, const BT_i8 *szpName, BT_THREAD_CONFIG *pConfig, BT_ERROR *pError) {
 	BT_HANDLE hProcess = BT_CreateHandle(&oHandleInterface, sizeof(struct _BT_OPAQUE_HANDLE), pError);
@@ -66,18 +69,29 @@ BT_HANDLE BT_CreateProcess(BT_FN_THREAD_ENTRY pfnStartRoutine, const BT_i8 *szpN
 	total_processes += 1;
 
 	// Inherit the file-descriptors from the parent.
-	BT_u32 i;
-	for(i = 0; i < (sizeof(hProcess->task.fds)/sizeof(BT_HANDLE)); i++) {
-		BT_RefHandle(hProcess->task.parent->fds[i]);
-	}
-
-	memcpy(hProcess->task.fds, hProcess->task.parent->fds, sizeof(hProcess->task.fds));
-	hProcess->task.free_fd = hProcess->task.parent->free_fd;
+	fdtable_inherit(&hProcess->task.fdt, &hProcess->task.parent->fdt);
 
 	return hProcess;
 }
 BT_EXPORT_SYMBOL(BT_CreateProcess);
 
+/*
+ *	Takes the first handle off a process list, so that closing it cannot race with
+ *	walking the list.
+ */
+static BT_HANDLE detach_first(struct bt_list_head *list) {
+	BT_HANDLE h = NULL;
+
+	BT_kEnterCritical();
+	if(!bt_list_empty(list)) {
+		h = bt_container_of(list->next, struct _BT_OPAQUE_HANDLE, h.item);
+		bt_list_del_init(&h->h.item);
+	}
+	BT_kExitCritical();
+
+	return h;
+}
+
 BT_ERROR BT_DestroyProcess(BT_HANDLE hProcess) {
 
 	// Kill the process in the scheduler.
@@ -88,9 +102,8 @@ BT_ERROR BT_DestroyProcess(BT_HANDLE hProcess) {
 
 	// Suspend each thread. (Except calling thread).
 	// Close the an open handles.
-	struct bt_list_head *pos;
-	bt_list_for_each(pos, &hProcess->task.threads) {
-		BT_HANDLE h = bt_container_of(pos, struct _BT_OPAQUE_HANDLE, h.item);
+	BT_HANDLE h;
+	while((h = detach_first(&hProcess->task.threads))) {
 		BT_CloseHandle(h);
 	}
 
@@ -103,16 +116,11 @@ BT_ERROR BT_DestroyProcess(BT_HANDLE hProcess) {
 		return BT_ERR_NONE;
 	}
 
-	BT_u32 i = 0;
-	for(i = 0; i < sizeof(hProcess->task.fds)/sizeof(BT_HANDLE); i++) {
-		BT_SetProcessFileDescriptor(hProcess, i, NULL);	// This will cause the handle to be closed or unreferenced.
-	}
-
 	// Close all open file-descriptors.
+	fdtable_close_all(&hProcess->task.fdt);
 
 	// Close the an open handles.
-	bt_list_for_each(pos, &hProcess->task.handles) {
-		BT_HANDLE h = bt_container_of(pos, struct _BT_OPAQUE_HANDLE, h.item);
+	while((h = detach_first(&hProcess->task.handles))) {
 		BT_CloseHandle(h);
 	}
 
@@ -224,18 +232,251 @@ BT_u32 BT_GetTotalProcesses() {
 }
 BT_EXPORT_SYMBOL(BT_GetTotalProcesses);
 
+static void fdtable_init(struct bt_fdtable *fdt) {
+	memset(fdt, 0, sizeof(*fdt));
+	fdt->ulMax 		= BT_FD_INLINE;
+	fdt->fds 		= fdt->inline_fds;
+	fdt->open 		= fdt->inline_open;
+	fdt->cloexec 	= fdt->inline_cloexec;
+}
+
+/*
+ *	Grows the table to hold descriptor fd. The arrays are allocated outside of the critical
+ *	section and only swapped in it, so lookups never see them half copied.
+ */
+static BT_ERROR fdtable_expand(struct bt_fdtable *fdt, BT_u32 fd) {
+	if(fd >= BT_CONFIG_PROCESS_MAX_FDS || !fdt->ulMax) {
+		return BT_ERR_GENERIC;
+	}
+
+	BT_u32 ulMax = fdt->ulMax;
+	while(ulMax <= fd) {
+		ulMax *= 2;
+	}
+
+	BT_u32 ulLimit = ((BT_CONFIG_PROCESS_MAX_FDS + 31) / 32) * 32;
+	if(ulMax > ulLimit) {
+		ulMax = ulLimit;
+	}
+
+	BT_u32 ulWords = ulMax / 32;
+	BT_HANDLE *fds = BT_kMalloc(ulMax * sizeof(BT_HANDLE) + 2 * ulWords * sizeof(BT_u32));
+	if(!fds) {
+		return BT_ERR_NO_MEMORY;
+	}
+
+	BT_u32 *open = (BT_u32 *) (fds + ulMax);
+	BT_u32 *cloexec = open + ulWords;
+	void *old = NULL;
+
+	BT_kEnterCritical();
+	{
+		if(fdt->ulMax < ulMax) {	// Unless another thread grew it meanwhile.
+			BT_u32 ulOldWords = fdt->ulMax / 32;
+
+			memcpy(fds, fdt->fds, fdt->ulMax * sizeof(BT_HANDLE));
+			memset(fds + fdt->ulMax, 0, (ulMax - fdt->ulMax) * sizeof(BT_HANDLE));
+			memcpy(open, fdt->open, ulOldWords * sizeof(BT_u32));
+			memset(open + ulOldWords, 0, (ulWords - ulOldWords) * sizeof(BT_u32));
+			memcpy(cloexec, fdt->cloexec, ulOldWords * sizeof(BT_u32));
+			memset(cloexec + ulOldWords, 0, (ulWords - ulOldWords) * sizeof(BT_u32));
+
+			if(fdt->fds != fdt->inline_fds) {
+				old = fdt->fds;
+			}
+
+			fdt->fds 		= fds;
+			fdt->open 		= open;
+			fdt->cloexec 	= cloexec;
+			fdt->ulMax 		= ulMax;
+			fds = NULL;
+		}
+	}
+	BT_kExitCritical();
+
+	if(old) {
+		BT_kFree(old);
+	}
+
+	if(fds) {
+		BT_kFree(fds);
+	}
+
+	return BT_ERR_NONE;
+}
+
+/*
+ *	Allocates the lowest free descriptor from ulMin up, a bitmap word at a time. The
+ *	table is rounded up to whole words, so the slots past BT_CONFIG_PROCESS_MAX_FDS
+ *	are never handed out.
+ */
+static BT_s32 fdtable_alloc(struct bt_fdtable *fdt, BT_u32 ulMin) {
+	while(1) {
+		BT_kEnterCritical();
+
+		BT_u32 ulEnd = (fdt->ulMax < BT_CONFIG_PROCESS_MAX_FDS) ? fdt->ulMax : BT_CONFIG_PROCESS_MAX_FDS;
+		BT_u32 i = (ulMin > fdt->ulFree) ? ulMin : fdt->ulFree;
+		for(; i < ulEnd; i = (i | 31) + 1) {
+			BT_u32 free = ~fdt->open[i / 32] & (0xFFFFFFFF << (i % 32));
+			if(free) {
+				i = (i & ~31) + __builtin_ctz(free);
+				if(i >= ulEnd) {
+					break;
+				}
+				__bt_set_bit(i, fdt->open);
+				__bt_clear_bit(i, fdt->cloexec);
+				if(ulMin <= fdt->ulFree) {
+					fdt->ulFree = i + 1;
+				}
+				BT_kExitCritical();
+				return (BT_s32) i;
+			}
+		}
+
+		BT_u32 ulMax = (ulMin > fdt->ulMax) ? ulMin : fdt->ulMax;
+		BT_kExitCritical();
+
+		BT_ERROR Error = fdtable_expand(fdt, ulMax);
+		if(Error) {
+			return Error;
+		}
+	}
+}
+
+/*
+ *	Returns the handle fd held, the caller releases its reference.
+ */
+static BT_HANDLE fdtable_free(struct bt_fdtable *fdt, BT_u32 fd) {
+	BT_HANDLE h = NULL;
+
+	BT_kEnterCritical();
+	if(fd < fdt->ulMax) {
+		h = fdt->fds[fd];
+		fdt->fds[fd] = NULL;
+		__bt_clear_bit(fd, fdt->open);
+		__bt_clear_bit(fd, fdt->cloexec);
+		if(fd < fdt->ulFree) {
+			fdt->ulFree = fd;
+		}
+	}
+	BT_kExitCritical();
+
+	return h;
+}
+
+/*
+ *	Copies the parent's descriptors, apart from those with BT_FD_CLOEXEC.
+ */
+static void fdtable_inherit(struct bt_fdtable *fdt, struct bt_fdtable *parent) {
+	fdtable_init(fdt);
+
+	if(parent->ulMax > fdt->ulMax) {
+		fdtable_expand(fdt, parent->ulMax - 1);
+	}
+
+	BT_kEnterCritical();
+	{
+		BT_u32 ulMax = (parent->ulMax < fdt->ulMax) ? parent->ulMax : fdt->ulMax;
+		BT_u32 i;
+
+		for(i = 0; i < ulMax / 32; i++) {
+			fdt->open[i] = parent->open[i] & ~parent->cloexec[i];
+		}
+
+		for(i = 0; i < ulMax; i++) {
+			if(bt_test_bit(i, fdt->open)) {
+				fdt->fds[i] = parent->fds[i];
+				BT_RefHandle(fdt->fds[i]);
+			}
+		}
+	}
+	BT_kExitCritical();
+}
+
+/*
+ *	Looks fd up and references its handle, so that a close from another thread
+ *	cannot free it under the caller.
+ */
+static BT_HANDLE fdtable_get_ref(struct bt_fdtable *fdt, BT_u32 fd) {
+	BT_HANDLE h = NULL;
+
+	BT_kEnterCritical();
+	if(fd < fdt->ulMax) {
+		h = fdt->fds[fd];
+		BT_RefHandle(h);
+	}
+	BT_kExitCritical();
+
+	return h;
+}
+
+static void fdtable_close_all(struct bt_fdtable *fdt) {
+	BT_u32 i;
+
+	for(i = 0; i < fdt->ulMax; i++) {
+		BT_HANDLE h = fdtable_free(fdt, i);
+		if(h) {
+			BT_CloseHandle(h);	// This will cause the handle to be closed or unreferenced.
+		}
+	}
+
+	BT_kEnterCritical();
+	void *old = (fdt->fds != fdt->inline_fds) ? fdt->fds : NULL;
+	fdtable_init(fdt);
+	BT_kExitCritical();
+
+	if(old) {
+		BT_kFree(old);
+	}
+}
+
 BT_ERROR BT_SetProcessFileDescriptor(BT_HANDLE hProcess, BT_u32 i, BT_HANDLE h) {
-	struct bt_task *task = BT_GetProcessTask(hProcess);
-	BT_CloseHandle(task->fds[i]);	// Unreference or close handle used.
+	struct bt_fdtable *fdt = &BT_GetProcessTask(hProcess)->fdt;
+
+	if(i >= fdt->ulMax || i >= BT_CONFIG_PROCESS_MAX_FDS) {
+		if(!h) {
+			return BT_ERR_NONE;
+		}
+
+		BT_ERROR Error = fdtable_expand(fdt, i);
+		if(Error) {
+			return Error;
+		}
+	}
+
 	BT_RefHandle(h);				// Ensure we reference the handle when creating an FD.
-	task->fds[i] = h;
+
+	BT_kEnterCritical();
+	BT_HANDLE hOld = fdt->fds[i];
+	fdt->fds[i] = h;
+	if(h) {
+		__bt_set_bit(i, fdt->open);
+	}
+	BT_kExitCritical();
+
+	if(hOld) {
+		BT_CloseHandle(hOld);		// Unreference or close handle used.
+	}
+
 	return BT_ERR_NONE;
 }
 BT_EXPORT_SYMBOL(BT_SetProcessFileDescriptor);
 
 BT_HANDLE BT_GetProcessFileDescriptor(BT_HANDLE hProcess, BT_u32 i, BT_ERROR *pError) {
-	struct bt_task *task = BT_GetProcessTask(hProcess);
-	return task->fds[i];
+	struct bt_fdtable *fdt = &BT_GetProcessTask(hProcess)->fdt;
+	BT_HANDLE h = NULL;
+
+	BT_kEnterCritical();
+	if(i < fdt->ulMax) {
+		h = fdt->fds[i];
+	}
+	BT_kExitCritical();
+
+	if(pError) {
+		*pError = h ? BT_ERR_NONE : BT_ERR_INVALID_HANDLE;
+	}
+
+	return h;
 }
 BT_EXPORT_SYMBOL(BT_GetProcessFileDescriptor);
 
@@ -251,51 +492,117 @@ BT_HANDLE BT_GetFileDescriptor(BT_u32 i, BT_ERROR *pError) {
 }
 BT_EXPORT_SYMBOL(BT_GetFileDescriptor);
 
-static BT_s32 task_alloc_fd(struct bt_task *task) {
-	BT_s32 i;
-	BT_u32 mask = 0x80000000 >> task->free_fd;
+BT_s32 BT_AllocFileDescriptor() {
+	struct bt_task *task = BT_GetProcessTask(NULL);
+	return fdtable_alloc(&task->fdt, 0);
+}
+BT_EXPORT_SYMBOL(BT_AllocFileDescriptor);
 
-	for(i = task->free_fd; i < 8; i++) {
-		if(!(mask & task->flags)) {
-			task->flags |= mask;
-			task->free_fd = i;
-			return i;
-		}
+BT_ERROR BT_FreeFileDescriptor(BT_s32 fd) {
+	struct bt_task *task = BT_GetProcessTask(NULL);
+
+	if(fd < 0) {
+		return BT_ERR_GENERIC;
+	}
 
-		mask >>= 1;
+	BT_HANDLE h = fdtable_free(&task->fdt, fd);
+	if(h) {
+		BT_CloseHandle(h);
 	}
 
-	return BT_ERR_GENERIC;
+	return BT_ERR_NONE;
+}
+BT_EXPORT_SYMBOL(BT_FreeFileDescriptor);
+
+static void fdtable_set_flags(struct bt_fdtable *fdt, BT_u32 fd, BT_u32 ulFlags) {
+	if(ulFlags & BT_FD_CLOEXEC) {
+		__bt_set_bit(fd, fdt->cloexec);
+	} else {
+		__bt_clear_bit(fd, fdt->cloexec);
+	}
 }
 
-BT_s32 BT_AllocFileDescriptor() {
-	struct bt_task *task = BT_GetProcessTask(NULL);
-	return task_alloc_fd(task);
+BT_s32 BT_DupFileDescriptor(BT_u32 fd, BT_u32 ulMin, BT_u32 ulFlags) {
+	struct bt_fdtable *fdt = &BT_GetProcessTask(NULL)->fdt;
+
+	BT_HANDLE h = fdtable_get_ref(fdt, fd);
+	if(!h) {
+		return BT_ERR_INVALID_HANDLE;
+	}
+
+	BT_s32 newfd = fdtable_alloc(fdt, ulMin);
+	if(newfd >= 0) {
+		BT_SetFileDescriptor(newfd, h);
+
+		BT_kEnterCritical();
+		fdtable_set_flags(fdt, newfd, ulFlags);
+		BT_kExitCritical();
+	}
+
+	BT_CloseHandle(h);
+
+	return newfd;
 }
-BT_EXPORT_SYMBOL(BT_AllocFileDescriptor);
+BT_EXPORT_SYMBOL(BT_DupFileDescriptor);
 
-static BT_ERROR task_free_fd(struct bt_task *task, BT_s32 fd) {
-	if(fd < 0) {
-		return BT_ERR_GENERIC;
+BT_s32 BT_Dup2FileDescriptor(BT_u32 fd, BT_u32 newfd, BT_u32 ulFlags) {
+	struct bt_fdtable *fdt = &BT_GetProcessTask(NULL)->fdt;
+
+	if(newfd >= BT_CONFIG_PROCESS_MAX_FDS) {
+		return BT_ERR_INVALID_HANDLE;
+	}
+
+	BT_HANDLE h = fdtable_get_ref(fdt, fd);
+	if(!h) {
+		return BT_ERR_INVALID_HANDLE;
 	}
 
-	if(fd < 8) {
-		BT_u32 mask = 0x80000000 >> fd;
-		task->flags &= ~mask;
-		if(fd < task->free_fd) {
-			task->free_fd = fd;
+	BT_s32 ret = newfd;
+	if(fd != newfd) {	// Otherwise nothing changes, not even the flags.
+		BT_ERROR Error = BT_SetFileDescriptor(newfd, h);	// Closes what newfd held.
+		if(Error) {
+			ret = Error;
+		} else {
+			BT_kEnterCritical();
+			fdtable_set_flags(fdt, newfd, ulFlags);
+			BT_kExitCritical();
 		}
-		return BT_ERR_NONE;
 	}
 
-	return BT_ERR_GENERIC;
+	BT_CloseHandle(h);
+
+	return ret;
 }
+BT_EXPORT_SYMBOL(BT_Dup2FileDescriptor);
 
-BT_ERROR BT_FreeFileDescriptor(BT_s32 fd) {
-	struct bt_task *task = BT_GetProcessTask(NULL);
-	return task_free_fd(task, fd);
+BT_s32 BT_GetFileDescriptorFlags(BT_u32 fd) {
+	struct bt_fdtable *fdt = &BT_GetProcessTask(NULL)->fdt;
+	BT_s32 flags = BT_ERR_INVALID_HANDLE;
+
+	BT_kEnterCritical();
+	if(fd < fdt->ulMax && fdt->fds[fd]) {
+		flags = bt_test_bit(fd, fdt->cloexec) ? BT_FD_CLOEXEC : 0;
+	}
+	BT_kExitCritical();
+
+	return flags;
 }
-BT_EXPORT_SYMBOL(BT_FreeFileDescriptor);
+BT_EXPORT_SYMBOL(BT_GetFileDescriptorFlags);
+
+BT_ERROR BT_SetFileDescriptorFlags(BT_u32 fd, BT_u32 ulFlags) {
+	struct bt_fdtable *fdt = &BT_GetProcessTask(NULL)->fdt;
+	BT_ERROR Error = BT_ERR_INVALID_HANDLE;
+
+	BT_kEnterCritical();
+	if(fd < fdt->ulMax && fdt->fds[fd]) {
+		fdtable_set_flags(fdt, fd, ulFlags);
+		Error = BT_ERR_NONE;
+	}
+	BT_kExitCritical();
+
+	return Error;
+}
+BT_EXPORT_SYMBOL(BT_SetFileDescriptorFlags);
 
 static BT_ERROR bt_process_cleanup(BT_HANDLE hProcess) {
 
@@ -315,6 +622,7 @@ BT_ERROR bt_process_init() {
 	// Create the kernel process handle!
 	BT_LIST_INIT_HEAD(&process_handles);
 	memset(&kernel_handle, 0, sizeof(struct _BT_OPAQUE_HANDLE));
+	fdtable_init(&kernel_handle.task.fdt);
 	strncpy(kernel_handle.task.name, "kernel", BT_CONFIG_MAX_PROCESS_NAME);
 #ifdef BT_CONFIG_USE_VIRTUAL_ADDRESSING
 	kernel_handle.task.map = bt_vm_get_kernel_map();
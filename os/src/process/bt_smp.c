@@ -0,0 +1,137 @@
+/**
+ *	BT SMP Implementation.
+ *
+ *	Each secondary CPU is booted onto its own stack through the machine's BT_BootCore(),
+ *	sets up its interrupt controller interface and marks itself online. It then sleeps
+ *	in WFI, waking for the software interrupts other CPUs send it.
+ *
+ *	Calls are pushed onto a lock-free list per target CPU, followed by a BT_IPI_CALL
+ *	software interrupt. The caller's list node lives on its stack, it waits in WFE for
+ *	the target to mark it done.
+ **/
+
+#include <bitthunder.h>
+#include <process/bt_smp.h>
+#include <collections/bt_lifo.h>
+
+BT_DEF_MODULE_NAME	("SMP")
+
+struct smp_call {
+	struct bt_lifo_node	node;
+	BT_SMP_FUNCTION		pfnFunction;
+	void			   *pParam;
+	volatile BT_u32		ulDone;
+};
+
+static struct bt_lifo g_calls[BT_CONFIG_CPU_CORES];
+static volatile BT_u32 g_ulOnline = BT_CPU_MASK(0);
+
+extern void bt_secondary_reset(void);
+
+BT_u32 BT_GetOnlineCPUs() {
+	return __atomic_load_n(&g_ulOnline, __ATOMIC_ACQUIRE);
+}
+BT_EXPORT_SYMBOL(BT_GetOnlineCPUs);
+
+static BT_ERROR ipi_call_handler(BT_u32 ulIRQ, void *pParam) {
+	struct bt_lifo_node *n = bt_lifo_pop_all(&g_calls[BT_GetCoreID()]);
+
+	while(n) {
+		struct smp_call *pCall = bt_container_of(n, struct smp_call, node);
+		n = n->next;		// The caller may return as soon as the call is done.
+
+		pCall->pfnFunction(pCall->pParam);
+		__atomic_store_n(&pCall->ulDone, 1, __ATOMIC_RELEASE);
+	}
+
+	__asm volatile("dsb\n\tsev" ::: "memory");
+
+	return BT_ERR_NONE;
+}
+
+BT_ERROR BT_SMPCallFunction(BT_u32 ulCPU, BT_SMP_FUNCTION pfnFunction, void *pParam) {
+	if(ulCPU == BT_GetCoreID()) {
+		pfnFunction(pParam);
+		return BT_ERR_NONE;
+	}
+
+	if(ulCPU >= BT_CONFIG_CPU_CORES || !(BT_GetOnlineCPUs() & BT_CPU_MASK(ulCPU))) {
+		return BT_ERR_INVALID_VALUE;
+	}
+
+	struct smp_call oCall = {
+		.pfnFunction	= pfnFunction,
+		.pParam			= pParam,
+		.ulDone			= 0,
+	};
+
+	bt_lifo_push(&g_calls[ulCPU], &oCall.node);
+	BT_SendSoftwareInterrupt(BT_IPI_CALL, BT_CPU_MASK(ulCPU));
+
+	while(!__atomic_load_n(&oCall.ulDone, __ATOMIC_ACQUIRE)) {
+		__asm volatile("wfe" ::: "memory");
+	}
+
+	return BT_ERR_NONE;
+}
+BT_EXPORT_SYMBOL(BT_SMPCallFunction);
+
+/*
+ *	Called from bt_secondary_reset, on the CPU's own stack with IRQs masked.
+ */
+static void secondary_start(BT_u32 ulCPU) {
+	BT_InitInterruptCPU();
+
+	__atomic_fetch_or(&g_ulOnline, BT_CPU_MASK(ulCPU), __ATOMIC_RELEASE);
+	__asm volatile("dsb\n\tsev" ::: "memory");
+
+	__asm volatile("cpsie i" ::: "memory");
+
+	while(1) {
+		__asm volatile("wfi");
+	}
+}
+
+static BT_ERROR bt_smp_init() {
+	BT_u32 i, ulOnline = 1;
+
+	BT_ERROR Error = BT_RegisterInterrupt(BT_IPI_CALL, ipi_call_handler, NULL);
+	if(Error) {
+		return Error;
+	}
+
+	BT_EnableInterrupt(BT_IPI_CALL);
+
+	for(i = 1; i < BT_GetTotalCores() && i < BT_CONFIG_CPU_CORES; i++) {
+		BT_u8 *pStack = BT_kMalloc(BT_CONFIG_SMP_STACK);
+		if(!pStack) {
+			return BT_ERR_NO_MEMORY;
+		}
+
+		bt_register_t ulTop = ((bt_register_t) (pStack + BT_CONFIG_SMP_STACK)) & ~7;
+
+		Error = BT_BootCore(i, (void *) bt_secondary_reset, ulTop, i, (bt_register_t) secondary_start, 0);
+		if(!Error) {
+			BT_u32 ulWait = 100;
+			while(!(BT_GetOnlineCPUs() & BT_CPU_MASK(i)) && ulWait--) {
+				BT_ThreadSleep(1);
+			}
+		}
+
+		if(!(BT_GetOnlineCPUs() & BT_CPU_MASK(i))) {
+			BT_kPrint("SMP: CPU%lu did not come online.", i);
+			continue;		// Its stack is leaked, it may still be running on it.
+		}
+
+		ulOnline++;
+	}
+
+	BT_kPrint("SMP: %lu CPUs online.", ulOnline);
+
+	return BT_ERR_NONE;
+}
+
+BT_MODULE_INIT_DEF oModuleEntry = {
+	BT_MODULE_NAME,
+	bt_smp_init,
+};
@@ -52,7 +52,7 @@ static void threadStartup(void *pParam) {
 static const BT_IF_HANDLE oHandleInterface;
 
 static BT_ERROR thread_cleanup(BT_HANDLE hThread) {
-	bt_list_del(&hThread->h.item);
+	BT_DetachHandle(hThread->hProcess, hThread);	// Deleting the calling thread does not return.
 	BT_kTaskDelete(hThread->thread.pKThreadID);	// Schedule thread to be deleted completely.
 	return BT_ERR_NONE;
 }
@@ -82,7 +82,7 @@ BT_HANDLE BT_CreateProcessThread(BT_HANDLE hProcess, BT_FN_THREAD_ENTRY pfnStart
 
 	hThread->thread.pKThreadID = BT_kTaskCreate(threadStartup, NULL, &hThread->oConfig, &Error);
 	if(!hThread->thread.pKThreadID) {
-		BT_DetachHandle(hThread);
+		BT_DetachHandle(hProcess, hThread);
 		BT_DestroyHandle(hThread);
 		return NULL;
 	}
@@ -0,0 +1,146 @@
+/**
+ *	Measures the AMP message channel against an echo main on the remote core, e.g.:
+ *
+ *		ampbench 10000
+ *
+ *	The latency pass sends one message at a time and waits for it to come back. The
+ *	throughput pass keeps the ring to the remote core full, so that both cores run
+ *	without waiting for each other.
+ *
+ *	Not yet run on hardware or under QEMU (-smp 2), there are no reference figures.
+ **/
+#include <bitthunder.h>
+#include <process/bt_amp.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define AMPBENCH_ITERATIONS		10000
+#define AMPBENCH_TIMEOUT		1000
+
+static void echo_main(void *pParam) {
+	while(1) {
+		BT_u32 ulLength;
+		void *pIn = BT_AmpReceiveMessage(&ulLength, BT_INFINITE_TIMEOUT);
+		void *pOut;
+
+		while(!(pOut = BT_AmpAllocMessage())) {
+			;		// CPU0 is behind receiving our replies.
+		}
+
+		memcpy(pOut, pIn, ulLength);
+		BT_AmpReleaseMessage(pIn);
+		BT_AmpSendMessage(pOut, ulLength);
+	}
+}
+
+static BT_u64 to_ns(BT_u64 ticks) {
+	BT_u32 ulRate = BT_GetGlobalTimerRate();
+	return ulRate ? (ticks * 1000000000ULL) / ulRate : 0;
+}
+
+static int latency(BT_HANDLE hShell, BT_u32 ulIterations) {
+	BT_u64 min = ~0ULL, max = 0, total = 0;
+	BT_u32 i;
+
+	for(i = 0; i < ulIterations; i++) {
+		BT_u32 *pOut = BT_AmpAllocMessage();
+		if(!pOut) {
+			return -1;
+		}
+
+		BT_u64 start = BT_GetGlobalTimer();
+		*pOut = i;
+		BT_AmpSendMessage(pOut, sizeof(*pOut));
+
+		BT_u32 *pIn = BT_AmpReceiveMessage(NULL, AMPBENCH_TIMEOUT);
+		BT_u64 rtt = BT_GetGlobalTimer() - start;
+		if(!pIn || *pIn != i) {
+			BT_PRSHELL("Error: reply %d lost\n", i);
+			return -1;
+		}
+		BT_AmpReleaseMessage(pIn);
+
+		total += rtt;
+		if(rtt < min) {
+			min = rtt;
+		}
+		if(rtt > max) {
+			max = rtt;
+		}
+	}
+
+	BT_PRSHELL("round trip: %d ns min, %d ns avg, %d ns max\n", (BT_u32) to_ns(min), (BT_u32) to_ns(total / ulIterations), (BT_u32) to_ns(max));
+
+	return 0;
+}
+
+static int throughput(BT_HANDLE hShell, BT_u32 ulIterations) {
+	BT_u32 ulSize = BT_AmpMessageSize();
+	BT_u32 ulSent = 0, ulReceived = 0;
+
+	BT_u64 start = BT_GetGlobalTimer();
+	while(ulReceived < ulIterations) {
+		void *pOut;
+		while(ulSent < ulIterations && (pOut = BT_AmpAllocMessage())) {
+			BT_AmpSendMessage(pOut, ulSize);
+			ulSent++;
+		}
+
+		void *pIn = BT_AmpReceiveMessage(NULL, AMPBENCH_TIMEOUT);
+		if(!pIn) {
+			BT_PRSHELL("Error: %d of %d replies lost\n", ulIterations - ulReceived, ulIterations);
+			return -1;
+		}
+		BT_AmpReleaseMessage(pIn);
+		ulReceived++;
+	}
+	BT_u64 ns = to_ns(BT_GetGlobalTimer() - start);
+
+	if(!ns) {
+		return -1;
+	}
+
+	BT_u64 ullMessages = ((BT_u64) ulIterations * 1000000000ULL) / ns;
+	BT_PRSHELL("throughput: %d messages/s each way, %d KB/s at %d bytes\n", (BT_u32) ullMessages, (BT_u32) ((ullMessages * ulSize) / 1024), ulSize);
+
+	return 0;
+}
+
+static int bt_ampbench(BT_HANDLE hShell, int argc, char **argv) {
+
+	BT_u32 ulIterations = AMPBENCH_ITERATIONS;
+
+	if(argc > 2) {
+		BT_PRSHELL("Usage: %s [iterations]\n", argv[0]);
+		return -1;
+	}
+
+	if(argc == 2) {
+		ulIterations = strtoul(argv[1], NULL, 10);
+	}
+
+	if(!ulIterations) {
+		return -1;
+	}
+
+	BT_ERROR Error = BT_AmpStartRemote(echo_main, NULL);
+	if(Error == BT_ERR_BUSY) {
+		BT_PRSHELL("Assuming the remote core already runs the echo main\n");
+	} else if(Error) {
+		BT_PRSHELL("Error: the remote core did not start\n");
+		return -1;
+	}
+
+	BT_PRSHELL("%d iterations:\n", ulIterations);
+
+	if(latency(hShell, ulIterations)) {
+		return -1;
+	}
+
+	return throughput(hShell, ulIterations);
+}
+
+BT_SHELL_COMMAND_DEF oCommand = {
+	.szpName = "ampbench",
+	.pfnCommand = bt_ampbench,
+};
@@ -0,0 +1,117 @@
+/**
+ *	Measures the read/write bandwidth of a raw block device, and the bandwidth of
+ *	direct access through BT_BlockMap() for devices that support it.
+ **/
+#include <bitthunder.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int bt_blkbench(BT_HANDLE hShell, int argc, char **argv) {
+
+	BT_ERROR Error;
+	BT_BLOCK_GEOMETRY oGeometry;
+	BT_u32 ulChunk = 8;
+	BT_u32 i;
+	int retval = 0;
+
+	if(argc != 2 && argc != 3 && argc != 4) {
+		BT_PRSHELL("Usage: %s [block-device-path] [blocks-per-request] [-w]\n", argv[0]);
+		BT_PRSHELL("    +- E.g. %s /dev/rd0 64\n", argv[0]);
+		BT_PRSHELL("    +- -w also measures writes, destroying the device contents.\n");
+		return -1;
+	}
+
+	if(argc >= 3) {
+		ulChunk = strtoul(argv[2], NULL, 10);
+		if(!ulChunk) {
+			ulChunk = 1;
+		}
+	}
+
+	BT_HANDLE hBlock = BT_Open(argv[1], 0, &Error);
+	if(!hBlock) {
+		BT_PRSHELL("Error: Could not open %s\n", argv[1]);
+		return -1;
+	}
+
+	if(BT_GetBlockGeometry(hBlock, &oGeometry) != BT_ERR_NONE) {
+		BT_PRSHELL("Error: %s is not a RAW block device\n", argv[1]);
+		retval = -1;
+		goto close_out;
+	}
+
+	if(ulChunk > oGeometry.ulTotalBlocks) {
+		ulChunk = oGeometry.ulTotalBlocks;
+	}
+
+	BT_u32 ulRequests = oGeometry.ulTotalBlocks / ulChunk;
+	BT_u64 bytes = (BT_u64) ulRequests * ulChunk * oGeometry.ulBlockSize;
+
+	BT_u8 *buffer = BT_kMalloc(ulChunk * oGeometry.ulBlockSize);
+	if(!buffer) {
+		BT_PRSHELL("Error: Could not allocate a %d byte buffer\n", ulChunk * oGeometry.ulBlockSize);
+		retval = -1;
+		goto close_out;
+	}
+
+	BT_PRSHELL("%s: %d blocks of %d bytes, %d blocks per request\n", argv[1], oGeometry.ulTotalBlocks, oGeometry.ulBlockSize, ulChunk);
+
+	BT_u64 start = BT_GetGlobalTimer();
+	for(i = 0; i < ulRequests; i++) {
+		if(BT_BlockRead(hBlock, i * ulChunk, ulChunk, buffer) != ulChunk) {
+			BT_PRSHELL("Error: read failed at block %d\n", i * ulChunk);
+			retval = -1;
+			goto free_out;
+		}
+	}
+	BT_PRSHELL("read : %d KB/s\n", BT_GlobalTimerKBps(bytes, BT_GetGlobalTimer() - start));
+
+	if(argc == 4 && !strcmp(argv[3], "-w")) {
+		start = BT_GetGlobalTimer();
+		for(i = 0; i < ulRequests; i++) {
+			if(BT_BlockWrite(hBlock, i * ulChunk, ulChunk, buffer) != ulChunk) {
+				BT_PRSHELL("Error: write failed at block %d\n", i * ulChunk);
+				retval = -1;
+				goto free_out;
+			}
+		}
+		BT_PRSHELL("write: %d KB/s\n", BT_GlobalTimerKBps(bytes, BT_GetGlobalTimer() - start));
+	}
+
+	/*
+	 *	Direct access, every word of the device is touched so that the figure is
+	 *	comparable with the copying read above.
+	 */
+	if(BT_BlockMap(hBlock, 0, 1, &Error)) {
+		volatile BT_u32 sum = 0;
+		start = BT_GetGlobalTimer();
+		for(i = 0; i < ulRequests; i++) {
+			const BT_u32 *p = BT_BlockMap(hBlock, i * ulChunk, ulChunk, &Error);
+			if(!p) {
+				BT_PRSHELL("Error: map failed at block %d (%d)\n", i * ulChunk, Error);
+				retval = -1;
+				goto free_out;
+			}
+			BT_u32 words = (ulChunk * oGeometry.ulBlockSize) / sizeof(BT_u32);
+			while(words--) {
+				sum += *p++;
+			}
+		}
+		BT_PRSHELL("map  : %d KB/s\n", BT_GlobalTimerKBps(bytes, BT_GetGlobalTimer() - start));
+	} else {
+		BT_PRSHELL("map  : not supported by %s\n", argv[1]);
+	}
+
+free_out:
+	BT_kFree(buffer);
+
+close_out:
+	BT_CloseHandle(hBlock);
+
+	return retval;
+}
+
+BT_SHELL_COMMAND_DEF oCommand = {
+	.szpName = "blkbench",
+	.pfnCommand = bt_blkbench,
+};
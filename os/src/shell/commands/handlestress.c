@@ -0,0 +1,176 @@
+/**
+ *	Opens and closes handles from several threads at once, then checks that no
+ *	reference or handle was lost, e.g.:
+ *
+ *		handlestress 4 10000
+ *
+ *	Each thread creates and closes handles of its own, takes and drops references on
+ *	a handle shared by all of them, and duplicates and frees a descriptor of it. The
+ *	threads run at the same priority and yield, so that these interleave.
+ **/
+#include <bitthunder.h>
+#include <stdlib.h>
+
+#define HANDLESTRESS_THREADS		4
+#define HANDLESTRESS_MAX_THREADS	16
+#define HANDLESTRESS_ITERATIONS		10000
+#define HANDLESTRESS_PRIORITY		1
+
+struct _BT_OPAQUE_HANDLE {
+	BT_HANDLE_HEADER	h;
+};
+
+struct handlestress_peer {
+	BT_HANDLE			hShared;
+	BT_u32				fdShared;
+	BT_u32				ulIterations;
+	BT_u32				ulCreated;
+	BT_u32				ulErrors;
+	volatile BT_BOOL	bDone;
+};
+
+static volatile BT_u32 g_ulCleaned;
+
+static BT_ERROR stress_cleanup(BT_HANDLE h) {
+	BT_kEnterCritical();
+	g_ulCleaned++;
+	BT_kExitCritical();
+	return BT_ERR_NONE;
+}
+
+static const BT_IF_HANDLE oHandleInterface = {
+	.eType 		= BT_HANDLE_T_SYSTEM,
+	.pfnCleanup = stress_cleanup,
+};
+
+static BT_ERROR peer(BT_HANDLE hThread, void *pParam) {
+	struct handlestress_peer *peer = (struct handlestress_peer *) pParam;
+	BT_ERROR Error;
+	BT_u32 i;
+
+	for(i = 0; i < peer->ulIterations; i++) {
+		BT_HANDLE h = BT_CreateHandle(&oHandleInterface, sizeof(struct _BT_OPAQUE_HANDLE), &Error);
+		if(h) {
+			peer->ulCreated++;
+			BT_CloseHandle(h);
+		} else {
+			peer->ulErrors++;
+		}
+
+		BT_RefHandle(peer->hShared);
+		BT_CloseHandle(peer->hShared);
+
+		BT_s32 fd = BT_DupFileDescriptor(peer->fdShared, 0, 0);
+		if(fd >= 0) {
+			BT_FreeFileDescriptor(fd);
+		} else {
+			peer->ulErrors++;
+		}
+
+		if(!(i & 7)) {
+			BT_ThreadYield();
+		}
+	}
+
+	peer->bDone = BT_TRUE;
+
+	return BT_ERR_NONE;
+}
+
+static int bt_handlestress(BT_HANDLE hShell, int argc, char **argv) {
+
+	struct handlestress_peer oPeers[HANDLESTRESS_MAX_THREADS];
+	BT_u32 ulThreads = HANDLESTRESS_THREADS;
+	BT_u32 ulIterations = HANDLESTRESS_ITERATIONS;
+	BT_ERROR Error;
+	BT_u32 i, n;
+
+	if(argc > 3) {
+		BT_PRSHELL("Usage: %s [threads] [iterations]\n", argv[0]);
+		return -1;
+	}
+
+	if(argc > 1) {
+		ulThreads = strtoul(argv[1], NULL, 10);
+	}
+
+	if(argc > 2) {
+		ulIterations = strtoul(argv[2], NULL, 10);
+	}
+
+	if(!ulThreads || ulThreads > HANDLESTRESS_MAX_THREADS || !ulIterations) {
+		BT_PRSHELL("Error: 1 to %d threads, and at least 1 iteration\n", HANDLESTRESS_MAX_THREADS);
+		return -1;
+	}
+
+	g_ulCleaned = 0;
+
+	BT_HANDLE hShared = BT_CreateHandle(&oHandleInterface, sizeof(struct _BT_OPAQUE_HANDLE), &Error);
+	BT_s32 fdShared = BT_AllocFileDescriptor();
+	if(!hShared || fdShared < 0) {
+		BT_PRSHELL("Error: No memory\n");
+		if(fdShared >= 0) {
+			BT_FreeFileDescriptor(fdShared);
+		}
+		if(hShared) {
+			BT_CloseHandle(hShared);
+		}
+		return -1;
+	}
+
+	BT_SetFileDescriptor(fdShared, hShared);
+	BT_CloseHandle(hShared);	// The descriptor holds its own reference.
+
+	BT_THREAD_CONFIG oThreadConfig = {
+		.ulStackDepth 	= 256,
+		.ulPriority		= HANDLESTRESS_PRIORITY,
+	};
+
+	BT_u64 start = BT_GetGlobalTimer();
+	for(n = 0; n < ulThreads; n++) {
+		oPeers[n].hShared = hShared;
+		oPeers[n].fdShared = fdShared;
+		oPeers[n].ulIterations = ulIterations;
+		oPeers[n].ulCreated = 0;
+		oPeers[n].ulErrors = 0;
+		oPeers[n].bDone = BT_FALSE;
+		oThreadConfig.pParam = &oPeers[n];
+		if(!BT_CreateThread(peer, &oThreadConfig, &Error)) {
+			break;
+		}
+	}
+
+	BT_u32 ulCreated = 0, ulErrors = 0;
+	for(i = 0; i < n; i++) {
+		while(!oPeers[i].bDone) {
+			BT_ThreadSleep(1);
+		}
+		ulCreated += oPeers[i].ulCreated;
+		ulErrors += oPeers[i].ulErrors;
+	}
+	BT_u64 ticks = BT_GetGlobalTimer() - start;
+
+	BT_u32 ulRefs = hShared->h.ulReferenceCount;
+	BT_u32 ulCleaned = g_ulCleaned;
+
+	BT_FreeFileDescriptor(fdShared);
+
+	BT_u32 ulRate = BT_GetGlobalTimerRate();
+	BT_PRSHELL("%d threads, %d iterations: %d ms\n", n, ulIterations, ulRate ? (BT_u32) ((ticks * 1000) / ulRate) : 0);
+	BT_PRSHELL("handles created %d, cleaned up %d\n", ulCreated, ulCleaned);
+	BT_PRSHELL("shared handle references %d, expected 1\n", ulRefs);
+
+	if(n < ulThreads || ulErrors || ulCleaned != ulCreated || ulRefs != 1 || g_ulCleaned != ulCreated + 1) {
+		BT_PRSHELL("FAILED (%d threads started, %d errors)\n", n, ulErrors);
+		return -1;
+	}
+
+	BT_PRSHELL("OK\n");
+
+	return 0;
+}
+
+BT_SHELL_COMMAND_DEF oCommand = {
+	.szpName = "handlestress",
+	.pfnCommand = bt_handlestress,
+};
@@ -7,6 +7,42 @@
 #include <stdlib.h>
 #include <string.h>
 
+/*
+ *	ifconfig -s samples the receive counters of every interface over one second.
+ */
+static int ifconfig_rates(BT_HANDLE hStdout) {
+	BT_u32 i;
+	BT_u32 total_interfaces = BT_GetTotalNetworkInterfaces();
+
+	struct bt_netif_rx_stats *before = BT_kMalloc(sizeof(*before) * (total_interfaces + 1));
+	if(!before) {
+		return -1;
+	}
+
+	for(i = 0; i < total_interfaces; i++) {
+		BT_NetifGetRxStats(BT_GetNetifByIndex(i), &before[i]);
+	}
+
+	BT_ThreadSleep(1000);
+
+	for(i = 0; i < total_interfaces; i++) {
+		BT_NET_IF *netif = BT_GetNetifByIndex(i);
+		struct bt_netif_rx_stats after;
+		BT_NetifGetRxStats(netif, &after);
+
+		BT_u32 polls = after.ulPolls - before[i].ulPolls;
+		BT_u32 frames = after.ulFrames - before[i].ulFrames;
+
+		bt_fprintf(hStdout, "%-5s  RX frames/s:%d  interrupts/s:%d  polls/s:%d  frames/poll:%d  ring full/s:%d\n", netif->name,
+				   frames, after.ulInterrupts - before[i].ulInterrupts, polls, polls ? frames / polls : 0,
+				   after.ulRingFull - before[i].ulRingFull);
+	}
+
+	BT_kFree(before);
+
+	return 0;
+}
+
 static int bt_ifconfig(BT_HANDLE hShell, int argc, char **argv) {
 
 	BT_HANDLE hStdout = BT_ShellGetStdout(hShell);
@@ -14,6 +50,10 @@ static int bt_ifconfig(BT_HANDLE hShell, int argc, char **argv) {
 	BT_u32 i;
 	BT_u32 total_interfaces = BT_GetTotalNetworkInterfaces();
 
+	if(argc == 2 && !strcmp(argv[1], "-s")) {
+		return ifconfig_rates(hStdout);
+	}
+
 	for(i = 0; i < total_interfaces; i++) {
 		BT_NET_IF *netif = BT_GetNetifByIndex(i);
 		if(!netif) {
@@ -44,6 +84,13 @@ static int bt_ifconfig(BT_HANDLE hShell, int argc, char **argv) {
 		bt_fprintf(hStdout, "       %s\n", linkup);
 		bt_fprintf(hStdout, "       MAC Type: %s\n", netif->device_name);
 
+		struct bt_netif_rx_stats stats;
+		BT_NetifGetRxStats(netif, &stats);
+
+		bt_fprintf(hStdout, "       RX frames:%d  interrupts:%d  polls:%d  frames/poll:%d  over budget:%d  ring full:%d  queue full:%d\n",
+				   stats.ulFrames, stats.ulInterrupts, stats.ulPolls, stats.ulPolls ? stats.ulFrames / stats.ulPolls : 0,
+				   stats.ulBudgetExhausted, stats.ulRingFull, stats.ulQueueFull);
+
 	}
 
 	return 0;
@@ -0,0 +1,37 @@
+/**
+ *	Prints the statistics of each threaded interrupt (CONFIG_INTERRUPTS_THREADED).
+ *
+ *	LATENCY is the longest time from the hard handler waking the thread to the
+ *	thread handler starting, RUN the longest thread handler run.
+ **/
+#include <bitthunder.h>
+
+#define IRQSTAT_MAX		64
+
+static int bt_irqstat(BT_HANDLE hShell, int argc, char **argv) {
+
+	struct bt_irq_thread_stats *pStats = BT_kMalloc(sizeof(*pStats) * IRQSTAT_MAX);
+	if(!pStats) {
+		return -1;
+	}
+
+	BT_u32 i, n = BT_GetThreadedInterruptStats(pStats, IRQSTAT_MAX);
+
+	BT_PRSHELL(" IRQ  PRIO     WAKEUPS        RUNS  LATENCY(us)  RUN(us)  LABEL\n");
+	for(i = 0; i < n; i++) {
+		struct bt_irq_thread_stats *s = &pStats[i];
+		const BT_i8 *label = BT_GetInterruptLabel(s->ulIRQ);
+
+		BT_PRSHELL("%4d  %4d  %10d  %10d  %11d  %7d  %s\n", s->ulIRQ, s->ulPriority, s->ulWakeups, s->ulRuns,
+				   s->ulWorstLatencyUs, s->ulWorstRunUs, label ? label : "");
+	}
+
+	BT_kFree(pStats);
+
+	return 0;
+}
+
+BT_SHELL_COMMAND_DEF oCommand = {
+	.szpName = "irqstat",
+	.pfnCommand = bt_irqstat,
+};
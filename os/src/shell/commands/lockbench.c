@@ -0,0 +1,179 @@
+/**
+ *	Compares the cost of the kernel mutex, the kernel semaphore and the lightweight
+ *	bt_lock, in CPU cycles per acquire/release pair, e.g.:
+ *
+ *		lockbench 100000
+ *
+ *	The uncontended pass acquires and releases from the shell thread only. The
+ *	contended pass runs two threads at the same priority, both yielding while they
+ *	hold the lock, so every acquisition has to wait for a hand over.
+ **/
+#include <bitthunder.h>
+#include <stdlib.h>
+
+#define LOCKBENCH_ITERATIONS	100000
+#define LOCKBENCH_CONTENDED		1000
+#define LOCKBENCH_PRIORITY		1
+
+struct lockbench_lock {
+	const char *name;
+	void	  (*pfnLock)	(void *p);
+	void	  (*pfnUnlock)	(void *p);
+	void	   *p;
+};
+
+struct lockbench_peer {
+	struct lockbench_lock  *lock;
+	BT_u32					ulIterations;
+	BT_u64					end;
+	volatile BT_BOOL		bDone;
+};
+
+static void kmutex_lock(void *p) {
+	BT_kMutexPend(p, BT_INFINITE_TIMEOUT);
+}
+
+static void kmutex_unlock(void *p) {
+	BT_kMutexRelease(p);
+}
+
+static void lock_lock(void *p) {
+	bt_lock((struct bt_lock *) p);
+}
+
+static void lock_unlock(void *p) {
+	bt_unlock((struct bt_lock *) p);
+}
+
+static void run(struct lockbench_lock *lock, BT_u32 ulIterations, BT_BOOL bYield) {
+	BT_u32 i;
+	for(i = 0; i < ulIterations; i++) {
+		lock->pfnLock(lock->p);
+		if(bYield) {
+			BT_ThreadYield();
+		}
+		lock->pfnUnlock(lock->p);
+	}
+}
+
+static BT_ERROR peer(BT_HANDLE hThread, void *pParam) {
+	struct lockbench_peer *peer = (struct lockbench_peer *) pParam;
+
+	run(peer->lock, peer->ulIterations, BT_TRUE);
+	peer->end = BT_GetGlobalTimer();
+	peer->bDone = BT_TRUE;
+
+	return BT_ERR_NONE;
+}
+
+/*
+ *	Global timer ticks to CPU cycles, per acquire/release pair.
+ */
+static BT_u32 cycles(BT_u64 ticks, BT_u32 ulPairs) {
+	BT_u64 rate = (BT_u64) BT_GetGlobalTimerRate() * ulPairs;
+	return rate ? (BT_u32) ((ticks * BT_GetCpuClockFrequency()) / rate) : 0;
+}
+
+static void bench(BT_HANDLE hShell, struct lockbench_lock *lock, BT_u32 ulIterations) {
+	struct lockbench_peer oPeers[2];
+	BT_ERROR Error;
+	BT_u32 i, n;
+
+	BT_u64 start = BT_GetGlobalTimer();
+	run(lock, ulIterations, BT_FALSE);
+	BT_u32 uncontended = cycles(BT_GetGlobalTimer() - start, ulIterations);
+
+	BT_THREAD_CONFIG oThreadConfig = {
+		.ulStackDepth 	= 256,
+		.ulPriority		= LOCKBENCH_PRIORITY,
+	};
+
+	start = BT_GetGlobalTimer();
+	for(n = 0; n < 2; n++) {
+		oPeers[n].lock = lock;
+		oPeers[n].ulIterations = LOCKBENCH_CONTENDED;
+		oPeers[n].bDone = BT_FALSE;
+		oThreadConfig.pParam = &oPeers[n];
+		if(!BT_CreateThread(peer, &oThreadConfig, &Error)) {
+			break;
+		}
+	}
+
+	BT_u64 end = start;
+	for(i = 0; i < n; i++) {
+		while(!oPeers[i].bDone) {
+			BT_ThreadSleep(1);
+		}
+		if(oPeers[i].end > end) {
+			end = oPeers[i].end;
+		}
+	}
+
+	if(n < 2) {
+		BT_PRSHELL("%-10s: %6d cycles\n", lock->name, uncontended);
+		return;
+	}
+
+	BT_PRSHELL("%-10s: %6d cycles, %8d contended\n", lock->name, uncontended, cycles(end - start, LOCKBENCH_CONTENDED * 2));
+}
+
+static int bt_lockbench(BT_HANDLE hShell, int argc, char **argv) {
+
+	BT_u32 ulIterations = LOCKBENCH_ITERATIONS;
+	int retval = -1;
+	struct bt_lock oLock = { BT_LOCK_FREE, NULL };
+
+	if(argc > 2) {
+		BT_PRSHELL("Usage: %s [iterations]\n", argv[0]);
+		return -1;
+	}
+
+	if(argc == 2) {
+		ulIterations = strtoul(argv[1], NULL, 10);
+	}
+
+	if(!ulIterations) {
+		return -1;
+	}
+
+	void *pMutex = BT_kMutexCreate();
+	void *pSemaphore = BT_kSemaphoreCreate();
+
+	if(!pMutex || !pSemaphore || bt_lock_init(&oLock)) {
+		BT_PRSHELL("Error: No memory\n");
+		goto out;
+	}
+
+	struct lockbench_lock locks[] = {
+		{ "kmutex",		kmutex_lock,	kmutex_unlock,	pMutex 		},
+		{ "ksemaphore",	kmutex_lock,	kmutex_unlock,	pSemaphore	},
+		{ "bt_lock",	lock_lock,		lock_unlock,	&oLock		},
+	};
+
+	BT_PRSHELL("%d iterations, per acquire/release pair:\n", ulIterations);
+
+	BT_u32 i;
+	for(i = 0; i < sizeof(locks) / sizeof(locks[0]); i++) {
+		bench(hShell, &locks[i], ulIterations);
+	}
+
+	retval = 0;
+
+out:
+	bt_lock_destroy(&oLock);
+
+	if(pSemaphore) {
+		BT_kMutexDestroy(pSemaphore);
+	}
+
+	if(pMutex) {
+		BT_kMutexDestroy(pMutex);
+	}
+
+	return retval;
+}
+
+BT_SHELL_COMMAND_DEF oCommand = {
+	.szpName = "lockbench",
+	.pfnCommand = bt_lockbench,
+};
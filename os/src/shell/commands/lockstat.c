@@ -0,0 +1,45 @@
+/**
+ *	Prints the contention of each kernel mutex (CONFIG_KERNEL_MUTEX_STATS).
+ *
+ *	Mutexes are identified by the address of the code that created them. "lockstat
+ *	reset" clears the counters, to measure one workload at a time.
+ **/
+#include <bitthunder.h>
+#include <string.h>
+
+#define LOCKSTAT_MAX	64
+
+static int bt_lockstat(BT_HANDLE hShell, int argc, char **argv) {
+
+	if(argc == 2 && !strcmp(argv[1], "reset")) {
+		BT_kMutexResetStats();
+		return 0;
+	}
+
+	struct bt_kmutex_stats *pStats = BT_kMalloc(sizeof(*pStats) * LOCKSTAT_MAX);
+	if(!pStats) {
+		return -1;
+	}
+
+	BT_u32 i, n = BT_kMutexGetStats(pStats, LOCKSTAT_MAX);
+
+	BT_PRSHELL("MUTEX       CREATOR      ACQUIRED  CONTENDED  WORST(us)\n");
+	for(i = 0; i < n; i++) {
+		struct bt_kmutex_stats *m = &pStats[i];
+		if(!m->ulAcquired) {
+			continue;
+		}
+
+		BT_PRSHELL("%08x%s  %08x  %10d %10d %10d\n", (BT_u32) m->pMutex, m->bRecursive ? "r" : " ",
+				   (BT_u32) m->pCreator, m->ulAcquired, m->ulContended, m->ulWorstBlockedUs);
+	}
+
+	BT_kFree(pStats);
+
+	return 0;
+}
+
+BT_SHELL_COMMAND_DEF oCommand = {
+	.szpName = "lockstat",
+	.pfnCommand = bt_lockstat,
+};
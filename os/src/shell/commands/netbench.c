@@ -0,0 +1,320 @@
+/**
+ *	Benchmarks the network stack over a frame reflector interface (CONFIG_DRIVERS_NET_REFLECTOR).
+ *
+ *	Traffic is sent to a peer address on the reflector's subnet and comes back to this
+ *	stack, so TCP throughput, UDP round trip latency and UDP packets per second are
+ *	measured without a link partner, e.g.:
+ *
+ *		netbench e1 1048576
+ *
+ *	Each test also reports the bytes copied by the netif glue per payload byte and
+ *	the stack's buffer allocations per frame received. Copies made by the socket API
+ *	itself, one on send and one on receive, are not included.
+ *
+ *	Sender and receiver run in the same stack and on the same CPU, so throughput is
+ *	lower than what one end of a real link would see. os/src/net/test/netperf.c runs
+ *	the same tests on the host, between two stacks.
+ **/
+#include <bitthunder.h>
+#include <sys/socket.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NETBENCH_TCP_PORT		5002
+#define NETBENCH_UDP_PORT		5003
+#define NETBENCH_BUFFER_SIZE	4096
+#define NETBENCH_UDP_SIZE		64
+#define NETBENCH_UDP_BURST		8		// Stays within the socket's receive mailbox.
+#define NETBENCH_UDP_COUNT		10000
+#define NETBENCH_TIMEOUT		1000
+
+struct netbench_sample {
+	BT_u64	ticks;
+	BT_u32	ulCopied;
+	BT_u32	ulFrames;
+	BT_u32	ulAllocations;
+};
+
+struct netbench_sink {
+	int				listener;
+	BT_u8		   *buffer;
+	volatile BT_u32	ulReceived;
+	volatile BT_BOOL bDone;
+};
+
+static void sample(BT_NET_IF *netif, struct netbench_sample *s) {
+	struct bt_netif_rx_stats stats;
+	BT_NetifGetRxStats(netif, &stats);
+
+	s->ticks = BT_GetGlobalTimer();
+	s->ulCopied = netif->ulBytesCopied;
+	s->ulFrames = stats.ulFrames;
+	s->ulAllocations = BT_NetGetAllocations();
+}
+
+/*
+ *	Prints the counters accumulated since start, ratios with two decimals.
+ */
+static void report(BT_HANDLE hShell, BT_NET_IF *netif, const char *name, struct netbench_sample *start, BT_u32 ulPayload) {
+	struct netbench_sample end;
+	sample(netif, &end);
+
+	BT_u32 ulFrames = end.ulFrames - start->ulFrames;
+	BT_u32 copies = ulPayload ? (BT_u32) (((BT_u64) (end.ulCopied - start->ulCopied) * 100) / ulPayload) : 0;
+	BT_u32 allocs = ulFrames ? ((end.ulAllocations - start->ulAllocations) * 100) / ulFrames : 0;
+
+	BT_PRSHELL("%-8s: %d frames, copies/byte %d.%02d, allocations/frame %d.%02d\n", name, ulFrames,
+			   copies / 100, copies % 100, allocs / 100, allocs % 100);
+}
+
+static BT_u32 elapsed_us(struct netbench_sample *start) {
+	return (BT_u32) (((BT_GetGlobalTimer() - start->ticks) * 1000000) / BT_GetGlobalTimerRate());
+}
+
+static BT_ERROR tcp_sink(BT_HANDLE hThread, void *pParam) {
+	struct netbench_sink *sink = (struct netbench_sink *) pParam;
+
+	int s = accept(sink->listener, NULL, NULL);
+	if(s) {
+		int n;
+		while((n = recv(s, sink->buffer, NETBENCH_BUFFER_SIZE, 0)) > 0) {
+			sink->ulReceived += n;
+		}
+		closesocket(s);
+	}
+
+	sink->bDone = BT_TRUE;
+
+	return BT_ERR_NONE;
+}
+
+static int bench_tcp(BT_HANDLE hShell, BT_NET_IF *netif, struct sockaddr_in *peer, BT_u32 ulBytes, BT_u8 *buffer) {
+	struct netbench_sink sink;
+	struct netbench_sample start;
+	struct sockaddr_in sad;
+	BT_ERROR Error;
+	int retval = -1;
+
+	memset(&sink, 0, sizeof(sink));
+	sink.buffer = buffer + NETBENCH_BUFFER_SIZE;
+
+	sink.listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if(!sink.listener) {
+		return -1;
+	}
+
+	memset(&sad, 0, sizeof(sad));
+	sad.sin_family = AF_INET;
+	sad.sin_port = htons(NETBENCH_TCP_PORT);
+	sad.sin_addr.s_addr = INADDR_ANY;
+
+	if(bind(sink.listener, (struct sockaddr *) &sad, sizeof(sad)) || listen(sink.listener, 1)) {
+		BT_PRSHELL("Error: Could not listen on port %d\n", NETBENCH_TCP_PORT);
+		goto listener_out;
+	}
+
+	int s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if(!s) {
+		goto listener_out;
+	}
+
+	sample(netif, &start);
+
+	if(connect(s, (struct sockaddr *) peer, sizeof(*peer))) {
+		BT_PRSHELL("Error: Could not connect through the reflector\n");
+		closesocket(s);
+		goto listener_out;
+	}
+
+	/*
+	 *	The connection waits in the listener's backlog, so the sink never blocks in
+	 *	accept() on a listener that is closed under it.
+	 */
+	BT_THREAD_CONFIG oThreadConfig = {
+		.ulStackDepth 	= 512,
+		.ulPriority		= 0,
+		.pParam			= &sink,
+	};
+
+	if(!BT_CreateThread(tcp_sink, &oThreadConfig, &Error)) {
+		closesocket(s);
+		goto listener_out;
+	}
+
+	BT_u32 ulSent = 0;
+	while(ulSent < ulBytes) {
+		BT_u32 ulSize = ulBytes - ulSent;
+		if(ulSize > NETBENCH_BUFFER_SIZE) {
+			ulSize = NETBENCH_BUFFER_SIZE;
+		}
+
+		if(send(s, buffer, ulSize, 0) != (int) ulSize) {
+			break;
+		}
+
+		ulSent += ulSize;
+	}
+
+	closesocket(s);
+
+	while(!sink.bDone) {
+		BT_ThreadSleep(1);
+	}
+
+	BT_u32 us = elapsed_us(&start);
+
+	BT_PRSHELL("tcp     : %d bytes in %d us, %d KB/s\n", sink.ulReceived, us, us ? (BT_u32) (((BT_u64) sink.ulReceived * 1000000) / ((BT_u64) us * 1024)) : 0);
+	report(hShell, netif, "tcp", &start, sink.ulReceived);
+
+	if(sink.ulReceived == ulBytes) {
+		retval = 0;
+	}
+
+listener_out:
+	closesocket(sink.listener);
+
+	return retval;
+}
+
+static int bench_udp(BT_HANDLE hShell, BT_NET_IF *netif, struct sockaddr_in *peer, BT_u32 ulCount, BT_u8 *buffer) {
+	struct netbench_sample start;
+	struct sockaddr_in sad;
+	BT_u32 ulReceived = 0;
+	BT_u32 i, n;
+	int retval = -1;
+
+	int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if(!s) {
+		return -1;
+	}
+
+	memset(&sad, 0, sizeof(sad));
+	sad.sin_family = AF_INET;
+	sad.sin_port = htons(NETBENCH_UDP_PORT);
+	sad.sin_addr.s_addr = INADDR_ANY;
+
+	if(bind(s, (struct sockaddr *) &sad, sizeof(sad))) {
+		BT_PRSHELL("Error: Could not bind port %d\n", NETBENCH_UDP_PORT);
+		goto socket_out;
+	}
+
+	int timeout = NETBENCH_TIMEOUT;
+	setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	/*
+	 *	Latency, one datagram in flight.
+	 */
+	sample(netif, &start);
+	for(i = 0; i < ulCount / NETBENCH_UDP_BURST; i++) {
+		sendto(s, buffer, NETBENCH_UDP_SIZE, 0, (struct sockaddr *) peer, sizeof(*peer));
+		if(recv(s, buffer, NETBENCH_UDP_SIZE, 0) != NETBENCH_UDP_SIZE) {
+			BT_PRSHELL("Error: Datagram lost\n");
+			goto socket_out;
+		}
+	}
+
+	BT_u32 us = elapsed_us(&start);
+	BT_PRSHELL("udp rtt : %d round trips, %d.%02d us each\n", i, i ? us / i : 0, i ? ((us % i) * 100) / i : 0);
+	report(hShell, netif, "udp rtt", &start, i * NETBENCH_UDP_SIZE);
+
+	/*
+	 *	Packet rate, bursts of datagrams.
+	 */
+	sample(netif, &start);
+	for(i = 0; i < ulCount; i += NETBENCH_UDP_BURST) {
+		for(n = 0; n < NETBENCH_UDP_BURST; n++) {
+			sendto(s, buffer, NETBENCH_UDP_SIZE, 0, (struct sockaddr *) peer, sizeof(*peer));
+		}
+		for(n = 0; n < NETBENCH_UDP_BURST; n++) {
+			if(recv(s, buffer, NETBENCH_UDP_SIZE, 0) != NETBENCH_UDP_SIZE) {
+				break;
+			}
+			ulReceived++;
+		}
+	}
+
+	us = elapsed_us(&start);
+	BT_PRSHELL("udp pps : %d of %d datagrams, %d packets/s\n", ulReceived, i, us ? (BT_u32) (((BT_u64) ulReceived * 1000000) / us) : 0);
+	report(hShell, netif, "udp pps", &start, ulReceived * NETBENCH_UDP_SIZE);
+
+	retval = 0;
+
+socket_out:
+	closesocket(s);
+
+	return retval;
+}
+
+static int bt_netbench(BT_HANDLE hShell, int argc, char **argv) {
+
+	BT_ERROR Error;
+	BT_IPADDRESS ip, netmask, gw;
+	BT_u32 ulBytes = 1024 * 1024;
+	int retval = 0;
+
+	if(argc != 2 && argc != 3) {
+		BT_PRSHELL("Usage: %s [reflector-interface] [tcp-bytes]\n", argv[0]);
+		BT_PRSHELL("    +- Interfaces without an address are given 10.99.0.1/24.\n");
+		return -1;
+	}
+
+	if(argc == 3) {
+		ulBytes = strtoul(argv[2], NULL, 10);
+	}
+
+	BT_NET_IF *netif = BT_GetNetif(argv[1], &Error);
+	if(!netif) {
+		BT_PRSHELL("Error: No interface %s\n", argv[1]);
+		return -1;
+	}
+
+	BT_NetifGetAddress(netif, &ip, &netmask, &gw);
+	if(!ip.ulIPAddress) {
+		ip.ulIPAddress = htonl(0x0A630001);
+		netmask.ulIPAddress = htonl(0xFFFFFF00);
+		gw.ulIPAddress = 0;
+		BT_NetifSetAddress(netif, &ip, &netmask, &gw);
+		BT_StartNetif(netif);
+	}
+
+	/*
+	 *	Any other host address on the subnet, the reflector answers for all of them.
+	 */
+	BT_u32 host = ntohl(ip.ulIPAddress);
+	BT_u32 mask = ntohl(netmask.ulIPAddress);
+	BT_u32 peer_host = host + 1;
+	if((peer_host & ~mask) == ~mask || !(peer_host & ~mask)) {
+		peer_host = host - 1;
+	}
+
+	struct sockaddr_in peer;
+	memset(&peer, 0, sizeof(peer));
+	peer.sin_family = AF_INET;
+	peer.sin_addr.s_addr = htonl(peer_host);
+
+	BT_u8 *buffer = BT_kMalloc(NETBENCH_BUFFER_SIZE * 2);
+	if(!buffer) {
+		return -1;
+	}
+
+	memset(buffer, 0x5A, NETBENCH_BUFFER_SIZE);
+
+	peer.sin_port = htons(NETBENCH_TCP_PORT);
+	if(bench_tcp(hShell, netif, &peer, ulBytes, buffer)) {
+		retval = -1;
+	}
+
+	peer.sin_port = htons(NETBENCH_UDP_PORT);
+	if(bench_udp(hShell, netif, &peer, NETBENCH_UDP_COUNT, buffer)) {
+		retval = -1;
+	}
+
+	BT_kFree(buffer);
+
+	return retval;
+}
+
+BT_SHELL_COMMAND_DEF oCommand = {
+	.szpName = "netbench",
+	.pfnCommand = bt_netbench,
+};
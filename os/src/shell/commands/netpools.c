@@ -0,0 +1,36 @@
+/**
+ *	Prints the TCP/IP stack's memory pools with their high-water marks.
+ *
+ *	Run it after the system has seen its peak load. SUGGEST is the high-water mark
+ *	plus a quarter, for pools that ran out (ERR) or are far larger than needed.
+ **/
+#include <bitthunder.h>
+
+#define NETPOOLS_MAX	32
+
+static int bt_netpools(BT_HANDLE hShell, int argc, char **argv) {
+
+	struct bt_net_pool_stats *pStats = BT_kMalloc(sizeof(*pStats) * NETPOOLS_MAX);
+	if(!pStats) {
+		return -1;
+	}
+
+	BT_u32 i, n = BT_NetGetPoolStats(pStats, NETPOOLS_MAX);
+
+	BT_PRSHELL("POOL                 SIZE   TOTAL    USED     MAX     ERR  SUGGEST\n");
+	for(i = 0; i < n; i++) {
+		struct bt_net_pool_stats *pool = &pStats[i];
+		BT_u32 suggest = pool->ulMax + (pool->ulMax + 3) / 4;
+		BT_PRSHELL("%-18s %6d  %6d  %6d  %6d  %6d  %7d\n", pool->szpName, pool->ulSize, pool->ulTotal,
+				   pool->ulUsed, pool->ulMax, pool->ulErrors, suggest);
+	}
+
+	BT_kFree(pStats);
+
+	return 0;
+}
+
+BT_SHELL_COMMAND_DEF oCommand = {
+	.szpName = "netpools",
+	.pfnCommand = bt_netpools,
+};
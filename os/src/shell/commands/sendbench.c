@@ -0,0 +1,142 @@
+/**
+ *	Compares TCP file serving through BT_SendFile() with a BT_Read() + send() loop.
+ *
+ *	The command listens on a port and sends the file to two consecutive connections,
+ *	first with BT_SendFile(), then by copying, e.g. on the host:
+ *
+ *		nc <board> 5001 > /dev/null; nc <board> 5001 > /dev/null
+ **/
+#include <bitthunder.h>
+#include <sys/socket.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SENDBENCH_BUFFER_SIZE	4096
+
+/*
+ *	Returns once the data is queued, while BT_SendFile() waits for the final acknowledgement,
+ *	so use a file that is large compared with the TCP send buffer.
+ */
+static BT_s32 send_copy(BT_HANDLE hSocket, BT_HANDLE hFile, BT_u32 ulLength, BT_u8 *buffer) {
+	BT_u32 ulSent = 0;
+
+	BT_Seek(hFile, 0, BT_SEEK_SET);
+
+	while(ulSent < ulLength) {
+		BT_u32 ulSize = ulLength - ulSent;
+		if(ulSize > SENDBENCH_BUFFER_SIZE) {
+			ulSize = SENDBENCH_BUFFER_SIZE;
+		}
+
+		BT_s32 slRead = BT_Read(hFile, 0, ulSize, buffer);
+		if(slRead <= 0) {
+			break;
+		}
+
+		if(send((int) hSocket, buffer, slRead, 0) != slRead) {
+			break;
+		}
+
+		ulSent += slRead;
+	}
+
+	return ulSent;
+}
+
+static int bt_sendbench(BT_HANDLE hShell, int argc, char **argv) {
+
+	BT_HANDLE hStdout = BT_ShellGetStdout(hShell);
+	BT_ERROR Error;
+	BT_u16 port = 5001;
+	int retval = 0;
+	int i;
+
+	if(argc != 2 && argc != 3) {
+		bt_fprintf(hStdout, "Usage: %s [file] [port]\n", argv[0]);
+		bt_fprintf(hStdout, "    +- Sends the file to two connections: with BT_SendFile, then by read+send.\n");
+		return -1;
+	}
+
+	if(argc == 3) {
+		port = strtoul(argv[2], NULL, 10);
+	}
+
+	BT_HANDLE hFile = BT_Open(argv[1], BT_GetModeFlags("rb"), &Error);
+	if(!hFile) {
+		bt_fprintf(hStdout, "Error: Could not open %s\n", argv[1]);
+		return -1;
+	}
+
+	BT_Seek(hFile, 0, BT_SEEK_END);
+	BT_u32 ulLength = (BT_u32) BT_Tell(hFile, &Error);
+
+	BT_u8 *buffer = BT_kMalloc(SENDBENCH_BUFFER_SIZE);
+	if(!buffer) {
+		retval = -1;
+		goto close_out;
+	}
+
+	int listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if(!listener) {
+		bt_fprintf(hStdout, "Error: Could not create a socket\n");
+		retval = -1;
+		goto free_out;
+	}
+
+	struct sockaddr_in sad;
+	memset(&sad, 0, sizeof(sad));
+	sad.sin_family = AF_INET;
+	sad.sin_port = htons(port);
+	sad.sin_addr.s_addr = INADDR_ANY;
+
+	if(bind(listener, (struct sockaddr *) &sad, sizeof(sad)) || listen(listener, 1)) {
+		bt_fprintf(hStdout, "Error: Could not listen on port %d\n", port);
+		retval = -1;
+		goto socket_out;
+	}
+
+	for(i = 0; i < 2; i++) {
+		bt_fprintf(hStdout, "Waiting for a connection on port %d (%s)\n", port, i ? "read+send" : "sendfile");
+
+		int s = accept(listener, NULL, NULL);
+		if(!s) {
+			retval = -1;
+			break;
+		}
+
+		BT_u64 start = BT_GetGlobalTimer();
+		BT_s32 slSent;
+		if(!i) {
+			slSent = BT_SendFile((BT_HANDLE) s, hFile, 0, ulLength);
+		} else {
+			slSent = send_copy((BT_HANDLE) s, hFile, ulLength, buffer);
+		}
+		BT_u64 ticks = BT_GetGlobalTimer() - start;
+
+		closesocket(s);
+
+		if(slSent < 0) {
+			bt_fprintf(hStdout, "Error: send failed (%d)\n", slSent);
+			retval = -1;
+			break;
+		}
+
+		bt_fprintf(hStdout, "%-9s: %d bytes, %d KB/s\n", i ? "read+send" : "sendfile", slSent, BT_GlobalTimerKBps(slSent, ticks));
+	}
+
+socket_out:
+	closesocket(listener);
+
+free_out:
+	BT_kFree(buffer);
+
+close_out:
+	BT_CloseHandle(hFile);
+
+	return retval;
+}
+
+BT_SHELL_COMMAND_DEF oCommand = {
+	.szpName = "sendbench",
+	.pfnCommand = bt_sendbench,
+};
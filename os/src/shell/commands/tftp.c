@@ -6,12 +6,27 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <ctype.h>
 
 #define TFTP_RRQ 	0x0001
 #define TFTP_WRP	0x0002
 #define TFTP_DATA	0x0003
 #define TFTP_ACK 	0x0004
 #define TFTP_ERROR 	0x0005
+#define TFTP_OACK	0x0006
+
+#define TFTP_EOPTION			8		///< Error code for a failed option negotiation (RFC 2347).
+
+#define TFTP_PORT				69
+#define TFTP_DEFAULT_BLKSIZE	512		///< Used when the server ignores our options.
+#define TFTP_BLKSIZE			1468	///< Largest block that fits a 1500 byte MTU without fragmentation.
+#define TFTP_MAX_BLKSIZE		65464	///< RFC 2348 limit, anything above TFTP_BLKSIZE needs IP reassembly.
+#define TFTP_WINDOWSIZE			8		///< Keep within the UDP receive mailbox of the stack.
+#define TFTP_MAX_WINDOWSIZE		65535
+#define TFTP_TIMEOUT			250		///< ms
+#define TFTP_RETRIES			8
+#define TFTP_STAGING_SIZE		(64 * 1024)
+#define TFTP_MAX_PATH			256		///< Leaves room for the options in a request packet.
 
 struct ack_packet {
 	BT_u16 	opcode;
@@ -35,9 +50,181 @@ struct tftp_packet {
 	char 	info[514];
 };
 
+/*
+ *	Received blocks are written in order to a memory address, or staged and written to a
+ *	file or block device in large requests, so the image size is not limited by RAM.
+ */
+struct tftp_sink {
+	BT_u8 			   *dest;			///< Memory destination, or NULL.
+	BT_HANDLE			hOut;			///< File or block device.
+	BT_BOOL				bBlock;
+	BT_BLOCK_GEOMETRY	oGeometry;
+	BT_u8 			   *staging;
+	BT_u32				ulStagingSize;
+	BT_u32				ulStaged;
+	BT_u32				ulNextBlock;	///< Next device block to write.
+};
+
+static BT_ERROR sink_flush(struct tftp_sink *sink) {
+	if(!sink->ulStaged) {
+		return BT_ERR_NONE;
+	}
+
+	if(sink->bBlock) {
+		// Pad the last request up to a whole block.
+		BT_u32 ulBlockSize = sink->oGeometry.ulBlockSize;
+		BT_u32 ulBlocks = (sink->ulStaged + ulBlockSize - 1) / ulBlockSize;
+		memset(sink->staging + sink->ulStaged, 0, (ulBlocks * ulBlockSize) - sink->ulStaged);
+
+		if(sink->ulNextBlock + ulBlocks > sink->oGeometry.ulTotalBlocks) {
+			return BT_ERR_INVALID_VALUE;
+		}
+
+		if(BT_BlockWrite(sink->hOut, sink->ulNextBlock, ulBlocks, sink->staging) != ulBlocks) {
+			return BT_ERR_GENERIC;
+		}
+
+		sink->ulNextBlock += ulBlocks;
+	} else {
+		if(BT_Write(sink->hOut, 0, sink->ulStaged, sink->staging) != sink->ulStaged) {
+			return BT_ERR_GENERIC;
+		}
+	}
+
+	sink->ulStaged = 0;
+
+	return BT_ERR_NONE;
+}
+
+static BT_ERROR sink_write(struct tftp_sink *sink, BT_u32 ulOffset, const void *data, BT_u32 ulLength) {
+	const BT_u8 *p = data;
+
+	if(sink->dest) {
+		memcpy(sink->dest + ulOffset, data, ulLength);
+		return BT_ERR_NONE;
+	}
+
+	while(ulLength) {
+		BT_u32 ulSize = sink->ulStagingSize - sink->ulStaged;
+		if(ulSize > ulLength) {
+			ulSize = ulLength;
+		}
+
+		memcpy(sink->staging + sink->ulStaged, p, ulSize);
+		sink->ulStaged += ulSize;
+		p += ulSize;
+		ulLength -= ulSize;
+
+		if(sink->ulStaged == sink->ulStagingSize) {
+			BT_ERROR Error = sink_flush(sink);
+			if(Error) {
+				return Error;
+			}
+		}
+	}
+
+	return BT_ERR_NONE;
+}
+
+static BT_ERROR sink_open(struct tftp_sink *sink, const char *path) {
+	BT_ERROR Error;
+
+	sink->hOut = BT_Open(path, BT_GetModeFlags("wb"), &Error);
+	if(!sink->hOut) {
+		return BT_ERR_GENERIC;
+	}
+
+	sink->ulStagingSize = TFTP_STAGING_SIZE;
+	if(BT_GetBlockGeometry(sink->hOut, &sink->oGeometry) == BT_ERR_NONE) {
+		sink->bBlock = BT_TRUE;
+		sink->ulStagingSize -= TFTP_STAGING_SIZE % sink->oGeometry.ulBlockSize;
+		if(!sink->ulStagingSize) {
+			sink->ulStagingSize = sink->oGeometry.ulBlockSize;
+		}
+	}
+
+	sink->staging = BT_kMalloc(sink->ulStagingSize);
+	if(!sink->staging) {
+		BT_CloseHandle(sink->hOut);
+		return BT_ERR_NO_MEMORY;
+	}
+
+	return BT_ERR_NONE;
+}
+
+static void sink_close(struct tftp_sink *sink) {
+	if(sink->hOut) {
+		BT_kFree(sink->staging);
+		BT_CloseHandle(sink->hOut);
+	}
+}
+
+static BT_BOOL tftp_option_is(const char *name, const char *option) {
+	while(*name && tolower((int) *name) == *option) {
+		name++;
+		option++;
+	}
+	return (!*name && !*option);
+}
+
+/*
+ *	Applies the options a server acknowledged (RFC 2347), options it left out keep
+ *	their RFC 1350 defaults. *pulBlksize and *pulWindowsize hold the requested values
+ *	on entry, a server may only lower them (RFC 2348, RFC 7440).
+ */
+static BT_ERROR tftp_parse_oack(const char *p, int len, BT_u32 *pulBlksize, BT_u32 *pulWindowsize, BT_u32 *pulTsize) {
+	const char *end = p + len;
+	BT_u32 ulRequestedBlksize = *pulBlksize;
+	BT_u32 ulRequestedWindowsize = *pulWindowsize;
+
+	*pulBlksize = TFTP_DEFAULT_BLKSIZE;
+	*pulWindowsize = 1;
+
+	while(p < end) {
+		const char *name = p;
+		const char *value = name + strnlen(name, end - name) + 1;
+		if(value >= end) {
+			break;
+		}
+
+		BT_u32 ulValue = strtoul(value, NULL, 10);
+		if(tftp_option_is(name, "blksize")) {
+			if(ulValue < 8 || ulValue > ulRequestedBlksize) {
+				return BT_ERR_INVALID_VALUE;
+			}
+			*pulBlksize = ulValue;
+		} else if(tftp_option_is(name, "windowsize")) {
+			if(ulValue < 1 || ulValue > ulRequestedWindowsize) {
+				return BT_ERR_INVALID_VALUE;
+			}
+			*pulWindowsize = ulValue;
+		} else if(tftp_option_is(name, "tsize")) {
+			*pulTsize = ulValue;
+		}
+
+		p = value + strnlen(value, end - value) + 1;
+	}
+
+	return BT_ERR_NONE;
+}
+
+static void tftp_usage(BT_HANDLE hStdout, const char *name) {
+	bt_fprintf(hStdout, "Usage: %s [-b blksize] [-w windowsize] 0x[address] [remote-path]\n", name);
+	bt_fprintf(hStdout, "       %s [-b blksize] [-w windowsize] -o [file-or-block-device] [remote-path]\n", name);
+	bt_fprintf(hStdout, "    +- blksize defaults to %d, windowsize to %d.\n", TFTP_BLKSIZE, TFTP_WINDOWSIZE);
+}
+
 static int bt_tftp_command(BT_HANDLE hShell, int argc, char **argv) {
 
 	BT_HANDLE hStdout = BT_ShellGetStdout(hShell);
+	BT_ERROR Error = BT_ERR_NONE;
+	struct tftp_sink sink;
+	BT_u32 blksize = TFTP_BLKSIZE;
+	BT_u32 windowsize = TFTP_WINDOWSIZE;
+	const char *output = NULL;
+	int i;
+
+	memset(&sink, 0, sizeof(sink));
 
 	BT_ENV_VARIABLE *server_host = BT_ShellGetEnv("server-host");
 	if(!server_host) {
@@ -45,19 +232,43 @@ static int bt_tftp_command(BT_HANDLE hShell, int argc, char **argv) {
 		return -1;
 	}
 
-	if(argc != 3) {
-		bt_fprintf(hStdout, "Usage: %s 0x[address] [remote-path]\n", argv[0]);
+	for(i = 1; i < argc - 2 && argv[i][0] == '-'; i += 2) {
+		if(!strcmp(argv[i], "-b")) {
+			blksize = strtoul(argv[i+1], NULL, 10);
+		} else if(!strcmp(argv[i], "-w")) {
+			windowsize = strtoul(argv[i+1], NULL, 10);
+		} else if(!strcmp(argv[i], "-o")) {
+			output = argv[i+1];
+		} else {
+			break;
+		}
+	}
+
+	// What is left is the address and remote path, or only the remote path with -o.
+	if(i != (output ? argc - 1 : argc - 2) || strlen(argv[argc - 1]) > TFTP_MAX_PATH
+	   || blksize < 8 || blksize > TFTP_MAX_BLKSIZE || windowsize < 1 || windowsize > TFTP_MAX_WINDOWSIZE) {
+		tftp_usage(hStdout, argv[0]);
 		return -1;
 	}
 
+	const char *remote = argv[argc - 1];
+
+	if(output) {
+		Error = sink_open(&sink, output);
+		if(Error) {
+			bt_fprintf(hStdout, "Error: Could not open %s\n", output);
+			return -1;
+		}
+	} else {
+		sink.dest = (BT_u8 *) strtoul(argv[argc - 2], NULL, 16);
+	}
+
 	int sockfd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
 	struct sockaddr_in sad;
 
-	bt_fprintf(hStdout, "sockfd = %08x\n", sockfd);
-
 	memset(&sad, 0, sizeof(sad));
 	sad.sin_family = AF_INET;
-	sad.sin_port = htons(69);
+	sad.sin_port = htons(TFTP_PORT);
 
 	int timeout = 3;
 
@@ -69,95 +280,186 @@ static int bt_tftp_command(BT_HANDLE hShell, int argc, char **argv) {
 		}
 	}
 
-	if(ptrh) {
-		bt_fprintf(hStdout, "ptrh->h_addr: %d.%d.%d.%d\n", ptrh->h_addr[0], ptrh->h_addr[1], ptrh->h_addr[2], ptrh->h_addr[3]);
-	} else {
+	if(!ptrh) {
 		bt_fprintf(hStdout, "Could not resolve hostname: %s\n", server_host->o.string->s);
 		goto cleanup_socket;
 	}
 
 	memcpy(&sad.sin_addr, ptrh->h_addr, ptrh->h_length);
 
-	void *pBuffer = BT_kMalloc(1024);
+	// Large enough for the default block size too, in case the server ignores our options.
+	BT_u32 ulBufferSize = ((blksize > TFTP_DEFAULT_BLKSIZE) ? blksize : TFTP_DEFAULT_BLKSIZE) + 4;
+	void *pBuffer = BT_kMalloc(ulBufferSize);
 	struct tftp_packet *packet = (struct tftp_packet *) pBuffer;
 	if(!packet) {
 		goto cleanup_socket;
 	}
 
-	packet->opcode = htons(TFTP_RRQ);
-	int n = sprintf(packet->info, "%s%c%s%c", argv[2], '\0', "octet", '\0');
-
-	n = sendto(sockfd, (void *) packet, n+2, 0, (struct sockaddr *) &sad, sizeof(sad));
+	/*
+	 *	Request blksize (RFC 2348), windowsize (RFC 7440) and tsize (RFC 2349).
+	 */
+	struct tftp_packet request;
+	request.opcode = htons(TFTP_RRQ);
+	int reqlen = sprintf(request.info, "%s%c%s%c%s%c%d%c%s%c%d%c%s%c%d%c",
+						 remote, '\0', "octet", '\0',
+						 "blksize", '\0', (int) blksize, '\0',
+						 "windowsize", '\0', (int) windowsize, '\0',
+						 "tsize", '\0', 0, '\0') + 2;
+
+	int sock_opt = TFTP_TIMEOUT;
+	setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &sock_opt, sizeof(sock_opt));
 
 	struct sockaddr rxaddr;
 	socklen_t rxaddr_len = sizeof(rxaddr);
+	struct sockaddr_in *server_addr = (struct sockaddr_in *) &rxaddr;
 
-	int sock_opt = 250;
-	setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &sock_opt, sizeof(sock_opt));
+	struct ack_packet ack;
+	ack.opcode = htons(TFTP_ACK);
 
-	n = recvfrom(sockfd, pBuffer, 1024, 0, &rxaddr, &rxaddr_len);
-	if(n) {
-		bt_fprintf(hStdout, "Received %d bytes\n");
-	} else {
-		bt_fprintf(hStdout, "No response from server\n");
-		goto err_free_buffer;
-	}
+	BT_u32 tsize = 0;
+	BT_u32 total_length = 0;
+	BT_u16 expected = 1;			// Next block number, wraps like the protocol's.
+	BT_u32 in_window = 0;			// In-order blocks received since the last ACK.
+	BT_BOOL bConnected = BT_FALSE;	// Server's transfer port is known.
+	BT_BOOL bDone = BT_FALSE;
+	int retries = 0;
 
-	packet = (struct tftp_packet *) pBuffer;
-	switch(ntohs(packet->opcode)) {
-	case TFTP_ERROR: {
-		struct error_packet *err_packet = (struct error_packet *) packet;
-		bt_fprintf(hStdout, "tftp error: %d - %s\n", ntohs(err_packet->error_code), err_packet->message);
-		goto err_free_buffer;
-		break;
-	}
+	sendto(sockfd, (void *) &request, reqlen, 0, (struct sockaddr *) &sad, sizeof(sad));
 
-	case TFTP_DATA: {
-		struct data_packet *data_packet = (struct data_packet *) packet;
-		BT_u32 blocksize = 512;
-		BT_u32 length;
-		BT_u32 address = strtoul(argv[1], NULL, 16);
-		BT_u8 *dest = (BT_u8 *) address;
-		BT_u32 total_length = 0;
-		BT_u32 last_block = 0;
+	BT_u64 start = BT_GetGlobalTimer();
 
-		do {
-			BT_u16 block = ntohs(data_packet->block_nr);
-			length = n - 4;
-			memcpy(dest + ((block-1) * blocksize), data_packet->data, length);
+	while(!bDone) {
+		int n = recvfrom(sockfd, pBuffer, ulBufferSize, 0, &rxaddr, &rxaddr_len);
+		if(n <= 0) {
+			if(++retries > TFTP_RETRIES) {
+				bt_fprintf(hStdout, "No response from server\n");
+				goto err_free_buffer;
+			}
+
+			// Timeout, repeat the request, or acknowledge the last in-order block to restart the window.
+			if(!bConnected) {
+				sendto(sockfd, (void *) &request, reqlen, 0, (struct sockaddr *) &sad, sizeof(sad));
+			} else {
+				ack.block_nr = htons((BT_u16) (expected - 1));
+				sendto(sockfd, (void *) &ack, sizeof(ack), 0, (struct sockaddr *) &sad, sizeof(sad));
+				in_window = 0;
+			}
+			continue;
+		}
 
-			// Send ack
-			struct ack_packet *ack_packet = (struct ack_packet *) packet;
-			ack_packet->opcode 		= htons(TFTP_ACK);
-			ack_packet->block_nr 	= htons(block);
+		if(bConnected && server_addr->sin_port != sad.sin_port) {
+			continue;	// Not from our transfer.
+		}
+
+		packet = (struct tftp_packet *) pBuffer;
+		switch(ntohs(packet->opcode)) {
+		case TFTP_ERROR: {
+			struct error_packet *err_packet = (struct error_packet *) packet;
+			bt_fprintf(hStdout, "tftp error: %d - %s\n", ntohs(err_packet->error_code), err_packet->message);
+			goto err_free_buffer;
+		}
+
+		case TFTP_OACK: {
+			if(bConnected) {
+				break;
+			}
 
-			struct sockaddr_in *server_addr = (struct sockaddr_in *) &rxaddr;
 			sad.sin_port = server_addr->sin_port;
+			if(tftp_parse_oack(packet->info, n - 2, &blksize, &windowsize, &tsize)) {
+				struct error_packet oError;
+				oError.opcode = htons(TFTP_ERROR);
+				oError.error_code = htons(TFTP_EOPTION);
+				oError.message[0] = '\0';
+				sendto(sockfd, (void *) &oError, (oError.message - (char *) &oError) + 1, 0, (struct sockaddr *) &sad, sizeof(sad));
+				bt_fprintf(hStdout, "Error: server acknowledged options larger than requested\n");
+				goto err_free_buffer;
+			}
+
+			bConnected = BT_TRUE;
+			retries = 0;
+
+			if(tsize && sink.bBlock && tsize > (BT_u64) sink.oGeometry.ulTotalBlocks * sink.oGeometry.ulBlockSize) {
+				bt_fprintf(hStdout, "Error: %s (%d bytes) does not fit on %s\n", remote, tsize, output);
+				goto err_free_buffer;
+			}
+
+			ack.block_nr = htons(0);
+			sendto(sockfd, (void *) &ack, sizeof(ack), 0, (struct sockaddr *) &sad, sizeof(sad));
+			break;
+		}
+
+		case TFTP_DATA: {
+			struct data_packet *data_packet = (struct data_packet *) packet;
+			BT_u16 block = ntohs(data_packet->block_nr);
+			BT_u32 length = n - 4;
+
+			if(!bConnected) {
+				// The server ignored our options.
+				blksize = TFTP_DEFAULT_BLKSIZE;
+				windowsize = 1;
+				sad.sin_port = server_addr->sin_port;
+				bConnected = BT_TRUE;
+			}
 
-			sendto(sockfd, (void *) ack_packet, 4, 0, (struct sockaddr *) &sad, sizeof(sad));
-			if(block > last_block) {
-				total_length += length;
+			if(block != expected) {
+				// Lost or reordered, restart the window after the last in-order block (RFC 7440).
+				// A repeat of the last acknowledged block means that our ACK was lost.
+				if(in_window || block == (BT_u16) (expected - 1)) {
+					ack.block_nr = htons((BT_u16) (expected - 1));
+					sendto(sockfd, (void *) &ack, sizeof(ack), 0, (struct sockaddr *) &sad, sizeof(sad));
+					in_window = 0;
+				}
+				break;
 			}
 
-			last_block = block;
+			retries = 0;
 
-			n = recvfrom(sockfd, pBuffer, 1024, 0, &rxaddr, &rxaddr_len);
-		} while(length == 512);
+			if(length > blksize) {
+				bt_fprintf(hStdout, "Error: server sent a block of %d bytes, blksize is %d\n", length, blksize);
+				goto err_free_buffer;
+			}
 
-		bt_fprintf(hStdout, "received %d bytes\n", total_length);
+			Error = sink_write(&sink, total_length, data_packet->data, length);
+			if(Error) {
+				bt_fprintf(hStdout, "Error: Could not write to %s\n", output);
+				goto err_free_buffer;
+			}
 
-		sprintf(pBuffer, "%d", (int) total_length);
+			total_length += length;
+			expected += 1;
+			in_window += 1;
 
-		BT_ShellSetEnv("tftp-length", pBuffer, BT_ENV_T_STRING);
+			if(length < blksize) {
+				bDone = BT_TRUE;
+			}
 
-		break;
+			if(bDone || in_window == windowsize) {
+				ack.block_nr = htons(block);
+				sendto(sockfd, (void *) &ack, sizeof(ack), 0, (struct sockaddr *) &sad, sizeof(sad));
+				in_window = 0;
+			}
+			break;
+		}
 
+		default:
+			break;
+		}
 	}
 
-	default:
+	Error = sink_flush(&sink);
+	if(Error) {
+		bt_fprintf(hStdout, "Error: Could not write to %s\n", output);
 		goto err_free_buffer;
 	}
 
+	BT_u64 ticks = BT_GetGlobalTimer() - start;
+
+	bt_fprintf(hStdout, "received %d bytes (blksize %d, windowsize %d), %d KB/s\n", total_length, blksize, windowsize,
+			   BT_GlobalTimerKBps(total_length, ticks));
+
+	sprintf(pBuffer, "%d", (int) total_length);
+
+	BT_ShellSetEnv("tftp-length", pBuffer, BT_ENV_T_STRING);
 
 err_free_buffer:
 	BT_kFree(pBuffer);
@@ -166,6 +468,9 @@ cleanup_socket:
 	if(sockfd) {
 		closesocket(sockfd);
 	}
+
+	sink_close(&sink);
+
 	return 0;
 }
 
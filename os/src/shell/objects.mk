@@ -3,7 +3,9 @@ BT_OS_OBJECTS-$(BT_CONFIG_SHELL) += $(BUILD_DIR)/os/src/shell/bt_env.o
 
 
 # Commands
+BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_AMPBENCH) 	+= $(BUILD_DIR)/os/src/shell/commands/ampbench.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_ATAGS) 		+= $(BUILD_DIR)/os/src/shell/commands/atag/atag.o
+BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_BLKBENCH) 	+= $(BUILD_DIR)/os/src/shell/commands/blkbench.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_BOOT) 		+= $(BUILD_DIR)/os/src/shell/commands/boot.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_BOOT_JTAG) 	+= $(BUILD_DIR)/os/src/shell/commands/boot_jtag.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_CAT)		+= $(BUILD_DIR)/os/src/shell/commands/cat.o
@@ -18,20 +20,27 @@ BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_FORMAT)		+= $(BUILD_DIR)/os/src/shell/comman
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_FREE)  		+= $(BUILD_DIR)/os/src/shell/commands/free.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_GETENV)	  	+= $(BUILD_DIR)/os/src/shell/commands/getenv.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_GPIO)	  	+= $(BUILD_DIR)/os/src/shell/commands/gpio.o
+BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_HANDLESTRESS)	+= $(BUILD_DIR)/os/src/shell/commands/handlestress.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_HELP) 		+= $(BUILD_DIR)/os/src/shell/commands/help.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_IFCONFIG)	+= $(BUILD_DIR)/os/src/shell/commands/ifconfig.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_IOMEM)		+= $(BUILD_DIR)/os/src/shell/commands/iomem.o
+BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_IRQSTAT)	+= $(BUILD_DIR)/os/src/shell/commands/irqstat.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_LOAD) 		+= $(BUILD_DIR)/os/src/shell/commands/load.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_LOAD_FPGA) 	+= $(BUILD_DIR)/os/src/shell/commands/load_fpga.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_LOOP) 	+= $(BUILD_DIR)/os/src/shell/commands/loop.o
+BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_LOCKBENCH)	+= $(BUILD_DIR)/os/src/shell/commands/lockbench.o
+BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_LOCKSTAT)	+= $(BUILD_DIR)/os/src/shell/commands/lockstat.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_LS)			+= $(BUILD_DIR)/os/src/shell/commands/ls.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_MD5SUM) 	+= $(BUILD_DIR)/os/src/shell/commands/md5sum.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_MEMCAT) 	+= $(BUILD_DIR)/os/src/shell/commands/memcat.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_MKDIR)		+= $(BUILD_DIR)/os/src/shell/commands/mkdir.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_MOUNT)		+= $(BUILD_DIR)/os/src/shell/commands/mount.o
+BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_NETBENCH)	+= $(BUILD_DIR)/os/src/shell/commands/netbench.o
+BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_NETPOOLS)	+= $(BUILD_DIR)/os/src/shell/commands/netpools.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_PARTITION)	+= $(BUILD_DIR)/os/src/shell/commands/partition.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_PS)			+= $(BUILD_DIR)/os/src/shell/commands/ps.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_PWD)		+= $(BUILD_DIR)/os/src/shell/commands/pwd.o
+BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_SENDBENCH)	+= $(BUILD_DIR)/os/src/shell/commands/sendbench.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_SETENV)	  	+= $(BUILD_DIR)/os/src/shell/commands/setenv.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_SLABTOP)  	+= $(BUILD_DIR)/os/src/shell/commands/slabtop.o
 BT_OS_OBJECTS-$(BT_CONFIG_SHELL_CMD_SLEEP)		+= $(BUILD_DIR)/os/src/shell/commands/sleep.o
@@ -28,8 +28,10 @@ struct syscall_entry {
 
 #ifdef BT_SYSCALL_DEBUG
 #define SYSCALL(n, fn)	{n, #fn, (syscall_fn)(fn)}
+#define SYSCALL_NONE	{0, NULL, NULL}
 #else
 #define SYSCALL(n, fn)	{(syscall_fn)(fn)}
+#define SYSCALL_NONE	{NULL}
 #endif
 
 static const struct syscall_entry syscall_table[] = {
@@ -45,6 +47,18 @@ static const struct syscall_entry syscall_table[] = {
 	/*		9 */	SYSCALL(2, bt_sys_gpioset),
 	/*	   10 */	SYSCALL(2, bt_sys_gettimeofday),
 	/*	   11 */	SYSCALL(2, bt_sys_settimeofday),
+#ifdef BT_CONFIG_POLL
+	/*	   12 */	SYSCALL(1, bt_sys_epoll_create),
+	/*	   13 */	SYSCALL(4, bt_sys_epoll_ctl),
+	/*	   14 */	SYSCALL(4, bt_sys_epoll_wait),
+#else
+	/*	   12 */	SYSCALL_NONE,		// Keep the numbers of the calls below.
+	/*	   13 */	SYSCALL_NONE,
+	/*	   14 */	SYSCALL_NONE,
+#endif
+	/*	   15 */	SYSCALL(1, bt_sys_dup),
+	/*	   16 */	SYSCALL(2, bt_sys_dup2),
+	/*	   17 */	SYSCALL(3, bt_sys_fcntl),
 };
 
 #define SYSCALL_TOTAL	(BT_u32) (sizeof(syscall_table)/sizeof(struct syscall_entry))
@@ -55,7 +69,7 @@ bt_register_t bt_syscall_handler(bt_register_t a1, bt_register_t a2, bt_register
 	bt_register_t retval = -1;
 	const struct syscall_entry *syscall;
 
-	if(nr < SYSCALL_TOTAL) {
+	if(nr < SYSCALL_TOTAL && syscall_table[nr].syscall) {
 		syscall = &syscall_table[nr];
 		retval = syscall->syscall(a1, a2, a3, a4);
 	} else {
@@ -1,11 +1,14 @@
 #include <bitthunder.h>
+#include <syscall/errno.h>
+#include <errno.h>
 
 long bt_sys_close(int fd) {
-	BT_ERROR Error = BT_ERR_NONE;
-	BT_HANDLE hFile = BT_GetFileDescriptor(fd, &Error);
-	BT_SetFileDescriptor(fd, NULL);
-	BT_CloseHandle(hFile);
-	BT_FreeFileDescriptor(fd);
+	if(!BT_GetFileDescriptor(fd, NULL)) {
+		errno = EBADF;
+		return -1;
+	}
+
+	BT_FreeFileDescriptor(fd);	// Closes the handle, unless another descriptor still refers to it.
 
 	return 0;
 }
@@ -0,0 +1,40 @@
+#include <bitthunder.h>
+#include <syscall/errno.h>
+#include <errno.h>
+
+/**
+ *	@brief	POSIX dup() and dup2().
+ *
+ *	The new descriptor refers to the same handle, and so shares its file offset. It
+ *	starts without FD_CLOEXEC.
+ *
+ **/
+long bt_sys_dup(int oldfd) {
+	if(oldfd < 0 || !BT_GetFileDescriptor(oldfd, NULL)) {
+		errno = EBADF;
+		return -1;
+	}
+
+	BT_s32 fd = BT_DupFileDescriptor(oldfd, 0, 0);
+	if(fd < 0) {
+		errno = EMFILE;
+		return -1;
+	}
+
+	return (long) fd;
+}
+
+long bt_sys_dup2(int oldfd, int newfd) {
+	if(oldfd < 0 || newfd < 0 || newfd >= BT_CONFIG_PROCESS_MAX_FDS) {
+		errno = EBADF;
+		return -1;
+	}
+
+	BT_s32 fd = BT_Dup2FileDescriptor(oldfd, newfd, 0);
+	if(fd < 0) {
+		errno = (fd == BT_ERR_INVALID_HANDLE) ? EBADF : ENOMEM;
+		return -1;
+	}
+
+	return (long) fd;
+}
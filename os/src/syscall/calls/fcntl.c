@@ -0,0 +1,57 @@
+#include <bitthunder.h>
+#include <syscall/errno.h>
+#include <errno.h>
+#include <fcntl.h>
+
+/**
+ *	@brief	POSIX fcntl(), for the descriptor commands only.
+ *
+ *	F_DUPFD, F_DUPFD_CLOEXEC, F_GETFD and F_SETFD. Handles have no file status flags
+ *	that can change after open(), so F_GETFL and F_SETFL are not supported.
+ *
+ **/
+long bt_sys_fcntl(int fd, int cmd, int arg) {
+	BT_s32 ret;
+
+	if(fd < 0 || !BT_GetFileDescriptor(fd, NULL)) {
+		errno = EBADF;
+		return -1;
+	}
+
+	switch(cmd) {
+	case F_DUPFD:
+#ifdef F_DUPFD_CLOEXEC
+	case F_DUPFD_CLOEXEC:
+#endif
+		if(arg < 0 || arg >= BT_CONFIG_PROCESS_MAX_FDS) {
+			errno = EINVAL;
+			return -1;
+		}
+
+		ret = BT_DupFileDescriptor(fd, arg, (cmd == F_DUPFD) ? 0 : BT_FD_CLOEXEC);
+		if(ret < 0) {
+			errno = EMFILE;
+			return -1;
+		}
+		return (long) ret;
+
+	case F_GETFD:
+		ret = BT_GetFileDescriptorFlags(fd);
+		if(ret < 0) {
+			errno = EBADF;
+			return -1;
+		}
+		return (ret & BT_FD_CLOEXEC) ? FD_CLOEXEC : 0;
+
+	case F_SETFD:
+		if(BT_SetFileDescriptorFlags(fd, (arg & FD_CLOEXEC) ? BT_FD_CLOEXEC : 0)) {
+			errno = EBADF;
+			return -1;
+		}
+		return 0;
+
+	default:
+		errno = EINVAL;
+		return -1;
+	}
+}
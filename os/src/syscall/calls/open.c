@@ -1,6 +1,7 @@
 #include <bitthunder.h>
 #include <syscall/errno.h>
 #include <errno.h>
+#include <fcntl.h>
 
 struct flag_mask {
 	BT_u32 flag;
@@ -59,6 +60,13 @@ long bt_sys_open(const char *pathname, int flags, int mode) {
 	}
 
 	BT_SetFileDescriptor(fd, hFile);
+	BT_CloseHandle(hFile);	// The descriptor holds its own reference.
+
+#ifdef O_CLOEXEC
+	if(flags & O_CLOEXEC) {
+		BT_SetFileDescriptorFlags(fd, BT_FD_CLOEXEC);
+	}
+#endif
 
 	return (long) fd;
 }
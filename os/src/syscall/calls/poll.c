@@ -0,0 +1,89 @@
+#include <bitthunder.h>
+#include <syscall/errno.h>
+#include <errno.h>
+
+/**
+ *	@brief	epoll_create(), epoll_ctl() and epoll_wait() on top of BT_Poll*.
+ *
+ *	The interest set is an ordinary file descriptor, released with close().
+ *	Events use the BT_POLL* flags, which match the Linux EPOLL* values.
+ *
+ **/
+long bt_sys_epoll_create(int size) {
+
+	BT_ERROR Error = BT_ERR_NONE;
+	int fd = (int) BT_AllocFileDescriptor();
+	if(fd < 0) {
+		errno = EMFILE;
+		return -1;
+	}
+
+	BT_HANDLE hPoll = BT_PollCreate(&Error);
+	if(!hPoll) {
+		BT_FreeFileDescriptor(fd);
+		errno = ENOMEM;
+		return -1;
+	}
+
+	BT_SetFileDescriptor(fd, hPoll);
+	BT_CloseHandle(hPoll);	// The descriptor holds its own reference.
+
+	return (long) fd;
+}
+
+long bt_sys_epoll_ctl(int epfd, int op, int fd, struct bt_poll_event *event) {
+
+	BT_ERROR Error = BT_ERR_NONE;
+	BT_HANDLE hPoll = BT_GetFileDescriptor(epfd, &Error);
+	BT_HANDLE hFile = BT_GetFileDescriptor(fd, &Error);
+	if(!hPoll || !hFile) {
+		errno = EBADF;
+		return -1;
+	}
+
+	Error = BT_PollCtl(hPoll, op, hFile, event);
+	switch(Error) {
+	case BT_ERR_NONE:
+		return 0;
+	case BT_ERR_BUSY:
+		errno = EEXIST;
+		break;
+	case BT_ERR_INVALID_HANDLE:
+		errno = ENOENT;
+		break;
+	case BT_ERR_NO_MEMORY:
+		errno = ENOMEM;
+		break;
+	case BT_ERR_UNSUPPORTED_INTERFACE:
+		errno = EPERM;
+		break;
+	default:
+		errno = EINVAL;
+		break;
+	}
+
+	return -1;
+}
+
+long bt_sys_epoll_wait(int epfd, struct bt_poll_event *events, int maxevents, int timeout) {
+
+	BT_ERROR Error = BT_ERR_NONE;
+	BT_HANDLE hPoll = BT_GetFileDescriptor(epfd, &Error);
+	if(!hPoll) {
+		errno = EBADF;
+		return -1;
+	}
+
+	if(maxevents <= 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	BT_s32 slEvents = BT_PollWait(hPoll, events, maxevents, timeout);
+	if(slEvents < 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	return (long) slEvents;
+}
@@ -19,7 +19,10 @@ BT_OS_OBJECTS 	+= $(BUILD_DIR)/os/src/syscall/calls/close.o
 BT_OS_OBJECTS 	+= $(BUILD_DIR)/os/src/syscall/calls/read.o
 BT_OS_OBJECTS 	+= $(BUILD_DIR)/os/src/syscall/calls/write.o
 BT_OS_OBJECTS 	+= $(BUILD_DIR)/os/src/syscall/calls/lseek.o
+BT_OS_OBJECTS 	+= $(BUILD_DIR)/os/src/syscall/calls/dup.o
+BT_OS_OBJECTS 	+= $(BUILD_DIR)/os/src/syscall/calls/fcntl.o
 BT_OS_OBJECTS 	+= $(BUILD_DIR)/os/src/syscall/calls/klog.o
 BT_OS_OBJECTS 	+= $(BUILD_DIR)/os/src/syscall/calls/sleep.o
 BT_OS_OBJECTS 	+= $(BUILD_DIR)/os/src/syscall/calls/gpio.o
 BT_OS_OBJECTS 	+= $(BUILD_DIR)/os/src/syscall/calls/time.o
+BT_OS_OBJECTS-$(BT_CONFIG_POLL) += $(BUILD_DIR)/os/src/syscall/calls/poll.o
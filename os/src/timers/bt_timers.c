@@ -21,6 +21,16 @@ static BT_HANDLE g_gTimer = NULL;
 static const BT_DEV_IF_SYSTIMER *g_Ops 	= NULL;
 static const BT_DEV_IF_GTIMER 	*g_gOps = NULL;
 
+#ifdef BT_CONFIG_HRTIMERS
+#define HRTIMER_MIN_DELTA	2		///< Global timer counts, covers programming the comparator.
+
+static BT_LIST_HEAD(g_hrtimers);				///< Sorted by expiry.
+static bt_spinlock_t g_hrtimer_lock = BT_SPINLOCK_INIT;
+static BT_BOOL g_bHrTimers = BT_FALSE;
+
+static BT_ERROR hrtimer_irq(BT_u32 ulIRQ, void *pParam);
+#endif
+
 BT_ERROR BT_SetSystemTimerHandle(BT_HANDLE hTimer) {
 	if(!g_hTimer) {
 		g_hTimer = hTimer;
@@ -36,6 +46,11 @@ BT_ERROR BT_SetGlobalTimerHandle(BT_HANDLE hTimer) {
 	if(!g_gTimer) {
 		g_gTimer = hTimer;
 		g_gOps = BT_IF_GTIMER_OPS(hTimer);
+#ifdef BT_CONFIG_HRTIMERS
+		if(g_gOps->pfnSetCompare && g_gOps->pfnRegisterInterrupt) {
+			g_bHrTimers = g_gOps->pfnRegisterInterrupt(hTimer, hrtimer_irq, NULL) ? BT_FALSE : BT_TRUE;
+		}
+#endif
 		return BT_ERR_NONE;
 	}
 	return BT_ERR_GENERIC;
@@ -87,6 +102,14 @@ BT_u32 BT_GetGlobalTimerRate() {
 }
 BT_EXPORT_SYMBOL(BT_GetGlobalTimerRate);
 
+BT_u32 BT_GlobalTimerKBps(BT_u64 ullBytes, BT_u64 ullTicks) {
+	if(!ullTicks) {
+		return 0;
+	}
+	return (BT_u32) ((ullBytes * BT_GetGlobalTimerRate()) / (ullTicks * 1024));
+}
+BT_EXPORT_SYMBOL(BT_GlobalTimerKBps);
+
 BT_u32 BT_GetKernelTime() {
 	BT_u32 ulOldTick, ulNewTick;
 	BT_u32 us;
@@ -104,3 +127,184 @@ BT_u32 BT_GetKernelTick() {
 	return BT_kTickCount();
 }
 BT_EXPORT_SYMBOL(BT_GetKernelTick);
+
+#ifdef BT_CONFIG_HRTIMERS
+/*
+ *	v * mul / div without overflowing, as long as mul * div fits in 64 bits.
+ */
+static BT_u64 scale(BT_u64 v, BT_u32 mul, BT_u32 div) {
+	return (v / div) * mul + ((v % div) * mul + div - 1) / div;
+}
+
+BT_u64 BT_HrTimerNow() {
+	BT_u32 ulRate = BT_GetGlobalTimerRate();
+	if(!ulRate) {
+		return 0;
+	}
+
+	return scale(BT_GetGlobalTimer(), 1000000000, ulRate);
+}
+BT_EXPORT_SYMBOL(BT_HrTimerNow);
+
+/*
+ *	Called with g_hrtimer_lock held.
+ */
+static void hrtimer_program(void) {
+	if(bt_list_empty(&g_hrtimers)) {
+		g_gOps->pfnClearCompare(g_gTimer);
+		return;
+	}
+
+	BT_HRTIMER *pFirst = bt_list_first_entry(&g_hrtimers, BT_HRTIMER, item);
+	BT_u64 ullMin = BT_GetGlobalTimer() + HRTIMER_MIN_DELTA;
+
+	g_gOps->pfnSetCompare(g_gTimer, pFirst->ullExpires > ullMin ? pFirst->ullExpires : ullMin);
+}
+
+static void hrtimer_enqueue(BT_HRTIMER *pTimer) {
+	struct bt_list_head *pos;
+
+	bt_list_for_each(pos, &g_hrtimers) {
+		if(bt_list_entry(pos, BT_HRTIMER, item)->ullExpires > pTimer->ullExpires) {
+			break;
+		}
+	}
+
+	bt_list_add_tail(&pTimer->item, pos);
+}
+
+static BT_ERROR hrtimer_start(BT_HRTIMER *pTimer, BT_u64 ullExpires, BT_u64 ullPeriod) {
+	bt_irqflags_t flags;
+
+	if(!g_bHrTimers) {
+		return BT_ERR_UNSUPPORTED_INTERFACE;
+	}
+
+#ifdef BT_CONFIG_SMP
+	if(BT_GetCoreID()) {
+		return BT_ERR_GENERIC;		// The comparator is banked per CPU.
+	}
+#endif
+
+	bt_spin_lock_irqsave(&g_hrtimer_lock, flags);
+
+	bt_list_del_init(&pTimer->item);
+	pTimer->ullExpires = ullExpires;
+	pTimer->ullPeriod = ullPeriod;
+	hrtimer_enqueue(pTimer);
+
+	if(g_hrtimers.next == &pTimer->item) {
+		hrtimer_program();
+	}
+
+	bt_spin_unlock_irqrestore(&g_hrtimer_lock, flags);
+
+	return BT_ERR_NONE;
+}
+
+BT_ERROR BT_HrTimerStart(BT_HRTIMER *pTimer, BT_u64 ullDelayNs, BT_u64 ullPeriodNs) {
+	BT_u32 ulRate = BT_GetGlobalTimerRate();
+
+	if(!pTimer || !pTimer->pfnCallback) {
+		return BT_ERR_NULL_POINTER;
+	}
+
+	if(!g_bHrTimers || !ulRate) {
+		return BT_ERR_UNSUPPORTED_INTERFACE;
+	}
+
+	return hrtimer_start(pTimer, BT_GetGlobalTimer() + scale(ullDelayNs, ulRate, 1000000000), scale(ullPeriodNs, ulRate, 1000000000));
+}
+BT_EXPORT_SYMBOL(BT_HrTimerStart);
+
+/*
+ *	The comparator is left armed, if it fires early the interrupt finds nothing expired
+ *	and programs the next timer.
+ */
+BT_BOOL BT_HrTimerCancel(BT_HRTIMER *pTimer) {
+	bt_irqflags_t flags;
+	BT_BOOL bActive;
+
+	bt_spin_lock_irqsave(&g_hrtimer_lock, flags);
+	bActive = bt_list_empty(&pTimer->item) ? BT_FALSE : BT_TRUE;
+	bt_list_del_init(&pTimer->item);
+	bt_spin_unlock_irqrestore(&g_hrtimer_lock, flags);
+
+	return bActive;
+}
+BT_EXPORT_SYMBOL(BT_HrTimerCancel);
+
+/*
+ *	Runs every timer that expired by the time of the interrupt once, callbacks without the
+ *	lock so that they can restart timers.
+ */
+static BT_ERROR hrtimer_irq(BT_u32 ulIRQ, void *pParam) {
+	bt_irqflags_t flags;
+
+	bt_spin_lock_irqsave(&g_hrtimer_lock, flags);
+
+	BT_u64 ullNow = BT_GetGlobalTimer();
+	while(!bt_list_empty(&g_hrtimers)) {
+		BT_HRTIMER *pTimer = bt_list_first_entry(&g_hrtimers, BT_HRTIMER, item);
+		if(pTimer->ullExpires > ullNow) {
+			break;
+		}
+
+		bt_list_del_init(&pTimer->item);
+		if(pTimer->ullPeriod) {
+			pTimer->ullExpires += ((ullNow - pTimer->ullExpires) / pTimer->ullPeriod + 1) * pTimer->ullPeriod;
+			hrtimer_enqueue(pTimer);
+		}
+
+		bt_spin_unlock_irqrestore(&g_hrtimer_lock, flags);
+		pTimer->pfnCallback(pTimer, pTimer->pParam);
+		bt_spin_lock_irqsave(&g_hrtimer_lock, flags);
+	}
+
+	hrtimer_program();
+
+	bt_spin_unlock_irqrestore(&g_hrtimer_lock, flags);
+
+	return BT_ERR_NONE;
+}
+#endif
+
+#ifdef BT_CONFIG_KERNEL_TICKLESS_IDLE
+static void tickless_wakeup(BT_HRTIMER *pTimer, void *pParam) {
+	;	// The interrupt has woken the CPU, the kernel does the rest.
+}
+
+static BT_HRTIMER g_oTicklessWakeup = BT_HRTIMER_INIT(g_oTicklessWakeup, tickless_wakeup, NULL);
+
+/*
+ *	Called with IRQs masked. Stops the tick timer and sleeps until the tick ulTicks from
+ *	the last one, or until another interrupt, and returns the ticks that went by. The
+ *	tick timer restarts at the point of its period it would have reached anyway.
+ */
+BT_u32 bt_tickless_sleep(BT_u32 ulTicks) {
+	BT_ERROR Error;
+
+	if(!g_hTimer || !g_Ops->pfnRestart || !g_bHrTimers) {
+		return 0;
+	}
+
+	BT_u32 ulRate = g_Ops->pfnGetClockRate(g_hTimer, &Error);
+	BT_u32 ulPeriod = ulRate / g_Ops->pfnGetFrequency(g_hTimer, &Error);
+	BT_u32 ulGlobalRate = BT_GetGlobalTimerRate();
+
+	g_Ops->pfnStop(g_hTimer);
+	BT_u64 ullStart = BT_GetGlobalTimer();
+	BT_u32 ulOffset = g_Ops->pfnGetOffset(g_hTimer, &Error);
+
+	BT_u64 ullSleep = (BT_u64) ulTicks * ulPeriod - ulOffset;
+	if(!hrtimer_start(&g_oTicklessWakeup, ullStart + scale(ullSleep, ulGlobalRate, ulRate), 0)) {
+		__asm volatile("dsb\n\twfi" ::: "memory");		// Pending IRQs wake it even though masked.
+		BT_HrTimerCancel(&g_oTicklessWakeup);
+	}
+
+	BT_u64 ullElapsed = ulOffset + scale(BT_GetGlobalTimer() - ullStart, ulRate, ulGlobalRate);
+	g_Ops->pfnRestart(g_hTimer, ullElapsed % ulPeriod);
+
+	return ullElapsed / ulPeriod;
+}
+#endif
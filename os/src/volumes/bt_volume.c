@@ -7,6 +7,7 @@
 #include <bitthunder.h>
 #include <collections/bt_list.h>
 #include <lib/getmem.h>
+#include <hash/bt_crc.h>
 #include "ibm_mbr.h"
 #include <string.h>
 #include <stdio.h>
@@ -46,40 +47,296 @@ static const BT_DEVFS_OPS oDevfsOps = {
 	.pfnOpen = devfs_open,
 };
 
-static BT_u32 BT_PartitionCount(BT_u8 *pBuffer) {
-	BT_u32 count = 0;
-	BT_u8 part;
-	// Check PBR or MBR signature
-	if (pBuffer[IBM_MBR_SIGNATURE] != 0x55 &&
-		pBuffer[IBM_MBR_SIGNATURE+1] != 0xAA ) {
-		// No MBR, but is it a PBR ?
-		if (pBuffer[0] == 0xEB &&          // PBR Byte 0
-		    pBuffer[2] == 0x90 &&          // PBR Byte 2
-		    (pBuffer[21] & 0xF0) == 0xF0) {// PBR Byte 21 : Media byte
-			return 1;	// No MBR but PBR exist then only one partition
+#define MBR_TYPE_EXTENDED_CHS		0x05
+#define MBR_TYPE_EXTENDED_LBA		0x0F
+#define MBR_TYPE_EXTENDED_LINUX		0x85
+#define MBR_TYPE_GPT_PROTECTIVE		0xEE
+
+#define MBR_MAX_LOGICAL				128		///< Bounds the EBR chain walk, protects against loops.
+
+#define GPT_SIGNATURE				"EFI PART"
+#define GPT_HDR_SIGNATURE			0x00
+#define GPT_HDR_SIZE				0x0C
+#define GPT_HDR_CRC32				0x10
+#define GPT_HDR_MY_LBA				0x18
+#define GPT_HDR_ALTERNATE_LBA		0x20
+#define GPT_HDR_ENTRIES_LBA			0x48
+#define GPT_HDR_NUM_ENTRIES			0x50
+#define GPT_HDR_ENTRY_SIZE			0x54
+#define GPT_HDR_ENTRIES_CRC32		0x58
+#define GPT_HDR_MIN_SIZE			92
+
+#define GPT_ENTRY_TYPE_GUID			0x00
+#define GPT_ENTRY_FIRST_LBA			0x20
+#define GPT_ENTRY_LAST_LBA			0x28
+#define GPT_ENTRY_MIN_SIZE			128
+#define GPT_ENTRY_MAX_SIZE			512
+#define GPT_MAX_ENTRIES				1024
+#define GPT_MAX_ARRAY_SIZE			(GPT_MAX_ENTRIES * GPT_ENTRY_MIN_SIZE)	///< Largest entry array that is read.
+
+static void init_devfs_node(BT_HANDLE hVolume) {
+	hVolume->v.node.pOps = &oDevfsOps;
+}
+
+static BT_u32 crc32_of(const void *data, BT_u32 nbytes) {
+	BT_u32 crc;
+	bt_crc32(data, nbytes, (BT_u8 *) &crc);
+	return crc;
+}
+
+static BT_ERROR read_blocks(BT_BLKDEV_DESCRIPTOR *blk, BT_u32 ulAddress, BT_u32 ulBlocks, void *pBuffer) {
+	BT_s32 ret = BT_BlockRead((BT_HANDLE) &blk->h, ulAddress, ulBlocks, pBuffer);
+	if(ret == ulBlocks) {
+		return BT_ERR_NONE;
+	}
+
+	return (ret < 0) ? ret : BT_ERR_GENERIC;
+}
+
+static BT_ERROR add_volume(BT_BLKDEV_DESCRIPTOR *blk, BT_u32 ulNumber, BT_u32 ulBase, BT_u32 ulBlocks, BT_VOLUME_TYPE eType) {
+
+	BT_HANDLE hVolume = BT_kMalloc(sizeof(BT_PARTITION));
+	if(!hVolume) {
+		return BT_ERR_NO_MEMORY;
+	}
+
+	BT_PARTITION *pPart = (BT_PARTITION *) hVolume;
+
+	hVolume->v.eType 			= eType;
+	hVolume->v.ulTotalBlocks 	= ulBlocks;
+	hVolume->v.blkdev         	= blk;
+	hVolume->v.ulReferenceCount = 0;
+	pPart->ulBaseAddress 		= ulBase;
+	pPart->ulPartitionNumber 	= ulNumber;
+
+	bt_list_add(&hVolume->v.item, &blk->volumes);
+
+	BT_i8 *iname = BT_kMalloc(strlen(blk->node.szpName) + 10);
+	bt_sprintf(iname, "%s%lu", blk->node.szpName, ulNumber);
+
+	init_devfs_node(hVolume);
+
+	BT_DeviceRegister(&hVolume->v.node, iname);
+
+	BT_u32 ulErase = blk->oGeometry.ulEraseBlocks;
+	if(ulErase && (ulBase % ulErase)) {
+		BT_kPrint("Volume %s starts %lu blocks into an erase unit (%lu blocks), expect read-modify-write cycles.", iname, ulBase % ulErase, ulErase);
+	} else {
+		BT_kDebug("Adding a volume: %s", iname);
+	}
+
+	BT_kFree(iname);
+
+	return BT_ERR_NONE;
+}
+
+/**
+ *	Reads and validates a GPT header at ulLBA, followed by its partition entry array.
+ *	On success *ppEntries holds the entry array, which the caller must free.
+ **/
+static BT_ERROR gpt_read(BT_BLKDEV_DESCRIPTOR *blk, BT_u32 ulLBA, BT_u8 *pHeader, BT_u8 **ppEntries) {
+
+	BT_ERROR Error;
+	BT_u32 ulBlockSize = blk->oGeometry.ulBlockSize;
+
+	Error = read_blocks(blk, ulLBA, 1, pHeader);
+	if(Error) {
+		return Error;
+	}
+
+	if(memcmp(pHeader + GPT_HDR_SIGNATURE, GPT_SIGNATURE, 8)) {
+		return BT_ERR_INVALID_VALUE;
+	}
+
+	BT_u32 ulHeaderSize = BT_Get32LE(pHeader, GPT_HDR_SIZE);
+	if(ulHeaderSize < GPT_HDR_MIN_SIZE || ulHeaderSize > ulBlockSize) {
+		return BT_ERR_INVALID_VALUE;
+	}
+
+	// The header CRC is calculated with its own field zeroed.
+	BT_u32 ulCRC = BT_Get32LE(pHeader, GPT_HDR_CRC32);
+	memset(pHeader + GPT_HDR_CRC32, 0, 4);
+	if(crc32_of(pHeader, ulHeaderSize) != ulCRC) {
+		BT_kPrint("GPT header at LBA %lu has a bad CRC.", ulLBA);
+		return BT_ERR_INVALID_VALUE;
+	}
+
+	if(BT_Get64LE(pHeader, GPT_HDR_MY_LBA) != ulLBA) {
+		return BT_ERR_INVALID_VALUE;
+	}
+
+	BT_u64 ullEntries 		= BT_Get64LE(pHeader, GPT_HDR_ENTRIES_LBA);
+	BT_u32 ulNumEntries 	= BT_Get32LE(pHeader, GPT_HDR_NUM_ENTRIES);
+	BT_u32 ulEntrySize 		= BT_Get32LE(pHeader, GPT_HDR_ENTRY_SIZE);
+
+	// Entries are 128 * 2^n bytes. Bound both factors and their product, so that the
+	// array size cannot wrap and gpt_enumerate() stays within the array it allocates.
+	if(ulEntrySize < GPT_ENTRY_MIN_SIZE || ulEntrySize > GPT_ENTRY_MAX_SIZE || (ulEntrySize & (ulEntrySize - 1))) {
+		return BT_ERR_INVALID_VALUE;
+	}
+
+	if(!ulNumEntries || ulNumEntries > GPT_MAX_ENTRIES || (BT_u64) ulNumEntries * ulEntrySize > GPT_MAX_ARRAY_SIZE) {
+		return BT_ERR_INVALID_VALUE;
+	}
+
+	BT_u32 ulArraySize 	= ulNumEntries * ulEntrySize;
+	BT_u32 ulArrayBlocks = (ulArraySize + ulBlockSize - 1) / ulBlockSize;
+
+	if(ullEntries < 2 || ullEntries > blk->oGeometry.ulTotalBlocks || ullEntries + ulArrayBlocks > blk->oGeometry.ulTotalBlocks) {
+		return BT_ERR_INVALID_VALUE;
+	}
+
+	BT_u8 *pEntries = BT_kMalloc(ulArrayBlocks * ulBlockSize);
+	if(!pEntries) {
+		return BT_ERR_NO_MEMORY;
+	}
+
+	Error = read_blocks(blk, (BT_u32) ullEntries, ulArrayBlocks, pEntries);
+	if(Error) {
+		goto err_free_out;
+	}
+
+	if(crc32_of(pEntries, ulArraySize) != BT_Get32LE(pHeader, GPT_HDR_ENTRIES_CRC32)) {
+		BT_kPrint("GPT partition entries at LBA %lu have a bad CRC.", (BT_u32) ullEntries);
+		Error = BT_ERR_INVALID_VALUE;
+		goto err_free_out;
+	}
+
+	*ppEntries = pEntries;
+
+	return BT_ERR_NONE;
+
+err_free_out:
+	BT_kFree(pEntries);
+	return Error;
+}
+
+/**
+ *	Enumerates partitions from the primary GPT, falling back to the backup GPT
+ *	(at the alternate LBA, or the last block of the device) if the primary is corrupt.
+ **/
+static BT_ERROR gpt_enumerate(BT_BLKDEV_DESCRIPTOR *blk, BT_u8 *pBuffer, BT_u32 *pulCount) {
+
+	BT_ERROR Error;
+	BT_u8 *pEntries = NULL;
+	BT_u32 ulLast = blk->oGeometry.ulTotalBlocks - 1;
+
+	Error = gpt_read(blk, 1, pBuffer, &pEntries);
+	if(Error) {
+		BT_kPrint("Primary GPT is invalid, trying the backup.");
+		Error = gpt_read(blk, ulLast, pBuffer, &pEntries);
+		if(Error) {
+			return Error;
+		}
+	} else {
+		// Primary is good, but report a damaged backup so that it can be repaired.
+		BT_u64 ullAlternate = BT_Get64LE(pBuffer, GPT_HDR_ALTERNATE_LBA);
+		BT_u8 *pBackup = BT_kMalloc(blk->oGeometry.ulBlockSize);
+		BT_u8 *pBackupEntries = NULL;
+		if(pBackup) {
+			if(ullAlternate > ulLast || gpt_read(blk, (BT_u32) ullAlternate, pBackup, &pBackupEntries)) {
+				BT_kPrint("Backup GPT is invalid.");
+			} else {
+				BT_kFree(pBackupEntries);
+			}
+			BT_kFree(pBackup);
+		}
+	}
+
+	BT_u32 ulNumEntries = BT_Get32LE(pBuffer, GPT_HDR_NUM_ENTRIES);
+	BT_u32 ulEntrySize 	= BT_Get32LE(pBuffer, GPT_HDR_ENTRY_SIZE);
+	BT_u32 i;
+
+	for(i = 0; i < ulNumEntries; i++) {
+		BT_u8 *pEntry = pEntries + (i * ulEntrySize);
+		static const BT_u8 zero_guid[16] = { 0 };
+
+		if(!memcmp(pEntry + GPT_ENTRY_TYPE_GUID, zero_guid, 16)) {
+			continue;	// Unused entry.
+		}
+
+		BT_u64 ullFirst = BT_Get64LE(pEntry, GPT_ENTRY_FIRST_LBA);
+		BT_u64 ullLast 	= BT_Get64LE(pEntry, GPT_ENTRY_LAST_LBA);
+
+		if(ullLast < ullFirst || ullLast > ulLast) {
+			BT_kPrint("GPT entry %lu is outside of the device, ignored.", i);
+			continue;
+		}
+
+		Error = add_volume(blk, *pulCount, (BT_u32) ullFirst, (BT_u32) (ullLast - ullFirst + 1), BT_VOLUME_PARTITION);
+		if(Error) {
+			break;
 		}
-		return 0;   // No MBR and no PBR then no partition found
+
+		*pulCount += 1;
 	}
-	for (part = 0; part < 4; part++)  {
-		BT_u8 active = pBuffer[IBM_MBR_PTBL + IBM_MBR_PTBL_ACTIVE + (16 * part)];
-		BT_u8 part_id = pBuffer[IBM_MBR_PTBL + IBM_MBR_PTBL_ID + (16 * part)];
-		// The first sector must be a MBR, then check the partition entry in the MBR
-		if (active != 0x80 && (active != 0 || part_id == 0)) {
+
+	BT_kFree(pEntries);
+
+	return Error;
+}
+
+static BT_BOOL mbr_is_extended(BT_u8 part_id) {
+	return (part_id == MBR_TYPE_EXTENDED_CHS || part_id == MBR_TYPE_EXTENDED_LBA || part_id == MBR_TYPE_EXTENDED_LINUX);
+}
+
+/**
+ *	Walks the chain of extended boot records, each describing one logical partition
+ *	(relative to the EBR) and the next EBR (relative to the extended partition).
+ **/
+static BT_ERROR mbr_enumerate_logical(BT_BLKDEV_DESCRIPTOR *blk, BT_u8 *pBuffer, BT_u32 ulExtended, BT_u32 *pulCount) {
+
+	BT_ERROR Error = BT_ERR_NONE;
+	BT_u32 ulEBR = ulExtended;
+	BT_u32 i;
+
+	for(i = 0; i < MBR_MAX_LOGICAL; i++) {
+		Error = read_blocks(blk, ulEBR, 1, pBuffer);
+		if(Error) {
+			break;
+		}
+
+		if(pBuffer[IBM_MBR_SIGNATURE] != 0x55 || pBuffer[IBM_MBR_SIGNATURE+1] != 0xAA) {
+			break;
+		}
+
+		BT_u8 *pLogical = pBuffer + IBM_MBR_PTBL;
+		BT_u8 *pNext 	= pBuffer + IBM_MBR_PTBL + 16;
+
+		BT_u32 ulSectors = BT_Get32LE(pLogical, IBM_MBR_PTBL_SECTORS);
+		if(pLogical[IBM_MBR_PTBL_ID] && ulSectors) {
+			Error = add_volume(blk, *pulCount, ulEBR + BT_Get32LE(pLogical, IBM_MBR_PTBL_LBA), ulSectors, BT_VOLUME_PARTITION);
+			if(Error) {
+				break;
+			}
+			*pulCount += 1;
+		}
+
+		BT_u32 ulNext = BT_Get32LE(pNext, IBM_MBR_PTBL_LBA);
+		if(!mbr_is_extended(pNext[IBM_MBR_PTBL_ID]) || !ulNext) {
+			break;
+		}
+
+		ulEBR = ulExtended + ulNext;
+		if(ulEBR >= blk->oGeometry.ulTotalBlocks) {
 			break;
 		}
-		count++;
 	}
-	return count;
+
+	return Error;
 }
 
-static void init_devfs_node(BT_HANDLE hVolume) {
-	hVolume->v.node.pOps = &oDevfsOps;
+static BT_BOOL is_pbr(BT_u8 *pBuffer) {
+	return (pBuffer[0] == 0xEB &&          		// PBR Byte 0
+			pBuffer[2] == 0x90 &&          		// PBR Byte 2
+			(pBuffer[21] & 0xF0) == 0xF0);		// PBR Byte 21 : Media byte
 }
 
 BT_ERROR BT_EnumerateVolumes(BT_HANDLE hBlock) {
 
 	BT_ERROR Error = BT_ERR_NONE;
-	BT_s32 ret;
+	BT_u32 ulCount = 0;
+	BT_u32 i;
 
 	BT_BLKDEV_DESCRIPTOR *blk = (BT_BLKDEV_DESCRIPTOR *) hBlock;
 
@@ -91,75 +348,60 @@ BT_ERROR BT_EnumerateVolumes(BT_HANDLE hBlock) {
 	}
 
 
-	BT_u8 *pMBR = BT_kMalloc(blk->oGeometry.ulBlockSize);
+	BT_u8 *pMBR = BT_kMalloc(blk->oGeometry.ulBlockSize * 2);
 	if(!pMBR) {
 		Error = BT_ERR_NO_MEMORY;
 		goto err_out;
 	}
 
-	ret = BT_BlockRead((BT_HANDLE) &blk->h, 0, 1, pMBR);
-	if(ret != 1) {
-		if(ret < 0) {
-			Error = ret;
-		} else {
-			Error = BT_ERR_GENERIC;
-		}
+	BT_u8 *pScratch = pMBR + blk->oGeometry.ulBlockSize;
+
+	Error = read_blocks(blk, 0, 1, pMBR);
+	if(Error) {
 		goto err_free_out;
 	}
 
-	// Create the volume handle.
-	BT_u32 partCount = BT_PartitionCount(pMBR);
-	if(!partCount) {
-		BT_HANDLE hVolume = BT_kMalloc(sizeof(struct _BT_OPAQUE_HANDLE));
-		if(!hVolume) {
-			return BT_ERR_NO_MEMORY;
-		}
-
-		hVolume->v.eType 			= BT_VOLUME_NORMAL;
-		hVolume->v.ulTotalBlocks 	= blk->oGeometry.ulTotalBlocks;
-		hVolume->v.blkdev         	= blk;
-		hVolume->v.ulReferenceCount = 0;
-
-		bt_list_add(&hVolume->v.item, &blk->volumes);
+	if(pMBR[IBM_MBR_SIGNATURE] == 0x55 && pMBR[IBM_MBR_SIGNATURE+1] == 0xAA && !is_pbr(pMBR)) {
 
-		BT_i8 *iname = BT_kMalloc(strlen(blk->node.szpName) + 10);;
-		bt_sprintf(iname, "%s%d", blk->node.szpName, 0);
-
-		init_devfs_node(hVolume);
-
-		BT_DeviceRegister(&hVolume->v.node, iname);
-		BT_kDebug("Adding a volume: %s", iname);
-
-		BT_kFree(iname);
-
-	} else {
-		BT_u32 i;
-		for(i = 0; i < partCount; i++) {
-			BT_HANDLE hVolume = BT_kMalloc(sizeof(BT_PARTITION));
-			if(!hVolume) {
-				return BT_ERR_NO_MEMORY;
+		for(i = 0; i < 4; i++) {
+			if(pMBR[IBM_MBR_PTBL + (16 * i) + IBM_MBR_PTBL_ID] == MBR_TYPE_GPT_PROTECTIVE) {
+				break;
 			}
+		}
 
-			BT_PARTITION *pPart = (BT_PARTITION *) hVolume;
-
-			hVolume->v.eType 				= BT_VOLUME_PARTITION;
-			pPart->ulBaseAddress 		= BT_Get32LE(pMBR, (IBM_MBR_PTBL + (16 * i) + IBM_MBR_PTBL_LBA));
-			pPart->ulPartitionNumber 	= i;
-			hVolume->v.ulTotalBlocks		= BT_Get32LE(pMBR, (IBM_MBR_PTBL + (16 * i) + IBM_MBR_PTBL_SECTORS));
-			hVolume->v.blkdev     		= blk;
-			hVolume->v.ulReferenceCount 	= 0;
+		if(i < 4 && gpt_enumerate(blk, pScratch, &ulCount) == BT_ERR_NONE) {
+			goto done;
+		}
 
-			bt_list_add(&hVolume->v.item, &blk->volumes);
+		for(i = 0; i < 4; i++) {
+			BT_u8 *pEntry 	= pMBR + IBM_MBR_PTBL + (16 * i);
+			BT_u8 active 	= pEntry[IBM_MBR_PTBL_ACTIVE];
+			BT_u8 part_id 	= pEntry[IBM_MBR_PTBL_ID];
+			BT_u32 ulBase 	= BT_Get32LE(pEntry, IBM_MBR_PTBL_LBA);
+			BT_u32 ulSectors = BT_Get32LE(pEntry, IBM_MBR_PTBL_SECTORS);
 
-			BT_i8 *iname = BT_kMalloc(strlen(blk->node.szpName) + 10);
-			bt_sprintf(iname, "%s%lu", blk->node.szpName, i);
+			if((active != 0x80 && active != 0) || !part_id || part_id == MBR_TYPE_GPT_PROTECTIVE || !ulSectors) {
+				continue;
+			}
 
-			init_devfs_node(hVolume);
+			if(mbr_is_extended(part_id)) {
+				Error = mbr_enumerate_logical(blk, pScratch, ulBase, &ulCount);
+			} else {
+				Error = add_volume(blk, ulCount++, ulBase, ulSectors, BT_VOLUME_PARTITION);
+			}
 
-			BT_DeviceRegister(&hVolume->v.node, iname);
-			BT_kDebug("Adding a partition: %s", iname);
+			if(Error) {
+				goto err_free_out;
+			}
+		}
+	}
 
-			BT_kFree(iname);
+done:
+	if(!ulCount) {
+		// No partition table (or a bare PBR), the volume spans the whole device.
+		Error = add_volume(blk, 0, 0, blk->oGeometry.ulTotalBlocks, BT_VOLUME_NORMAL);
+		if(Error) {
+			goto err_free_out;
 		}
 	}
 
@@ -223,6 +465,34 @@ BT_ERROR BT_GetVolumeGeometry(BT_HANDLE hVolume, BT_BLOCK_GEOMETRY *pGeometry) {
 }
 BT_EXPORT_SYMBOL(BT_GetVolumeGeometry);
 
+BT_ERROR BT_GetVolumeAlignment(BT_HANDLE hVolume, BT_VOLUME_ALIGNMENT *pAlignment) {
+
+	if(!hVolume || BT_HANDLE_TYPE(hVolume) != BT_HANDLE_T_VOLUME) {
+		return BT_ERR_INVALID_HANDLE;
+	}
+
+	if(!pAlignment) {
+		return BT_ERR_NULL_POINTER;
+	}
+
+	BT_PARTITION *pPart = (BT_PARTITION *) hVolume;
+	BT_u32 ulStart = pPart->ulBaseAddress;
+	BT_u32 ulErase = hVolume->v.blkdev->oGeometry.ulEraseBlocks;
+
+	pAlignment->ulStartBlock 	= ulStart;
+	pAlignment->ulEraseBlocks 	= ulErase;
+	pAlignment->ulEraseOffset 	= ulErase ? (ulStart % ulErase) : 0;
+
+	// Largest power of two dividing the start block, a start of 0 is aligned to anything.
+	pAlignment->ulAlignment = ulStart ? (ulStart & -ulStart) : 0x80000000;
+	if(ulErase && pAlignment->ulAlignment > ulErase) {
+		pAlignment->ulAlignment = ulErase;
+	}
+
+	return BT_ERR_NONE;
+}
+BT_EXPORT_SYMBOL(BT_GetVolumeAlignment);
+
 static BT_ERROR bt_volume_inode_cleanup(BT_HANDLE hVolume) {
 	hVolume->v.ulReferenceCount -= 1;
 	return BT_ERR_NONE;